@@ -0,0 +1,648 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Drives every module's step() against the Rack stand-in in bench/include with a synthetic
+//patch (clock, reset and CV inputs) and reports the per-sample cost of each configuration.
+//
+//Usage: bench [-r sampleRate] [-s seconds] [-seed n] [-hash] [-block frames] [-json] [-undo] [-predict] [slug ...]
+//  -hash: instead of timing, print a hash of every output's sample stream, so that the output of two
+//         builds can be diffed to check that an optimization is bit-exact (same seed, same sample rate);
+//         make bench-check compares them with the golden files in bench/golden, see bench/bench.mk
+//  -block: drive the modules that have one through processBlock() with buffers of the given size instead of
+//         step(), the hashes must match the ones of the per-sample path
+//  -json: instead of running the modules, print the size of each module's saved state (randomized content) and the
+//         time it takes to save it (toJson() and dump) and to load it back (parse and fromJson()); Foundry is also
+//         measured with the step arrays of earlier versions, for comparison with its binary step data
+//  -undo: instead of running the modules, check the undo journal of Foundry's sequencer (edits on randomized content are
+//         undone and redone, and must give back the states before and after each edit); the exit status is 1 on failure
+//  -predict: instead of running the modules, check the lookahead of Foundry's sequencer against the steps that clockStep()
+//         then plays, with random run modes, a track in TKA and edits along the way; the exit status is 1 on failure
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include "ImpromptuModular.hpp"
+#include "FoundryUtil.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+using namespace rack;
+
+
+// Synthetic patch for each model: which input jacks receive a clock, a reset or CVs, and which knobs are turned away from
+// their defaults (the module is created with its widget, so all other params have the defaults of their widgets).
+// Expansion inputs are only connected in the configurations where the expansion panel is on, BPM inputs only in the
+// configurations with BPM detection (they receive an external clock with jitter and tempo changes).
+struct BenchPatch {
+	std::vector<int> clockInputs;
+	std::vector<int> resetInputs;
+	std::vector<int> cvInputs;
+	std::vector<int> expansionInputs;
+	std::vector<int> bpmInputs;
+	std::vector<std::pair<int, float>> params;// param id and value
+	int maxExpansion;// when the expansion setting goes above 1 (Clocked's sub clock bank is 2)
+};
+
+static const std::map<std::string, BenchPatch> benchPatches = {
+	{"Tact", {{}, {}, {0, 1, 2, 3}, {}}},
+	{"Tact1", {{}, {}, {}, {}}},
+	{"Twelve-Key", {{0}, {}, {1}, {}}},
+	{"Clocked", {{}, {4}, {}, {0, 1, 2, 3, 7, 8, 9, 10}, {6}, {
+		{0, 133.0f},// 133 BPM
+		{1, 9.0f}, {2, -5.0f}, {3, 4.0f},// x8, /4, x3
+		{5, 0.4f}, {10, 0.25f},// swing of clock 1, pulse width of clock 2
+		{15, 3.0f}, {17, 7.0f},// delays of clocks 1 and 3 (1/4 and 3/4)
+		{19, 1.0f}, {20, -1.0f}, {21, 5.0f}, {22, -5.0f}, {23, 9.0f}, {24, 33.0f},// bank ratios: x1.5, /1.5, x4, /4, x8, x64,
+		{25, -33.0f}, {26, 19.0f}, {27, -20.0f}, {28, 24.0f}, {29, 2.0f}, {30, -9.0f},//   /64, x19, /23, x32, x2, /8
+		{31, 0.5f}, {34, -0.3f}, {37, 0.8f}, {45, 0.1f}, {48, 0.9f}, {53, 0.3f},// bank swings and pulse widths
+		{55, 7.0f}, {57, 2.0f}, {58, 5.0f}, {60, 4.0f}, {63, 1.0f}, {66, 6.0f}},// bank delays
+		2}},
+	{"Foundry", {{6}, {5}, {}, {14, 16, 17, 18, 19, 20}}},
+	{"Gate-Seq-64", {{0}, {1}, {}, {6}}},
+	{"Phrase-Seq-16", {{3}, {2}, {}, {8, 9, 10, 11, 12}}},
+	{"Phrase-Seq-32", {{3}, {2}, {}, {8, 9, 10, 11, 12}}},
+	{"Write-Seq-32", {{6}, {7}, {1}, {}}},
+	{"Write-Seq-64", {{6, 7}, {8}, {1}, {}}},
+	{"Big-Button-Seq", {{0}, {5}, {}, {}}},
+	{"Big-Button-Seq2", {{0}, {5}, {10}, {}}},
+	{"Four-View", {{}, {}, {0, 1, 2, 3}, {}}},
+	{"Semi-Modular Synth", {{3}, {2}, {}, {}}},
+	{"Blank-Panel", {{}, {}, {}, {}}},
+};
+
+
+struct BenchConfig {
+	std::string name;
+	int running;// -1 when the module has no run state
+	int expansion;// -1 when the module has no expansion panel
+	bool bpmDetection;
+};
+
+
+// FNV-1a over the bit patterns of all outputs of one sample
+static uint64_t hashValue(uint64_t hash, float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	for (int i = 0; i < 4; i++) {
+		hash ^= (bits >> (i * 8)) & 0xFF;
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+static uint64_t hashOutputs(uint64_t hash, Module *module) {
+	for (Output &output : module->outputs)
+		hash = hashValue(hash, output.value);
+	return hash;
+}
+
+
+static uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+
+// Sets the given integer/boolean members of the module's patch state through its own
+// toJson()/fromJson(), exactly as a patch load would.
+static void applyConfig(Module *module, const BenchConfig &config) {
+	json_t *rootJ = module->toJson();
+	if (!rootJ)
+		return;
+	if (config.running != -1)
+		json_object_set_new(rootJ, "running", json_boolean(config.running != 0));
+	if (config.expansion != -1)
+		json_object_set_new(rootJ, "expansion", json_integer(config.expansion));
+	if (config.bpmDetection)
+		json_object_set_new(rootJ, "bpmDetectionMode", json_true());
+	module->fromJson(rootJ);
+	json_decref(rootJ);
+}
+
+
+static std::vector<BenchConfig> listConfigs(Module *module, const BenchPatch &patch) {
+	std::vector<BenchConfig> configs;
+	json_t *rootJ = module->toJson();
+	bool hasRunning = json_object_get(rootJ, "running") != NULL;
+	bool hasExpansion = json_object_get(rootJ, "expansion") != NULL;
+	json_decref(rootJ);
+	int maxExpansion = hasExpansion ? std::max(patch.maxExpansion, 1) : -1;
+	static const char *expansionNames[] = {"", "+exp", "+bank"};
+	for (int running = (hasRunning ? 0 : -1); running <= (hasRunning ? 1 : -1); running++) {
+		for (int expansion = (hasExpansion ? 0 : -1); expansion <= maxExpansion; expansion++) {
+			std::string name;
+			if (running != -1)
+				name += (running ? "running" : "stopped");
+			if (expansion != -1)
+				name += expansionNames[expansion];
+			configs.push_back({name.empty() ? "default" : name, running, expansion, false});
+		}
+	}
+	// following the external clock, which also starts the module on its first pulse
+	if (!patch.bpmInputs.empty()) {
+		for (int expansion = (hasExpansion ? 0 : -1); expansion <= maxExpansion; expansion++)
+			configs.push_back({std::string("bpm") + (expansion > 0 ? expansionNames[expansion] : ""), -1, expansion, true});
+	}
+	return configs;
+}
+
+
+// Clock is 16th notes at about 120 BPM with 50% duty cycle, its tempo wobbles slowly so that its edges fall at varied
+// positions between samples; reset is a 1 ms pulse at the start, CVs are slow triangles between 0V and 2V so that gate CVs
+// also cross their trigger threshold. The external clock for BPM detection is 16th notes at 120 BPM that slow down to 60 BPM
+// from 0.8 s to 1.6 s of every 2 s, and each of its pulses is late by up to 8% of a pulse.
+struct PatchValues {
+	float clock;
+	float reset;
+	float cv;
+	float bpmClock;
+};
+
+// (not inlined, so that -funsafe-math-optimizations can't round it differently for the step() and processBlock() paths)
+static __attribute__((noinline)) PatchValues calcPatchValues(long sample, float sampleRate) {
+	float time = sample / sampleRate;
+	float clockPhase = time * 8.0f + 0.05f * sinf(time * 2.1f);
+	float cvPhase = time * 0.3f;
+	PatchValues values;
+	values.clock = (clockPhase - floorf(clockPhase)) < 0.5f ? 10.0f : 0.0f;
+	values.reset = time < 0.001f ? 10.0f : 0.0f;
+	values.cv = 4.0f * fabsf(cvPhase - floorf(cvPhase) - 0.5f);
+	float cycle = floorf(time * 0.5f);
+	float cycleTime = time - cycle * 2.0f;
+	float bpmPhase = cycle * 12.8f + 8.0f * fminf(cycleTime, 0.8f) + 4.0f * clamp(cycleTime - 0.8f, 0.0f, 0.8f) + 8.0f * fmaxf(cycleTime - 1.6f, 0.0f);
+	float pulse = floorf(bpmPhase);
+	float late = (float)(((uint32_t)pulse * 2654435761u) >> 24) * (0.08f / 256.0f);// hash of the pulse number
+	float pulseFraction = bpmPhase - pulse;
+	values.bpmClock = (pulseFraction >= late && pulseFraction < late + 0.5f) ? 10.0f : 0.0f;
+	return values;
+}
+
+static void patchInputs(Module *module, const BenchPatch &patch, const BenchConfig &config, long sample, float sampleRate) {
+	PatchValues values = calcPatchValues(sample, sampleRate);
+	for (int i : patch.clockInputs)
+		module->inputs[i].value = values.clock;
+	for (int i : patch.resetInputs)
+		module->inputs[i].value = values.reset;
+	for (int i : patch.cvInputs)
+		module->inputs[i].value = values.cv;
+	if (config.expansion > 0) {
+		for (int i : patch.expansionInputs)
+			module->inputs[i].value = values.cv;
+	}
+	if (config.bpmDetection) {
+		for (int i : patch.bpmInputs)
+			module->inputs[i].value = values.bpmClock;
+	}
+}
+
+
+// Buffers for processBlock(): only the connected inputs get one, all outputs do
+struct BlockBuffers {
+	std::vector<std::vector<float>> inputs;
+	std::vector<std::vector<float>> outputs;
+	std::vector<const float*> inPtrs;
+	std::vector<float*> outPtrs;
+	
+	BlockBuffers(Module *module, int frames) {
+		inputs.resize(module->inputs.size());
+		outputs.resize(module->outputs.size(), std::vector<float>(frames));
+		inPtrs.resize(module->inputs.size(), NULL);
+		for (size_t i = 0; i < module->inputs.size(); i++) {
+			if (module->inputs[i].active) {
+				inputs[i].resize(frames);
+				inPtrs[i] = inputs[i].data();
+			}
+		}
+		for (size_t i = 0; i < module->outputs.size(); i++)
+			outPtrs.push_back(outputs[i].data());
+	}
+	
+	void fill(const BenchPatch &patch, const BenchConfig &config, long sample, int frames, float sampleRate) {
+		for (int f = 0; f < frames; f++) {
+			PatchValues values = calcPatchValues(sample + f, sampleRate);
+			for (int i : patch.clockInputs)
+				inputs[i][f] = values.clock;
+			for (int i : patch.resetInputs)
+				inputs[i][f] = values.reset;
+			for (int i : patch.cvInputs)
+				inputs[i][f] = values.cv;
+			if (config.expansion > 0) {
+				for (int i : patch.expansionInputs)
+					inputs[i][f] = values.cv;
+			}
+			if (config.bpmDetection) {
+				for (int i : patch.bpmInputs)
+					inputs[i][f] = values.bpmClock;
+			}
+		}
+	}
+};
+
+
+static void connectInputs(Module *module, const BenchPatch &patch, const BenchConfig &config) {
+	for (Input &input : module->inputs)
+		input.active = false;
+	for (int i : patch.clockInputs)
+		module->inputs[i].active = true;
+	for (int i : patch.resetInputs)
+		module->inputs[i].active = true;
+	for (int i : patch.cvInputs)
+		module->inputs[i].active = true;
+	if (config.expansion > 0) {
+		for (int i : patch.expansionInputs)
+			module->inputs[i].active = true;
+	}
+	if (config.bpmDetection) {
+		for (int i : patch.bpmInputs)
+			module->inputs[i].active = true;
+	}
+	for (Output &output : module->outputs)
+		output.active = true;
+}
+
+
+// Patch save and load of the module's current state, averaged over a few round trips
+static void benchJson(Module *module, const std::string &slug, const char *format) {
+	static const int numRoundTrips = 20;
+	size_t size = 0;
+	double saveNs = 0.0;
+	double loadNs = 0.0;
+	for (int i = 0; i < numRoundTrips; i++) {
+		auto start = std::chrono::steady_clock::now();
+		json_t *rootJ = module->toJson();
+		char *text = json_dumps(rootJ, 0);
+		auto saved = std::chrono::steady_clock::now();
+		json_decref(rootJ);
+		rootJ = json_loads(text, 0, NULL);
+		module->fromJson(rootJ);
+		auto loaded = std::chrono::steady_clock::now();
+		json_decref(rootJ);
+		size = strlen(text);
+		free(text);
+		saveNs += std::chrono::duration<double, std::nano>(saved - start).count();
+		loadNs += std::chrono::duration<double, std::nano>(loaded - saved).count();
+	}
+	printf("%-20s %-16s %12zu %12.1f %12.1f\n", slug.c_str(), format, size, saveNs / numRoundTrips / 1000.0, loadNs / numRoundTrips / 1000.0);
+}
+
+
+// Saved state of all tracks (step data, sequences, phrases and settings) without the edit indexes, for checkUndo()
+template <class SEQUENCER>
+static std::string sequencerState(SEQUENCER &seq) {
+	json_t *rootJ = json_object();
+	for (int trkn = 0; trkn < SEQUENCER::NUM_TRACKS; trkn++) {
+		typename SEQUENCER::Kernel kernel = seq.getKernel(trkn);
+		kernel.toJson(rootJ);
+	}
+	char *text = json_dumps(rootJ, 0);
+	std::string state(text);
+	free(text);
+	json_decref(rootJ);
+	return state;
+}
+
+// Undo journal of the Foundry sequencer: a few edits on randomized content, then undoing them one by one must give back the
+//   state before each edit, and redoing them the state after it (the edits are small enough for all of them to fit in the
+//   journal of each variant). Returns the number of failures.
+template <class SEQUENCER>
+static int checkUndo(const char *name, uint64_t seed) {
+	static const char *editNames[] = {"transpose", "rotate", "paste", "paste song"};
+	static const int numEdits = 4;
+	bool holdTiedNotes = true;
+	int velocityMode = 0;
+	int slideShape = SLIDE_LINEAR;
+	int rotateOffset = 0;
+	std::unique_ptr<SEQUENCER> seq(new SEQUENCER());
+	seq->construct(&holdTiedNotes, &velocityMode, &slideShape);
+	randomSeed(seed);
+	seq->randomize();
+
+	std::string states[numEdits + 1];
+	states[0] = sequencerState(*seq);
+	int failures = 0;
+	for (int edit = 0; edit < numEdits; edit++) {
+		switch (edit) {
+			case 0 :
+				seq->setTrackIndexEdit(1);
+				seq->setSeqIndexEdit(5);
+				seq->transposeSeq(3, true);
+			break;
+			case 1 :
+				seq->rotateSeq(&rotateOffset, -2, false);
+			break;
+			case 2 :
+				seq->setStepIndexEdit(4, 44100);
+				seq->copySequence(16);
+				seq->setSeqIndexEdit(9);
+				seq->pasteSequence(false);
+			break;
+			default :
+				seq->setPhraseIndexEdit(2);
+				seq->copySong(20);
+				seq->setPhraseIndexEdit(40);
+				seq->pasteSong(false);
+		}
+		states[edit + 1] = sequencerState(*seq);
+		if (states[edit + 1] == states[edit]) {
+			printf("%-20s %-16s   edit changed nothing\n", name, editNames[edit]);
+			failures++;
+		}
+	}
+	for (int edit = numEdits - 1; edit >= 0; edit--) {
+		bool ok = seq->undo() && sequencerState(*seq) == states[edit];
+		printf("%-20s %-16s   undo %s\n", name, editNames[edit], ok ? "ok" : "FAILED");
+		failures += ok ? 0 : 1;
+	}
+	for (int edit = 0; edit < numEdits; edit++) {
+		bool ok = seq->redo() && sequencerState(*seq) == states[edit + 1];
+		printf("%-20s %-16s   redo %s\n", name, editNames[edit], ok ? "ok" : "FAILED");
+		failures += ok ? 0 : 1;
+	}
+	return failures;
+}
+
+
+// Lookahead of the Foundry sequencer: before each clock pulse, every track is asked for the next few steps, which must agree
+//   with what it predicted before (nothing is edited in between) and then with the steps that clockStep() actually plays.
+//   Tracks B, C and D are in TKA. B has the same pulses per step as track A. C has more (never predicted). D is not predicted
+//   while it has more pulses per step (at the start) or another clock input. Edits along the way start the comparison over.
+//   Returns the number of failures.
+template <class SEQUENCER>
+static int checkPredict(const char *name, uint64_t seed) {
+	typedef typename SEQUENCER::Kernel Kernel;
+	static const int numPulses = 3000;
+	bool holdTiedNotes = true;
+	int velocityMode = 0;
+	int slideShape = SLIDE_LINEAR;
+	std::unique_ptr<SEQUENCER> seq(new SEQUENCER());
+	seq->construct(&holdTiedNotes, &velocityMode, &slideShape);
+	seq->reset();
+	randomSeed(seed);
+	seq->randomize();
+	for (int trkn = 1; trkn < 4; trkn++) {
+		seq->setTrackIndexEdit(trkn);
+		seq->modRunModeSong(Kernel::NUM_MODES, false);// TKA
+	}
+	seq->modPulsesPerStep(1, false);// on track D, restored below
+	seq->setTrackIndexEdit(2);
+	seq->modPulsesPerStep(1, false);
+	seq->initRun();
+
+	std::vector<PredictedStep> expected[SEQUENCER::NUM_TRACKS];// steps predicted and not yet played
+	int checked[SEQUENCER::NUM_TRACKS] = {};
+	int failures[SEQUENCER::NUM_TRACKS] = {};
+	for (int pulse = 0; pulse < numPulses; pulse++) {
+		bool edited = true;
+		switch (pulse) {
+			case 100 :// track D back to the same pulses per step as track A
+				seq->setTrackIndexEdit(3);
+				seq->modPulsesPerStep(-1, false);
+			break;
+			case 700 :
+				seq->setTrackIndexEdit(0);
+				seq->setSeqIndexEdit(seq->getPredictedStep(0, 0).seqn);// the sequence that plays next
+				seq->modLength(-3, false);
+			break;
+			case 1000 :
+				seq->setClockSource(3, 3);
+			break;
+			case 1800 :
+				seq->setClockSource(3, 0);
+			break;
+			case 2200 :
+				seq->setTrackIndexEdit(0);
+				seq->modRunModeSong(-Kernel::NUM_MODES, false);
+				seq->modRunModeSong(Kernel::MODE_RND, false);
+			break;
+			default :
+				edited = false;
+		}
+		if (edited) {
+			for (std::vector<PredictedStep> &e : expected)
+				e.clear();
+		}
+		
+		int count = 1 + (pulse * 7) % Kernel::PREDICT_SIZE;
+		for (int trkn = 0; trkn < SEQUENCER::NUM_TRACKS; trkn++) {
+			int n = seq->predictSteps(trkn, count);
+			bool predictable = trkn != 2 && !(trkn == 3 && (pulse < 100 || (pulse >= 1000 && pulse < 1800)));
+			if ((n > 0) != predictable) {
+				failures[trkn]++;
+				continue;
+			}
+			for (int i = 0; i < n; i++) {
+				PredictedStep ps = seq->getPredictedStep(trkn, i);
+				if (i < (int)expected[trkn].size()) {
+					const PredictedStep &e = expected[trkn][i];
+					if (ps.phrn != e.phrn || ps.seqn != e.seqn || ps.stepn != e.stepn)
+						failures[trkn]++;
+				}
+				else
+					expected[trkn].push_back(ps);
+			}
+		}
+		
+		for (int trkn = 0; trkn < SEQUENCER::NUM_TRACKS; trkn++) {
+			seq->clockStep(trkn, true, 0.0f);
+			if (expected[trkn].empty())// tracks with predictions step on every pulse (one pulse per step, no delay)
+				continue;
+			const PredictedStep &e = expected[trkn].front();
+			if (seq->getPhraseIndexRun(trkn) != e.phrn || seq->getStepIndexRun(trkn) != e.stepn)
+				failures[trkn]++;
+			checked[trkn]++;
+			expected[trkn].erase(expected[trkn].begin());
+		}
+	}
+	
+	int total = 0;
+	for (int trkn = 0; trkn < SEQUENCER::NUM_TRACKS; trkn++) {
+		printf("%-20s track %-10d   predict %s (%d steps)\n", name, trkn + 1, failures[trkn] == 0 ? "ok" : "FAILED", checked[trkn]);
+		total += failures[trkn];
+	}
+	return total;
+}
+
+
+int main(int argc, char **argv) {
+	float sampleRate = 44100.0f;
+	float seconds = 10.0f;
+	uint64_t seed = 1;
+	bool hashMode = false;
+	bool jsonMode = false;
+	bool undoMode = false;
+	bool predictMode = false;
+	int blockSize = 0;
+	std::vector<std::string> slugs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-r" && i + 1 < argc)
+			sampleRate = atof(argv[++i]);
+		else if (arg == "-s" && i + 1 < argc)
+			seconds = atof(argv[++i]);
+		else if (arg == "-seed" && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 10);
+		else if (arg == "-hash")
+			hashMode = true;
+		else if (arg == "-block" && i + 1 < argc)
+			blockSize = std::max(atoi(argv[++i]), 1);
+		else if (arg == "-json")
+			jsonMode = true;
+		else if (arg == "-undo")
+			undoMode = true;
+		else if (arg == "-predict")
+			predictMode = true;
+		else if (arg == "-h" || arg == "--help") {
+			printf("Usage: %s [-r sampleRate] [-s seconds] [-seed n] [-hash] [-block frames] [-json] [-undo] [-predict] [slug ...]\n", argv[0]);
+			return 0;
+		}
+		else
+			slugs.push_back(arg);
+	}
+
+	randomInit();
+	engineSetSampleRate(sampleRate);
+	Plugin *p = new Plugin();
+	p->path = ".";
+	init(p);
+
+	long numSamples = (long)(seconds * sampleRate);
+	long warmupSamples = (long)(0.1f * sampleRate);
+	printf("Impromptu Modular %s bench, %.0f Hz, %ld samples per configuration, seed %llu", p->version.c_str(), sampleRate, numSamples, (unsigned long long)seed);
+	if (blockSize > 0)
+		printf(", blocks of %d frames", blockSize);
+	printf("\n");
+	
+	if (jsonMode) {
+		printf("%-20s %-16s %12s %12s %12s\n", "module", "format", "bytes", "save us", "load us");
+		for (Model *model : p->models) {
+			if (!slugs.empty() && std::find(slugs.begin(), slugs.end(), model->slug) == slugs.end())
+				continue;
+			randomSeed(seed);
+			Module *module = model->createModule();
+			module->onRandomize();
+			benchJson(module, model->slug, "default");
+			if (model->slug == "Foundry") {
+				SequencerKernel::writeLegacyJson = true;
+				benchJson(module, model->slug, "legacy arrays");
+				SequencerKernel::writeLegacyJson = false;
+			}
+			delete module;
+		}
+		return 0;
+	}
+	
+	if (undoMode) {
+		int failures = checkUndo<Sequencer>("Sequencer", seed);
+		failures += checkUndo<Sequencer64Steps>("Sequencer64Steps", seed);
+		failures += checkUndo<Sequencer8Tracks>("Sequencer8Tracks", seed);
+		return failures == 0 ? 0 : 1;
+	}
+	
+	if (predictMode) {
+		int failures = checkPredict<Sequencer>("Sequencer", seed);
+		failures += checkPredict<Sequencer64Steps>("Sequencer64Steps", seed);
+		failures += checkPredict<Sequencer8Tracks>("Sequencer8Tracks", seed);
+		return failures == 0 ? 0 : 1;
+	}
+	
+	if (hashMode)
+		printf("%-20s %-16s %18s\n", "module", "config", "output hash");
+	else
+		printf("%-20s %-16s %12s %14s\n", "module", "config", "ns/sample", "cycles/sample");
+
+	for (Model *model : p->models) {
+		if (!slugs.empty() && std::find(slugs.begin(), slugs.end(), model->slug) == slugs.end())
+			continue;
+		auto patchIt = benchPatches.find(model->slug);
+		BenchPatch patch = (patchIt != benchPatches.end()) ? patchIt->second : BenchPatch();
+
+		Module *probe = model->createModule();
+		std::vector<BenchConfig> configs = listConfigs(probe, patch);
+		delete probe;
+
+		for (const BenchConfig &config : configs) {
+			// fresh instance per configuration with randomized content from a fixed seed, so every run sees the same patch
+			randomSeed(seed);
+			ModuleWidget *widget = model->createModuleWidget();
+			Module *module = widget->module;
+			for (const std::pair<int, float> &param : patch.params)
+				module->params[param.first].value = param.second;
+			module->onSampleRateChange();
+			module->onRandomize();
+			applyConfig(module, config);
+			connectInputs(module, patch, config);
+
+			for (long s = 0; s < warmupSamples; s++) {
+				patchInputs(module, patch, config, s, sampleRate);
+				module->step();
+			}
+
+			BlockProcessor *blockProcessor = (blockSize > 0) ? dynamic_cast<BlockProcessor*>(module) : NULL;
+			if (blockProcessor) {
+				BlockBuffers buffers(module, blockSize);
+				uint64_t hash = 0xCBF29CE484222325ULL;
+				double ns = 0.0;
+				uint64_t cycles = 0;
+				for (long s = 0; s < numSamples; s += blockSize) {
+					int frames = (int)std::min((long)blockSize, numSamples - s);
+					buffers.fill(patch, config, warmupSamples + s, frames, sampleRate);
+					auto start = std::chrono::steady_clock::now();
+					uint64_t startCycles = readCycles();
+					blockProcessor->processBlock(frames, buffers.inPtrs.data(), buffers.outPtrs.data());
+					cycles += readCycles() - startCycles;
+					ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+					if (hashMode) {
+						for (int f = 0; f < frames; f++) {
+							for (std::vector<float> &output : buffers.outputs)
+								hash = hashValue(hash, output[f]);
+						}
+					}
+				}
+				if (hashMode)
+					printf("%-20s %-16s   %016llx\n", model->slug.c_str(), config.name.c_str(), (unsigned long long)hash);
+				else
+					printf("%-20s %-16s %12.2f %14.1f  (block)\n", model->slug.c_str(), config.name.c_str(), ns / numSamples, (double)cycles / numSamples);
+				delete widget;
+				continue;
+			}
+
+			if (hashMode) {
+				uint64_t hash = 0xCBF29CE484222325ULL;
+				for (long s = 0; s < numSamples; s++) {
+					patchInputs(module, patch, config, warmupSamples + s, sampleRate);
+					module->step();
+					hash = hashOutputs(hash, module);
+				}
+				printf("%-20s %-16s   %016llx\n", model->slug.c_str(), config.name.c_str(), (unsigned long long)hash);
+				delete widget;
+				continue;
+			}
+
+			double outputSum = 0.0;
+			auto start = std::chrono::steady_clock::now();
+			uint64_t startCycles = readCycles();
+			for (long s = 0; s < numSamples; s++) {
+				patchInputs(module, patch, config, warmupSamples + s, sampleRate);
+				module->step();
+				outputSum += module->outputs.empty() ? 0.0f : module->outputs[0].value;
+			}
+			uint64_t endCycles = readCycles();
+			auto end = std::chrono::steady_clock::now();
+
+			double ns = std::chrono::duration<double, std::nano>(end - start).count();
+			printf("%-20s %-16s %12.2f %14.1f", model->slug.c_str(), config.name.c_str(), ns / numSamples, (double)(endCycles - startCycles) / numSamples);
+			printf("%s\n", outputSum != outputSum ? "  (NaN output)" : "");
+			delete widget;
+		}
+	}
+	return 0;
+}
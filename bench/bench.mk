@@ -0,0 +1,89 @@
+# Headless benchmark, see bench/bench.cpp
+# Builds the plugin sources against the Rack stand-in in bench/include, so no Rack SDK is needed:
+#   make bench
+#   ./bench/build/bench [-r sampleRate] [-s seconds] [slug ...]
+#   ./bench/build/render [-i file] [-midi file] [-check] [Foundry | Phrase-Seq-16]   (offline song render, see bench/render.cpp)
+#   make bench-check   (compares the output hashes with the golden files in bench/golden, per-sample and block paths,
+#                       checks Foundry's undo journal and lookahead, see bench -undo and -predict, and checks the
+#                       Phrase-Seq-16 song render against the module, see render -check)
+#   make bench-golden  (rewrites the golden files, see below)
+
+BENCH_DIR := bench
+BENCH_BUILD := $(BENCH_DIR)/build
+BENCH_FLAGS := -std=c++11 -O3 -march=nocona -funsafe-math-optimizations -fno-finite-math-only -Wall -Wno-unused-variable -Wno-format-truncation
+BENCH_FLAGS += -DSLUG=$(SLUG) -DVERSION=$(VERSION) -I$(BENCH_DIR)/include -Isrc
+BENCH_SOURCES := $(SOURCES) $(BENCH_DIR)/rackstub.cpp $(BENCH_DIR)/bench.cpp
+BENCH_OBJECTS := $(patsubst %.cpp, $(BENCH_BUILD)/obj/%.o, $(BENCH_SOURCES))
+RENDER_SOURCES := $(SOURCES) $(BENCH_DIR)/rackstub.cpp $(BENCH_DIR)/render.cpp $(BENCH_DIR)/renderfoundry.cpp $(BENCH_DIR)/renderphraseseq.cpp
+RENDER_OBJECTS := $(patsubst %.cpp, $(BENCH_BUILD)/obj/%.o, $(RENDER_SOURCES))
+
+bench: $(BENCH_BUILD)/bench $(BENCH_BUILD)/render
+
+$(BENCH_BUILD)/bench: $(BENCH_OBJECTS)
+	$(CXX) -o $@ $^ $(LDFLAGS)
+
+$(BENCH_BUILD)/render: $(RENDER_OBJECTS)
+	$(CXX) -o $@ $^ $(LDFLAGS)
+
+$(BENCH_BUILD)/obj/%.o: %.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(BENCH_FLAGS) $(FLAGS) $(CXXFLAGS) -MMD -MP -c -o $@ $<
+
+-include $(sort $(BENCH_OBJECTS:.o=.d) $(RENDER_OBJECTS:.o=.d))
+
+# Golden output hashes
+# The check build has its own objects without -funsafe-math-optimizations, so that the hashes only depend on the
+# source and not on how the compiler chooses to reassociate the float math of a given build.
+# Rebaselining rule: run make bench-golden only in a commit that changes the output on purpose, and say in its
+# message which modules' hashes changed and why; an optimization must pass make bench-check unchanged.
+CHECK_BUILD := $(BENCH_BUILD)/check
+CHECK_FLAGS := $(filter-out -funsafe-math-optimizations -fno-finite-math-only, $(BENCH_FLAGS))
+CHECK_OBJECTS := $(patsubst %.cpp, $(CHECK_BUILD)/obj/%.o, $(BENCH_SOURCES))
+GOLDEN_DIR := $(BENCH_DIR)/golden
+GOLDEN_RATES := 44100 48000 96000
+GOLDEN_SEEDS := 1 2
+GOLDEN_SECONDS := 2
+GOLDEN_BLOCK := 64
+
+$(CHECK_BUILD)/bench: $(CHECK_OBJECTS)
+	$(CXX) -o $@ $^ $(LDFLAGS)
+
+$(CHECK_BUILD)/obj/%.o: %.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(CHECK_FLAGS) $(FLAGS) $(CXXFLAGS) -MMD -MP -c -o $@ $<
+
+-include $(CHECK_OBJECTS:.o=.d)
+
+bench-check: $(CHECK_BUILD)/bench $(BENCH_BUILD)/render
+	@status=0; \
+	for rate in $(GOLDEN_RATES); do \
+		for seed in $(GOLDEN_SEEDS); do \
+			golden=$(GOLDEN_DIR)/hash-$$rate-$$seed.txt; \
+			$< -r $$rate -s $(GOLDEN_SECONDS) -seed $$seed -hash > $(CHECK_BUILD)/step.txt; \
+			$< -r $$rate -s $(GOLDEN_SECONDS) -seed $$seed -hash -block $(GOLDEN_BLOCK) > $(CHECK_BUILD)/block.txt; \
+			if diff -u $$golden $(CHECK_BUILD)/step.txt; then echo "$$golden: ok"; else status=1; fi; \
+			tail -n +2 $$golden > $(CHECK_BUILD)/golden.txt; \
+			tail -n +2 $(CHECK_BUILD)/block.txt > $(CHECK_BUILD)/blockhashes.txt; \
+			if diff -u $(CHECK_BUILD)/golden.txt $(CHECK_BUILD)/blockhashes.txt; then echo "$$golden (blocks of $(GOLDEN_BLOCK)): ok"; else status=1; fi; \
+		done; \
+	done; \
+	if $< -undo > $(CHECK_BUILD)/undo.txt; then echo "undo journal: ok"; else cat $(CHECK_BUILD)/undo.txt; status=1; fi; \
+	if $< -predict > $(CHECK_BUILD)/predict.txt; then echo "lookahead: ok"; else cat $(CHECK_BUILD)/predict.txt; status=1; fi; \
+	for pps in 1 4; do \
+		if $(BENCH_BUILD)/render -check -seed 2 -steps 300 -prob 0.5 -pps $$pps Phrase-Seq-16 > /dev/null 2> $(CHECK_BUILD)/render.txt; \
+		then echo "Phrase-Seq-16 render ($$pps pulses per step): ok"; else cat $(CHECK_BUILD)/render.txt; status=1; fi; \
+	done; \
+	exit $$status
+
+bench-golden: $(CHECK_BUILD)/bench
+	@mkdir -p $(GOLDEN_DIR)
+	@for rate in $(GOLDEN_RATES); do \
+		for seed in $(GOLDEN_SEEDS); do \
+			$< -r $$rate -s $(GOLDEN_SECONDS) -seed $$seed -hash > $(GOLDEN_DIR)/hash-$$rate-$$seed.txt; \
+		done; \
+	done
+
+bench-clean:
+	rm -rf $(BENCH_BUILD)
+
+.PHONY: bench bench-clean bench-check bench-golden
@@ -0,0 +1,98 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Same behaviour as Rack 0.6's dsp/digital.hpp (SchmittTrigger, PulseGenerator).
+//***********************************************************************************************
+
+#pragma once
+#include "rack.hpp"
+
+
+namespace rack {
+
+struct SchmittTrigger {
+	// UNKNOWN is included to handle cases where the input starts in between low and high
+	enum State {
+		UNKNOWN,
+		LOW,
+		HIGH
+	};
+	State state;
+	SchmittTrigger() {
+		reset();
+	}
+	void reset() {
+		state = UNKNOWN;
+	}
+	/** Returns true if triggered */
+	bool process(float in) {
+		switch (state) {
+			case LOW:
+				if (in >= 1.f) {
+					state = HIGH;
+					return true;
+				}
+				break;
+			case HIGH:
+				if (in <= 0.f) {
+					state = LOW;
+				}
+				break;
+			default:
+				if (in >= 1.f) {
+					state = HIGH;
+				}
+				else if (in <= 0.f) {
+					state = LOW;
+				}
+				break;
+		}
+		return false;
+	}
+	bool isHigh() {
+		return state == HIGH;
+	}
+};
+
+/** Detects when a boolean changes from false to true */
+struct BooleanTrigger {
+	bool lastState;
+	BooleanTrigger() {
+		reset();
+	}
+	void reset() {
+		lastState = true;
+	}
+	bool process(bool state) {
+		bool triggered = (state && !lastState);
+		lastState = state;
+		return triggered;
+	}
+};
+
+struct PulseGenerator {
+	float time = 0.f;
+	float triggerDuration = 0.f;
+	PulseGenerator() {
+		reset();
+	}
+	void reset() {
+		time = 0.f;
+		triggerDuration = 0.f;
+	}
+	/** Advances the state by `deltaTime`. Returns whether the pulse is in the HIGH state. */
+	bool process(float deltaTime) {
+		time += deltaTime;
+		return time < triggerDuration;
+	}
+	/** Begins a trigger with the given `triggerDuration`. */
+	void trigger(float triggerDuration) {
+		// Keep the previous triggerDuration if it's greater than the one being triggered
+		if (time + triggerDuration >= this->triggerDuration) {
+			time = 0.f;
+			this->triggerDuration = triggerDuration;
+		}
+	}
+};
+
+} // namespace rack
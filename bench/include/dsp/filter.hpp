@@ -0,0 +1,35 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Stand-in for Rack 0.6's dsp/filter.hpp.
+//***********************************************************************************************
+
+#pragma once
+#include "rack.hpp"
+
+
+namespace rack {
+
+struct RCFilter {
+	float c = 0.f;
+	float xstate[1] = {};
+	float ystate[1] = {};
+
+	// `r` is the ratio between the cutoff frequency and sample rate, i.e. r = f_c / f_s
+	void setCutoff(float r) {
+		c = 2.f / r;
+	}
+	void process(float x) {
+		float y = (x + xstate[0] - ystate[0] * (1 - c)) / (1 + c);
+		xstate[0] = x;
+		ystate[0] = y;
+	}
+	float lowpass() {
+		return ystate[0];
+	}
+	float highpass() {
+		return xstate[0] - ystate[0];
+	}
+};
+
+} // namespace rack
@@ -0,0 +1,36 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Stand-in for Rack 0.6's dsp/functions.hpp.
+//***********************************************************************************************
+
+#pragma once
+#include "rack.hpp"
+
+
+namespace rack {
+
+inline float sinc(float x) {
+	if (x == 0.f)
+		return 1.f;
+	x *= M_PI;
+	return sinf(x) / x;
+}
+
+inline float blackmanHarris(float p) {
+	return 0.35875f - 0.48829f * cosf(2 * M_PI * p) + 0.14128f * cosf(4 * M_PI * p) - 0.01168f * cosf(6 * M_PI * p);
+}
+
+inline void blackmanHarrisWindow(float *x, int n) {
+	for (int i = 0; i < n; i++)
+		x[i] *= blackmanHarris((float)i / (n - 1));
+}
+
+inline void boxcarLowpassIR(float *out, int len, float cutoff = 0.5f) {
+	for (int i = 0; i < len; i++) {
+		float t = i - (len - 1) / 2.f;
+		out[i] = 2 * cutoff * sinc(2 * cutoff * t);
+	}
+}
+
+} // namespace rack
@@ -0,0 +1,45 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Stand-in for Rack 0.6's dsp/ode.hpp.
+//***********************************************************************************************
+
+#pragma once
+
+
+namespace rack {
+namespace ode {
+
+/** Solves an ODE system using the 4th order Runge-Kutta method */
+template<typename T, typename F>
+void stepRK4(T t, T dt, T x[], int len, F f) {
+	T k1[len];
+	T k2[len];
+	T k3[len];
+	T k4[len];
+	T yi[len];
+
+	f(t, x, k1);
+
+	for (int i = 0; i < len; i++) {
+		yi[i] = x[i] + k1[i] * dt / 2.f;
+	}
+	f(t + dt / 2.f, yi, k2);
+
+	for (int i = 0; i < len; i++) {
+		yi[i] = x[i] + k2[i] * dt / 2.f;
+	}
+	f(t + dt / 2.f, yi, k3);
+
+	for (int i = 0; i < len; i++) {
+		yi[i] = x[i] + k3[i] * dt;
+	}
+	f(t + dt, yi, k4);
+
+	for (int i = 0; i < len; i++) {
+		x[i] += dt * (k1[i] + 2.f * k2[i] + 2.f * k3[i] + k4[i]) / 6.f;
+	}
+}
+
+} // namespace ode
+} // namespace rack
@@ -0,0 +1,601 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Thin stand-in for the parts of the VCV Rack 0.6 API used by this plugin. The engine side
+//(Module, Param, Input, Output, Light, engineGetSampleRate(), random) behaves like Rack's;
+//the widget side only has to compile and construct, it never draws anything.
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+#ifndef IM_BENCH_RACK_HPP
+#define IM_BENCH_RACK_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include "jansson.h"
+
+
+#define TOSTRING_(x) #x
+#define TOSTRING(x) TOSTRING_(x)
+
+#ifndef SLUG
+#define SLUG ImpromptuModular
+#endif
+#ifndef VERSION
+#define VERSION bench
+#endif
+
+#define ENUMS(name, count) name, name ## _LAST = name + (count) - 1
+
+#define CHECKMARK_STRING "\xE2\x9C\x94"
+#define CHECKMARK(_cond) ((_cond) ? CHECKMARK_STRING : "")
+#define RIGHT_ARROW "\xE2\x96\xB8"
+
+
+// NanoVG (drawing is a no-op)
+
+struct NVGcontext;
+struct NVGcolor {
+	float r, g, b, a;
+};
+inline NVGcolor nvgRGBAf(float r, float g, float b, float a) {return NVGcolor{r, g, b, a};}
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {return nvgRGBAf(r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f);}
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) {return nvgRGBA(r, g, b, 255);}
+inline NVGcolor nvgTransRGBA(NVGcolor c, unsigned char a) {c.a = a / 255.0f; return c;}
+inline void nvgBeginPath(NVGcontext *) {}
+inline void nvgRect(NVGcontext *, float, float, float, float) {}
+inline void nvgRoundedRect(NVGcontext *, float, float, float, float, float) {}
+inline void nvgCircle(NVGcontext *, float, float, float) {}
+inline void nvgMoveTo(NVGcontext *, float, float) {}
+inline void nvgLineTo(NVGcontext *, float, float) {}
+inline void nvgFill(NVGcontext *) {}
+inline void nvgFillColor(NVGcontext *, NVGcolor) {}
+inline void nvgStroke(NVGcontext *) {}
+inline void nvgStrokeColor(NVGcontext *, NVGcolor) {}
+inline void nvgStrokeWidth(NVGcontext *, float) {}
+inline void nvgFontSize(NVGcontext *, float) {}
+inline void nvgFontFaceId(NVGcontext *, int) {}
+inline void nvgTextLetterSpacing(NVGcontext *, float) {}
+inline float nvgText(NVGcontext *, float x, float, const char *, const char *) {return x;}
+
+
+namespace rack {
+
+
+// Math (util/math.hpp)
+
+inline int min(int a, int b) {return (a < b) ? a : b;}
+inline int max(int a, int b) {return (a > b) ? a : b;}
+inline int eucmod(int a, int base) {int mod = a % base; return (mod < 0) ? mod + base : mod;}
+inline int clamp(int x, int minimum, int maximum) {return min(max(x, minimum), maximum);}
+inline float min(float a, float b) {return (a < b) ? a : b;}
+inline float max(float a, float b) {return (a > b) ? a : b;}
+inline float clamp(float x, float minimum, float maximum) {return fminf(fmaxf(x, minimum), maximum);}
+inline float clamp2(float x, float a, float b) {return clamp(x, fminf(a, b), fmaxf(a, b));}
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) {return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin);}
+inline bool isNear(float a, float b, float epsilon = 1.0e-6f) {return fabsf(a - b) <= epsilon;}
+inline float crossfade(float a, float b, float frac) {return a + frac * (b - a);}
+inline float quadraticBipolar(float x) {float x2 = x*x; return (x >= 0.f) ? x2 : -x2;}
+inline float cubic(float x) {return x*x*x;}
+inline float interpolateLinear(const float *p, float x) {
+	int xi = x;
+	float xf = x - xi;
+	return crossfade(p[xi], p[xi + 1], xf);
+}
+
+struct Vec {
+	float x = 0.0f;
+	float y = 0.0f;
+	Vec() {}
+	Vec(float _x, float _y) : x(_x), y(_y) {}
+	Vec neg() const {return Vec(-x, -y);}
+	Vec plus(Vec b) const {return Vec(x + b.x, y + b.y);}
+	Vec minus(Vec b) const {return Vec(x - b.x, y - b.y);}
+	Vec mult(float s) const {return Vec(x * s, y * s);}
+	Vec mult(Vec b) const {return Vec(x * b.x, y * b.y);}
+	Vec div(float s) const {return Vec(x / s, y / s);}
+	Vec div(Vec b) const {return Vec(x / b.x, y / b.y);}
+	Vec round() const {return Vec(roundf(x), roundf(y));}
+};
+
+struct Rect {
+	Vec pos;
+	Vec size;
+	Vec getCenter() const {return pos.plus(size.mult(0.5f));}
+};
+
+inline Vec mm2px(Vec mm) {return mm.mult(75.0f / 25.4f);}
+
+static const float RACK_GRID_WIDTH = 15;
+static const float RACK_GRID_HEIGHT = 380;
+static const Vec RACK_GRID_SIZE = Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT);
+
+
+// Random (util/common.hpp), same xoroshiro128+ generator as Rack
+
+void randomInit();
+void randomSeed(uint64_t seed);
+uint32_t randomu32();
+uint64_t randomu64();
+float randomUniform();
+float randomNormal();
+
+
+// Engine (engine.hpp)
+
+struct Param {
+	float value = 0.0f;
+};
+
+struct Light {
+	float value = 0.0f;
+	void setBrightness(float brightness) {value = (brightness > 0.0f) ? brightness * brightness : 0.0f;}
+	void setBrightnessSmooth(float brightness, float frames = 1.0f) {setBrightness(brightness);}
+};
+
+struct Input {
+	float value = 0.0f;
+	bool active = false;
+	float normalize(float normalValue) {return active ? value : normalValue;}
+};
+
+struct Output {
+	float value = 0.0f;
+	bool active = false;
+};
+
+struct Module {
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	float cpuTime = 0.0f;
+
+	Module() {}
+	Module(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+		params.resize(numParams);
+		inputs.resize(numInputs);
+		outputs.resize(numOutputs);
+		lights.resize(numLights);
+	}
+	virtual ~Module() {}
+
+	virtual void step() {}
+	virtual void onSampleRateChange() {}
+	virtual void onCreate() {}
+	virtual void onDelete() {}
+	virtual void onReset() {}
+	virtual void onRandomize() {}
+	virtual json_t *toJson() {return NULL;}
+	virtual void fromJson(json_t *rootJ) {}
+	void reset() {onReset();}
+	void randomize() {onRandomize();}
+};
+
+float engineGetSampleRate();
+float engineGetSampleTime();
+void engineSetSampleRate(float sampleRate);
+
+
+// Widgets and events (widgets.hpp, app.hpp); these construct but never draw
+
+struct Widget;
+
+struct Event {
+	bool consumed = false;
+};
+struct EventPosition : Event {
+	Vec pos;
+};
+struct EventMouseDown : EventPosition {
+	int button = 0;
+	Widget *target = NULL;
+};
+struct EventMouseUp : EventPosition {
+	int button = 0;
+	Widget *target = NULL;
+};
+struct EventDragStart : Event {};
+struct EventDragEnd : Event {};
+struct EventDragMove : Event {
+	Vec mouseRel;
+};
+struct EventAction : Event {};
+struct EventChange : Event {};
+
+struct SVG {
+	std::string path;
+	static std::shared_ptr<SVG> load(const std::string &filename);
+};
+
+struct Font {
+	int handle = -1;
+	static std::shared_ptr<Font> load(const std::string &filename);
+};
+
+struct Widget {
+	Rect box;
+	Widget *parent = NULL;
+	std::list<Widget*> children;
+	bool visible = true;
+
+	virtual ~Widget();
+	void addChild(Widget *widget);
+	void removeChild(Widget *widget);
+	void clearChildren();
+	virtual void step();
+	virtual void draw(NVGcontext *vg);
+	virtual void onMouseDown(EventMouseDown &e) {}
+	virtual void onMouseUp(EventMouseUp &e) {}
+	virtual void onDragStart(EventDragStart &e) {}
+	virtual void onDragEnd(EventDragEnd &e) {}
+	virtual void onDragMove(EventDragMove &e) {}
+	virtual void onAction(EventAction &e) {}
+	virtual void onChange(EventChange &e) {}
+
+	template <typename T = Widget>
+	static T *create(Vec pos = Vec()) {
+		T *o = new T();
+		o->box.pos = pos;
+		return o;
+	}
+};
+
+struct TransparentWidget : virtual Widget {};
+struct OpaqueWidget : virtual Widget {};
+
+struct TransformWidget : virtual Widget {
+	void identity() {}
+	void translate(Vec delta) {}
+	void rotate(float angle) {}
+	void scale(Vec s) {}
+};
+
+struct FramebufferWidget : virtual Widget {
+	bool dirty = true;
+	float oversample = 1.0f;
+	void step() override {Widget::step();}
+};
+
+struct SVGWidget : virtual Widget {
+	std::shared_ptr<SVG> svg;
+	void wrap() {box.size = Vec(30, 30);}
+	void setSVG(std::shared_ptr<SVG> _svg) {svg = _svg; wrap();}
+};
+
+struct CircularShadow : TransparentWidget {
+	float blurRadius = 0.0f;
+	float opacity = 0.15f;
+};
+
+struct QuantityWidget : virtual Widget {
+	float value = 0.0f;
+	float minValue = 0.0f;
+	float maxValue = 1.0f;
+	float defaultValue = 0.0f;
+	void setValue(float _value) {value = clamp2(_value, minValue, maxValue); EventChange e; onChange(e);}
+	void setLimits(float _minValue, float _maxValue) {minValue = _minValue; maxValue = _maxValue;}
+	void setDefaultValue(float _defaultValue) {defaultValue = _defaultValue; setValue(_defaultValue);}// as in Rack, this sets the module's param
+};
+
+struct Module;
+struct ParamWidget : OpaqueWidget, QuantityWidget {
+	Module *module = NULL;
+	int paramId = 0;
+	bool randomizable = true;
+	bool smooth = false;
+	void onMouseDown(EventMouseDown &e) override {}
+	void onMouseUp(EventMouseUp &e) override {}
+	void onChange(EventChange &e) override;
+
+	template <typename T = ParamWidget>
+	static T *create(Vec pos, Module *module, int paramId, float minValue, float maxValue, float defaultValue) {
+		T *o = Widget::create<T>(pos);
+		o->module = module;
+		o->paramId = paramId;
+		o->setLimits(minValue, maxValue);
+		o->setDefaultValue(defaultValue);
+		return o;
+	}
+};
+
+struct Knob : ParamWidget {
+	bool snap = false;
+	float speed = 1.0f;
+	float dragValue = 0.0f;
+	void onDragStart(EventDragStart &e) override {}
+	void onDragMove(EventDragMove &e) override {}
+	void onDragEnd(EventDragEnd &e) override {}
+};
+
+struct SVGKnob : Knob, FramebufferWidget {
+	TransformWidget *tw;
+	SVGWidget *sw;
+	CircularShadow *shadow;
+	float minAngle = -M_PI;
+	float maxAngle = M_PI;
+	SVGKnob();
+	void setSVG(std::shared_ptr<SVG> svg) {sw->setSVG(svg); box.size = sw->box.size;}
+	void step() override {FramebufferWidget::step();}
+	void onChange(EventChange &e) override {dirty = true; Knob::onChange(e);}
+};
+
+struct SVGSwitch : virtual ParamWidget, FramebufferWidget {
+	std::vector<std::shared_ptr<SVG>> frames;
+	SVGWidget *sw;
+	SVGSwitch();
+	void addFrame(std::shared_ptr<SVG> svg) {frames.push_back(svg); if (!sw->svg) {sw->setSVG(svg); box.size = sw->box.size;}}
+	void onChange(EventChange &e) override {dirty = true; ParamWidget::onChange(e);}
+};
+
+struct ToggleSwitch : virtual ParamWidget {};
+struct MomentarySwitch : virtual ParamWidget {};
+
+struct Port : OpaqueWidget {
+	enum PortType {INPUT, OUTPUT};
+	Module *module = NULL;
+	PortType type = INPUT;
+	int portId = 0;
+	void step() override {Widget::step();}
+
+	template <typename T = Port>
+	static T *create(Vec pos, PortType type, Module *module, int portId) {
+		T *o = Widget::create<T>(pos);
+		o->type = type;
+		o->module = module;
+		o->portId = portId;
+		return o;
+	}
+};
+
+struct SVGPort : Port, FramebufferWidget {
+	SVGWidget *background;
+	CircularShadow *shadow;
+	SVGPort();
+	void setSVG(std::shared_ptr<SVG> svg) {background->setSVG(svg); box.size = background->box.size;}
+	void step() override {Port::step();}
+};
+
+struct SVGScrew : FramebufferWidget {
+	SVGWidget *sw;
+	SVGScrew();
+};
+
+struct LightWidget : TransparentWidget {
+	NVGcolor bgColor = nvgRGBAf(0, 0, 0, 0);
+	NVGcolor color = nvgRGBAf(0, 0, 0, 0);
+	NVGcolor borderColor = nvgRGBAf(0, 0, 0, 0);
+};
+
+struct MultiLightWidget : LightWidget {
+	std::vector<NVGcolor> baseColors;
+	void addBaseColor(NVGcolor baseColor) {baseColors.push_back(baseColor);}
+};
+
+struct ModuleLightWidget : MultiLightWidget {
+	Module *module = NULL;
+	int firstLightId = 0;
+
+	template <typename T = ModuleLightWidget>
+	static T *create(Vec pos, Module *module, int firstLightId) {
+		T *o = Widget::create<T>(pos);
+		o->module = module;
+		o->firstLightId = firstLightId;
+		return o;
+	}
+};
+
+static const NVGcolor COLOR_RED = nvgRGB(0xed, 0x2c, 0x24);
+static const NVGcolor COLOR_ORANGE = nvgRGB(0xf2, 0xb1, 0x20);
+static const NVGcolor COLOR_YELLOW = nvgRGB(0xf9, 0xdf, 0x1c);
+static const NVGcolor COLOR_GREEN = nvgRGB(0x90, 0xc7, 0x3e);
+static const NVGcolor COLOR_BLUE = nvgRGB(0x29, 0xb2, 0xef);
+static const NVGcolor COLOR_WHITE = nvgRGB(0xff, 0xff, 0xff);
+
+struct GrayModuleLightWidget : ModuleLightWidget {};
+struct RedLight : GrayModuleLightWidget {RedLight() {addBaseColor(COLOR_RED);}};
+struct GreenLight : GrayModuleLightWidget {GreenLight() {addBaseColor(COLOR_GREEN);}};
+struct YellowLight : GrayModuleLightWidget {YellowLight() {addBaseColor(COLOR_YELLOW);}};
+struct BlueLight : GrayModuleLightWidget {BlueLight() {addBaseColor(COLOR_BLUE);}};
+struct WhiteLight : GrayModuleLightWidget {WhiteLight() {addBaseColor(COLOR_WHITE);}};
+struct GreenRedLight : GrayModuleLightWidget {GreenRedLight() {addBaseColor(COLOR_GREEN); addBaseColor(COLOR_RED);}};
+
+template <typename BASE>
+struct LargeLight : BASE {LargeLight() {this->box.size = mm2px(Vec(5.179, 5.179));}};
+template <typename BASE>
+struct MediumLight : BASE {MediumLight() {this->box.size = mm2px(Vec(3.176, 3.176));}};
+template <typename BASE>
+struct SmallLight : BASE {SmallLight() {this->box.size = mm2px(Vec(2.176, 2.176));}};
+template <typename BASE>
+struct TinyLight : BASE {TinyLight() {this->box.size = mm2px(Vec(1.088, 1.088));}};
+
+struct LEDButton : SVGSwitch, MomentarySwitch {};
+struct LEDBezel : SVGSwitch, MomentarySwitch {};
+struct CKSS : SVGSwitch, ToggleSwitch {};
+struct CKSSThree : SVGSwitch, ToggleSwitch {};
+
+struct Menu : OpaqueWidget {};
+struct MenuEntry : OpaqueWidget {
+	std::string text;
+};
+struct MenuLabel : MenuEntry {};
+struct MenuItem : MenuEntry {
+	std::string rightText;
+	virtual Menu *createChildMenu() {return NULL;}
+	template <typename T = MenuItem>
+	static T *create(std::string text, std::string rightText = "") {
+		T *o = new T();
+		o->text = text;
+		o->rightText = rightText;
+		return o;
+	}
+};
+
+struct Model;
+struct ModuleWidget : OpaqueWidget {
+	Model *model = NULL;
+	Module *module = NULL;
+	std::vector<Port*> inputs;
+	std::vector<Port*> outputs;
+	std::vector<ParamWidget*> params;
+
+	ModuleWidget(Module *_module) {module = _module;}
+	~ModuleWidget();
+	void addInput(Port *input) {inputs.push_back(input); addChild(input);}
+	void addOutput(Port *output) {outputs.push_back(output); addChild(output);}
+	void addParam(ParamWidget *param) {params.push_back(param); addChild(param);}
+	virtual Menu *createContextMenu() {return new Menu();}
+};
+
+struct WireContainer : TransparentWidget {
+	void removeAllWires(Port *port) {}
+};
+
+struct RackWidget : OpaqueWidget {
+	WireContainer *wireContainer;
+	Vec lastMousePos;
+	RackWidget() {wireContainer = new WireContainer(); addChild(wireContainer);}
+};
+
+extern RackWidget *gRackWidget;
+extern float gPixelRatio;
+
+
+// Plugin (plugin.hpp)
+
+enum ModelTag {
+	NO_TAG, AMPLIFIER_TAG, ATTENUATOR_TAG, BLANK_TAG, CLOCK_TAG, CONTROLLER_TAG, DELAY_TAG, DIGITAL_TAG, DISTORTION_TAG,
+	DRUM_TAG, DUAL_TAG, DYNAMICS_TAG, EFFECT_TAG, ENVELOPE_FOLLOWER_TAG, ENVELOPE_GENERATOR_TAG, EQUALIZER_TAG,
+	EXTERNAL_TAG, FILTER_TAG, FUNCTION_GENERATOR_TAG, GRANULAR_TAG, LFO_TAG, LOGIC_TAG, LOW_PASS_GATE_TAG, MIDI_TAG,
+	MIXER_TAG, MULTIPLE_TAG, NOISE_TAG, OSCILLATOR_TAG, PANNING_TAG, QUAD_TAG, QUANTIZER_TAG, RANDOM_TAG, RECORDING_TAG,
+	REVERB_TAG, RING_MODULATOR_TAG, SAMPLE_AND_HOLD_TAG, SAMPLER_TAG, SEQUENCER_TAG, SLEW_LIMITER_TAG, SWITCH_TAG,
+	SYNTH_VOICE_TAG, TUNER_TAG, UTILITY_TAG, VISUAL_TAG, VOCODER_TAG, WAVESHAPER_TAG, NUM_TAGS
+};
+
+struct Plugin;
+struct Model {
+	Plugin *plugin = NULL;
+	std::string slug;
+	std::string name;
+	std::string author;
+	std::list<ModelTag> tags;
+
+	virtual ~Model() {}
+	virtual Module *createModule() {return NULL;}
+	virtual ModuleWidget *createModuleWidget() {return NULL;}
+	virtual ModuleWidget *createModuleWidgetNull() {return NULL;}
+
+	template <typename TModule, typename TModuleWidget, typename... Tags>
+	static Model *create(std::string author, std::string slug, std::string name, Tags... tags) {
+		struct TModel : Model {
+			Module *createModule() override {
+				return new TModule();
+			}
+			ModuleWidget *createModuleWidget() override {
+				TModule *module = new TModule();
+				TModuleWidget *moduleWidget = new TModuleWidget(module);
+				moduleWidget->model = this;
+				return moduleWidget;
+			}
+		};
+		TModel *o = new TModel();
+		o->author = author;
+		o->slug = slug;
+		o->name = name;
+		o->tags = {tags...};
+		return o;
+	}
+};
+
+struct Plugin {
+	std::list<Model*> models;
+	std::string path;
+	std::string slug;
+	std::string version;
+	void addModel(Model *model) {model->plugin = this; models.push_back(model);}
+};
+
+std::string assetGlobal(std::string filename);
+std::string assetPlugin(Plugin *plugin, std::string filename);
+
+
+// Helpers (helpers.hpp)
+
+template <class TWidget>
+TWidget *createWidget(Vec pos) {
+	TWidget *o = new TWidget();
+	o->box.pos = pos;
+	return o;
+}
+
+template <class TParamWidget>
+TParamWidget *createParam(Vec pos, Module *module, int paramId, float minValue, float maxValue, float defaultValue) {
+	TParamWidget *o = new TParamWidget();
+	o->box.pos = pos;
+	o->module = module;
+	o->paramId = paramId;
+	o->setLimits(minValue, maxValue);
+	o->setDefaultValue(defaultValue);
+	return o;
+}
+
+template <class TParamWidget>
+TParamWidget *createParamCentered(Vec pos, Module *module, int paramId, float minValue, float maxValue, float defaultValue) {
+	TParamWidget *o = createParam<TParamWidget>(pos, module, paramId, minValue, maxValue, defaultValue);
+	o->box.pos = o->box.pos.minus(o->box.size.div(2));
+	return o;
+}
+
+template <class TPort>
+TPort *createInput(Vec pos, Module *module, int inputId) {
+	TPort *o = new TPort();
+	o->box.pos = pos;
+	o->module = module;
+	o->type = Port::INPUT;
+	o->portId = inputId;
+	return o;
+}
+
+template <class TPort>
+TPort *createOutput(Vec pos, Module *module, int outputId) {
+	TPort *o = new TPort();
+	o->box.pos = pos;
+	o->module = module;
+	o->type = Port::OUTPUT;
+	o->portId = outputId;
+	return o;
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget *createLight(Vec pos, Module *module, int firstLightId) {
+	TModuleLightWidget *o = new TModuleLightWidget();
+	o->box.pos = pos;
+	o->module = module;
+	o->firstLightId = firstLightId;
+	return o;
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget *createLightCentered(Vec pos, Module *module, int firstLightId) {
+	TModuleLightWidget *o = createLight<TModuleLightWidget>(pos, module, firstLightId);
+	o->box.pos = o->box.pos.minus(o->box.size.div(2));
+	return o;
+}
+
+
+} // namespace rack
+
+
+// The plugin's entry point and instance, see ImpromptuModular.cpp
+void init(rack::Plugin *p);
+
+
+#endif
@@ -0,0 +1,8 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Stand-in for Rack's window.hpp, nothing is ever drawn in the bench.
+//***********************************************************************************************
+
+#pragma once
+#include "rack.hpp"
@@ -0,0 +1,538 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Implementation of the Rack and jansson stand-ins declared in bench/include.
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+
+#include <map>
+#include "rack.hpp"
+#include "dsp/digital.hpp"
+
+
+namespace rack {
+
+
+// Random (xoroshiro128+, as in Rack's util/random.cpp)
+
+static uint64_t xoroshiro128plus_state[2] = {};
+
+static uint64_t rotl(const uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t xoroshiro128plus_next(void) {
+	const uint64_t s0 = xoroshiro128plus_state[0];
+	uint64_t s1 = xoroshiro128plus_state[1];
+	const uint64_t result = s0 + s1;
+
+	s1 ^= s0;
+	xoroshiro128plus_state[0] = rotl(s0, 55) ^ s1 ^ (s1 << 14);
+	xoroshiro128plus_state[1] = rotl(s1, 36);
+
+	return result;
+}
+
+void randomSeed(uint64_t seed) {
+	xoroshiro128plus_state[0] = seed ^ 0x9E3779B97F4A7C15ULL;
+	xoroshiro128plus_state[1] = (seed << 1) ^ 0xBF58476D1CE4E5B9ULL;
+	// Shift state a few times due to low seed entropy
+	for (int i = 0; i < 50; i++) {
+		xoroshiro128plus_next();
+	}
+}
+
+void randomInit() {
+	randomSeed(1);
+}
+
+uint32_t randomu32() {
+	return xoroshiro128plus_next() >> 32;
+}
+
+uint64_t randomu64() {
+	return xoroshiro128plus_next();
+}
+
+float randomUniform() {
+	// 24 bits of granularity is the best that can be done with floats while ensuring that the return value lies in [0.0, 1.0).
+	return (xoroshiro128plus_next() >> (64 - 24)) / powf(2, 24);
+}
+
+float randomNormal() {
+	// Box-Muller transform
+	float radius = sqrtf(-2.f * logf(1.f - randomUniform()));
+	float theta = 2.f * M_PI * randomUniform();
+	return radius * sinf(theta);
+}
+
+
+// Engine
+
+static float sampleRate = 44100.0f;
+static float sampleTime = 1.0f / 44100.0f;
+
+float engineGetSampleRate() {
+	return sampleRate;
+}
+
+float engineGetSampleTime() {
+	return sampleTime;
+}
+
+void engineSetSampleRate(float newSampleRate) {
+	sampleRate = newSampleRate;
+	sampleTime = 1.0f / newSampleRate;
+}
+
+
+// Widgets
+
+RackWidget *gRackWidget = NULL;
+float gPixelRatio = 1.0f;
+
+std::shared_ptr<SVG> SVG::load(const std::string &filename) {
+	std::shared_ptr<SVG> svg = std::make_shared<SVG>();
+	svg->path = filename;
+	return svg;
+}
+
+std::shared_ptr<Font> Font::load(const std::string &filename) {
+	return std::make_shared<Font>();
+}
+
+Widget::~Widget() {
+	clearChildren();
+}
+
+void Widget::addChild(Widget *widget) {
+	widget->parent = this;
+	children.push_back(widget);
+}
+
+void Widget::removeChild(Widget *widget) {
+	widget->parent = NULL;
+	children.remove(widget);
+}
+
+void Widget::clearChildren() {
+	for (Widget *child : children) {
+		child->parent = NULL;
+		delete child;
+	}
+	children.clear();
+}
+
+void Widget::step() {
+	for (Widget *child : children) {
+		child->step();
+	}
+}
+
+void Widget::draw(NVGcontext *vg) {}
+
+void ParamWidget::onChange(EventChange &e) {
+	if (module)
+		module->params[paramId].value = value;
+}
+
+SVGKnob::SVGKnob() {
+	shadow = new CircularShadow();
+	addChild(shadow);
+	tw = new TransformWidget();
+	addChild(tw);
+	sw = new SVGWidget();
+	tw->addChild(sw);
+}
+
+SVGSwitch::SVGSwitch() {
+	sw = new SVGWidget();
+	addChild(sw);
+}
+
+SVGPort::SVGPort() {
+	shadow = new CircularShadow();
+	addChild(shadow);
+	background = new SVGWidget();
+	addChild(background);
+}
+
+SVGScrew::SVGScrew() {
+	sw = new SVGWidget();
+	addChild(sw);
+}
+
+ModuleWidget::~ModuleWidget() {
+	delete module;
+}
+
+
+// Assets
+
+std::string assetGlobal(std::string filename) {
+	return "res/Rack/" + filename;
+}
+
+std::string assetPlugin(Plugin *plugin, std::string filename) {
+	return plugin->path + "/" + filename;
+}
+
+
+} // namespace rack
+
+
+
+// jansson subset
+
+struct json_t {
+	json_type type;
+	int refcount = 1;
+	json_int_t integer = 0;
+	double real = 0.0;
+	std::string str;
+	std::vector<json_t*> array;
+	std::vector<std::pair<std::string, json_t*>> object;// insertion order like jansson's dumps with JSON_PRESERVE_ORDER
+
+	json_t(json_type _type) : type(_type) {}
+};
+
+static json_t *json_new(json_type type) {
+	return new json_t(type);
+}
+
+json_t *json_object() {return json_new(JSON_OBJECT);}
+json_t *json_array() {return json_new(JSON_ARRAY);}
+json_t *json_string(const char *value) {
+	if (!value)
+		return NULL;
+	json_t *json = json_new(JSON_STRING);
+	json->str = value;
+	return json;
+}
+json_t *json_integer(json_int_t value) {
+	json_t *json = json_new(JSON_INTEGER);
+	json->integer = value;
+	return json;
+}
+json_t *json_real(double value) {
+	json_t *json = json_new(JSON_REAL);
+	json->real = value;
+	return json;
+}
+json_t *json_true() {return json_new(JSON_TRUE);}
+json_t *json_false() {return json_new(JSON_FALSE);}
+json_t *json_null() {return json_new(JSON_NULL);}
+
+json_t *json_incref(json_t *json) {
+	if (json)
+		json->refcount++;
+	return json;
+}
+
+void json_decref(json_t *json) {
+	if (!json || --json->refcount > 0)
+		return;
+	for (json_t *child : json->array)
+		json_decref(child);
+	for (auto &member : json->object)
+		json_decref(member.second);
+	delete json;
+}
+
+json_type json_typeof(const json_t *json) {
+	return json->type;
+}
+
+json_int_t json_integer_value(const json_t *json) {
+	return (json && json->type == JSON_INTEGER) ? json->integer : 0;
+}
+
+double json_real_value(const json_t *json) {
+	return (json && json->type == JSON_REAL) ? json->real : 0.0;
+}
+
+double json_number_value(const json_t *json) {
+	if (!json)
+		return 0.0;
+	if (json->type == JSON_INTEGER)
+		return (double)json->integer;
+	if (json->type == JSON_REAL)
+		return json->real;
+	return 0.0;
+}
+
+const char *json_string_value(const json_t *json) {
+	return (json && json->type == JSON_STRING) ? json->str.c_str() : NULL;
+}
+
+int json_object_set_new(json_t *object, const char *key, json_t *value) {
+	if (!value)
+		return -1;
+	if (!json_is_object(object) || !key) {
+		json_decref(value);
+		return -1;
+	}
+	for (auto &member : object->object) {
+		if (member.first == key) {
+			json_decref(member.second);
+			member.second = value;
+			return 0;
+		}
+	}
+	object->object.push_back(std::make_pair(std::string(key), value));
+	return 0;
+}
+
+json_t *json_object_get(const json_t *object, const char *key) {
+	if (!json_is_object(object) || !key)
+		return NULL;
+	for (auto &member : object->object) {
+		if (member.first == key)
+			return member.second;
+	}
+	return NULL;
+}
+
+size_t json_object_size(const json_t *object) {
+	return json_is_object(object) ? object->object.size() : 0;
+}
+
+size_t json_array_size(const json_t *array) {
+	return json_is_array(array) ? array->array.size() : 0;
+}
+
+json_t *json_array_get(const json_t *array, size_t index) {
+	if (!json_is_array(array) || index >= array->array.size())
+		return NULL;
+	return array->array[index];
+}
+
+int json_array_append_new(json_t *array, json_t *value) {
+	if (!value)
+		return -1;
+	if (!json_is_array(array)) {
+		json_decref(value);
+		return -1;
+	}
+	array->array.push_back(value);
+	return 0;
+}
+
+int json_array_insert_new(json_t *array, size_t index, json_t *value) {
+	if (!value)
+		return -1;
+	if (!json_is_array(array) || index > array->array.size()) {
+		json_decref(value);
+		return -1;
+	}
+	array->array.insert(array->array.begin() + index, value);
+	return 0;
+}
+
+
+// Serialization
+
+static void json_dump_string(const std::string &s, std::string &out) {
+	out += '"';
+	for (char c : s) {
+		switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default: out += c;
+		}
+	}
+	out += '"';
+}
+
+static void json_dump(const json_t *json, std::string &out) {
+	char buf[64];
+	switch (json->type) {
+		case JSON_OBJECT:
+			out += '{';
+			for (size_t i = 0; i < json->object.size(); i++) {
+				if (i > 0)
+					out += ',';
+				json_dump_string(json->object[i].first, out);
+				out += ':';
+				json_dump(json->object[i].second, out);
+			}
+			out += '}';
+			break;
+		case JSON_ARRAY:
+			out += '[';
+			for (size_t i = 0; i < json->array.size(); i++) {
+				if (i > 0)
+					out += ',';
+				json_dump(json->array[i], out);
+			}
+			out += ']';
+			break;
+		case JSON_STRING:
+			json_dump_string(json->str, out);
+			break;
+		case JSON_INTEGER:
+			snprintf(buf, sizeof(buf), "%lld", json->integer);
+			out += buf;
+			break;
+		case JSON_REAL:
+			snprintf(buf, sizeof(buf), "%.17g", json->real);
+			if (!strpbrk(buf, ".eE"))
+				strcat(buf, ".0");
+			out += buf;
+			break;
+		case JSON_TRUE: out += "true"; break;
+		case JSON_FALSE: out += "false"; break;
+		case JSON_NULL: out += "null"; break;
+	}
+}
+
+char *json_dumps(const json_t *json, size_t flags) {
+	if (!json)
+		return NULL;
+	std::string out;
+	json_dump(json, out);
+	return strdup(out.c_str());
+}
+
+static void json_skip_ws(const char *&p) {
+	while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+		p++;
+}
+
+static bool json_parse_string(const char *&p, std::string &out) {
+	if (*p != '"')
+		return false;
+	p++;
+	while (*p && *p != '"') {
+		if (*p == '\\') {
+			p++;
+			switch (*p) {
+				case 'n': out += '\n'; break;
+				case 't': out += '\t'; break;
+				case '\0': return false;
+				default: out += *p;
+			}
+		}
+		else
+			out += *p;
+		p++;
+	}
+	if (*p != '"')
+		return false;
+	p++;
+	return true;
+}
+
+static json_t *json_parse(const char *&p) {
+	json_skip_ws(p);
+	if (*p == '{') {
+		p++;
+		json_t *object = json_object();
+		json_skip_ws(p);
+		if (*p == '}') {
+			p++;
+			return object;
+		}
+		while (true) {
+			std::string key;
+			json_skip_ws(p);
+			if (!json_parse_string(p, key))
+				break;
+			json_skip_ws(p);
+			if (*p++ != ':')
+				break;
+			json_t *value = json_parse(p);
+			if (!value)
+				break;
+			json_object_set_new(object, key.c_str(), value);
+			json_skip_ws(p);
+			if (*p == ',') {
+				p++;
+				continue;
+			}
+			if (*p == '}') {
+				p++;
+				return object;
+			}
+			break;
+		}
+		json_decref(object);
+		return NULL;
+	}
+	if (*p == '[') {
+		p++;
+		json_t *array = json_array();
+		json_skip_ws(p);
+		if (*p == ']') {
+			p++;
+			return array;
+		}
+		while (true) {
+			json_t *value = json_parse(p);
+			if (!value)
+				break;
+			json_array_append_new(array, value);
+			json_skip_ws(p);
+			if (*p == ',') {
+				p++;
+				continue;
+			}
+			if (*p == ']') {
+				p++;
+				return array;
+			}
+			break;
+		}
+		json_decref(array);
+		return NULL;
+	}
+	if (*p == '"') {
+		std::string str;
+		if (!json_parse_string(p, str))
+			return NULL;
+		return json_string(str.c_str());
+	}
+	if (strncmp(p, "true", 4) == 0) {
+		p += 4;
+		return json_true();
+	}
+	if (strncmp(p, "false", 5) == 0) {
+		p += 5;
+		return json_false();
+	}
+	if (strncmp(p, "null", 4) == 0) {
+		p += 4;
+		return json_null();
+	}
+	const char *start = p;
+	if (*p == '-')
+		p++;
+	while ((*p >= '0' && *p <= '9'))
+		p++;
+	bool isReal = (*p == '.' || *p == 'e' || *p == 'E');
+	if (p == start)
+		return NULL;
+	if (isReal) {
+		char *end;
+		double value = strtod(start, &end);
+		p = end;
+		return json_real(value);
+	}
+	return json_integer(strtoll(start, NULL, 10));
+}
+
+json_t *json_loads(const char *input, size_t flags, void *error) {
+	if (!input)
+		return NULL;
+	const char *p = input;
+	json_t *json = json_parse(p);
+	json_skip_ws(p);
+	if (json && *p != '\0') {
+		json_decref(json);
+		return NULL;
+	}
+	return json;
+}
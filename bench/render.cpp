@@ -0,0 +1,307 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Offline song render: plays a Foundry or Phrase-Seq-16 song at clock rate (one clock edge per pulse, no
+//samples) and dumps the changes of the outputs as CSV or as a standard MIDI file, so that long songs
+//can be checked and diffed far faster than real time.
+//
+//Usage: render [-i file] [-seed n] [-steps n] [-prob p] [-slide s] [-pps n] [-ppqn n] [-bpm n] [-midi file] [-check] [slug]
+//  slug: Foundry (default) or Phrase-Seq-16
+//  -i: module or patch file to read the song from (the module's "data" object, or the first module of the
+//      given slug in the "modules" of a patch); without it, the song is the module's randomized content from
+//      the given seed, as in the bench
+//  -steps: number of steps to render (default is one forward pass of the song, see render.hpp)
+//  -prob: gate 1 probability knob of Phrase-Seq-16 (default 1.0)
+//  -slide: slide knob of Phrase-Seq-16 (default 0.2)
+//  -pps: pulses per step of Phrase-Seq-16 (1 or an even number up to 24), instead of the one saved with the song
+//  -ppqn, -bpm: clock pulses per quarter note (default 4) and tempo (default 120), for the MIDI file only
+//  -midi: write a MIDI file (format 0, one channel per track) instead of CSV on stdout
+//  -check: Phrase-Seq-16 only, play the same song on the module itself one sample at a time and compare its outputs
+//      with the render (see checkPhraseSeq16()), exits with 1 on the first difference
+//The render time (in microseconds) is reported on stderr.
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include "ImpromptuModular.hpp"
+#include "render.hpp"
+
+
+using namespace rack;
+
+
+static json_t *findModuleData(json_t *rootJ, const std::string &slug) {
+	json_t *modulesJ = json_object_get(rootJ, "modules");
+	if (modulesJ) {// patch
+		for (size_t i = 0; i < json_array_size(modulesJ); i++) {
+			json_t *moduleJ = json_array_get(modulesJ, i);
+			json_t *modelJ = json_object_get(moduleJ, "model");
+			if (modelJ && slug == json_string_value(modelJ))
+				return json_object_get(moduleJ, "data");
+		}
+		return NULL;
+	}
+	json_t *dataJ = json_object_get(rootJ, "data");// module or preset
+	return dataJ ? dataJ : rootJ;
+}
+
+
+// Plays the song on the module itself, one sample at a time, with a square clock of CHECK_PULSE_SAMPLES samples per pulse
+// and the reset on its first edge, and compares the gate and CV outputs with the render. The outputs are read on each
+// clock edge and three quarters into the pulse (after the 10 ms trigger gates have ended), that is at the times of the render's
+// half pulses. The render must be made with the slide knob at 0, so that the CV output is the step CV.
+static const long CHECK_PULSE_SAMPLES = 2000;
+
+static bool checkPhraseSeq16(Model *model, json_t *rootJ, long pulses, float gate1Prob, const RenderSink &render) {
+	enum {EDIT_PARAM = 3, SLIDE_KNOB_PARAM = 19, GATE1_KNOB_PARAM = 42};// see PhraseSeq16::ParamIds
+	enum {RESET_INPUT = 2, CLOCK_INPUT = 3};// see PhraseSeq16::InputIds
+	enum {CV_OUTPUT, GATE1_OUTPUT, GATE2_OUTPUT};// see PhraseSeq16::OutputIds
+
+	engineSetSampleRate(44100.0f);
+	ModuleWidget *widget = model->createModuleWidget();
+	Module *module = widget->module;
+	module->params[EDIT_PARAM].value = 0.0f;// song
+	module->params[GATE1_KNOB_PARAM].value = gate1Prob;
+	module->params[SLIDE_KNOB_PARAM].value = 0.0f;
+	module->onSampleRateChange();
+	json_object_set_new(rootJ, "running", json_true());
+	module->fromJson(rootJ);
+	module->inputs[RESET_INPUT].active = true;
+	module->inputs[CLOCK_INPUT].active = true;
+
+	RenderSink played;
+	played.reset(2);
+	module->step();// inputs low, so that the first clock edge and the reset are seen as edges
+	for (long p = 0; p < pulses; p++) {
+		for (long i = 0; i < CHECK_PULSE_SAMPLES; i++) {
+			bool high = i < CHECK_PULSE_SAMPLES / 2;
+			module->inputs[CLOCK_INPUT].value = high ? 10.0f : 0.0f;
+			module->inputs[RESET_INPUT].value = (p == 0 && high) ? 10.0f : 0.0f;
+			module->step();
+			if (i == 0 || i == CHECK_PULSE_SAMPLES * 3 / 4) {
+				uint32_t time = (uint32_t)(p * 2 + (i == 0 ? 0 : 1));
+				float cv = module->outputs[CV_OUTPUT].value;
+				played.put(time, 0, module->outputs[GATE1_OUTPUT].value > 5.0f, cv, 100, 0);
+				played.put(time, 1, module->outputs[GATE2_OUTPUT].value > 5.0f, cv, 100, 0);
+			}
+		}
+	}
+	played.end((uint32_t)(pulses * 2));
+	delete widget;
+
+	size_t count = std::max(render.events.size(), played.events.size());
+	for (size_t i = 0; i < count; i++) {
+		if (i >= render.events.size() || i >= played.events.size()) {
+			fprintf(stderr, "Render check: %zu events rendered, %zu played\n", render.events.size(), played.events.size());
+			return false;
+		}
+		const RenderEvent &r = render.events[i];
+		const RenderEvent &m = played.events[i];
+		if (r.time != m.time || r.track != m.track || r.gate != m.gate || r.cv != m.cv || r.velocity != m.velocity || r.slide != m.slide) {
+			fprintf(stderr, "Render check: event %zu differs, rendered %.1f,%d,%d,%.6f, played %.1f,%d,%d,%.6f\n", i,
+				r.time * 0.5f, r.track, r.gate, r.cv, m.time * 0.5f, m.track, m.gate, m.cv);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static void writeCsv(const RenderSink &sink) {
+	printf("time,track,gate,cv,velocity,slide\n");
+	for (const RenderEvent &event : sink.events)
+		printf("%.1f,%d,%d,%.6f,%d,%d\n", event.time * 0.5f, event.track, event.gate, event.cv, event.velocity, event.slide);
+}
+
+
+static void putVarLen(std::string &bytes, uint32_t value) {
+	uint8_t groups[5];
+	int n = 0;
+	do {
+		groups[n++] = value & 0x7F;
+		value >>= 7;
+	} while (value != 0);
+	while (n > 1)
+		bytes.push_back((char)(groups[--n] | 0x80));
+	bytes.push_back((char)groups[0]);
+}
+
+static void putBigEndian(std::string &bytes, uint32_t value, int numBytes) {
+	for (int i = numBytes - 1; i >= 0; i--)
+		bytes.push_back((char)((value >> (i * 8)) & 0xFF));
+}
+
+// Notes are the CVs rounded to semitones (0V is middle C), a note starts on a gate rise or on a new note while the gate is high.
+// Slides are sent as portamento (CC 65) on the note's channel.
+static bool writeMidi(const RenderSink &sink, const char *path, int ppqn, float bpm) {
+	std::string trackBytes;
+	uint32_t lastTime = 0;
+	auto putEvent = [&](uint32_t time, uint8_t status, uint8_t data1, uint8_t data2) {
+		putVarLen(trackBytes, time - lastTime);
+		lastTime = time;
+		trackBytes.push_back((char)status);
+		trackBytes.push_back((char)data1);
+		trackBytes.push_back((char)data2);
+	};
+
+	// tempo
+	putVarLen(trackBytes, 0);
+	trackBytes.append("\xFF\x51\x03", 3);
+	putBigEndian(trackBytes, (uint32_t)(60000000.0f / bpm + 0.5f), 3);
+
+	int notes[RenderSink::MAX_TRACKS];
+	bool slides[RenderSink::MAX_TRACKS];
+	for (int t = 0; t < RenderSink::MAX_TRACKS; t++) {
+		notes[t] = -1;
+		slides[t] = false;
+	}
+	for (const RenderEvent &event : sink.events) {
+		uint8_t channel = event.track & 0x0F;
+		int note = clamp((int)roundf(event.cv * 12.0f) + 60, 0, 127);
+		if (notes[event.track] != -1 && (!event.gate || note != notes[event.track])) {
+			putEvent(event.time, 0x80 | channel, notes[event.track], 0);
+			notes[event.track] = -1;
+		}
+		if (event.gate && notes[event.track] == -1) {
+			bool slide = event.slide != 0;
+			if (slide != slides[event.track]) {
+				putEvent(event.time, 0xB0 | channel, 65, slide ? 127 : 0);
+				slides[event.track] = slide;
+			}
+			putEvent(event.time, 0x90 | channel, note, max((int)event.velocity, 1));// velocity 0 would be a note off
+			notes[event.track] = note;
+		}
+	}
+	putVarLen(trackBytes, 0);
+	trackBytes.append("\xFF\x2F\x00", 3);// end of track
+
+	std::string bytes("MThd", 4);
+	putBigEndian(bytes, 6, 4);
+	putBigEndian(bytes, 0, 2);// format 0
+	putBigEndian(bytes, 1, 2);// one track
+	putBigEndian(bytes, ppqn * 2, 2);// ticks per quarter note, event times are in half pulses
+	bytes.append("MTrk", 4);
+	putBigEndian(bytes, trackBytes.size(), 4);
+	bytes += trackBytes;
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(bytes.data(), bytes.size());
+	return file.good();
+}
+
+
+int main(int argc, char **argv) {
+	std::string slug = "Foundry";
+	std::string inPath;
+	std::string midiPath;
+	uint64_t seed = 1;
+	long steps = 0;
+	float gate1Prob = 1.0f;
+	float slideKnob = 0.2f;
+	int pulsesPerStep = 0;
+	bool check = false;
+	int ppqn = 4;
+	float bpm = 120.0f;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-i" && i + 1 < argc)
+			inPath = argv[++i];
+		else if (arg == "-seed" && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 10);
+		else if (arg == "-steps" && i + 1 < argc)
+			steps = atol(argv[++i]);
+		else if (arg == "-prob" && i + 1 < argc)
+			gate1Prob = atof(argv[++i]);
+		else if (arg == "-slide" && i + 1 < argc)
+			slideKnob = clamp((float)atof(argv[++i]), 0.0f, 2.0f);
+		else if (arg == "-pps" && i + 1 < argc)
+			pulsesPerStep = clamp(atoi(argv[++i]), 1, 24);
+		else if (arg == "-ppqn" && i + 1 < argc)
+			ppqn = clamp(atoi(argv[++i]), 1, 16383);
+		else if (arg == "-bpm" && i + 1 < argc)
+			bpm = clamp((float)atof(argv[++i]), 1.0f, 1000.0f);
+		else if (arg == "-midi" && i + 1 < argc)
+			midiPath = argv[++i];
+		else if (arg == "-check")
+			check = true;
+		else if (arg == "-h" || arg == "--help") {
+			printf("Usage: %s [-i file] [-seed n] [-steps n] [-prob p] [-slide s] [-pps n] [-ppqn n] [-bpm n] [-midi file] [-check] [Foundry | Phrase-Seq-16]\n", argv[0]);
+			return 0;
+		}
+		else
+			slug = arg;
+	}
+	if (slug != "Foundry" && slug != "Phrase-Seq-16") {
+		fprintf(stderr, "No song render for %s\n", slug.c_str());
+		return 1;
+	}
+	if (check && slug != "Phrase-Seq-16") {
+		fprintf(stderr, "No render check for %s (its render runs the module's own SequencerKernel)\n", slug.c_str());
+		return 1;
+	}
+
+	randomInit();
+	Plugin *p = new Plugin();
+	p->path = ".";
+	init(p);
+	Model *model = NULL;
+	for (Model *m : p->models) {
+		if (m->slug == slug)
+			model = m;
+	}
+
+	// song
+	json_t *rootJ = NULL;
+	json_t *dataJ = NULL;
+	if (!inPath.empty()) {
+		std::ifstream file(inPath);
+		std::stringstream text;
+		text << file.rdbuf();
+		rootJ = json_loads(text.str().c_str(), 0, NULL);
+		dataJ = rootJ ? findModuleData(rootJ, slug) : NULL;
+		if (!dataJ) {
+			fprintf(stderr, "No %s song in %s\n", slug.c_str(), inPath.c_str());
+			return 1;
+		}
+	}
+	else {
+		randomSeed(seed);
+		Module *module = model->createModule();
+		module->onRandomize();
+		rootJ = module->toJson();
+		delete module;
+		dataJ = rootJ;
+	}
+	if (pulsesPerStep > 0 && slug == "Phrase-Seq-16")
+		json_object_set_new(dataJ, "pulsesPerStep", json_integer(pulsesPerStep));
+
+	RenderSink sink;
+	auto start = std::chrono::steady_clock::now();
+	long pulses;
+	if (slug == "Foundry")
+		pulses = renderFoundry(dataJ, steps, sink);
+	else
+		pulses = renderPhraseSeq16(dataJ, steps, gate1Prob, check ? 0.0f : slideKnob, sink);
+	double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "%s: %ld pulses, %zu events, rendered in %.1f us\n", slug.c_str(), pulses, sink.events.size(), us);
+
+	if (check) {
+		bool ok = checkPhraseSeq16(model, dataJ, pulses, gate1Prob, sink);
+		json_decref(rootJ);
+		return ok ? 0 : 1;
+	}
+	json_decref(rootJ);
+
+	if (!midiPath.empty()) {
+		if (!writeMidi(sink, midiPath.c_str(), ppqn, bpm)) {
+			fprintf(stderr, "Could not write %s\n", midiPath.c_str());
+			return 1;
+		}
+	}
+	else
+		writeCsv(sink);
+	return 0;
+}
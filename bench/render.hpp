@@ -0,0 +1,69 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Offline song render: the sequencers' run logic is driven one clock pulse at a time (not one sample
+//at a time), and every change of a track's outputs is kept as a compact event, see bench/render.cpp
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+#ifndef IM_BENCH_RENDER_HPP
+#define IM_BENCH_RENDER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "jansson.h"
+
+
+// One change of a track's outputs (events are in time order, tracks in order within a time)
+struct RenderEvent {
+	uint32_t time;// in half clock pulses, so that clock and trigger gate types (high for part of the pulse only) can end between two pulses
+	uint8_t track;
+	uint8_t gate;// 0 or 1
+	uint8_t velocity;// MIDI scale (0 to 127)
+	uint8_t slide;// slide amount (0 to 100) when the step slides, 0 otherwise
+	float cv;// step CV in volts (1V/oct), without the slide
+};
+static_assert(sizeof(RenderEvent) == 12, "RenderEvent must stay compact");
+
+
+struct RenderSink {
+	static const int MAX_TRACKS = 8;
+	std::vector<RenderEvent> events;
+	RenderEvent last[MAX_TRACKS];
+	bool started[MAX_TRACKS];
+	int numTracks;
+
+	void reset(int _numTracks) {
+		numTracks = _numTracks;
+		events.clear();
+		for (int t = 0; t < MAX_TRACKS; t++)
+			started[t] = false;
+	}
+
+	inline void put(uint32_t time, int track, bool gate, float cv, int velocity, int slide) {// only keeps the event when an output changed
+		RenderEvent event = {time, (uint8_t)track, (uint8_t)(gate ? 1 : 0), (uint8_t)velocity, (uint8_t)slide, cv};
+		RenderEvent &prev = last[track];
+		if (started[track] && prev.gate == event.gate && prev.cv == event.cv && prev.velocity == event.velocity && prev.slide == event.slide)
+			return;
+		events.push_back(event);
+		prev = event;
+		started[track] = true;
+	}
+
+	void end(uint32_t time) {// gates off at the end of the render, so that every note has an end
+		for (int t = 0; t < numTracks; t++) {
+			if (started[t])
+				put(time, t, false, last[t].cv, last[t].velocity, last[t].slide);
+		}
+	}
+};
+
+
+// Each renderer reads the module's saved state (as given by its toJson()) and plays the song from a reset,
+// with one clock edge per pulse. The reset and the first clock edge coincide (that edge is ignored, as on the
+// modules). steps <= 0 means one pass of the song with the forward run modes. Returns the number of pulses rendered.
+long renderFoundry(json_t *rootJ, long steps, RenderSink &sink);// tracks A to D, all on clock A
+long renderPhraseSeq16(json_t *rootJ, long steps, float gate1Prob, float slideKnob, RenderSink &sink);// song mode, track 0 is gate 1, track 1 is gate 2
+
+
+#endif
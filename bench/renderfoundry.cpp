@@ -0,0 +1,81 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Offline song render of Foundry, around SequencerKernel::clockStep(), see bench/render.hpp
+//(in its own file since FoundryUtil.hpp and PhraseSeqUtil.hpp both define a StepAttributes class)
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+
+#include <memory>
+#include "render.hpp"
+#include "FoundryUtil.hpp"
+
+
+typedef Sequencer::Kernel Kernel;
+
+
+static int velocityToMidi(int vVal, int velocityMode) {// same voltage as Sequencer::calcVelocityVoltage(), scaled to 0-127
+	float velVolts = (float)vVal;
+	if (velocityMode == 0)
+		velVolts = velVolts * 10.0f / 200.0f;
+	else if (velocityMode == 1)
+		velVolts = velVolts * 10.0f / 127.0f;
+	else
+		velVolts = velVolts / 12.0f;
+	return (int)(min(velVolts, 10.0f) * 12.7f + 0.5f);
+}
+
+
+long renderFoundry(json_t *rootJ, long steps, RenderSink &sink) {
+	bool holdTiedNotes = true;
+	json_t *holdTiedNotesJ = json_object_get(rootJ, "holdTiedNotes");
+	if (holdTiedNotesJ)
+		holdTiedNotes = json_is_true(holdTiedNotesJ);
+	int velocityMode = 0;
+	json_t *velocityModeJ = json_object_get(rootJ, "velocityMode");
+	if (velocityModeJ)
+		velocityMode = json_integer_value(velocityModeJ);
+	int slideShape = SLIDE_LINEAR;// slides are not rendered, see RenderEvent
+
+	std::unique_ptr<Kernel[]> sek(new Kernel[Sequencer::NUM_TRACKS]);
+	for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++) {
+		sek[trkn].construct(trkn, trkn == 0 ? nullptr : &sek[0], &holdTiedNotes, &slideShape);
+		sek[trkn].reset();
+		sek[trkn].fromJson(rootJ);
+	}
+	for (int rsti = 0; rsti < 2; rsti++) {// once in the module's fromJson(), once more for the reset
+		for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++)
+			sek[trkn].initRun();
+	}
+
+	if (steps <= 0) {// one forward pass of the song of track A
+		steps = 0;
+		for (int phrn = sek[0].getBegin(); phrn <= sek[0].getEnd(); phrn++)
+			steps += (long)sek[0].getPhraseReps(phrn) * sek[0].getLength(sek[0].getPhraseSeq(phrn));
+	}
+	long pulses = steps * sek[0].getPulsesPerStep() + sek[0].getDelay();
+
+	sink.reset(Sequencer::NUM_TRACKS);
+	int gateCodes[Sequencer::NUM_TRACKS];
+	float cvs[Sequencer::NUM_TRACKS];
+	int velocities[Sequencer::NUM_TRACKS];
+	int slides[Sequencer::NUM_TRACKS];
+	for (long p = 0; p < pulses; p++) {
+		for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++) {
+			if (p > 0)
+				sek[trkn].clockStep(true, 0.0f);
+			StepAttributes attribRun = sek[trkn].getAttributeRun();
+			gateCodes[trkn] = sek[trkn].getGateCode();
+			cvs[trkn] = sek[trkn].getCVRun();
+			velocities[trkn] = velocityToMidi(attribRun.getVelocityVal(), velocityMode);
+			slides[trkn] = attribRun.getSlide() ? attribRun.getSlideVal() : 0;
+		}
+		for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++)
+			sink.put((uint32_t)(p * 2), trkn, gateCodes[trkn] >= 1, cvs[trkn], velocities[trkn], slides[trkn]);
+		for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++)// clock and trigger gates are low for the second half of the pulse
+			sink.put((uint32_t)(p * 2 + 1), trkn, gateCodes[trkn] == 1, cvs[trkn], velocities[trkn], slides[trkn]);
+	}
+	sink.end((uint32_t)(pulses * 2));
+	return pulses;
+}
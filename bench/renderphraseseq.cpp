@@ -0,0 +1,170 @@
+//***********************************************************************************************
+//Impromptu Modular: headless benchmark support
+//
+//Offline song render of Phrase-Seq-16, around moveIndexRunMode(), see bench/render.hpp
+//The clock code is the song mode path of PhraseSeq16::step(), the song is read with the keys of the
+//current patch format (see PhraseSeq16::toJson()). render -check compares it with the module, see checkPhraseSeq16() in bench/render.cpp
+//See ./LICENSE.txt for all licenses
+//***********************************************************************************************
+
+
+#include "render.hpp"
+#include "PhraseSeqUtil.hpp"
+
+
+struct PhraseSeq16Song {
+	// Need to save
+	int pulsesPerStep;
+	int runModeSeq[16];
+	int runModeSong;
+	int lengths[16];
+	int phrase[16];
+	int phrases;
+	float cv[16][16];
+	StepAttributes attributes[16][16];
+	RandomGenerator rng;
+
+	// No need to save
+	float gate1Prob;// GATE1_KNOB_PARAM
+	float slideKnob;// SLIDE_KNOB_PARAM
+	int stepIndexRun;
+	unsigned long stepIndexRunHistory;
+	int phraseIndexRun;
+	unsigned long phraseIndexRunHistory;
+	int ppqnCount;
+	int gate1Code;
+	int gate2Code;
+
+
+	void onReset() {
+		pulsesPerStep = 1;
+		runModeSong = MODE_FWD;
+		phrases = 4;
+		for (int i = 0; i < 16; i++) {
+			runModeSeq[i] = MODE_FWD;
+			lengths[i] = 16;
+			phrase[i] = 0;
+			for (int s = 0; s < 16; s++) {
+				cv[i][s] = 0.0f;
+				attributes[i][s].init();
+			}
+		}
+	}
+
+
+	static void readIntArray(json_t *rootJ, const char *key, int *values, int count) {
+		json_t *arrayJ = json_object_get(rootJ, key);
+		if (arrayJ) {
+			for (int i = 0; i < count; i++) {
+				json_t *valueJ = json_array_get(arrayJ, i);
+				if (valueJ)
+					values[i] = json_integer_value(valueJ);
+			}
+		}
+	}
+
+	void fromJson(json_t *rootJ) {
+		// pulsesPerStep
+		json_t *pulsesPerStepJ = json_object_get(rootJ, "pulsesPerStep");
+		if (pulsesPerStepJ)
+			pulsesPerStep = json_integer_value(pulsesPerStepJ);
+
+		// runModeSeq, runModeSong, lengths, phrase
+		readIntArray(rootJ, "runModeSeq3", runModeSeq, 16);
+		json_t *runModeSongJ = json_object_get(rootJ, "runModeSong3");
+		if (runModeSongJ)
+			runModeSong = json_integer_value(runModeSongJ);
+		readIntArray(rootJ, "lengths", lengths, 16);
+		readIntArray(rootJ, "phrase", phrase, 16);
+
+		// phrases
+		json_t *phrasesJ = json_object_get(rootJ, "phrases");
+		if (phrasesJ)
+			phrases = json_integer_value(phrasesJ);
+
+		// CV and attributes
+		json_t *cvJ = json_object_get(rootJ, "cv");
+		json_t *attributesJ = json_object_get(rootJ, "attributes");
+		for (int i = 0; i < 16; i++) {
+			for (int s = 0; s < 16; s++) {
+				json_t *cvArrayJ = cvJ ? json_array_get(cvJ, s + (i * 16)) : NULL;
+				if (cvArrayJ)
+					cv[i][s] = json_number_value(cvArrayJ);
+				json_t *attributesArrayJ = attributesJ ? json_array_get(attributesJ, s + (i * 16)) : NULL;
+				if (attributesArrayJ)
+					attributes[i][s].setAttribute((unsigned short)json_integer_value(attributesArrayJ));
+			}
+		}
+
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
+	}
+
+
+	void initRun() {
+		phraseIndexRun = (runModeSong == MODE_REV ? phrases - 1 : 0);
+		phraseIndexRunHistory = 0;
+
+		int seq = phrase[phraseIndexRun];
+		stepIndexRun = (runModeSeq[seq] == MODE_REV ? lengths[seq] - 1 : 0);
+		stepIndexRunHistory = 0;
+
+		ppqnCount = 0;
+		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, gate1Prob, &rng);
+		gate2Code = calcGate2Code(attributes[seq][stepIndexRun], 0, pulsesPerStep);
+	}
+
+
+	void clockPulse() {
+		ppqnCount++;
+		if (ppqnCount >= pulsesPerStep)
+			ppqnCount = 0;
+
+		if (ppqnCount == 0) {
+			if (moveIndexRunMode(&stepIndexRun, lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory, &rng)) {
+				moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory, &rng);
+				stepIndexRun = (runModeSeq[phrase[phraseIndexRun]] == MODE_REV ? lengths[phrase[phraseIndexRun]] - 1 : 0);// must always refresh after phraseIndexRun has changed
+			}
+		}
+		int newSeq = phrase[phraseIndexRun];
+		if (gate1Code != -1 || ppqnCount == 0)
+			gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, gate1Prob, &rng);
+		gate2Code = calcGate2Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep);
+	}
+};
+
+
+long renderPhraseSeq16(json_t *rootJ, long steps, float gate1Prob, float slideKnob, RenderSink &sink) {
+	PhraseSeq16Song song;
+	song.onReset();
+	song.fromJson(rootJ);
+	song.gate1Prob = gate1Prob;
+	song.slideKnob = slideKnob;
+	song.initRun();// once in the module's fromJson(), once more for the reset
+	song.initRun();
+
+	if (steps <= 0) {// one forward pass of the song
+		steps = 0;
+		for (int i = 0; i < song.phrases; i++)
+			steps += song.lengths[song.phrase[i]];
+	}
+	long pulses = steps * song.pulsesPerStep;
+
+	const int velocity = 100;// Phrase-Seq-16 has no velocity output
+	sink.reset(2);
+	for (long p = 0; p < pulses; p++) {
+		if (p > 0)
+			song.clockPulse();
+		int seq = song.phrase[song.phraseIndexRun];
+		StepAttributes attribRun = song.attributes[seq][song.stepIndexRun];
+		float cv = song.cv[seq][song.stepIndexRun];
+		int slide = attribRun.getSlide() ? (int)(song.slideKnob * 50.0f + 0.5f) : 0;// the slide amount is the SLIDE_KNOB_PARAM (0 to 2), for all steps
+		int gateCodes[2] = {song.gate1Code, song.gate2Code};
+		for (int trkn = 0; trkn < 2; trkn++)
+			sink.put((uint32_t)(p * 2), trkn, gateCodes[trkn] >= 1, cv, velocity, slide);
+		for (int trkn = 0; trkn < 2; trkn++)// clock and trigger gates are low for the second half of the pulse
+			sink.put((uint32_t)(p * 2 + 1), trkn, gateCodes[trkn] == 1, cv, velocity, slide);
+	}
+	sink.end((uint32_t)(pulses * 2));
+	return pulses;
+}
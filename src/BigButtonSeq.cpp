@@ -68,6 +68,7 @@ struct BigButtonSeq : Module {
 	int indexStep;
 	int bank[6];
 	uint64_t gates[6][2];// chan , bank
+	RandomGenerator rng;// see ImpromptuModular.hpp
 	
 	// No need to save
 	long clockIgnoreOnReset;
@@ -77,7 +78,7 @@ struct BigButtonSeq : Module {
 	bool fillPressed;
 	
 
-	unsigned int lightRefreshCounter = 0;	
+	RefreshCounter refresh;
 	float bigLight = 0.0f;
 	float metronomeLightStart = 0.0f;
 	float metronomeLightDiv = 0.0f;
@@ -124,11 +125,11 @@ struct BigButtonSeq : Module {
 
 
 	void onRandomize() override {
-		indexStep = randomu32() % 64;
+		indexStep = rng.u32() % 64;
 		for (int c = 0; c < 6; c++) {
-			bank[c] = randomu32() % 2;
-			gates[c][0] = randomu64();
-			gates[c][1] = randomu64();
+			bank[c] = rng.u32() % 2;
+			gates[c][0] = rng.u64();
+			gates[c][1] = rng.u64();
 		}
 	}
 
@@ -167,6 +168,9 @@ struct BigButtonSeq : Module {
 		// quantizeBig
 		json_object_set_new(rootJ, "quantizeBig", json_boolean(quantizeBig));
 
+		// rng
+		json_object_set_new(rootJ, "rng", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -222,6 +226,9 @@ struct BigButtonSeq : Module {
 		json_t *quantizeBigJ = json_object_get(rootJ, "quantizeBig");
 		if (quantizeBigJ)
 			quantizeBig = json_is_true(quantizeBigJ);
+
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
 	}
 
 	
@@ -239,7 +246,7 @@ struct BigButtonSeq : Module {
 		float chanInputValue = inputs[CHAN_INPUT].value / 10.0f * (6.0f - 1.0f);
 		chan = (int) clamp(roundf(params[CHAN_PARAM].value + chanInputValue), 0.0f, (6.0f - 1.0f));		
 		
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 
 			// Big button
 			if (bigTrigger.process(params[BIG_PARAM].value + inputs[BIG_INPUT].value)) {
@@ -312,7 +319,7 @@ struct BigButtonSeq : Module {
 				// Random (toggle gate according to probability knob)
 				float rnd01 = params[RND_PARAM].value / 100.0f + inputs[RND_INPUT].value / 10.0f;
 				if (rnd01 > 0.0f) {
-					if (randomUniform() < rnd01)// randomUniform is [0.0, 1.0), see include/util/common.hpp
+					if (rng.uniform() < rnd01)// uniform is [0.0, 1.0), see ImpromptuModular.hpp
 						toggleGate(chan);
 				}
 				lastPeriod = clockTime > 2.0 ? 2.0 : clockTime;
@@ -346,17 +353,15 @@ struct BigButtonSeq : Module {
 		}
 
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			// Gate light outputs
-			bool bigLightPulseState = bigLightPulse.process((float)sampleTime * displayRefreshStepSkips);
-			bool outLightPulseState = outLightPulse.process((float)sampleTime * displayRefreshStepSkips);
+			bool bigLightPulseState = bigLightPulse.process((float)sampleTime * refresh.lightSkips);
+			bool outLightPulseState = outLightPulse.process((float)sampleTime * refresh.lightSkips);
 			for (int i = 0; i < 6; i++) {
 				bool gate = getGate(i);
 				bool outLight  = (((gate || (i == chan && fillPressed)) && outLightPulseState) || (gate && bigLightPulseState && i == chan));
-				lights[(CHAN_LIGHTS + i) * 2 + 1].setBrightnessSmooth(outLight ? 1.0f : 0.0f, displayRefreshStepSkips);
+				lights[(CHAN_LIGHTS + i) * 2 + 1].setBrightnessSmooth(outLight ? 1.0f : 0.0f, refresh.lightSkips);
 				lights[(CHAN_LIGHTS + i) * 2 + 0].value = (i == chan ? (1.0f - lights[(CHAN_LIGHTS + i) * 2 + 1].value) / 2.0f : 0.0f);
 			}
 
@@ -372,9 +377,9 @@ struct BigButtonSeq : Module {
 			lights[WRITEFILL_LIGHT].value = writeFillsToMemory ? 1.0f : 0.0f;
 			lights[QUANTIZEBIG_LIGHT].value = quantizeBig ? 1.0f : 0.0f;
 		
-			bigLight -= (bigLight / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
-			metronomeLightStart -= (metronomeLightStart / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
-			metronomeLightDiv -= (metronomeLightDiv / lightLambda) * (float)sampleTime * displayRefreshStepSkips;
+			bigLight -= (bigLight / lightLambda) * (float)sampleTime * refresh.lightSkips;	
+			metronomeLightStart -= (metronomeLightStart / lightLambda) * (float)sampleTime * refresh.lightSkips;	
+			metronomeLightDiv -= (metronomeLightDiv / lightLambda) * (float)sampleTime * refresh.lightSkips;
 		}
 		
 		clockTime += sampleTime;
@@ -410,6 +415,10 @@ struct BigButtonSeqWidget : ModuleWidget {
 		ChanDisplayWidget() {
 			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
 		}
+		
+		uint64_t calcStateHash() {// see CachedDisplay
+			return *chan;
+		}
 
 		void draw(NVGcontext *vg) override {
 			NVGcolor textColor = prepareDisplay(vg, &box, 18);
@@ -433,6 +442,10 @@ struct BigButtonSeqWidget : ModuleWidget {
 		StepsDisplayWidget() {
 			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
 		}
+		
+		uint64_t calcStateHash() {// see CachedDisplay
+			return *len;
+		}
 
 		void draw(NVGcontext *vg) override {
 			NVGcolor textColor = prepareDisplay(vg, &box, 18);
@@ -534,8 +547,8 @@ struct BigButtonSeqWidget : ModuleWidget {
 	BigButtonSeqWidget(BigButtonSeq *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/BigButtonSeq.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/BigButtonSeq_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/BigButtonSeq.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/BigButtonSeq_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
@@ -590,13 +603,13 @@ struct BigButtonSeqWidget : ModuleWidget {
 		displayChan->box.pos = Vec(colRulerCenter + 43, rowRuler1 + vOffsetDisplay - 1);
 		displayChan->box.size = Vec(24, 30);// 1 character
 		displayChan->chan = &module->chan;
-		addChild(displayChan);	
+		addChild(createCachedDisplay(displayChan));	
 		// Length display
 		StepsDisplayWidget *displaySteps = new StepsDisplayWidget();
 		displaySteps->box.pos = Vec(colRulerT5 - 17, rowRuler1 + vOffsetDisplay - 1);
 		displaySteps->box.size = Vec(40, 30);// 2 characters
 		displaySteps->len = &module->len;
-		addChild(displaySteps);	
+		addChild(createCachedDisplay(displaySteps));	
 
 
 		
@@ -662,6 +675,9 @@ Model *modelBigButtonSeq = Model::create<BigButtonSeq, BigButtonSeqWidget>("Impr
 
 /*CHANGE LOG
 
+0.6.13:
+use a per-module random number generator (saved in the patch) instead of Rack's global one
+
 0.6.12:
 input refresh optimization
 
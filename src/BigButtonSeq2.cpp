@@ -74,6 +74,7 @@ struct BigButtonSeq2 : Module {
 	int bank[6];
 	uint64_t gates[6][2][2];// channel , bank , 64x2 page for 128
 	float cv[6][2][128];// channel , bank , indexStep
+	RandomGenerator rng;// see ImpromptuModular.hpp
 	
 	// No need to save
 	long clockIgnoreOnReset;
@@ -83,7 +84,7 @@ struct BigButtonSeq2 : Module {
 	float pendingCV;// 
 	bool fillPressed;
 
-	unsigned int lightRefreshCounter = 0;	
+	RefreshCounter refresh;
 	float bigLight = 0.0f;
 	float metronomeLightStart = 0.0f;
 	float metronomeLightDiv = 0.0f;
@@ -110,7 +111,7 @@ struct BigButtonSeq2 : Module {
 	inline void clearGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] &= ~(((uint64_t)1) << (uint64_t)(indexStep & 0x3F));}
 	inline void toggleGate(int chan) {gates[chan][bank[chan]][indexStep >> 6] ^= (((uint64_t)1) << (uint64_t)(indexStep & 0x3F));}
 	inline void clearGates(int chan, int bnk) {gates[chan][bnk][0] = 0; gates[chan][bnk][1] = 0;}
-	inline void randomizeGates(int chan, int bnk) {gates[chan][bnk][0] = randomu64(); gates[chan][bnk][1] = randomu64();}
+	inline void randomizeGates(int chan, int bnk) {gates[chan][bnk][0] = rng.u64(); gates[chan][bnk][1] = rng.u64();}
 	inline void writeCV(int chan, float cvValue) {cv[chan][bank[chan]][indexStep] = cvValue;}
 	inline void writeCV(int chan, int bnk, int step, float cvValue) {cv[chan][bnk][step] = cvValue;}
 	inline void sampleOutput(int chan) {sampleHoldBuf[chan] = cv[chan][bank[chan]][indexStep];}
@@ -145,13 +146,13 @@ struct BigButtonSeq2 : Module {
 
 
 	void onRandomize() override {
-		indexStep = randomu32() % 128;
+		indexStep = rng.u32() % 128;
 		for (int c = 0; c < 6; c++) {
-			bank[c] = randomu32() % 2;
+			bank[c] = rng.u32() % 2;
 			for (int b = 0; b < 2; b++) {
 				randomizeGates(c, b);
 				for (int s = 0; s < 128; s++)
-					writeCV(c, b, s, ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f);
+					writeCV(c, b, s, ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f);
 			}
 		}
 	}
@@ -220,6 +221,9 @@ struct BigButtonSeq2 : Module {
 		// sampleAndHold
 		json_object_set_new(rootJ, "sampleAndHold", json_boolean(sampleAndHold));
 
+		// rng
+		json_object_set_new(rootJ, "rng", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -316,6 +320,9 @@ struct BigButtonSeq2 : Module {
 		json_t *sampleAndHoldJ = json_object_get(rootJ, "sampleAndHold");
 		if (sampleAndHoldJ)
 			sampleAndHold = json_is_true(sampleAndHoldJ);
+
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
 }
 
 	
@@ -333,7 +340,7 @@ struct BigButtonSeq2 : Module {
 		float chanInputValue = inputs[CHAN_INPUT].value / 10.0f * (6.0f - 1.0f);
 		channel = (int) clamp(roundf(params[CHAN_PARAM].value + chanInputValue), 0.0f, (6.0f - 1.0f));		
 		
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {		
+		if (refresh.processInputs()) {		
 		
 			// Big button
 			if (bigTrigger.process(params[BIG_PARAM].value + inputs[BIG_INPUT].value)) {
@@ -420,7 +427,7 @@ struct BigButtonSeq2 : Module {
 				// Random (toggle gate according to probability knob)
 				float rnd01 = params[RND_PARAM].value / 100.0f + inputs[RND_INPUT].value / 10.0f;
 				if (rnd01 > 0.0f) {
-					if (randomUniform() < rnd01)// randomUniform is [0.0, 1.0), see include/util/common.hpp
+					if (rng.uniform() < rnd01)// uniform is [0.0, 1.0), see ImpromptuModular.hpp
 						toggleGate(channel);
 				}
 				lastPeriod = clockTime > 2.0 ? 2.0 : clockTime;
@@ -458,17 +465,15 @@ struct BigButtonSeq2 : Module {
 		}
 
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			// Gate light outputs
-			bool bigLightPulseState = bigLightPulse.process((float)sampleTime * displayRefreshStepSkips);
-			bool outLightPulseState = outLightPulse.process((float)sampleTime * displayRefreshStepSkips);
+			bool bigLightPulseState = bigLightPulse.process((float)sampleTime * refresh.lightSkips);
+			bool outLightPulseState = outLightPulse.process((float)sampleTime * refresh.lightSkips);
 			for (int i = 0; i < 6; i++) {
 				bool gate = getGate(i);
 				bool outLight  = (((gate || (i == channel && fillPressed)) && outLightPulseState) || (gate && bigLightPulseState && i == channel));
-				lights[(CHAN_LIGHTS + i) * 2 + 1].setBrightnessSmooth(outLight ? 1.0f : 0.0f, displayRefreshStepSkips);
+				lights[(CHAN_LIGHTS + i) * 2 + 1].setBrightnessSmooth(outLight ? 1.0f : 0.0f, refresh.lightSkips);
 				lights[(CHAN_LIGHTS + i) * 2 + 0].value = (i == channel ? (1.0f - lights[(CHAN_LIGHTS + i) * 2 + 1].value) / 2.0f : 0.0f);
 			}
 
@@ -485,9 +490,9 @@ struct BigButtonSeq2 : Module {
 			lights[QUANTIZEBIG_LIGHT].value = quantizeBig ? 1.0f : 0.0f;
 			lights[SAMPLEHOLD_LIGHT].value = sampleAndHold ? 1.0f : 0.0f;
 		
-			bigLight -= (bigLight / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
-			metronomeLightStart -= (metronomeLightStart / lightLambda) * (float)sampleTime * displayRefreshStepSkips;	
-			metronomeLightDiv -= (metronomeLightDiv / lightLambda) * (float)sampleTime * displayRefreshStepSkips;
+			bigLight -= (bigLight / lightLambda) * (float)sampleTime * refresh.lightSkips;	
+			metronomeLightStart -= (metronomeLightStart / lightLambda) * (float)sampleTime * refresh.lightSkips;	
+			metronomeLightDiv -= (metronomeLightDiv / lightLambda) * (float)sampleTime * refresh.lightSkips;
 		}
 		
 		clockTime += sampleTime;
@@ -649,8 +654,8 @@ struct BigButtonSeq2Widget : ModuleWidget {
 	BigButtonSeq2Widget(BigButtonSeq2 *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/BigButtonSeq2.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/BigButtonSeq2_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/BigButtonSeq2.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/BigButtonSeq2_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
@@ -788,6 +793,9 @@ Model *modelBigButtonSeq2 = Model::create<BigButtonSeq2, BigButtonSeq2Widget>("I
 
 /*CHANGE LOG
 
+0.6.13:
+use a per-module random number generator (saved in the patch) instead of Rack's global one
+
 0.6.12:
 input refresh optimization
 
@@ -88,8 +88,8 @@ struct BlankPanelWidget : ModuleWidget {
 	BlankPanelWidget(BlankPanel *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        //panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/BlankPanel.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/BlankPanel_dark.svg")));
+        //panel->addPanel(assetPlugin(plugin, "res/light/BlankPanel.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/BlankPanel_dark.svg"));
         box.size = panel->box.size;
         //panel->mode = &module->panelTheme;
         addChild(panel);
@@ -11,107 +11,230 @@
 //***********************************************************************************************
 
 
+#include <memory>
 #include "ImpromptuModular.hpp"
 
 
 class Clock {
-	// The -1.0 step is used as a reset state every double-period so that 
-	//   lengths can be re-computed; it will stay at -1.0 when a clock is inactive.
-	// a clock frame is defined as "length * iterations + syncWait", and
-	//   for master, syncWait does not apply and iterations = 1
+	// The -1 step is used as a reset state every frame so that 
+	//   lengths can be re-computed; it will stay at -1 when a clock is inactive.
+	// a clock frame is "length * iterations" (double periods), and for master, iterations = 1
+	// Time is counted in fixed point samples (see ONE), and a sub clock's frame is an exact whole number of master
+	//   frames, so that sub clocks end their frames on the same sample as the master when the length doesn't change; a sub
+	//   clock also ends its frame when the master has ended as many frames, so that they can't drift apart after a length change
+	// The edges of the two pulses of a double period are only recalculated when the length, swing or pulse width change
+	//   (see calcEdges()), so that isHigh() is a few compares and calcIdleSteps() can tell how far away the next edge is
 
+	public:
 	
-	double step;// -1.0 when stopped, [0 to 2*period[ for clock steps (*2 is because of swing, so we do groups of 2 periods)
-	double length;// double period
-	double sampleTime;
+	static const int FRAC_BITS = 32;
+	static constexpr int64_t ONE = ((int64_t)1) << FRAC_BITS;// one sample
+	
+	private:
+	
+	int64_t step;// -1 when stopped, [0 to length[ for clock steps (a double period, because of swing, so we do groups of 2 periods)
+	int64_t length;// double period
+	int64_t frameLength;// length * iterations, where the lengths of the double periods of a frame differ by at most one unit
+	int64_t carry;// the master starts a frame where the previous one ended, rather than on the next whole sample
+	double unitsPerSecond;
 	int iterations;// run this many double periods before going into sync if sub-clock
+	int iteration;// index of the current double period in the frame
+	int syncFrames;// sub clocks: number of master frames left to end this frame
 	Clock* syncSrc = nullptr; // only subclocks will have this set to master clock
-	static constexpr double guard = 0.0005;// in seconds, region for sync to occur right before end of length of last iteration; sub clocks must be low during this period
+	float swing;// [-1 : 1]
+	float pulseWidth;// [0 : 1]
+	int64_t p2;// fall of first pulse (first pulse rises at 0)
+	int64_t p3;// rise of second pulse
+	int64_t p4;// fall of second pulse
+	int high;// last value returned by isHigh()
+	
+	void calcEdges() {
+		calcPulseEdges(length, unitsPerSecond, swing, pulseWidth, &p2, &p3, &p4);
+	}
+	
+	inline int64_t calcLength(int iter) {// double period iter of the frame
+		return calcLength(frameLength, iter, iterations);
+	}
+	
+	inline int calcHigh() {
+		return calcHigh(step, p2, p3, p4);
+	}
 	
 	public:
 	
+	// shared with ClockBank
+	static void calcPulseEdges(int64_t length, double unitsPerSecond, float swing, float pulseWidth, int64_t* p2, int64_t* p3, int64_t* p4) {
+		// last 1ms of a double period is always low, the code below disallows any pulses or inter-pulse times less than 1ms
+		
+		// all following values are in seconds
+		float onems = 0.001f;
+		float period = (float)((double)length / unitsPerSecond) / 2.0f;
+		float swingTime = (period - 2.0f * onems) * swing;
+		float p2min = onems;
+		float p2max = period - onems - fabs(swingTime);
+		if (p2max < p2min) {
+			p2max = p2min;
+		}
+		
+		//p1 = 0;// implicit, no need 
+		*p2 = (int64_t)((double)((p2max - p2min) * pulseWidth + p2min) * unitsPerSecond);
+		*p3 = (int64_t)((double)(period + swingTime) * unitsPerSecond);
+		*p4 = *p3 + *p2;
+	}
+	static inline int64_t calcLength(int64_t frameLength, int iter, int iterations) {
+		return (frameLength * (iter + 1)) / iterations - (frameLength * iter) / iterations;
+	}
+	static inline int calcHigh(int64_t step, int64_t p2, int64_t p3, int64_t p4) {
+		if (step < 0)
+			return 1;// default state is clock high, in first pulse, when reset
+		if (step < p2)
+			return 1;
+		if ((step >= p3) && (step < p4))
+			return 2;
+		return 0;
+	}
+	static inline int calcPart(int64_t step, int64_t p2, int64_t p3, int64_t p4) {// 0 and 2 are the pulses, 1 and 3 the low times after them
+		return step < p2 ? 0 : (step < p3 ? 1 : (step < p4 ? 2 : 3));
+	}
+	static inline int64_t clampToPart(int64_t step, int part, int64_t p2, int64_t p3, int64_t p4) {
+		// keeps a stretched step in the part of the double period it was in, since the 1ms minimums of calcPulseEdges() don't stretch
+		//   (shrinking the length just after a pulse ended would otherwise raise that pulse again)
+		int64_t lo = (part == 0 ? 0 : (part == 1 ? p2 : (part == 2 ? p3 : p4)));
+		int64_t hi = (part == 0 ? p2 : (part == 1 ? p3 : (part == 2 ? p4 : INT64_MAX)));
+		return std::max(lo, std::min(step, hi - 1));
+	}
+	static void calcSubFrame(int ratioDoubled, int* iterations, int* syncFrames) {// ratioDoubled as given by Clocked::getRatioDoubled()
+		if (ratioDoubled < 0) {// if div 
+			ratioDoubled *= -1;
+			*iterations = 1 + (ratioDoubled % 2);
+			*syncFrames = (ratioDoubled * *iterations) / 2;
+		}
+		else {// mult 
+			*iterations = ratioDoubled / (2 - (ratioDoubled % 2));
+			*syncFrames = 1 + (ratioDoubled % 2);
+		}
+	}
+	static long calcIdleSteps(int64_t step, int64_t length, int64_t p2, int64_t p3, int64_t p4) {// see calcIdleSteps() below, for an active clock whose isHigh() is up to date
+		if (step >= length)
+			return LONG_MAX;// sub clock waiting for the master, which ends this frame on one of its own edges
+		if (step < p4) {// pulse edges are seen by isHigh(), at the start of module::step()
+			int64_t nextEdge = (step < p2 ? p2 : (step < p3 ? p3 : p4));
+			return (long)((nextEdge - step + ONE - 1) / ONE);
+		}
+		return (long)((length - step - 1) / ONE);// the end of the double period is seen by stepClock(), after step has been incremented
+	}
+	
 	Clock() {
+		length = ONE;
+		frameLength = ONE;
+		iterations = 1;
+		iteration = 0;
+		syncFrames = 0;
+		unitsPerSecond = (double)ONE;
+		swing = 0.0f;
+		pulseWidth = 0.5f;
+		high = 1;
+		calcEdges();
 		reset();
 	}
 	
+	static inline int64_t toUnits(double seconds, double sampleTime) {
+		return (int64_t)(seconds / sampleTime * (double)ONE + 0.5);
+	}
+	
 	inline void reset() {
-		step = -1.0;
+		step = -1;
+		carry = 0;
 	}
 	inline bool isReset() {
-		return step == -1.0;
+		return step == -1;
 	}
-	inline double getStep() {
+	inline double getStep() {// in seconds
+		return step < 0 ? -1.0 : (double)step / unitsPerSecond;
+	}
+	inline int64_t getStepUnits() {// in fixed point samples, -1 when reset
 		return step;
 	}
 	void setSync(Clock* clkGiven) {
 		syncSrc = clkGiven;
 	}
-	inline void start() {
-		step = 0.0;
+	inline void start() {// sub clocks must be started with (or after) the master, at the start of one of its frames
+		step = (syncSrc != nullptr ? syncSrc->step : carry);
+		carry = 0;
+	}
+	
+	void setup(double masterLength, int ratioDoubled, double sampleTime) {// ratioDoubled as given by Clocked::getRatioDoubled() (1 for master)
+		unitsPerSecond = (double)ONE / sampleTime;
+		frameLength = toUnits(masterLength, sampleTime);// length = double_period
+		if (syncSrc == nullptr) {// master
+			iterations = 1;
+			syncFrames = 0;
+		}
+		else
+			calcSubFrame(ratioDoubled, &iterations, &syncFrames);
+		frameLength *= syncFrames > 0 ? syncFrames : 1;
+		iteration = 0;
+		length = calcLength(0);
+		calcEdges();
 	}
 	
-	inline void setup(double lengthGiven, int iterationsGiven, double sampleTimeGiven) {
-		length = lengthGiven;
-		iterations = iterationsGiven;
-		sampleTime = sampleTimeGiven;
+	inline void setPulse(float swingGiven, float pulseWidthGiven) {// swing is [-1 : 1], pulseWidth is [0 : 1]
+		if (swing != swingGiven || pulseWidth != pulseWidthGiven) {
+			swing = swingGiven;
+			pulseWidth = pulseWidthGiven;
+			calcEdges();
+		}
 	}
 
 	void stepClock() {// here the clock was output on step "step", this function is called at end of module::step()
-		if (step >= 0.0) {// if active clock
-			step += sampleTime;
-			if ( (syncSrc != nullptr) && (iterations == 1) && (step > (length - guard)) ) {// if in sync region
-				if (syncSrc->isReset()) {
-					reset();
-				}// else nothing needs to be done, just wait and step stays the same
-			}
-			else {
-				if (step >= length) {// reached end iteration
-					iterations--;
-					step -= length;
-					if (iterations <= 0) 
-						reset();// frame done
+		if (step >= 0) {// if active clock
+			step += ONE;
+			if (syncSrc != nullptr && syncSrc->isReset()) {// master ended a frame
+				syncFrames--;
+				if (syncFrames <= 0) {
+					reset();// frame done, restarted with the master
+					return;
 				}
 			}
+			if (step >= length && iteration < iterations - 1) {// reached end iteration
+				iteration++;
+				step -= length;
+				length = calcLength(iteration);
+				calcEdges();
+			}
+			else if (step >= length && syncSrc == nullptr) {
+				carry = step - length;
+				step = -1;// frame done
+			}// else sub clock waits for the master's frame end (low, since past p4)
 		}
 	}
 	
 	void applyNewLength(double lengthStretchFactor) {
-		if (step != -1.0)
-			step *= lengthStretchFactor;
-		length *= lengthStretchFactor;
+		int part = calcPart(step, p2, p3, p4);
+		if (step != -1)
+			step = (int64_t)((double)step * lengthStretchFactor);
+		carry = (int64_t)((double)carry * lengthStretchFactor);
+		frameLength = (int64_t)((double)frameLength * lengthStretchFactor);
+		length = calcLength(iteration);
+		calcEdges();
+		if (step != -1)
+			step = clampToPart(step, part, p2, p3, p4);
 	}
 	
-	int isHigh(float swing, float pulseWidth) {
-		// last 0.5ms (guard time) must be low so that sync mechanism will work properly (i.e. no missed pulses)
-		//   this will automatically be the case, since code below disallows any pulses or inter-pulse times less than 1ms
-		int high = 0;
-		if (step >= 0.0) {
-			float swParam = swing;// swing is [-1 : 1]
-			
-			// all following values are in seconds
-			float onems = 0.001f;
-			float period = (float)length / 2.0f;
-			float swing = (period - 2.0f * onems) * swParam;
-			float p2min = onems;
-			float p2max = period - onems - fabs(swing);
-			if (p2max < p2min) {
-				p2max = p2min;
-			}
-			
-			//double p1 = 0.0;// implicit, no need 
-			double p2 = (double)((p2max - p2min) * pulseWidth + p2min);// pulseWidth is [0 : 1]
-			double p3 = (double)(period + swing);
-			double p4 = ((double)(period + swing)) + p2;
-			
-			if (step < p2)
-				high = 1;
-			else if ((step >= p3) && (step < p4))
-				high = 2;
-		}
-		else
-			high = 1;// default state is clock high, in first pulse, when reset
+	inline int isHigh() {
+		high = calcHigh();
 		return high;
-	}	
+	}
+	
+	long calcIdleSteps() {// number of upcoming stepClock() calls that will change neither isHigh() nor the frame
+		if (step < 0 || calcHigh() != high)
+			return 0l;
+		return calcIdleSteps(step, length, p2, p3, p4);
+	}
+	void skipIdleSteps(long n) {// same as n calls to stepClock() when idle
+		if (step >= 0)
+			step += (int64_t)n * ONE;
+	}
 };
 
 
@@ -119,13 +242,31 @@ class Clock {
 
 
 class ClockDelay {
-	long stepCounter;
+	// The edges written by the clock are queued with their sample number and played back when they are delaySamples old,
+	//   so that the pulses under way are never dropped or merged (high ratios, pulse width or swing changes), at O(1) cost per sample
+	// The delay is at most 3/4 of the sub clock's period, which holds at most 4 edges (the fifth would be a double period after
+	//   the first), and Clocked updates the delay as soon as the ratio or the master length changes; only swing, pulse width or
+	//   length changes in mid period can add edges, so when the ring is full a new edge cancels the newest queued one instead
+	//   (that short pulse is dropped, the edges already queued keep their timing)
+	
+	public:
+	
+	static const int SIZE = 8;// must be a power of 2
+	
+	private:
+	
+	int64_t stepCounter;
+	int64_t edges[SIZE];// sample number of each edge * 2, plus 1 for a rise
+	int head;// index of the oldest edge
+	int count;
 	int lastWriteValue;
 	bool readState;
-	long stepRise1;
-	long stepFall1;
-	long stepRise2;
-	long stepFall2;
+	
+	inline void playEdge() {// oldest edge
+		readState = (edges[head] & 0x1) != 0;
+		head = (head + 1) & (SIZE - 1);
+		count--;
+	}
 	
 	public:
 	
@@ -134,57 +275,272 @@ class ClockDelay {
 	}
 	
 	void reset() {
-		stepCounter = 0l;
+		stepCounter = 0;
+		head = 0;
+		count = 0;
 		lastWriteValue = 0;
 		readState = true;// default is clock high
-		stepRise1 = 0l;
-		stepFall1 = 0l;
-		stepRise2 = 0l;
-		stepFall2 = 0l;
 	}
 	
-	void write(int value) {
-		if (value == 1) {// first pulse is high
-			if (lastWriteValue == 0) // if got rise 1
-				stepRise1 = stepCounter;
-		}
-		else if (value == 2) {// second pulse is high
-			if (lastWriteValue == 0) // if got rise 2
-				stepRise2 = stepCounter;
-		}
-		else {// value = 0 (pulse is low)
-			if (lastWriteValue == 1) // if got fall 1
-				stepFall1 = stepCounter;
-			else if (lastWriteValue == 2) // if got fall 2
-				stepFall2 = stepCounter;
+	void write(int value) {// value is 0 when the clock is low, 1 or 2 when in its first or second pulse
+		if ((value != 0) != (lastWriteValue != 0)) {
+			if (count >= SIZE)
+				count--;// cancels the newest edge, which was the opposite of this one
+			else {
+				edges[(head + count) & (SIZE - 1)] = stepCounter * 2 + (value != 0 ? 1 : 0);
+				count++;
+			}
 		}
-		
 		lastWriteValue = value;
 	}
 	
-	bool read(long delaySamples) {
-		long delayedStepCounter = stepCounter - delaySamples;
-		if (delayedStepCounter == stepRise1 || delayedStepCounter == stepRise2)
-			readState = true;
-		else if (delayedStepCounter == stepFall1 || delayedStepCounter == stepFall2)
-			readState = false;
+	bool read(int64_t delaySamples) {// 64-bit sample counter, no need to keep it bounded (it would take millions of years to wrap)
+		int64_t delayedStepCounter = stepCounter - delaySamples;
+		if (count > 0 && (edges[head] >> 1) <= delayedStepCounter)// one edge per sample at most, so that the pulses that became old when the delay was shortened are not lost
+			playEdge();
 		stepCounter++;
-		if (stepCounter > 1e8) {// keep within long's bounds (could go higher or could allow negative)
-			stepCounter -= 1e8;// 192000 samp/s * 2s * 64 * (3/4) = 18.4 Msamp
-			stepRise1 -= 1e8;
-			stepFall1 -= 1e8;
-			stepRise2 -= 1e8;
-			stepFall2 -= 1e8;
-		}
 		return readState;
 	}
+	
+	long calcIdleSteps(int64_t delaySamples) {// number of upcoming read() calls that will not reach a delayed edge
+		if (count == 0)
+			return LONG_MAX;
+		int64_t stepsToEdge = (edges[head] >> 1) + delaySamples - stepCounter;
+		return stepsToEdge > 0 ? (long)std::min(stepsToEdge, (int64_t)LONG_MAX) : 0l;
+	}
+	void skipIdleSteps(long n) {// same as n calls to read() when idle (write() does nothing while its value doesn't change)
+		stepCounter += n;
+	}
 };
 
 
 //*****************************************************************************
 
 
-struct Clocked : Module {
+class ClockBank {
+	// Sub clocks that follow the master like the sub clocks of Clock, with their states in arrays across the channels (structure of
+	//   arrays). Each channel keeps the number of upcoming steps that only increment its step (see Clock::calcIdleSteps()), and its
+	//   step is only brought up to date when the channel is stepped on its own, which is when that number reaches 0 (an edge or the end
+	//   of a double period) or when the master ends a frame; the work done on every sample for all channels is then one loop of 32 bit
+	//   subtracts, which the compiler vectorizes
+	// The delay of each channel is a ClockDelay folded into the same arrays: a small ring of edges per channel, timed with samples
+	
+	public:
+	
+	static const int NUM_CHANNELS = 12;
+	
+	private:
+	
+	static const int64_t ONE = Clock::ONE;
+	
+	alignas(16) int32_t idleSteps[NUM_CHANNELS];// see Clock::calcIdleSteps(), the channel is stepped on its own when this reaches 0
+	int64_t samples;// counted by stepClocks()
+	int64_t step[NUM_CHANNELS];// -1 when reset, see Clock; at stepSample
+	int64_t stepSample[NUM_CHANNELS];
+	int64_t length[NUM_CHANNELS];
+	int64_t frameLength[NUM_CHANNELS];
+	int64_t p2[NUM_CHANNELS];
+	int64_t p3[NUM_CHANNELS];
+	int64_t p4[NUM_CHANNELS];
+	int high[NUM_CHANNELS];
+	int iterations[NUM_CHANNELS];
+	int iteration[NUM_CHANNELS];
+	int syncFrames[NUM_CHANNELS];
+	float swing[NUM_CHANNELS];
+	float pulseWidth[NUM_CHANNELS];
+	double unitsPerSecond;
+	int64_t delayEdges[NUM_CHANNELS][ClockDelay::SIZE];// see ClockDelay
+	int64_t delaySamples[NUM_CHANNELS];
+	int delayHead[NUM_CHANNELS];
+	int delayCount[NUM_CHANNELS];
+	int delayLastHigh[NUM_CHANNELS];
+	bool delayState[NUM_CHANNELS];
+	
+	inline void catchUp(int c) {// brings step up to date, must be called before any change to a channel
+		if (step[c] >= 0)
+			step[c] += (samples - stepSample[c]) * ONE;
+		stepSample[c] = samples;
+	}
+	
+	void update(int c) {// high and idleSteps, after any change to a channel
+		high[c] = Clock::calcHigh(step[c], p2[c], p3[c], p4[c]);
+		if (step[c] < 0)
+			idleSteps[c] = INT32_MAX;// started by the master
+		else
+			idleSteps[c] = (int32_t)std::min(Clock::calcIdleSteps(step[c], length[c], p2[c], p3[c], p4[c]), (long)INT32_MAX);
+	}
+	
+	inline void calcEdges(int c) {
+		Clock::calcPulseEdges(length[c], unitsPerSecond, swing[c], pulseWidth[c], &p2[c], &p3[c], &p4[c]);
+	}
+	
+	void stepChannel(int c, bool masterEnded) {// rest of Clock::stepClock(), after samples has been incremented
+		catchUp(c);
+		if (step[c] >= 0) {
+			if (masterEnded) {
+				syncFrames[c]--;
+				if (syncFrames[c] <= 0) {
+					step[c] = -1;// frame done, restarted with the master
+					update(c);
+					return;
+				}
+			}
+			if (step[c] >= length[c] && iteration[c] < iterations[c] - 1) {// reached end iteration
+				iteration[c]++;
+				step[c] -= length[c];
+				length[c] = Clock::calcLength(frameLength[c], iteration[c], iterations[c]);
+				calcEdges(c);
+			}// else waits for the master's frame end
+		}
+		update(c);
+	}
+	
+	public:
+	
+	ClockBank() {
+		samples = 0;
+		unitsPerSecond = (double)ONE;
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			length[c] = ONE;
+			frameLength[c] = ONE;
+			iterations[c] = 1;
+			iteration[c] = 0;
+			syncFrames[c] = 1;
+			swing[c] = 0.0f;
+			pulseWidth[c] = 0.5f;
+			calcEdges(c);
+			reset(c);
+			delaySamples[c] = 0;
+		}
+		resetDelays();
+	}
+	
+	inline void reset(int c) {
+		step[c] = -1;
+		stepSample[c] = samples;
+		update(c);
+	}
+	void reset() {
+		for (int c = 0; c < NUM_CHANNELS; c++)
+			reset(c);
+	}
+	inline bool isReset(int c) {
+		return step[c] == -1;
+	}
+	void resetDelays() {// the delays are kept through the resets of the channels, like the ClockDelay of the sub clocks
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			delayHead[c] = 0;
+			delayCount[c] = 0;
+			delayLastHigh[c] = 0;
+			delayState[c] = true;// default is clock high
+		}
+	}
+	
+	void start(int c, double masterLength, int ratioDoubled, double sampleTime, int64_t masterStep) {// with the master, at the start of one of its frames
+		unitsPerSecond = (double)ONE / sampleTime;
+		Clock::calcSubFrame(ratioDoubled, &iterations[c], &syncFrames[c]);
+		frameLength[c] = Clock::toUnits(masterLength, sampleTime) * syncFrames[c];
+		iteration[c] = 0;
+		length[c] = Clock::calcLength(frameLength[c], 0, iterations[c]);
+		calcEdges(c);
+		step[c] = masterStep;
+		stepSample[c] = samples;
+		update(c);
+	}
+	
+	inline void setPulse(int c, float swingGiven, float pulseWidthGiven) {
+		if (swing[c] != swingGiven || pulseWidth[c] != pulseWidthGiven) {
+			catchUp(c);
+			swing[c] = swingGiven;
+			pulseWidth[c] = pulseWidthGiven;
+			calcEdges(c);
+			update(c);
+		}
+	}
+	
+	void applyNewLength(double lengthStretchFactor) {
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			catchUp(c);
+			int part = Clock::calcPart(step[c], p2[c], p3[c], p4[c]);
+			if (step[c] != -1)
+				step[c] = (int64_t)((double)step[c] * lengthStretchFactor);
+			frameLength[c] = (int64_t)((double)frameLength[c] * lengthStretchFactor);
+			length[c] = Clock::calcLength(frameLength[c], iteration[c], iterations[c]);
+			calcEdges(c);
+			if (step[c] != -1)
+				step[c] = Clock::clampToPart(step[c], part, p2[c], p3[c], p4[c]);
+			update(c);
+		}
+	}
+	
+	inline int isHigh(int c) {
+		return high[c];
+	}
+	inline void setDelay(int c, int64_t delaySamplesGiven) {
+		delaySamples[c] = delaySamplesGiven;
+	}
+	
+	bool isDelayedHigh(int c) {// ClockDelay::write() of isHigh(c) then ClockDelay::read(), once per sample before stepClocks()
+		if ((high[c] != 0) != (delayLastHigh[c] != 0)) {
+			if (delayCount[c] >= ClockDelay::SIZE)
+				delayCount[c]--;// cancels the newest edge, see ClockDelay
+			else {
+				delayEdges[c][(delayHead[c] + delayCount[c]) & (ClockDelay::SIZE - 1)] = samples * 2 + (high[c] != 0 ? 1 : 0);
+				delayCount[c]++;
+			}
+		}
+		delayLastHigh[c] = high[c];
+		if (delayCount[c] > 0 && (delayEdges[c][delayHead[c]] >> 1) <= samples - delaySamples[c]) {// one edge per sample at most
+			delayState[c] = (delayEdges[c][delayHead[c]] & 0x1) != 0;
+			delayHead[c] = (delayHead[c] + 1) & (ClockDelay::SIZE - 1);
+			delayCount[c]--;
+		}
+		return delayState[c];
+	}
+	
+	void stepClocks(bool masterEnded) {// after the master's stepClock(), masterEnded when it has ended a frame
+		samples++;
+		int32_t due = 0;
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			idleSteps[c]--;
+			due |= idleSteps[c] - 1;// negative when idleSteps[c] reached 0
+		}
+		if (due < 0 || masterEnded) {
+			for (int c = 0; c < NUM_CHANNELS; c++) {
+				if (idleSteps[c] <= 0 || masterEnded)
+					stepChannel(c, masterEnded);
+			}
+		}
+	}
+	
+	long calcIdleSteps() {// number of upcoming stepClocks() calls that will change neither isHigh(), isDelayedHigh() nor the frames (the master's frame ends are not included)
+		int32_t minIdleSteps = INT32_MAX;
+		for (int c = 0; c < NUM_CHANNELS; c++)
+			minIdleSteps = std::min(minIdleSteps, idleSteps[c]);
+		int64_t minDelaySteps = INT64_MAX;
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			if ((high[c] != 0) != (delayLastHigh[c] != 0))// stepped into an edge that isDelayedHigh() has not written yet
+				return 0l;
+			if (delayCount[c] > 0)
+				minDelaySteps = std::min(minDelaySteps, (delayEdges[c][delayHead[c]] >> 1) + delaySamples[c] - samples);
+		}
+		return minDelaySteps > 0 ? (long)std::min((int64_t)minIdleSteps, minDelaySteps) : 0l;
+	}
+	void skipIdleSteps(long n) {// same as n calls to stepClocks(false) when idle
+		samples += n;
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			idleSteps[c] -= (int32_t)n;
+			if (idleSteps[c] <= 0)
+				stepChannel(c, false);
+		}
+	}
+};
+
+
+//*****************************************************************************
+
+
+struct Clocked : Module, BlockProcessor {
 	enum ParamIds {
 		ENUMS(RATIO_PARAMS, 4),// master is index 0
 		ENUMS(SWING_PARAMS, 4),// master is index 0
@@ -194,6 +550,11 @@ struct Clocked : Module {
 		ENUMS(DELAY_PARAMS, 4),// index 0 is unused
 		// -- 0.6.9 ^^
 		BPMMODE_PARAM,
+		// -- 0.6.10 ^^
+		ENUMS(BANK_RATIO_PARAMS, ClockBank::NUM_CHANNELS),
+		ENUMS(BANK_SWING_PARAMS, ClockBank::NUM_CHANNELS),
+		ENUMS(BANK_PW_PARAMS, ClockBank::NUM_CHANNELS),
+		ENUMS(BANK_DELAY_PARAMS, ClockBank::NUM_CHANNELS),
 		NUM_PARAMS
 	};
 	enum InputIds {
@@ -209,6 +570,7 @@ struct Clocked : Module {
 		RESET_OUTPUT,
 		RUN_OUTPUT,
 		BPM_OUTPUT,
+		ENUMS(BANK_CLK_OUTPUTS, ClockBank::NUM_CHANNELS),
 		NUM_OUTPUTS
 	};
 	enum LightIds {
@@ -221,38 +583,53 @@ struct Clocked : Module {
 	
 	
 	// Constants
-	const float delayValues[8] = {0.0f,  0.0625f, 0.125f, 0.25f, 1.0f/3.0f, 0.5f , 2.0f/3.0f, 0.75f};
+	const int delayNumerators[8] = {0, 1, 1, 1, 1, 1, 2, 3};// delays are exact fractions of the sub clock's period:
+	const int delayDenominators[8] = {1, 16, 8, 4, 3, 2, 3, 4};//   0, 1/16, 1/8, 1/4, 1/3, 1/2, 2/3, 3/4
 	const float ratioValues[34] = {1, 1.5, 2, 2.5, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 19, 23, 24, 29, 31, 32, 37, 41, 43, 47, 48, 53, 59, 61, 64};
 	static const int bpmMax = 300;
 	static const int bpmMin = 30;
 	static constexpr float masterLengthMax = 120.0f / bpmMin;// a length is a double period
 	static constexpr float masterLengthMin = 120.0f / bpmMax;// a length is a double period
+	enum PllBandwidthIds {PLL_SMOOTH, PLL_NORMAL, PLL_FAST, NUM_PLL_BANDWIDTHS};
+	const double pllPeriodGains[NUM_PLL_BANDWIDTHS] = {0.05, 0.1, 0.3};// fraction of each interval's deviation that goes into the period
+	const double pllPhaseGains[NUM_PLL_BANDWIDTHS] = {0.15, 0.2, 0.5};// fraction of the phase error that is corrected over the next pulse
+	static constexpr double pllOutlierRatio = 0.3;// intervals that differ from the period by more than this are ignored (jitter spikes, lost pulses)...
+	static const int pllOutliersToRelock = 3;// ... unless this many come in a row (tempo change)
+	static constexpr double pllLockWindow = 0.05;// in external pulses, the phase error must stay within this for a double period to be locked
 	static constexpr float delayInfoTime = 3.0f;// seconds
 	static constexpr float swingInfoTime = 2.0f;// seconds
 	
 	// Need to save
 	int panelTheme = 0;
-	int expansion = 0;
+	int expansion = 0;// 1 for the expansion panel, 2 for the expansion panel and the sub-clock bank
 	bool displayDelayNoteMode = true;
 	bool bpmDetectionMode = false;
 	bool emitResetOnStopRun = false;
 	int ppqn = 4;
+	int pllBandwidth = PLL_NORMAL;
 	bool running;
 	
 	// No need to save
 	Clock clk[4];
 	ClockDelay delay[3];// only channels 1 to 3 have delay
+	std::unique_ptr<ClockBank> bank;// allocated the first time the bank runs
+	bool bankRunning;// bank shown (expansion == 2) at the start of the master's frame, so that the sub clocks of the bank see all the master's frame ends
+	int bankRatiosDoubled[ClockBank::NUM_CHANNELS];
 	bool syncRatios[4];// 0 index unused
 	int ratiosDoubled[4];
-	int extPulseNumber;// 0 to ppqn - 1
-	double extIntervalTime;
+	int extPulseNumber;// 0 to ppqn * 2 - 1
+	double extIntervalTime;// since the last external pulse
 	double timeoutTime;
+	double pllPeriod;// filtered time between external pulses, 0.0 when not yet measured
+	int pllOutliers;// consecutive intervals ignored
+	int pllLostPulses;// pulses counted as lost in those intervals
+	int pllLockCount;// consecutive pulses within pllLockWindow, locked when it reaches ppqn * 2
 	float newMasterLength;
 	float masterLength;
 	long editingBpmMode;// 0 when no edit bpmMode, downward step counter timer when edit, negative upward when show can't edit ("--") 
 	float pulseWidth[4];
 	float swingAmount[4];
-	long delaySamples[4];
+	int64_t delaySamples[4];
 	double sampleRate;
 	double sampleTime;
 	
@@ -260,7 +637,11 @@ struct Clocked : Module {
 	int notifyingSource[4] = {-1, -1, -1, -1};
 	long notifyInfo[4] = {0l, 0l, 0l, 0l};// downward step counter when swing to be displayed, 0 when normal display
 	long cantRunWarning = 0l;// 0 when no warning, positive downward step counter timer when warning
-	unsigned int lightRefreshCounter = 0;
+	long lockFlash = 0l;// upward light counter, for the flashing of the BPM light while not locked
+	RefreshCounter refresh;
+#ifdef IM_CPU_METER
+	CpuMeter cpuMeter;
+#endif
 	float resetLight = 0.0f;
 	SchmittTrigger resetTrigger;
 	SchmittTrigger runTrigger;
@@ -282,8 +663,14 @@ struct Clocked : Module {
 		// returns a positive ratio for mult, negative ratio for div (0 never returned)
 		if (ratioKnobIndex < 1) 
 			return 1;
+		return calcRatioDoubled(params[RATIO_PARAMS + ratioKnobIndex].value);
+	}
+	inline int getBankRatioDoubled(int channel) {
+		return calcRatioDoubled(params[BANK_RATIO_PARAMS + channel].value);
+	}
+	int calcRatioDoubled(float ratioKnobValue) {
 		bool isDivision = false;
-		int i = (int) round( params[RATIO_PARAMS + ratioKnobIndex].value );// [ -(numRatios-1) ; (numRatios-1) ]
+		int i = (int) round( ratioKnobValue );// [ -(numRatios-1) ; (numRatios-1) ]
 		if (i < 0) {
 			i *= -1;
 			isDivision = true;
@@ -312,18 +699,38 @@ struct Clocked : Module {
 				swingAmount[i] += (inputs[SWING_INPUTS + i].value / 5.0f) - 1.0f;
 				swingAmount[i] = clamp(swingAmount[i], -1.0f, 1.0f);
 			}
+			
+			clk[i].setPulse(swingAmount[i], pulseWidth[i]);
 		}
 
-		// Delay
-		delaySamples[0] = 0ul;
-		for (int i = 1; i < 4; i++) {	
-			int delayKnobIndex = (int)(params[DELAY_PARAMS + i].value + 0.5f);
-			float delayFraction = delayValues[delayKnobIndex];
-			float ratioValue = ((float)ratiosDoubled[i]) / 2.0f;
-			if (ratioValue < 0)
-				ratioValue = 1.0f / (-1.0f * ratioValue);
-			delaySamples[i] = (long)(masterLength * delayFraction * sampleRate / (ratioValue * 2.0));
-		}				
+		// Sub-clock bank (no CV inputs)
+		if (bank) {
+			for (int c = 0; c < ClockBank::NUM_CHANNELS; c++)
+				bank->setPulse(c, params[BANK_SWING_PARAMS + c].value, params[BANK_PW_PARAMS + c].value);
+		}
+		
+		updateDelaySamples();
+	}
+	
+	void updateDelaySamples() {// also called as soon as the master length or a ratio changes, see ClockDelay
+		delaySamples[0] = 0;
+		int64_t masterUnits = Clock::toUnits(masterLength, sampleTime);
+		for (int i = 1; i < 4; i++)
+			delaySamples[i] = calcDelaySamples(masterUnits, params[DELAY_PARAMS + i].value, ratiosDoubled[i]);
+		if (bank) {
+			for (int c = 0; c < ClockBank::NUM_CHANNELS; c++)
+				bank->setDelay(c, calcDelaySamples(masterUnits, params[BANK_DELAY_PARAMS + c].value, bankRatiosDoubled[c]));
+		}
+	}
+	
+	int64_t calcDelaySamples(int64_t masterUnits, float delayKnobValue, int ratioDoubled) {
+		int delayKnobIndex = (int)(delayKnobValue + 0.5f);
+		int64_t delayUnits;// fraction of the period of the sub clock, which is masterLength * ratio / 4 (div) or masterLength / ratio (mult), with ratio = ratioDoubled
+		if (ratioDoubled < 0)
+			delayUnits = (masterUnits * delayNumerators[delayKnobIndex] * (-ratioDoubled)) / (delayDenominators[delayKnobIndex] * 4);
+		else
+			delayUnits = (masterUnits * delayNumerators[delayKnobIndex]) / (delayDenominators[delayKnobIndex] * ratioDoubled);
+		return (delayUnits + Clock::ONE / 2) >> Clock::FRAC_BITS;
 	}
 	
 	
@@ -356,13 +763,26 @@ struct Clocked : Module {
 				delay[i].reset();
 			syncRatios[i] = false;
 			ratiosDoubled[i] = getRatioDoubled(i);
-			updatePulseSwingDelay();
 			outputs[CLK_OUTPUTS + i].value = 10.0f;
 		}
+		if (bank) {
+			bank->reset();
+			bank->resetDelays();
+		}
+		bankRunning = false;
+		for (int c = 0; c < ClockBank::NUM_CHANNELS; c++) {
+			bankRatiosDoubled[c] = getBankRatioDoubled(c);
+			outputs[BANK_CLK_OUTPUTS + c].value = 10.0f;
+		}
+		updatePulseSwingDelay();
 		extPulseNumber = -1;
 		extIntervalTime = 0.0;
 		timeoutTime = 2.0 / ppqn + 0.1;// worst case. This is a double period at 30 BPM (4s), divided by the expected number of edges in the double period 
 									   //   which is 2*ppqn, plus epsilon. This timeoutTime is only used for timingout the 2nd clock edge
+		pllPeriod = 0.0;
+		pllOutliers = 0;
+		pllLostPulses = 0;
+		pllLockCount = 0;
 		if (inputs[BPM_INPUT].active) {
 			if (bpmDetectionMode) {
 				if (hardReset)
@@ -402,6 +822,9 @@ struct Clocked : Module {
 		// ppqn
 		json_object_set_new(rootJ, "ppqn", json_integer(ppqn));
 		
+		// pllBandwidth
+		json_object_set_new(rootJ, "pllBandwidth", json_integer(pllBandwidth));
+		
 		return rootJ;
 	}
 
@@ -442,10 +865,76 @@ struct Clocked : Module {
 		if (ppqnJ)
 			ppqn = clamp(json_integer_value(ppqnJ), 4, 24);
 
+		// pllBandwidth
+		json_t *pllBandwidthJ = json_object_get(rootJ, "pllBandwidth");
+		if (pllBandwidthJ)
+			pllBandwidth = clamp((int)json_integer_value(pllBandwidthJ), 0, NUM_PLL_BANDWIDTHS - 1);
+
 		scheduledReset = true;
 	}
 
 	
+	// BPM detection: phase locked loop on the pulses of the external clock. The time between pulses is filtered into pllPeriod, and
+	//   the master length is set so that the master clock's phase (the fraction of its double period that it has done) moves towards
+	//   the one of the current pulse. Smooth bandwidths follow a jittery clock with a steady master length, fast ones follow tempo changes sooner
+	float calcPllMasterLength(double interval) {
+		int pulsesPerLength = ppqn * 2;
+		bool lostPulse = pllPeriod > 0.0 && fabs(interval - 2.0 * pllPeriod) < pllOutlierRatio * pllPeriod;
+		bool outlier = pllPeriod > 0.0 && fabs(interval - pllPeriod) > pllOutlierRatio * pllPeriod;
+		bool maybeLost = false;
+		if (outlier) {
+			pllOutliers++;
+			pllLockCount = 0;
+			if (pllOutliers < pllOutliersToRelock) {
+				if (!lostPulse)
+					return masterLength;
+				// maybe one lost pulse: count it and keep following the phase, the next interval tells (back to the period: it was lost, double again: tempo change)
+				pllLostPulses++;
+				extPulseNumber++;
+				if (extPulseNumber >= pulsesPerLength)
+					extPulseNumber = 0;
+				maybeLost = true;
+			}
+			else {// tempo change, the pulses counted as lost were not
+				extPulseNumber -= pllLostPulses;
+				if (extPulseNumber < 0)
+					extPulseNumber += pulsesPerLength;
+			}
+		}
+		double phaseGain = pllPhaseGains[pllBandwidth];
+		if (!maybeLost) {
+			pllOutliers = 0;
+			pllLostPulses = 0;
+			if (pllPeriod <= 0.0 || outlier) {// first interval or tempo change, start over from this interval and align in one pulse
+				pllPeriod = interval;
+				phaseGain = 1.0;
+			}
+			else
+				pllPeriod += pllPeriodGains[pllBandwidth] * (interval - pllPeriod);
+		}
+		
+		// phase error, in external pulses
+		double phaseError = std::max(clk[0].getStep(), 0.0) / (double)masterLength * pulsesPerLength - extPulseNumber;
+		if (phaseError > ppqn)
+			phaseError -= pulsesPerLength;
+		else if (phaseError < -ppqn)
+			phaseError += pulsesPerLength;
+		if (!maybeLost && fabs(phaseError) < pllLockWindow) {
+			if (pllLockCount < pulsesPerLength)
+				pllLockCount++;
+		}
+		else
+			pllLockCount = 0;
+		
+		// master speed relative to the external clock; a gain of 1 would cancel the phase error by the next pulse
+		double speed = 1.0 - std::max(std::min(phaseGain * phaseError, 0.5), -0.5);
+		return clamp((float)(pllPeriod * pulsesPerLength / speed), masterLengthMin / 1.5f, masterLengthMax * 1.5f);// extended range for better sync ability (20-450 BPM)
+	}
+	inline bool isPllLocked() {
+		return pllLockCount >= ppqn * 2;
+	}
+	
+	
 	void onSampleRateChange() override {
 		sampleRate = (double)engineGetSampleRate();
 		sampleTime = 1.0 / sampleRate;
@@ -454,6 +943,7 @@ struct Clocked : Module {
 	
 
 	void step() override {		
+		IM_CPU_METER_BEGIN(cpuMeter);
 
 		// Scheduled reset
 		if (scheduledReset) {
@@ -473,7 +963,7 @@ struct Clocked : Module {
 				}
 			}
 			else
-				cantRunWarning = (long) (0.7 * sampleRate / displayRefreshStepSkips);
+				cantRunWarning = (long) (0.7 * sampleRate / refresh.lightSkips);
 		}
 
 		// Reset (has to be near top because it sets steps to 0, and 0 not a real step (clock section will move to 1 before reaching outputs)
@@ -483,7 +973,7 @@ struct Clocked : Module {
 			resetClocked(false);	
 		}	
 
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 
 			updatePulseSwingDelay();
 		
@@ -505,9 +995,10 @@ struct Clocked : Module {
 							bpmDetectionMode = false;
 					}
 				}
-				editingBpmMode = (long) (3.0 * sampleRate / displayRefreshStepSkips);
+				editingBpmMode = (long) (3.0 * sampleRate / refresh.lightSkips);
 			}
 			
+			IM_CPU_METER_MARK(cpuMeter, SECT_INPUTS);
 		}// userInputs refresh
 	
 		// BPM input and knob
@@ -527,18 +1018,16 @@ struct Clocked : Module {
 						resetClocked(false);
 					}
 					if (running) {
+						bool firstPulse = (extPulseNumber == -1);
 						extPulseNumber++;
 						if (extPulseNumber >= ppqn * 2)// *2 because working with double_periods
 							extPulseNumber = 0;
-						if (extPulseNumber == 0)// if first pulse, start interval timer
-							extIntervalTime = 0.0;
-						else {
-							// all other ppqn pulses except the first one. now we have an interval upon which to plan a strecth 
-							double timeLeft = extIntervalTime * (double)(ppqn * 2 - extPulseNumber) / ((double)extPulseNumber);
-							newMasterLength = clamp(clk[0].getStep() + timeLeft, masterLengthMin / 1.5f, masterLengthMax * 1.5f);// extended range for better sync ability (20-450 BPM)
-							timeoutTime = extIntervalTime * ((double)(1 + extPulseNumber) / ((double)extPulseNumber)) + 0.1; // when a second or higher clock edge is received, 
-							//  the timeout is the predicted next edge (whici is extIntervalTime + extIntervalTime / extPulseNumber) plus epsilon
+						if (!firstPulse) {
+							// all other pulses: now we have an interval to track
+							newMasterLength = calcPllMasterLength(extIntervalTime);
+							timeoutTime = pllPeriod * 2.0 + 0.1;// the timeout is the predicted edge after next (one pulse can be lost) plus epsilon
 						}
+						extIntervalTime = 0.0;
 					}
 				}
 				if (running) {
@@ -568,7 +1057,10 @@ struct Clocked : Module {
 			for (int i = 0; i < 4; i++) {
 				clk[i].applyNewLength(lengthStretchFactor);
 			}
+			if (bank)
+				bank->applyNewLength(lengthStretchFactor);
 			masterLength = newMasterLength;
+			updateDelaySamples();
 		}
 		
 		
@@ -580,59 +1072,81 @@ struct Clocked : Module {
 			// Master clock
 			if (clk[0].isReset()) {
 				// See if ratio knobs changed (or unitinialized)
+				bool ratiosChanged = false;
 				for (int i = 1; i < 4; i++) {
 					if (syncRatios[i]) {// unused (undetermined state) for master
 						clk[i].reset();// force reset (thus refresh) of that sub-clock
 						ratiosDoubled[i] = getRatioDoubled(i);
 						syncRatios[i] = false;
+						ratiosChanged = true;
 					}
 				}
 				clk[0].setup(masterLength, 1, sampleTime);// must call setup before start. length = double_period
 				clk[0].start();
+				
+				// Sub-clock bank, whose ratio changes are taken here (no sync lights)
+				bankRunning = (expansion == 2);
+				if (bankRunning && !bank) {// latched here rather than in the menu, so that the engine never sees a bank under construction
+					bank.reset(new ClockBank);
+					updatePulseSwingDelay();
+				}
+				if (bank) {
+					for (int c = 0; c < ClockBank::NUM_CHANNELS; c++) {
+						if (!bankRunning)
+							bank->reset(c);
+						else {
+							int ratioDoubled = getBankRatioDoubled(c);
+							if (ratioDoubled != bankRatiosDoubled[c]) {
+								bank->reset(c);
+								bankRatiosDoubled[c] = ratioDoubled;
+								ratiosChanged = true;
+							}
+							if (bank->isReset(c))
+								bank->start(c, masterLength, bankRatiosDoubled[c], sampleTime, clk[0].getStepUnits());
+						}
+					}
+				}
+				if (ratiosChanged)
+					updateDelaySamples();
 			}
-			outputs[CLK_OUTPUTS + 0].value = clk[0].isHigh(swingAmount[0], pulseWidth[0]) ? 10.0f : 0.0f;		
+			outputs[CLK_OUTPUTS + 0].value = clk[0].isHigh() ? 10.0f : 0.0f;		
 			
 			// Sub clocks
 			for (int i = 1; i < 4; i++) {
 				if (clk[i].isReset()) {
-					double length;
-					int iterations;
-					int ratioDoubled = ratiosDoubled[i];
-					if (ratioDoubled < 0) { // if div 
-						ratioDoubled *= -1;
-						length = masterLength * ((double)ratioDoubled) / 2.0;
-						iterations = 1l + (ratioDoubled % 2);		
-						clk[i].setup(length, iterations, sampleTime);
-					}
-					else {// mult 
-						length = (2.0f * masterLength) / ((double)ratioDoubled);
-						iterations = ratioDoubled / (2l - (ratioDoubled % 2l));							
-						clk[i].setup(length, iterations, sampleTime);
-					}
+					clk[i].setup(masterLength, ratiosDoubled[i], sampleTime);
 					clk[i].start();
 				}
-				delay[i - 1].write(clk[i].isHigh(swingAmount[i], pulseWidth[i]));
+				delay[i - 1].write(clk[i].isHigh());
 				outputs[CLK_OUTPUTS + i].value = delay[i - 1].read(delaySamples[i]) ? 10.0f : 0.0f;
 			}
+			if (bankRunning) {
+				for (int c = 0; c < ClockBank::NUM_CHANNELS; c++)
+					outputs[BANK_CLK_OUTPUTS + c].value = bank->isDelayedHigh(c) ? 10.0f : 0.0f;
+			}
 
 			// Step clocks
 			for (int i = 0; i < 4; i++)
 				clk[i].stepClock();
+			if (bankRunning)
+				bank->stepClocks(clk[0].isReset());
 		}
 			
+		IM_CPU_METER_MARK(cpuMeter, SECT_CLOCK);
+		
 		// Chaining outputs
 		outputs[RESET_OUTPUT].value = (resetPulse.process((float)sampleTime) ? 10.0f : 0.0f);
 		outputs[RUN_OUTPUT].value = (runPulse.process((float)sampleTime) ? 10.0f : 0.0f);
 		outputs[BPM_OUTPUT].value =  inputs[BPM_INPUT].active ? inputs[BPM_INPUT].value : log2f(1.0f / masterLength);
 			
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		IM_CPU_METER_MARK(cpuMeter, SECT_OUTPUTS);
+
+		if (refresh.processLights()) {
 
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;	
-			resetLight -= (resetLight / lightLambda) * (float)sampleTime * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * (float)sampleTime * refresh.lightSkips;
 			
 			// Run light
 			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
@@ -640,7 +1154,12 @@ struct Clocked : Module {
 			// BPM light
 			bool warningFlashState = true;
 			if (cantRunWarning > 0l) 
-				warningFlashState = calcWarningFlash(cantRunWarning, (long) (0.7 * sampleRate / displayRefreshStepSkips));
+				warningFlashState = calcWarningFlash(cantRunWarning, (long) (0.7 * sampleRate / refresh.lightSkips));
+			else if (bpmDetectionMode && inputs[BPM_INPUT].active && running && !isPllLocked()) {// flashes while following the external clock
+				long lockFlashSteps = (long) (0.5 * sampleRate / refresh.lightSkips);
+				lockFlash = (lockFlash + 1) % lockFlashSteps;
+				warningFlashState = lockFlash < lockFlashSteps / 2;
+			}
 			lights[BPMSYNC_LIGHT + 0].value = (bpmDetectionMode && warningFlashState) ? 1.0f : 0.0f;
 			lights[BPMSYNC_LIGHT + 1].value = (bpmDetectionMode && warningFlashState) ? (float)((ppqn - 4)*(ppqn - 4))/400.0f : 0.0f;			
 			
@@ -659,8 +1178,41 @@ struct Clocked : Module {
 			editingBpmMode--;
 			if (editingBpmMode < 0l)
 				editingBpmMode = 0l;
-		}// lightRefreshCounter
+			IM_CPU_METER_MARK(cpuMeter, SECT_LIGHTS);
+		}// processLights()
+		IM_CPU_METER_END(cpuMeter);
 	}// step()
+	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {
+		if (scheduledReset || resetPulse.time < resetPulse.triggerDuration || runPulse.time < runPulse.triggerDuration)
+			return 0l;
+		if (!running)
+			return LONG_MAX;
+		if (bpmDetectionMode && inputs[BPM_INPUT].active)
+			return 0l;// interval timer and timeout run every sample
+		long idleSteps = LONG_MAX;
+		for (int i = 0; i < 4; i++)
+			idleSteps = std::min(idleSteps, clk[i].calcIdleSteps());
+		for (int i = 1; i < 4; i++)
+			idleSteps = std::min(idleSteps, delay[i - 1].calcIdleSteps(delaySamples[i]));
+		if (bankRunning)
+			idleSteps = std::min(idleSteps, bank->calcIdleSteps());
+		return idleSteps;
+	}
+	inline void skipIdleSteps(long n) {
+		if (running) {
+			for (int i = 0; i < 4; i++)
+				clk[i].skipIdleSteps(n);
+			for (int i = 1; i < 4; i++)
+				delay[i - 1].skipIdleSteps(n);
+			if (bankRunning)
+				bank->skipIdleSteps(n);
+		}
+	}
 };
 
 
@@ -669,7 +1221,10 @@ struct ClockedWidget : ModuleWidget {
 	DynamicSVGPanel *panel;
 	int oldExpansion;
 	int expWidth = 60;
+	int bankWidth = 180;
+	int expBorderWidth = 60 + 180;// expWidth + bankWidth, for the border of the main panel (see PanelBorderWidget)
 	IMPort* expPorts[6];
+	IMPort* bankPorts[ClockBank::NUM_CHANNELS];
 
 
 	struct RatioDisplayWidget : TransparentWidget {
@@ -685,15 +1240,7 @@ struct ClockedWidget : ModuleWidget {
 			font = Font::load(assetPlugin(plugin, "res/fonts/Segment14.ttf"));
 		}
 		
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
-			//nvgTextLetterSpacing(vg, 2.5);
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
+		void printText() {
 			if (module->notifyInfo[knobIndex] > 0l)
 			{
 				int srcParam = module->notifyingSource[knobIndex];
@@ -718,22 +1265,27 @@ struct ClockedWidget : ModuleWidget {
 					int pwInt = ((int)round(pwValue * 98.0f)) + 1;
 					snprintf(displayStr, 4, "_%2u", (unsigned) abs(pwInt));
 				}					
+				else if ( (srcParam >= Clocked::BANK_RATIO_PARAMS) && (srcParam < Clocked::BANK_RATIO_PARAMS + ClockBank::NUM_CHANNELS) )
+					printRatio(module->getBankRatioDoubled(srcParam - Clocked::BANK_RATIO_PARAMS));
+				else if ( (srcParam >= Clocked::BANK_SWING_PARAMS) && (srcParam < Clocked::BANK_SWING_PARAMS + ClockBank::NUM_CHANNELS) ) {
+					int swInt = (int)round(module->params[srcParam].value * 99.0f);
+					snprintf(displayStr, 4, "%c%2u", swInt < 0 ? '-' : '+', (unsigned) abs(swInt));
+				}
+				else if ( (srcParam >= Clocked::BANK_PW_PARAMS) && (srcParam < Clocked::BANK_PW_PARAMS + ClockBank::NUM_CHANNELS) ) {
+					int pwInt = ((int)round(module->params[srcParam].value * 98.0f)) + 1;
+					snprintf(displayStr, 4, "_%2u", (unsigned) abs(pwInt));
+				}
+				else if ( (srcParam >= Clocked::BANK_DELAY_PARAMS) && (srcParam < Clocked::BANK_DELAY_PARAMS + ClockBank::NUM_CHANNELS) ) {
+					int delayKnobIndex = (int)(module->params[srcParam].value + 0.5f);
+					if (module->displayDelayNoteMode)
+						snprintf(displayStr, 4, "%s", (delayLabelsNote[delayKnobIndex]).c_str());
+					else
+						snprintf(displayStr, 4, "%s", (delayLabelsClock[delayKnobIndex]).c_str());
+				}
 			}
 			else {
 				if (knobIndex > 0) {// ratio to display
-					bool isDivision = false;
-					int ratioDoubled = module->getRatioDoubled(knobIndex);
-					if (ratioDoubled < 0) {
-						ratioDoubled = -1 * ratioDoubled;
-						isDivision = true;
-					}
-					if ( (ratioDoubled % 2) == 1 )
-						snprintf(displayStr, 4, "%c,5", 0x30 + (char)(ratioDoubled / 2));
-					else {
-						snprintf(displayStr, 4, "X%2u", (unsigned)(ratioDoubled / 2));
-						if (isDivision)
-							displayStr[0] = '/';
-					}
+					printRatio(module->getRatioDoubled(knobIndex));
 				}
 				else {// BPM to display
 					if (module->editingBpmMode != 0l) {
@@ -747,6 +1299,38 @@ struct ClockedWidget : ModuleWidget {
 				}
 			}
 			displayStr[3] = 0;// more safety
+		}
+		
+		void printRatio(int ratioDoubled) {
+			bool isDivision = false;
+			if (ratioDoubled < 0) {
+				ratioDoubled = -1 * ratioDoubled;
+				isDivision = true;
+			}
+			if ( (ratioDoubled % 2) == 1 )
+				snprintf(displayStr, 4, "%c,5", 0x30 + (char)(ratioDoubled / 2));
+			else {
+				snprintf(displayStr, 4, "X%2u", (unsigned)(ratioDoubled / 2));
+				if (isDivision)
+					displayStr[0] = '/';
+			}
+		}
+		
+		uint64_t calcStateHash() {// see CachedDisplay
+			printText();
+			return hashDisplayText(displayStr);
+		}
+		
+		void draw(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, font->handle);
+			//nvgTextLetterSpacing(vg, 2.5);
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
+			printText();
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -764,7 +1348,13 @@ struct ClockedWidget : ModuleWidget {
 	struct ExpansionItem : MenuItem {
 		Clocked *module;
 		void onAction(EventAction &e) override {
-			module->expansion = module->expansion == 1 ? 0 : 1;
+			module->expansion = module->expansion != 0 ? 0 : 1;
+		}
+	};
+	struct BankItem : MenuItem {
+		Clocked *module;
+		void onAction(EventAction &e) override {
+			module->expansion = module->expansion == 2 ? 1 : 2;
 		}
 	};
 	struct DelayDisplayNoteItem : MenuItem {
@@ -779,6 +1369,20 @@ struct ClockedWidget : ModuleWidget {
 			module->emitResetOnStopRun = !module->emitResetOnStopRun;
 		}
 	};	
+	struct PllBandwidthItem : MenuItem {
+		Clocked *module;
+		void onAction(EventAction &e) override {
+			module->pllBandwidth = (module->pllBandwidth + 1) % Clocked::NUM_PLL_BANDWIDTHS;
+		}
+		void step() override {
+			if (module->pllBandwidth == Clocked::PLL_SMOOTH)
+				text = "BPM Detect: <Smooth>,  Normal,  Fast";
+			else if (module->pllBandwidth == Clocked::PLL_NORMAL)
+				text = "BPM Detect: Smooth,  <Normal>,  Fast";
+			else
+				text = "BPM Detect: Smooth,  Normal,  <Fast>";
+		}	
+	};
 	Menu *createContextMenu() override {
 		Menu *menu = ModuleWidget::createContextMenu();
 
@@ -818,6 +1422,13 @@ struct ClockedWidget : ModuleWidget {
 		erItem->module = module;
 		menu->addChild(erItem);
 
+		PllBandwidthItem *pllItem = MenuItem::create<PllBandwidthItem>("BPM Detect: ", "");
+		pllItem->module = module;
+		menu->addChild(pllItem);
+		MenuLabel *pllLabel = new MenuLabel();
+		pllLabel->text = "    (Smooth: least jitter, Fast: follows tempo changes sooner)";
+		menu->addChild(pllLabel);
+
 		menu->addChild(new MenuLabel());// empty line
 		
 		MenuLabel *expansionLabel = new MenuLabel();
@@ -828,6 +1439,14 @@ struct ClockedWidget : ModuleWidget {
 		expItem->module = module;
 		menu->addChild(expItem);
 
+		BankItem *bankItem = MenuItem::create<BankItem>("Sub-clock bank", CHECKMARK(module->expansion == 2));
+		bankItem->module = module;
+		menu->addChild(bankItem);
+
+#ifdef IM_CPU_METER
+		addCpuMeterMenu(menu, &module->cpuMeter);// ImpromptuModular.hpp
+#endif
+
 		return menu;
 	}	
 	
@@ -837,17 +1456,25 @@ struct ClockedWidget : ModuleWidget {
 				for (int i = 0; i < 6; i++)
 					gRackWidget->wireContainer->removeAllWires(expPorts[i]);
 			}
+			if (oldExpansion!= -1 && module->expansion < 2) {// same for the sub-clock bank
+				for (int c = 0; c < ClockBank::NUM_CHANNELS; c++)
+					gRackWidget->wireContainer->removeAllWires(bankPorts[c]);
+			}
 			oldExpansion = module->expansion;		
 		}
-		box.size.x = panel->box.size.x - (1 - module->expansion) * expWidth;
+		box.size.x = calcWidth(module->expansion);
 		Widget::step();
 	}
 	
+	int calcWidth(int expansion) {
+		return panel->box.size.x - (expansion < 2 ? bankWidth : 0) - (expansion < 1 ? expWidth : 0);
+	}
+	
 	struct IMSmallKnobNotify : IMSmallKnob {
 		IMSmallKnobNotify() {};
 		void onDragMove(EventDragMove &e) override {
 			Clocked *module = dynamic_cast<Clocked*>(this->module);
-			int dispIndex = 0;
+			int dispIndex = 0;// sub-clock bank knobs are shown on the BPM display
 			if ( (paramId >= Clocked::SWING_PARAMS + 0) && (paramId <= Clocked::SWING_PARAMS + 3) )
 				dispIndex = paramId - Clocked::SWING_PARAMS;
 			else if ( (paramId >= Clocked::DELAY_PARAMS + 1) && (paramId <= Clocked::DELAY_PARAMS + 3) )
@@ -855,7 +1482,7 @@ struct ClockedWidget : ModuleWidget {
 			else if ( (paramId >= Clocked::PW_PARAMS + 0) && (paramId <= Clocked::PW_PARAMS + 3) )
 				dispIndex = paramId - Clocked::PW_PARAMS;
 			module->notifyingSource[dispIndex] = paramId;
-			module->notifyInfo[dispIndex] = (long) (Clocked::delayInfoTime * module->sampleRate / displayRefreshStepSkips);
+			module->notifyInfo[dispIndex] = (long) (Clocked::delayInfoTime * module->sampleRate / module->refresh.lightSkips);
 			Knob::onDragMove(e);
 		}
 	};
@@ -885,11 +1512,11 @@ struct ClockedWidget : ModuleWidget {
 		// Main panel from Inkscape
         panel = new DynamicSVGPanel();
         panel->mode = &module->panelTheme;
-		panel->expWidth = &expWidth;
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Clocked.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/Clocked_dark.svg")));
+		panel->expWidth = &expBorderWidth;
+        panel->addPanel(assetPlugin(plugin, "res/light/Clocked.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/Clocked_dark.svg"));
         box.size = panel->box.size;
-		box.size.x = box.size.x - (1 - module->expansion) * expWidth;
+		box.size.x = calcWidth(module->expansion);
         addChild(panel);		
 		
 		// Screws
@@ -897,8 +1524,10 @@ struct ClockedWidget : ModuleWidget {
 		addChild(createDynamicScrew<IMScrew>(Vec(15, 365), &module->panelTheme));
 		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 0), &module->panelTheme));
 		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30, 365), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 0), &module->panelTheme));
-		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-expWidth, 365), &module->panelTheme));
+		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-bankWidth, 0), &module->panelTheme));
+		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-bankWidth, 365), &module->panelTheme));
+		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-bankWidth-expWidth, 0), &module->panelTheme));
+		addChild(createDynamicScrew<IMScrew>(Vec(panel->box.size.x-30-bankWidth-expWidth, 365), &module->panelTheme));
 
 
 		static const int rowRuler0 = 50;//reset,run inputs, master knob and bpm display
@@ -941,7 +1570,7 @@ struct ClockedWidget : ModuleWidget {
 		displayRatios[0]->box.size = Vec(55, 30);// 3 characters
 		displayRatios[0]->module = module;
 		displayRatios[0]->knobIndex = 0;
-		addChild(displayRatios[0]);
+		addChild(createCachedDisplay(displayRatios[0]));
 		
 		// Row 1
 		// Reset LED bezel and light
@@ -971,7 +1600,7 @@ struct ClockedWidget : ModuleWidget {
 			displayRatios[i + 1]->box.size = Vec(55, 30);// 3 characters
 			displayRatios[i + 1]->module = module;
 			displayRatios[i + 1]->knobIndex = i + 1;
-			addChild(displayRatios[i + 1]);
+			addChild(createCachedDisplay(displayRatios[i + 1]));
 			// Sync light
 			addChild(createLight<SmallLight<RedLight>>(Vec(colRulerM1 + 62, rowRuler2 + i * rowSpacingClks + 10), module, Clocked::CLK_LIGHTS + i + 1));		
 			// Swing knobs
@@ -1004,6 +1633,26 @@ struct ClockedWidget : ModuleWidget {
 		addInput(expPorts[3] = createDynamicPort<IMPort>(Vec(colRulerExp, rowRulerExpTop + rowSpacingExp * 3), Port::INPUT, module, Clocked::SWING_INPUTS + 0, &module->panelTheme));
 		addInput(expPorts[4] = createDynamicPort<IMPort>(Vec(colRulerExp, rowRulerExpTop + rowSpacingExp * 4), Port::INPUT, module, Clocked::SWING_INPUTS + 1, &module->panelTheme));
 		addInput(expPorts[5] = createDynamicPort<IMPort>(Vec(colRulerExp, rowRulerExpTop + rowSpacingExp * 5), Port::INPUT, module, Clocked::SWING_INPUTS + 2, &module->panelTheme));
+		
+		// Sub-clock bank
+		static const int rowRulerBankTop = 32;
+		static const int rowSpacingBank = 27;
+		static const int colRulerBank0 = 360 + 12;// ratio knobs
+		static const int colSpacingBank = 30;
+		static const int colRulerBank4 = colRulerBank0 + colSpacingBank * 4 + 4;// outputs
+		for (int c = 0; c < ClockBank::NUM_CHANNELS; c++) {
+			int rowRulerBank = rowRulerBankTop + rowSpacingBank * c;
+			// Ratio knob
+			addParam(createDynamicParam<IMSmallSnapKnobNotify>(Vec(colRulerBank0 + offsetIMSmallKnob, rowRulerBank + offsetIMSmallKnob), module, Clocked::BANK_RATIO_PARAMS + c, (34.0f - 1.0f)*-1.0f, 34.0f - 1.0f, 0.0f, &module->panelTheme));
+			// Swing knob
+			addParam(createDynamicParam<IMSmallKnobNotify>(Vec(colRulerBank0 + colSpacingBank * 1 + offsetIMSmallKnob, rowRulerBank + offsetIMSmallKnob), module, Clocked::BANK_SWING_PARAMS + c, -1.0f, 1.0f, 0.0f, &module->panelTheme));
+			// PW knob
+			addParam(createDynamicParam<IMSmallKnobNotify>(Vec(colRulerBank0 + colSpacingBank * 2 + offsetIMSmallKnob, rowRulerBank + offsetIMSmallKnob), module, Clocked::BANK_PW_PARAMS + c, 0.0f, 1.0f, 0.5f, &module->panelTheme));
+			// Delay knob
+			addParam(createDynamicParam<IMSmallSnapKnobNotify>(Vec(colRulerBank0 + colSpacingBank * 3 + offsetIMSmallKnob, rowRulerBank + offsetIMSmallKnob), module, Clocked::BANK_DELAY_PARAMS + c, 0.0f, 8.0f - 1.0f, 0.0f, &module->panelTheme));
+			// Clock output
+			addOutput(bankPorts[c] = createDynamicPort<IMPort>(Vec(colRulerBank4, rowRulerBank), Port::OUTPUT, module, Clocked::BANK_CLK_OUTPUTS + c, &module->panelTheme));
+		}
 	}
 };
 
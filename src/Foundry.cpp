@@ -14,7 +14,7 @@
 #include "FoundryUtil.hpp"
 
 
-struct Foundry : Module {	
+struct Foundry : Module, BlockProcessor {	
 	enum ParamIds {
 		EDIT_PARAM,
 		PHRASE_PARAM,
@@ -86,6 +86,7 @@ struct Foundry : Module {
 		VEL_SLIDE_LIGHT,
 		NUM_LIGHTS
 	};
+	enum EditIds {EDIT_PANEL_THEME, EDIT_EXPANSION, EDIT_RESET_ON_RUN, EDIT_AUTOSEQ, EDIT_SEQCV_METHOD, EDIT_VEL_MODE, EDIT_HOLD_TIED, EDIT_SLIDE_SHAPE, EDIT_VELOCITY_KNOB_DEFAULT, EDIT_SEQUENCE_KNOB_DEFAULT, EDIT_PHRASE_KNOB_DEFAULT, EDIT_UNDO, EDIT_REDO};// see applyEdit()
 	
 	// Constants
 	enum EditPSDisplayStateIds {DISP_NORMAL, DISP_MODE_SEQ, DISP_MODE_SONG, DISP_LEN, DISP_REPS, DISP_TRANSPOSE, DISP_ROTATE, DISP_PPQN, DISP_DELAY, DISP_COPY_SEQ, DISP_PASTE_SEQ, DISP_COPY_SONG, DISP_PASTE_SONG};
@@ -95,6 +96,7 @@ struct Foundry : Module {
 	int expansion = 0;
 	int velocityMode = 0;
 	bool holdTiedNotes = true;
+	int slideShape = SLIDE_LINEAR;// see SlideGenerator
 	bool autoseq;
 	bool showSharp = true;
 	int seqCVmethod = 0;// 0 is 0-10V, 1 is C2-D7#, 2 is TrigIncr
@@ -117,7 +119,11 @@ struct Foundry : Module {
 	int clkInSources[Sequencer::NUM_TRACKS];// first index is always 0 and will never change
 	
 
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
+	EditQueue editQueue;// edits from the widgets, see ImpromptuModular.hpp
+#ifdef IM_CPU_METER
+	CpuMeter cpuMeter;
+#endif
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	int velocityKnob = 0;
@@ -126,7 +132,7 @@ struct Foundry : Module {
 	SchmittTrigger leftTrigger;
 	SchmittTrigger rightTrigger;
 	SchmittTrigger runningTrigger;
-	SchmittTrigger clockTriggers[SequencerKernel::MAX_STEPS];
+	ClockTrigger clockTriggers[SequencerKernel::MAX_STEPS];
 	SchmittTrigger keyTriggers[12];
 	SchmittTrigger octTriggers[7];
 	SchmittTrigger gate1Trigger;
@@ -163,7 +169,7 @@ struct Foundry : Module {
 
 	
 	Foundry() : Module(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
-		seq.construct(&holdTiedNotes, &velocityMode);
+		seq.construct(&holdTiedNotes, &velocityMode, &slideShape);
 		onReset();
 	}
 
@@ -214,6 +220,9 @@ struct Foundry : Module {
 		// holdTiedNotes
 		json_object_set_new(rootJ, "holdTiedNotes", json_boolean(holdTiedNotes));
 		
+		// slideShape
+		json_object_set_new(rootJ, "slideShape", json_integer(slideShape));
+		
 		// showSharp
 		json_object_set_new(rootJ, "showSharp", json_boolean(showSharp));
 		
@@ -264,6 +273,11 @@ struct Foundry : Module {
 		if (holdTiedNotesJ)
 			holdTiedNotes = json_is_true(holdTiedNotesJ);
 		
+		// slideShape
+		json_t *slideShapeJ = json_object_get(rootJ, "slideShape");
+		if (slideShapeJ)
+			slideShape = clamp((int)json_integer_value(slideShapeJ), 0, NUM_SLIDE_SHAPES - 1);
+		
 		// showSharp
 		json_t *showSharpJ = json_object_get(rootJ, "showSharp");
 		if (showSharpJ)
@@ -301,7 +315,124 @@ struct Foundry : Module {
 	}
 
 
+	void applyEdit(EditCommand command) {
+		switch (command.id) {
+			case EDIT_PANEL_THEME :
+				panelTheme = command.value;
+			break;
+			case EDIT_EXPANSION :
+				expansion = expansion == 1 ? 0 : 1;
+			break;
+			case EDIT_RESET_ON_RUN :
+				resetOnRun = !resetOnRun;
+			break;
+			case EDIT_AUTOSEQ :
+				autoseq = !autoseq;
+			break;
+			case EDIT_SEQCV_METHOD :
+				seqCVmethod++;
+				if (seqCVmethod > 2)
+					seqCVmethod = 0;
+			break;
+			case EDIT_VEL_MODE :
+				velocityMode++;
+				if (velocityMode > 2)
+					velocityMode = 0;
+			break;
+			case EDIT_HOLD_TIED :
+				holdTiedNotes = !holdTiedNotes;
+			break;
+			case EDIT_SLIDE_SHAPE :
+				slideShape++;
+				if (slideShape >= NUM_SLIDE_SHAPES)
+					slideShape = SLIDE_LINEAR;
+			break;
+			case EDIT_VELOCITY_KNOB_DEFAULT :
+				velocityKnobDefault();
+			break;
+			case EDIT_SEQUENCE_KNOB_DEFAULT :
+				sequenceKnobDefault();
+			break;
+			case EDIT_PHRASE_KNOB_DEFAULT :
+				phraseKnobDefault();
+			break;
+			case EDIT_UNDO :
+				if (seq.undo())
+					displayState = DISP_NORMAL;
+			break;
+			case EDIT_REDO :
+				if (seq.redo())
+					displayState = DISP_NORMAL;
+			break;
+		}
+	}
+	
+	void velocityKnobDefault() {// right-click on the velocity knob
+		// same code structure below as in velocity knob in main step()
+		if (isEditingSequence() && !attached) {
+			int multiStepsCount = multiSteps ? getCPMode() : 1;
+			if (velEditMode == 2) {
+				seq.initSlideVal(multiStepsCount, multiTracks);
+			}
+			else if (velEditMode == 1) {
+				seq.initGatePVal(multiStepsCount, multiTracks);
+			}
+			else {
+				seq.initVelocityVal(multiStepsCount, multiTracks);
+			}
+			displayState = DISP_NORMAL;
+		}
+	}
+	
+	void sequenceKnobDefault() {// right-click on the sequence knob
+		// same code structure below as in sequence knob in main step()
+		if (displayState == DISP_LEN) {
+			seq.initLength(multiTracks);
+		}
+		else if (displayState == DISP_TRANSPOSE) {
+			seq.unTransposeSeq(multiTracks);
+		}
+		else if (displayState == DISP_ROTATE) {
+			seq.rotateSeq(&rotateOffset, rotateOffset * -1, multiTracks);
+		}							
+		else if (displayState == DISP_REPS) {
+			seq.initPhraseReps(multiTracks);
+		}
+		else if (!attached) {
+			if (isEditingSequence()) {
+				if (!inputs[SEQCV_INPUT].active)
+					seq.setSeqIndexEdit(0);
+			}
+			else {// editing song
+				seq.initPhraseSeqNum(multiTracks);
+			}
+			displayState = DISP_NORMAL;
+		}
+	}
+	
+	void phraseKnobDefault() {// right-click on the phrase knob
+		// same code structure below as in phrase knob in main step()
+		if (displayState == DISP_MODE_SEQ) {
+			seq.initRunModeSeq(multiTracks);
+		}
+		else if (displayState == DISP_PPQN) {
+			seq.initPulsesPerStep(multiTracks);
+		}
+		else if (displayState == DISP_DELAY) {
+			seq.initDelay(multiTracks);
+		}
+		else if (displayState == DISP_MODE_SONG) {
+			seq.initRunModeSong(multiTracks);
+		}
+		else if (!isEditingSequence() && !attached) {
+			seq.setPhraseIndexEdit(0);
+			displayState = DISP_NORMAL;
+		}
+	}
+	
+	
 	void step() override {
+		IM_CPU_METER_BEGIN(cpuMeter);
 		const float sampleRate = engineGetSampleRate();
 		static const float revertDisplayTime = 0.7f;// seconds
 		static const float warningTime = 0.7f;// seconds
@@ -327,7 +458,11 @@ struct Foundry : Module {
 			multiTracks = false;
 		}
 
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
+			// Edits from the widgets
+			EditCommand editCommand;
+			while (editQueue.pop(&editCommand))
+				applyEdit(editCommand);
 			
 			// Seq CV input
 			if (inputs[SEQCV_INPUT].active) {
@@ -374,10 +509,10 @@ struct Foundry : Module {
 						seq.copySong(cpMode);
 						displayState = DISP_COPY_SONG;
 					}
-					revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+					revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 				}
 				else
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}
 			// Paste 
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
@@ -390,10 +525,10 @@ struct Foundry : Module {
 						seq.pasteSong(multiTracks);
 						displayState = DISP_PASTE_SONG;
 					}
-					revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+					revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 				}
 				else
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}			
 			
 
@@ -418,7 +553,7 @@ struct Foundry : Module {
 						seq.autostep(autoseq && !inputs[SEQCV_INPUT].active);
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}
 			// Left and right CV inputs
 			int delta = 0;
@@ -435,7 +570,7 @@ struct Foundry : Module {
 					}
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}
 
 			// Step button presses
@@ -448,16 +583,16 @@ struct Foundry : Module {
 				if (editingSequence && !attached) {
 					if (displayState == DISP_LEN) {
 						seq.setLength(stepPressed + 1, multiTracks);
-						revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+						revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 					}
 					else {
-						showLenInSteps = (long) (showLenInStepsTime * sampleRate / displayRefreshStepSkips);
+						showLenInSteps = (long) (showLenInStepsTime * sampleRate / refresh.lightSkips);
 						seq.setStepIndexEdit(stepPressed, sampleRate);
 						displayState = DISP_NORMAL; // leave this here, the if has it also, but through the revert mechanism
 					}
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			} 
 			
 			// Mode button
@@ -469,7 +604,7 @@ struct Foundry : Module {
 						displayState = DISP_NORMAL;
 				}
 				else
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}
 			
 			// Clk res/delay button
@@ -483,7 +618,7 @@ struct Foundry : Module {
 						displayState = DISP_NORMAL;
 				}
 				else
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}
 			
 			// Transpose/Rotate button
@@ -500,7 +635,7 @@ struct Foundry : Module {
 						displayState = DISP_NORMAL;
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}			
 
 			// Begin/End buttons
@@ -510,7 +645,7 @@ struct Foundry : Module {
 					displayState = DISP_NORMAL;
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}	
 			if (endTrigger.process(params[END_PARAM].value)) {
 				if (!editingSequence && !attached) {
@@ -518,7 +653,7 @@ struct Foundry : Module {
 					displayState = DISP_NORMAL;
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}	
 
 			// Rep/Len button
@@ -530,7 +665,7 @@ struct Foundry : Module {
 						displayState = DISP_NORMAL;
 				}
 				else
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 			}	
 
 			// Track Inc/Dec buttons
@@ -550,7 +685,7 @@ struct Foundry : Module {
 					multiTracks = !multiTracks;
 				else {
 					multiTracks = false;
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				}
 			}	
 			
@@ -560,7 +695,7 @@ struct Foundry : Module {
 					multiSteps = !multiSteps;
 				else if (attached) {
 					multiSteps = false;
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				}
 			}	
 			
@@ -597,7 +732,7 @@ struct Foundry : Module {
 						displayState = DISP_NORMAL;
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				}
 				velocityKnob = newVelocityKnob;
 			}	
@@ -640,7 +775,7 @@ struct Foundry : Module {
 						}
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				}
 				sequenceKnob = newSequenceKnob;
 			}	
@@ -673,7 +808,7 @@ struct Foundry : Module {
 							displayState = DISP_NORMAL;
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				}
 				phraseKnob = newPhraseKnob;
 			}	
@@ -684,10 +819,10 @@ struct Foundry : Module {
 				if (octTriggers[octn].process(params[OCTAVE_PARAM + octn].value)) {
 					if (editingSequence && !attached && displayState != DISP_PPQN) {
 						if (seq.applyNewOctave(6 - octn, multiSteps ? cpMode : 1, sampleRate, multiTracks))
-							tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+							tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					displayState = DISP_NORMAL;
 				}
 			}
@@ -704,11 +839,11 @@ struct Foundry : Module {
 						}
 						else {
 							if (seq.applyNewKey(keyn, multiSteps ? cpMode : 1, sampleRate, autostepClick, multiTracks))
-								tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+								tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 						}							
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				}
 			}
 			
@@ -718,29 +853,29 @@ struct Foundry : Module {
 					seq.toggleGate(multiSteps ? cpMode : 1, multiTracks);
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}		
 			if (gateProbTrigger.process(params[GATE_PROB_PARAM].value + inputs[GATEPCV_INPUT].value)) {
 				if (editingSequence && !attached ) {
 					if (seq.toggleGateP(multiSteps ? cpMode : 1, multiTracks)) 
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else if (seq.getAttribute().getGateP())
 						velEditMode = 1;
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}		
 			if (slideTrigger.process(params[SLIDE_BTN_PARAM].value + inputs[SLIDECV_INPUT].value)) {
 				if (editingSequence && !attached ) {
 					if (seq.toggleSlide(multiSteps ? cpMode : 1, multiTracks))
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else if (seq.getAttribute().getSlide())
 						velEditMode = 2;
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}		
 			if (tiedTrigger.process(params[TIE_PARAM].value + inputs[TIEDCV_INPUT].value)) {
@@ -748,12 +883,13 @@ struct Foundry : Module {
 					seq.toggleTied(multiSteps ? cpMode : 1, multiTracks);// will clear other attribs if new state is on
 				}
 				else if (attached)
-					attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+					attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}		
 			
 			calcClkInSources();
 			
+			IM_CPU_METER_MARK(cpuMeter, SECT_INPUTS);
 		}// userInputs refresh
 		
 		
@@ -766,7 +902,7 @@ struct Foundry : Module {
 		for (int trkn = 0; trkn < Sequencer::NUM_TRACKS; trkn++) {
 			clockTrigged[trkn] = clockTriggers[trkn].process(inputs[CLOCK_INPUTS + trkn].value);
 			if (clockTrigged[clkInSources[trkn]])
-				seq.clockStep(trkn, realClockEdgeToHandle);
+				seq.clockStep(trkn, realClockEdgeToHandle, clockTriggers[clkInSources[trkn]].edgeFraction);
 		}
 		seq.step();
 		
@@ -784,6 +920,8 @@ struct Foundry : Module {
 		}
 		
 		
+		IM_CPU_METER_MARK(cpuMeter, SECT_CLOCK);
+		
 		//********** Outputs and lights **********
 				
 		
@@ -796,9 +934,9 @@ struct Foundry : Module {
 		}
 
 		// lights
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		IM_CPU_METER_MARK(cpuMeter, SECT_OUTPUTS);
+
+		if (refresh.processLights()) {
 		
 			// Step lights
 			for (int stepn = 0; stepn < SequencerKernel::MAX_STEPS; stepn++) {
@@ -872,7 +1010,7 @@ struct Foundry : Module {
 				float red = 0.0f;
 				if (editingSequence || attached) {
 					if (tiedWarning > 0l) {
-						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 						red = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
 					}
 					else				
@@ -905,7 +1043,7 @@ struct Foundry : Module {
 					}
 					else {
 						if (tiedWarning > 0l) {
-							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 							red = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
 						}
 						else {
@@ -919,7 +1057,7 @@ struct Foundry : Module {
 			// Gate, Tied, GateProb, and Slide lights 
 			lights[GATE_LIGHT].value = attributesVisual.getGate() ? 1.0f : 0.0f;
 			if (tiedWarning > 0l) {
-				bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+				bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 				lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 			}
 			else
@@ -932,14 +1070,14 @@ struct Foundry : Module {
 			
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;
-			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * refresh.lightSkips;
 			
 			// Run light
 			lights[RUN_LIGHT].value = (running ? 1.0f : 0.0f);
 
 			// Attach light
 			if (attachedWarning > 0l) {
-				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 			}
 			else
@@ -967,13 +1105,27 @@ struct Foundry : Module {
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
-		}// lightRefreshCounter
+			IM_CPU_METER_MARK(cpuMeter, SECT_LIGHTS);
+		}// processLights()
 				
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 		
+		IM_CPU_METER_END(cpuMeter);
 	}// step()
 	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {
+		return seq.calcIdleSteps(engineGetSampleRate());
+	}
+	inline void skipIdleSteps(long n) {
+		seq.skipIdleSteps(n);
+		clockIgnoreOnReset = std::max(clockIgnoreOnReset - n, 0l);
+	}
+	
 
 	inline void setGreenRed(int id, float green, float red) {
 		lights[id + 0].value = green;
@@ -987,6 +1139,7 @@ struct Foundry : Module {
 				clkInSources[trkn] = trkn;
 			else 
 				clkInSources[trkn] = clkInSources[trkn - 1];
+			seq.setClockSource(trkn, clkInSources[trkn]);// for the lookahead of TKA tracks
 		}
 	}
 	
@@ -1042,6 +1195,11 @@ struct FoundryWidget : ModuleWidget {
 		}
 		
 		virtual char printText() = 0;
+		
+		uint64_t calcStateHash() {// see CachedDisplay
+			char overlayChar = printText();
+			return hashDisplayText(displayStr) * 31 + overlayChar;
+		}
 	};
 	
 	struct VelocityDisplayWidget : DisplayWidget<4> {
@@ -1243,7 +1401,7 @@ struct FoundryWidget : ModuleWidget {
 		Foundry *module;
 		int theme;
 		void onAction(EventAction &e) override {
-			module->panelTheme = theme;
+			module->editQueue.push(Foundry::EDIT_PANEL_THEME, theme);
 		}
 		void step() override {
 			rightText = (module->panelTheme == theme) ? "✔" : "";
@@ -1252,27 +1410,25 @@ struct FoundryWidget : ModuleWidget {
 	struct ExpansionItem : MenuItem {
 		Foundry *module;
 		void onAction(EventAction &e) override {
-			module->expansion = module->expansion == 1 ? 0 : 1;
+			module->editQueue.push(Foundry::EDIT_EXPANSION);
 		}
 	};
 	struct ResetOnRunItem : MenuItem {
 		Foundry *module;
 		void onAction(EventAction &e) override {
-			module->resetOnRun = !module->resetOnRun;
+			module->editQueue.push(Foundry::EDIT_RESET_ON_RUN);
 		}
 	};
 	struct AutoseqItem : MenuItem {
 		Foundry *module;
 		void onAction(EventAction &e) override {
-			module->autoseq = !module->autoseq;
+			module->editQueue.push(Foundry::EDIT_AUTOSEQ);
 		}
 	};
 	struct SeqCVmethodItem : MenuItem {
 		Foundry *module;
 		void onAction(EventAction &e) override {
-			module->seqCVmethod++;
-			if (module->seqCVmethod > 2)
-				module->seqCVmethod = 0;
+			module->editQueue.push(Foundry::EDIT_SEQCV_METHOD);
 		}
 		void step() override {
 			if (module->seqCVmethod == 0)
@@ -1286,9 +1442,7 @@ struct FoundryWidget : ModuleWidget {
 	struct VelModeItem : MenuItem {
 		Foundry *module;
 		void onAction(EventAction &e) override {
-			module->velocityMode++;
-			if (module->velocityMode > 2)
-				module->velocityMode = 0;
+			module->editQueue.push(Foundry::EDIT_VEL_MODE);
 		}
 		void step() override {
 			if (module->velocityMode == 0)
@@ -1299,10 +1453,36 @@ struct FoundryWidget : ModuleWidget {
 				text = "CV2: Volts,  0-127,  <0-127semitone>";
 		}	
 	};
+	struct SlideShapeItem : MenuItem {
+		Foundry *module;
+		void onAction(EventAction &e) override {
+			module->editQueue.push(Foundry::EDIT_SLIDE_SHAPE);
+		}
+		void step() override {
+			if (module->slideShape == SLIDE_LINEAR)
+				text = "Slide: <Linear>,  Exponential,  Logarithmic";
+			else if (module->slideShape == SLIDE_EXP)
+				text = "Slide: Linear,  <Exponential>,  Logarithmic";
+			else
+				text = "Slide: Linear,  Exponential,  <Logarithmic>";
+		}	
+	};
 	struct HoldTiedItem : MenuItem {
 		Foundry *module;
 		void onAction(EventAction &e) override {
-			module->holdTiedNotes = !module->holdTiedNotes;
+			module->editQueue.push(Foundry::EDIT_HOLD_TIED);
+		}
+	};
+	struct UndoItem : MenuItem {
+		Foundry *module;
+		void onAction(EventAction &e) override {
+			module->editQueue.push(Foundry::EDIT_UNDO);
+		}
+	};
+	struct RedoItem : MenuItem {
+		Foundry *module;
+		void onAction(EventAction &e) override {
+			module->editQueue.push(Foundry::EDIT_REDO);
 		}
 	};
 	Menu *createContextMenu() override {
@@ -1338,6 +1518,20 @@ struct FoundryWidget : ModuleWidget {
 
 		menu->addChild(new MenuLabel());// empty line
 		
+		MenuLabel *editLabel = new MenuLabel();
+		editLabel->text = "Edit";
+		menu->addChild(editLabel);
+		
+		UndoItem *undoItem = MenuItem::create<UndoItem>("Undo", "");
+		undoItem->module = module;
+		menu->addChild(undoItem);
+
+		RedoItem *redoItem = MenuItem::create<RedoItem>("Redo", "");
+		redoItem->module = module;
+		menu->addChild(redoItem);
+
+		menu->addChild(new MenuLabel());// empty line
+		
 		MenuLabel *settingsLabel = new MenuLabel();
 		settingsLabel->text = "Settings";
 		menu->addChild(settingsLabel);
@@ -1354,6 +1548,10 @@ struct FoundryWidget : ModuleWidget {
 		holdItem->module = module;
 		menu->addChild(holdItem);
 
+		SlideShapeItem *slideItem = MenuItem::create<SlideShapeItem>("Slide: ", "");
+		slideItem->module = module;
+		menu->addChild(slideItem);
+
 		VelModeItem *velItem = MenuItem::create<VelModeItem>("CV2: ", "");
 		velItem->module = module;
 		menu->addChild(velItem);
@@ -1374,6 +1572,10 @@ struct FoundryWidget : ModuleWidget {
 		expItem->module = module;
 		menu->addChild(expItem);
 		
+#ifdef IM_CPU_METER
+		addCpuMeterMenu(menu, &module->cpuMeter);// ImpromptuModular.hpp
+#endif
+
 		return menu;
 	}	
 	
@@ -1410,22 +1612,8 @@ struct FoundryWidget : ModuleWidget {
 		VelocityKnob() {};		
 		void onMouseDown(EventMouseDown &e) override {// from ParamWidget.cpp
 			Foundry* module = dynamic_cast<Foundry*>(this->module);
-			if (e.button == 1) {
-				// same code structure below as in velocity knob in main step()
-				if (module->isEditingSequence() && !module->attached) {
-					int multiStepsCount = module->multiSteps ? module->getCPMode() : 1;
-					if (module->velEditMode == 2) {
-						module->seq.initSlideVal(multiStepsCount, module->multiTracks);
-					}
-					else if (module->velEditMode == 1) {
-						module->seq.initGatePVal(multiStepsCount, module->multiTracks);
-					}
-					else {
-						module->seq.initVelocityVal(multiStepsCount, module->multiTracks);
-					}
-					module->displayState = Foundry::DISP_NORMAL;
-				}
-			}
+			if (e.button == 1)
+				module->editQueue.push(Foundry::EDIT_VELOCITY_KNOB_DEFAULT);// see velocityKnobDefault()
 			ParamWidget::onMouseDown(e);
 		}
 	};
@@ -1433,31 +1621,8 @@ struct FoundryWidget : ModuleWidget {
 		SequenceKnob() {};		
 		void onMouseDown(EventMouseDown &e) override {// from ParamWidget.cpp
 			Foundry* module = dynamic_cast<Foundry*>(this->module);
-			if (e.button == 1) {
-				// same code structure below as in sequence knob in main step()
-				if (module->displayState == Foundry::DISP_LEN) {
-					module->seq.initLength(module->multiTracks);
-				}
-				else if (module->displayState == Foundry::DISP_TRANSPOSE) {
-					module->seq.unTransposeSeq(module->multiTracks);
-				}
-				else if (module->displayState == Foundry::DISP_ROTATE) {
-					module->seq.rotateSeq(&(module->rotateOffset), module->rotateOffset * -1, module->multiTracks);
-				}							
-				else if (module->displayState == Foundry::DISP_REPS) {
-					module->seq.initPhraseReps(module->multiTracks);
-				}
-				else if (!module->attached) {
-					if (module->isEditingSequence()) {
-						if (!module->inputs[Foundry::SEQCV_INPUT].active)
-							module->seq.setSeqIndexEdit(0);
-					}
-					else {// editing song
-						module->seq.initPhraseSeqNum(module->multiTracks);
-					}
-					module->displayState = Foundry::DISP_NORMAL;
-				}
-			}
+			if (e.button == 1)
+				module->editQueue.push(Foundry::EDIT_SEQUENCE_KNOB_DEFAULT);// see sequenceKnobDefault()
 			ParamWidget::onMouseDown(e);
 		}
 	};
@@ -1465,25 +1630,8 @@ struct FoundryWidget : ModuleWidget {
 		PhraseKnob() {};		
 		void onMouseDown(EventMouseDown &e) override {// from ParamWidget.cpp
 			Foundry* module = dynamic_cast<Foundry*>(this->module);
-			if (e.button == 1) {
-				// same code structure below as in phrase knob in main step()
-				if (module->displayState == Foundry::DISP_MODE_SEQ) {
-					module->seq.initRunModeSeq(module->multiTracks);
-				}
-				else if (module->displayState == Foundry::DISP_PPQN) {
-					module->seq.initPulsesPerStep(module->multiTracks);
-				}
-				else if (module->displayState == Foundry::DISP_DELAY) {
-					module->seq.initDelay(module->multiTracks);
-				}
-				else if (module->displayState == Foundry::DISP_MODE_SONG) {
-					module->seq.initRunModeSong(module->multiTracks);
-				}
-				else if (!module->isEditingSequence() && !module->attached) {
-					module->seq.setPhraseIndexEdit(0);
-					module->displayState = Foundry::DISP_NORMAL;
-				}
-			}
+			if (e.button == 1)
+				module->editQueue.push(Foundry::EDIT_PHRASE_KNOB_DEFAULT);// see phraseKnobDefault()
 			ParamWidget::onMouseDown(e);
 		}
 	};
@@ -1496,9 +1644,9 @@ struct FoundryWidget : ModuleWidget {
         panel = new DynamicSVGPanel();
         panel->mode = &module->panelTheme;
 		panel->expWidth = &expWidth;
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Foundry.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Foundry_metal.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/Foundry_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/Foundry.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/light/Foundry_metal.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/Foundry_dark.svg"));
         box.size = panel->box.size;
 		box.size.x = box.size.x - (1 - module->expansion) * expWidth;
         addChild(panel);
@@ -1614,7 +1762,7 @@ struct FoundryWidget : ModuleWidget {
 		// Velocity display
 		static const int colRulerVel = 289;
 		static const int trkButtonsOffsetX = 14;
-		addChild(new VelocityDisplayWidget(Vec(colRulerVel, rowRulerDisp), Vec(displayWidths + 4, displayHeights), module));// 3 characters
+		addChild(createCachedDisplay(new VelocityDisplayWidget(Vec(colRulerVel, rowRulerDisp), Vec(displayWidths + 4, displayHeights), module)));// 3 characters
 		// Velocity knob
 		addParam(createDynamicParamCentered<VelocityKnob>(Vec(colRulerVel, rowRulerKnobs), module, Foundry::VEL_KNOB_PARAM, -INFINITY, INFINITY, 0.0f, &module->panelTheme));	
 		// Veocity mode button and lights
@@ -1625,7 +1773,7 @@ struct FoundryWidget : ModuleWidget {
 
 		// Seq edit display 
 		static const int colRulerEditSeq = colRulerVel + displaySpacingX + 3;
-		addChild(new SeqEditDisplayWidget(Vec(colRulerEditSeq, rowRulerDisp), Vec(displayWidths, displayHeights), module));// 5 characters
+		addChild(createCachedDisplay(new SeqEditDisplayWidget(Vec(colRulerEditSeq, rowRulerDisp), Vec(displayWidths, displayHeights), module)));// 5 characters
 		// Sequence-edit knob
 		addParam(createDynamicParamCentered<SequenceKnob>(Vec(colRulerEditSeq, rowRulerKnobs), module, Foundry::SEQUENCE_PARAM, -INFINITY, INFINITY, 0.0f, &module->panelTheme));		
 		// Transpose/rotate button
@@ -1634,7 +1782,7 @@ struct FoundryWidget : ModuleWidget {
 			
 		// Phrase edit display 
 		static const int colRulerEditPhr = colRulerEditSeq + displaySpacingX + 1;
-		addChild(new PhrEditDisplayWidget(Vec(colRulerEditPhr, rowRulerDisp), Vec(displayWidths, displayHeights), module));// 5 characters
+		addChild(createCachedDisplay(new PhrEditDisplayWidget(Vec(colRulerEditPhr, rowRulerDisp), Vec(displayWidths, displayHeights), module)));// 5 characters
 		// Phrase knob
 		addParam(createDynamicParamCentered<PhraseKnob>(Vec(colRulerEditPhr, rowRulerKnobs), module, Foundry::PHRASE_PARAM, -INFINITY, INFINITY, 0.0f, &module->panelTheme));		
 		// Begin/end buttons
@@ -1644,7 +1792,7 @@ struct FoundryWidget : ModuleWidget {
 				
 		// Track display
 		static const int colRulerTrk = colRulerEditPhr + displaySpacingX;
-		addChild(new TrackDisplayWidget(Vec(colRulerTrk, rowRulerDisp), Vec(displayWidths - 13, displayHeights), module));// 2 characters
+		addChild(createCachedDisplay(new TrackDisplayWidget(Vec(colRulerTrk, rowRulerDisp), Vec(displayWidths - 13, displayHeights), module)));// 2 characters
 		// Track buttons
 		addParam(createDynamicParamCentered<IMPushButton>(Vec(colRulerTrk + trkButtonsOffsetX, rowRulerKnobs), module, Foundry::TRACKUP_PARAM, 0.0f, 1.0f, 0.0f, &module->panelTheme));
 		addParam(createDynamicParamCentered<IMPushButton>(Vec(colRulerTrk - trkButtonsOffsetX, rowRulerKnobs), module, Foundry::TRACKDOWN_PARAM, 0.0f, 1.0f, 0.0f, &module->panelTheme));
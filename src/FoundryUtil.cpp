@@ -14,46 +14,47 @@ using namespace rack;
 //*****************************************************************************
 
 
-const std::string SequencerKernel::modeLabels[NUM_MODES] = {"FWD", "REV", "PPG", "PEN", "BRN", "RND", "TKA"};
+template <int STEPS, int SEQS, int PHRASES>
+const std::string BasicSequencerKernel<STEPS, SEQS, PHRASES>::modeLabels[NUM_MODES] = {"FWD", "REV", "PPG", "PEN", "BRN", "RND", "TKA"};
 
 
-const uint64_t SequencerKernel::advGateHitMaskLow[NUM_GATES] = 
-{0x0000000000FFFFFF, 0x0000FFFF0000FFFF, 0x0000FFFFFFFFFFFF, 0x0000FFFF00000000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 
-//				25%					TRI		  			50%					T23		  			75%					FUL		
- 0x000000000000FFFF, 0xFFFF000000FFFFFF, 0x0000FFFF00000000, 0xFFFF000000000000, 0x0000000000000000, 0};
-//  			TR1 				DUO		  			TR2 	     		D2		  			TR3  TRIG		
-const uint64_t SequencerKernel::advGateHitMaskHigh[NUM_GATES] = 
-{0x0000000000000000, 0x000000000000FFFF, 0x0000000000000000, 0x000000000000FFFF, 0x00000000000000FF, 0x00000000FFFFFFFF, 
-//				25%					TRI		  			50%					T23		  			75%					FUL		
- 0x0000000000000000, 0x00000000000000FF, 0x0000000000000000, 0x00000000000000FF, 0x000000000000FFFF, 0};
-//  			TR1 				DUO		  			TR2 	     		D2		  			TR3  TRIG		
-
-
-void SequencerKernel::construct(int _id, SequencerKernel *_masterKernel, bool* _holdTiedNotesPtr) {// don't want regaular constructor mechanism
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::construct(int _id, BasicSequencerKernel *_masterKernel, bool* _holdTiedNotesPtr, int* _slideShapePtr) {// don't want regaular constructor mechanism
 	id = _id;
 	ids = "id" + std::to_string(id) + "_";
 	masterKernel = _masterKernel;
 	holdTiedNotesPtr = _holdTiedNotesPtr;
+	slideShapePtr = _slideShapePtr;
+	clockSource = 0;
+	predictHead = 0;
+	predictCount = 0;
+	predictVersion = 0ul;
+	predictMasterVersion = 0ul;
 }
 
 
 
-void SequencerKernel::setGate(int seqn, int stepn, bool newGate, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setGate(int seqn, int stepn, bool newGate, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setGate(newGate);
+		steps[seqn][i].attributes.setGate(newGate);
 }
-void SequencerKernel::setGateP(int seqn, int stepn, bool newGateP, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setGateP(int seqn, int stepn, bool newGateP, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setGateP(newGateP);
+		steps[seqn][i].attributes.setGateP(newGateP);
+	invalidatePrediction();// gate probabilities draw from the rng
 }
-void SequencerKernel::setSlide(int seqn, int stepn, bool newSlide, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setSlide(int seqn, int stepn, bool newSlide, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setSlide(newSlide);
+		steps[seqn][i].attributes.setSlide(newSlide);
 }
-void SequencerKernel::setTied(int seqn, int stepn, bool newTied, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setTied(int seqn, int stepn, bool newTied, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	if (!newTied) {
 		for (int i = stepn; i < endi; i++)
@@ -63,110 +64,132 @@ void SequencerKernel::setTied(int seqn, int stepn, bool newTied, int count) {
 		for (int i = stepn; i < endi; i++)
 			activateTiedStep(seqn, i);
 	}
+	invalidatePrediction();// old tied method copies gate probabilities
 }
 
-void SequencerKernel::setGatePVal(int seqn, int stepn, int gatePval, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setGatePVal(int seqn, int stepn, int gatePval, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setGatePVal(gatePval);
+		steps[seqn][i].attributes.setGatePVal(gatePval);
 }
-void SequencerKernel::setSlideVal(int seqn, int stepn, int slideVal, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setSlideVal(int seqn, int stepn, int slideVal, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setSlideVal(slideVal);
+		steps[seqn][i].attributes.setSlideVal(slideVal);
 }
-void SequencerKernel::setVelocityVal(int seqn, int stepn, int velocity, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setVelocityVal(int seqn, int stepn, int velocity, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setVelocityVal(velocity);
+		steps[seqn][i].attributes.setVelocityVal(velocity);
 }
-void SequencerKernel::setGateType(int seqn, int stepn, int gateType, int count) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setGateType(int seqn, int stepn, int gateType, int count) {
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++)
-		attributes[seqn][i].setGateType(gateType);
+		steps[seqn][i].attributes.setGateType(gateType);
 }
 
 
-float SequencerKernel::applyNewOctave(int seqn, int stepn, int newOct, int count) {// does not overwrite tied steps
-	float newCV = cv[seqn][stepn] + 10.0f;//to properly handle negative note voltages
+template <int STEPS, int SEQS, int PHRASES>
+float BasicSequencerKernel<STEPS, SEQS, PHRASES>::applyNewOctave(int seqn, int stepn, int newOct, int count) {// does not overwrite tied steps
+	float newCV = steps[seqn][stepn].cv + 10.0f;//to properly handle negative note voltages
 	newCV = newCV - floor(newCV) + (float) (newOct - 3);
 	
 	writeCV(seqn, stepn, newCV, count);
 	return newCV;
 }
-float SequencerKernel::applyNewKey(int seqn, int stepn, int newKeyIndex, int count) {// does not overwrite tied steps
-	float newCV = floor(cv[seqn][stepn]) + ((float) newKeyIndex) / 12.0f;
+template <int STEPS, int SEQS, int PHRASES>
+float BasicSequencerKernel<STEPS, SEQS, PHRASES>::applyNewKey(int seqn, int stepn, int newKeyIndex, int count) {// does not overwrite tied steps
+	float newCV = floor(steps[seqn][stepn].cv) + ((float) newKeyIndex) / 12.0f;
 	
 	writeCV(seqn, stepn, newCV, count);
 	return newCV;
 }
-void SequencerKernel::writeCV(int seqn, int stepn, float newCV, int count) {// does not overwrite tied steps
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::writeCV(int seqn, int stepn, float newCV, int count) {// does not overwrite tied steps
 	int endi = min(MAX_STEPS, stepn + count);
 	for (int i = stepn; i < endi; i++) {
-		if (!attributes[seqn][i].getTied()) {
-			cv[seqn][i] = newCV;
+		if (!steps[seqn][i].attributes.getTied()) {
+			steps[seqn][i].cv = newCV;
 			propagateCVtoTied(seqn, i);
 		}
 	}
 }
 
 
-void SequencerKernel::initSequence(int seqn) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::initSequence(int seqn) {
 	sequences[seqn].init(MAX_STEPS, MODE_FWD);
 	for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
-		cv[seqn][stepn] = INIT_CV;
-		attributes[seqn][stepn].init();
+		steps[seqn][stepn].cv = INIT_CV;
+		steps[seqn][stepn].attributes.init();
 	}
+	invalidatePrediction();
 }
-void SequencerKernel::initSong() {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::initSong() {
 	runModeSong = MODE_FWD;
 	songBeginIndex = 0;
 	songEndIndex = 0;
 	for (int phrn = 0; phrn < MAX_PHRASES; phrn++) {
 		phrases[phrn].init();
 	}
+	updatePlayablePhrases();
+	invalidatePrediction();
 }
 
 
-void SequencerKernel::randomizeSequence(int seqn) {
-	sequences[seqn].randomize(MAX_STEPS, NUM_MODES);// code below uses lengths so this must be randomized first
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::randomizeSequence(int seqn) {
+	sequences[seqn].randomize(MAX_STEPS, NUM_MODES, &run.rng);// code below uses lengths so this must be randomized first
 	for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
-		cv[seqn][stepn] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
-		attributes[seqn][stepn].randomize();
-		if (attributes[seqn][stepn].getTied()) {
+		steps[seqn][stepn].cv = ((float)(run.rng.u32() % 7)) + ((float)(run.rng.u32() % 12)) / 12.0f - 3.0f;
+		steps[seqn][stepn].attributes.randomize(&run.rng);
+		if (steps[seqn][stepn].attributes.getTied()) {
 			activateTiedStep(seqn, stepn);
 		}	
 	}
+	invalidatePrediction();
 }
-void SequencerKernel::randomizeSong() {
-	runModeSong = randomu32() % NUM_MODES;
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::randomizeSong() {
+	runModeSong = run.rng.u32() % NUM_MODES;
 	songBeginIndex = 0;
-	songEndIndex = (randomu32() % MAX_PHRASES);
+	songEndIndex = (run.rng.u32() % MAX_PHRASES);
 	for (int phrn = 0; phrn < MAX_PHRASES; phrn++) {
-		phrases[phrn].randomize(MAX_SEQS);
+		phrases[phrn].randomize(MAX_SEQS, &run.rng);
 	}
+	updatePlayablePhrases();
+	invalidatePrediction();
 }	
 
 
-void SequencerKernel::copySequence(SeqCPbuffer* seqCPbuf, int seqn, int startCP, int countCP) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::copySequence(SeqCPbuffer* seqCPbuf, int seqn, int startCP, int countCP) {
 	countCP = min(countCP, MAX_STEPS - startCP);
 	for (int i = 0, stepn = startCP; i < countCP; i++, stepn++) {
-		seqCPbuf->cvCPbuffer[i] = cv[seqn][stepn];
-		seqCPbuf->attribCPbuffer[i] = attributes[seqn][stepn];
+		seqCPbuf->cvCPbuffer[i] = steps[seqn][stepn].cv;
+		seqCPbuf->attribCPbuffer[i] = steps[seqn][stepn].attributes;
 	}
 	seqCPbuf->seqAttribCPbuffer = sequences[seqn];
 	seqCPbuf->storedLength = countCP;
 }
-void SequencerKernel::pasteSequence(SeqCPbuffer* seqCPbuf, int seqn, int startCP) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::pasteSequence(SeqCPbuffer* seqCPbuf, int seqn, int startCP) {
 	int countCP = min(seqCPbuf->storedLength, MAX_STEPS - startCP);
 	for (int i = 0, stepn = startCP; i < countCP; i++, stepn++) {
-		cv[seqn][stepn] = seqCPbuf->cvCPbuffer[i];
-		attributes[seqn][stepn] = seqCPbuf->attribCPbuffer[i];
+		steps[seqn][stepn].cv = seqCPbuf->cvCPbuffer[i];
+		steps[seqn][stepn].attributes = seqCPbuf->attribCPbuffer[i];
 	}
 	if (startCP == 0 && countCP == MAX_STEPS)
 		sequences[seqn] = seqCPbuf->seqAttribCPbuffer;
+	invalidatePrediction();
 }
-void SequencerKernel::copySong(SongCPbuffer* songCPbuf, int startCP, int countCP) {	
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::copySong(SongCPbuffer* songCPbuf, int startCP, int countCP) {	
 	countCP = min(countCP, MAX_PHRASES - startCP);
 	for (int i = 0, phrn = startCP; i < countCP; i++, phrn++) {
 		songCPbuf->phraseCPbuffer[i] = phrases[phrn];
@@ -176,7 +199,8 @@ void SequencerKernel::copySong(SongCPbuffer* songCPbuf, int startCP, int countCP
 	songCPbuf->runModeSong = runModeSong;
 	songCPbuf->storedLength = countCP;
 }
-void SequencerKernel::pasteSong(SongCPbuffer* songCPbuf, int startCP) {	
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::pasteSong(SongCPbuffer* songCPbuf, int startCP) {	
 	int countCP = min(songCPbuf->storedLength, MAX_PHRASES - startCP);
 	for (int i = 0, phrn = startCP; i < countCP; i++, phrn++) {
 		phrases[phrn] = songCPbuf->phraseCPbuffer[i];
@@ -186,10 +210,13 @@ void SequencerKernel::pasteSong(SongCPbuffer* songCPbuf, int startCP) {
 		songEndIndex = songCPbuf->endIndex;
 		runModeSong = songCPbuf->runModeSong;
 	}
+	updatePlayablePhrases();
+	invalidatePrediction();
 }
 
 
-void SequencerKernel::reset() {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::reset() {
 	initPulsesPerStep();
 	initDelay();
 	initSong();
@@ -197,11 +224,13 @@ void SequencerKernel::reset() {
 		initSequence(seqn);		
 	}
 	clockPeriod = 0ul;
+	clockFraction = 0.0f;
 	initRun();
 }
 
 
-void SequencerKernel::randomize() {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::randomize() {
 	randomizeSong();
 	for (int seqn = 0; seqn < MAX_SEQS; seqn++) {
 		randomizeSequence(seqn);
@@ -210,21 +239,24 @@ void SequencerKernel::randomize() {
 }
 	
 
-void SequencerKernel::initRun() {
-	movePhraseIndexRun(true);// true means init 
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::initRun() {
+	movePhraseIndexRun(run, masterKernel != nullptr ? &masterKernel->run : nullptr, true);// true means init 
 
-	int seqn = phrases[phraseIndexRun].getSeqNum();
-	stepIndexRun = (sequences[seqn].getRunMode() == MODE_REV ? sequences[seqn].getLength() - 1 : 0);
-	stepIndexRunHistory = 0;
+	int seqn = phrases[run.phraseIndexRun].getSeqNum();
+	run.stepIndexRun = (sequences[seqn].getRunMode() == MODE_REV ? sequences[seqn].getLength() - 1 : 0);
+	run.stepIndexRunHistory = 0;
 
 	ppqnCount = 0;
 	ppqnLeftToSkip = delay;
-	calcGateCodeEx(seqn);// uses stepIndexRun as the step
-	slideStepsRemain = 0ul;
+	calcGateCodeEx(seqn);// uses run.stepIndexRun as the step
+	slide.reset();
+	invalidatePrediction();
 }
 
 
-void SequencerKernel::toJson(json_t *rootJ) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::toJson(json_t *rootJ) {
 	// pulsesPerStep
 	json_object_set_new(rootJ, (ids + "pulsesPerStep").c_str(), json_integer(pulsesPerStep));
 
@@ -247,32 +279,36 @@ void SequencerKernel::toJson(json_t *rootJ) {
 	json_object_set_new(rootJ, (ids + "phrases").c_str(), phrasesJ);
 
 	// CV and attributes
-	json_t *seqSavedJ = json_array();		
-	json_t *cvJ = json_array();
-	json_t *attributesJ = json_array();
-	for (int seqnRead = 0, seqnWrite = 0; seqnRead < MAX_SEQS; seqnRead++) {
-		bool compress = true;
-		for (int stepn = 0; stepn < 5; stepn++) {
-			if (cv[seqnRead][stepn] != INIT_CV || attributes[seqnRead][stepn].getAttribute() != StepAttributes::ATT_MSK_INITSTATE) {
-				compress = false;
-				break;
+	if (!writeLegacyJson)
+		json_object_set_new(rootJ, (ids + "stepData").c_str(), json_string(stepDataToString().c_str()));
+	else {
+		json_t *seqSavedJ = json_array();		
+		json_t *cvJ = json_array();
+		json_t *attributesJ = json_array();
+		for (int seqnRead = 0, seqnWrite = 0; seqnRead < MAX_SEQS; seqnRead++) {
+			bool compress = true;
+			for (int stepn = 0; stepn < 5; stepn++) {
+				if (steps[seqnRead][stepn].cv != INIT_CV || steps[seqnRead][stepn].attributes.getAttribute() != StepAttributes::ATT_MSK_INITSTATE) {
+					compress = false;
+					break;
+				}
 			}
-		}
-		if (compress) {
-			json_array_insert_new(seqSavedJ, seqnRead, json_integer(0));
-		}
-		else {
-			json_array_insert_new(seqSavedJ, seqnRead, json_integer(1));
-			for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
-				json_array_insert_new(cvJ, stepn + (seqnWrite * MAX_STEPS), json_real(cv[seqnRead][stepn]));
-				json_array_insert_new(attributesJ, stepn + (seqnWrite * MAX_STEPS), json_integer(attributes[seqnRead][stepn].getAttribute()));
+			if (compress) {
+				json_array_insert_new(seqSavedJ, seqnRead, json_integer(0));
+			}
+			else {
+				json_array_insert_new(seqSavedJ, seqnRead, json_integer(1));
+				for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
+					json_array_insert_new(cvJ, stepn + (seqnWrite * MAX_STEPS), json_real(steps[seqnRead][stepn].cv));
+					json_array_insert_new(attributesJ, stepn + (seqnWrite * MAX_STEPS), json_integer(steps[seqnRead][stepn].attributes.getAttribute()));
+				}
+				seqnWrite++;
 			}
-			seqnWrite++;
 		}
+		json_object_set_new(rootJ, (ids + "seqSaved").c_str(), seqSavedJ);
+		json_object_set_new(rootJ, (ids + "cv").c_str(), cvJ);
+		json_object_set_new(rootJ, (ids + "attributes").c_str(), attributesJ);
 	}
-	json_object_set_new(rootJ, (ids + "seqSaved").c_str(), seqSavedJ);
-	json_object_set_new(rootJ, (ids + "cv").c_str(), cvJ);
-	json_object_set_new(rootJ, (ids + "attributes").c_str(), attributesJ);
 
 	// songBeginIndex
 	json_object_set_new(rootJ, (ids + "songBeginIndex").c_str(), json_integer(songBeginIndex));
@@ -280,10 +316,14 @@ void SequencerKernel::toJson(json_t *rootJ) {
 	// songEndIndex
 	json_object_set_new(rootJ, (ids + "songEndIndex").c_str(), json_integer(songEndIndex));
 
+	// rng
+	json_object_set_new(rootJ, (ids + "rng").c_str(), run.rng.toJson());
+
 }
 
 
-void SequencerKernel::fromJson(json_t *rootJ) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::fromJson(json_t *rootJ) {
 	// pulsesPerStep
 	json_t *pulsesPerStepJ = json_object_get(rootJ, (ids + "pulsesPerStep").c_str());
 	if (pulsesPerStepJ)
@@ -319,41 +359,45 @@ void SequencerKernel::fromJson(json_t *rootJ) {
 			if (phrasesArrayJ)
 				phrases[i].setPhraseJson(json_integer_value(phrasesArrayJ));
 		}
+	updatePlayablePhrases();
 	
-	// CV and attributes
-	json_t *seqSavedJ = json_object_get(rootJ, (ids + "seqSaved").c_str());
-	int seqSaved[MAX_SEQS];
-	if (seqSavedJ) {
-		int i;
-		for (i = 0; i < MAX_SEQS; i++)
-		{
-			json_t *seqSavedArrayJ = json_array_get(seqSavedJ, i);
-			if (seqSavedArrayJ)
-				seqSaved[i] = json_integer_value(seqSavedArrayJ);
-			else 
-				break;
-		}	
-		if (i == MAX_SEQS) {			
-			json_t *cvJ = json_object_get(rootJ, (ids + "cv").c_str());
-			json_t *attributesJ = json_object_get(rootJ, (ids + "attributes").c_str());
-			if (cvJ && attributesJ) {
-				for (int seqnFull = 0, seqnComp = 0; seqnFull < MAX_SEQS; seqnFull++) {
-					if (!seqSaved[seqnFull]) {
-						continue;
-					}
-					for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
-						json_t *cvArrayJ = json_array_get(cvJ, stepn + (seqnComp * MAX_STEPS));
-						if (cvArrayJ)
-							cv[seqnFull][stepn] = json_number_value(cvArrayJ);
-						json_t *attributesArrayJ = json_array_get(attributesJ, stepn + (seqnComp * MAX_STEPS));
-						if (attributesArrayJ)
-							attributes[seqnFull][stepn].setAttribute(json_integer_value(attributesArrayJ));
+	// CV and attributes (step data string, or the json arrays of patches saved with earlier versions)
+	json_t *stepDataJ = json_object_get(rootJ, (ids + "stepData").c_str());
+	if (!stepDataJ || !stepDataFromString(json_string_value(stepDataJ))) {
+		json_t *seqSavedJ = json_object_get(rootJ, (ids + "seqSaved").c_str());
+		int seqSaved[MAX_SEQS];
+		if (seqSavedJ) {
+			int i;
+			for (i = 0; i < MAX_SEQS; i++)
+			{
+				json_t *seqSavedArrayJ = json_array_get(seqSavedJ, i);
+				if (seqSavedArrayJ)
+					seqSaved[i] = json_integer_value(seqSavedArrayJ);
+				else 
+					break;
+			}	
+			if (i == MAX_SEQS) {			
+				json_t *cvJ = json_object_get(rootJ, (ids + "cv").c_str());
+				json_t *attributesJ = json_object_get(rootJ, (ids + "attributes").c_str());
+				if (cvJ && attributesJ) {
+					for (int seqnFull = 0, seqnComp = 0; seqnFull < MAX_SEQS; seqnFull++) {
+						if (!seqSaved[seqnFull]) {
+							continue;
+						}
+						for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
+							json_t *cvArrayJ = json_array_get(cvJ, stepn + (seqnComp * MAX_STEPS));
+							if (cvArrayJ)
+								steps[seqnFull][stepn].cv = json_number_value(cvArrayJ);
+							json_t *attributesArrayJ = json_array_get(attributesJ, stepn + (seqnComp * MAX_STEPS));
+							if (attributesArrayJ)
+								steps[seqnFull][stepn].attributes.setAttribute(json_integer_value(attributesArrayJ));
+						}
+						seqnComp++;
 					}
-					seqnComp++;
 				}
 			}
-		}
-	}		
+		}		
+	}
 	
 	// songBeginIndex
 	json_t *songBeginIndexJ = json_object_get(rootJ, (ids + "songBeginIndex").c_str());
@@ -364,10 +408,192 @@ void SequencerKernel::fromJson(json_t *rootJ) {
 	json_t *songEndIndexJ = json_object_get(rootJ, (ids + "songEndIndex").c_str());
 	if (songEndIndexJ)
 		songEndIndex = json_integer_value(songEndIndexJ);
+
+	// rng
+	run.rng.fromJson(json_object_get(rootJ, (ids + "rng").c_str()));
+	
+	invalidatePrediction();
+}
+
+
+// Step data format: the cv and attributes of all sequences are saved as one base64 string per track, instead of the json 
+//   arrays of earlier versions (those are still read when the string is absent). After the version byte, the steps of all
+//   sequences (in order) are given as runs of identical steps:
+//     run length (varint), attribute (uint32), cv code (uint16)[, cv (float) when the code is stepDataRawCv]
+//   The cv code is the cv as a number of semitones plus an offset of -1 to 1 ulp, so that the cv is restored bit exact.
+//   All multi-byte values are little endian.
+
+template <int STEPS, int SEQS, int PHRASES>
+bool BasicSequencerKernel<STEPS, SEQS, PHRASES>::writeLegacyJson = false;
+
+static const unsigned char stepDataVersion = 1;
+static const int stepDataRawCv = 0xFFFF;
+static const int stepDataMaxSemitones = 120;// cv range of the cv codes is -10V to 10V
+
+static float semitonesToCv(int semitones) {
+	return (float)(semitones / 12.0);// in double so that the rounding to float doesn't depend on the math flags
+}
+
+static int32_t floatToBits(float value) {
+	int32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static float bitsToFloat(int32_t bits) {
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static int cvToCode(float cvVal) {
+	if (cvVal >= -10.0f && cvVal <= 10.0f) {
+		int semitones = (int)roundf(cvVal * 12.0f);
+		int32_t refBits = floatToBits(semitonesToCv(semitones));
+		int32_t cvBits = floatToBits(cvVal);
+		if ((refBits ^ cvBits) >= 0 && cvBits - refBits >= -1 && cvBits - refBits <= 1)// same sign and at most 1 ulp away
+			return (semitones + stepDataMaxSemitones) * 3 + (cvBits - refBits) + 1;
+	}
+	return stepDataRawCv;
+}
+
+static float codeToCv(int code) {
+	return bitsToFloat(floatToBits(semitonesToCv(code / 3 - stepDataMaxSemitones)) + (code % 3) - 1);
+}
+
+static void putBytes(std::vector<unsigned char> &bytes, uint32_t value, int numBytes) {// little endian
+	for (int b = 0; b < numBytes; b++)
+		bytes.push_back((value >> (b * 8)) & 0xFF);
+}
+
+static uint32_t getBytes(const unsigned char *bytes, int numBytes) {
+	uint32_t value = 0;
+	for (int b = 0; b < numBytes; b++)
+		value |= ((uint32_t)bytes[b]) << (b * 8);
+	return value;
+}
+
+static const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static std::string base64Encode(const std::vector<unsigned char> &bytes) {
+	std::string str;
+	str.reserve((bytes.size() + 2) / 3 * 4);
+	for (size_t i = 0; i < bytes.size(); i += 3) {
+		uint32_t triple = bytes[i] << 16;
+		if (i + 1 < bytes.size())
+			triple |= bytes[i + 1] << 8;
+		if (i + 2 < bytes.size())
+			triple |= bytes[i + 2];
+		str += base64Chars[(triple >> 18) & 0x3F];
+		str += base64Chars[(triple >> 12) & 0x3F];
+		str += (i + 1 < bytes.size()) ? base64Chars[(triple >> 6) & 0x3F] : '=';
+		str += (i + 2 < bytes.size()) ? base64Chars[triple & 0x3F] : '=';
+	}
+	return str;
+}
+
+static bool base64Decode(const char *str, std::vector<unsigned char> &bytes) {
+	uint32_t bits = 0;
+	int numBits = 0;
+	for (; *str != 0 && *str != '='; str++) {
+		const char *pos = strchr(base64Chars, *str);
+		if (pos == NULL)
+			return false;
+		bits = (bits << 6) | (uint32_t)(pos - base64Chars);
+		numBits += 6;
+		if (numBits >= 8) {
+			numBits -= 8;
+			bytes.push_back((bits >> numBits) & 0xFF);
+		}
+	}
+	return true;
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+std::string BasicSequencerKernel<STEPS, SEQS, PHRASES>::stepDataToString() {
+	static const int numSteps = MAX_SEQS * MAX_STEPS;
+	StepData *stepsFlat = &steps[0][0];
+	std::vector<unsigned char> bytes;
+	bytes.reserve(1024);
+	bytes.push_back(stepDataVersion);
+	for (int i = 0; i < numSteps; ) {
+		uint32_t attribute = stepsFlat[i].attributes.getAttribute();
+		int32_t cvBits = floatToBits(stepsFlat[i].cv);
+		int runLength = 1;
+		while (i + runLength < numSteps && stepsFlat[i + runLength].attributes.getAttribute() == attribute && floatToBits(stepsFlat[i + runLength].cv) == cvBits)
+			runLength++;
+		for (unsigned int rl = runLength; ; rl >>= 7) {// varint
+			if (rl < 0x80) {
+				bytes.push_back(rl);
+				break;
+			}
+			bytes.push_back((rl & 0x7F) | 0x80);
+		}
+		putBytes(bytes, attribute, 4);
+		int code = cvToCode(stepsFlat[i].cv);
+		putBytes(bytes, code, 2);
+		if (code == stepDataRawCv)
+			putBytes(bytes, cvBits, 4);
+		i += runLength;
+	}
+	return base64Encode(bytes);
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+bool BasicSequencerKernel<STEPS, SEQS, PHRASES>::stepDataFromString(const char *stepDataStr) {
+	static const int numSteps = MAX_SEQS * MAX_STEPS;
+	std::vector<unsigned char> bytes;
+	if (stepDataStr == NULL || !base64Decode(stepDataStr, bytes) || bytes.empty() || bytes[0] != stepDataVersion)
+		return false;
+	
+	// decoded into temporaries first, so that a truncated string leaves the sequences untouched
+	std::vector<float> cvNew(numSteps);
+	std::vector<uint32_t> attributesNew(numSteps);
+	size_t pos = 1;
+	for (int i = 0; i < numSteps; ) {
+		unsigned int runLength = 0;
+		for (int shift = 0; ; shift += 7) {// varint
+			if (pos >= bytes.size() || shift > 14)
+				return false;
+			runLength |= (bytes[pos] & 0x7F) << shift;
+			if ((bytes[pos++] & 0x80) == 0)
+				break;
+		}
+		if (runLength == 0 || runLength > (unsigned int)(numSteps - i) || pos + 6 > bytes.size())
+			return false;
+		uint32_t attribute = getBytes(&bytes[pos], 4);
+		int code = (int)getBytes(&bytes[pos + 4], 2);
+		pos += 6;
+		float cvVal;
+		if (code == stepDataRawCv) {
+			if (pos + 4 > bytes.size())
+				return false;
+			cvVal = bitsToFloat((int32_t)getBytes(&bytes[pos], 4));
+			pos += 4;
+		}
+		else
+			cvVal = codeToCv(code);
+		for (unsigned int r = 0; r < runLength; r++, i++) {
+			cvNew[i] = cvVal;
+			attributesNew[i] = attribute;
+		}
+	}
+	if (pos != bytes.size())
+		return false;
+
+	for (int i = 0; i < numSteps; i++) {
+		steps[i / MAX_STEPS][i % MAX_STEPS].cv = cvNew[i];
+		steps[i / MAX_STEPS][i % MAX_STEPS].attributes.setAttribute(attributesNew[i]);
+	}
+	invalidatePrediction();
+	return true;
 }
 
 
-void SequencerKernel::clockStep(bool realClockEdgeToHandle) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::clockStep(bool realClockEdgeToHandle, float edgeFraction) {// edgeFraction: see ClockTrigger
 	if (realClockEdgeToHandle) {
 		if (ppqnLeftToSkip > 0) {
 			ppqnLeftToSkip--;
@@ -379,32 +605,38 @@ void SequencerKernel::clockStep(bool realClockEdgeToHandle) {
 				ppqnCount = 0;
 			if (ppqnCount == 0) {
 				float slideFromCV = getCVRun();
-				if (moveStepIndexRun()) {
-					movePhraseIndexRun(false);// false means normal (not init)
-					SeqAttributes newSeq = sequences[phrases[phraseIndexRun].getSeqNum()];
-					stepIndexRun = (newSeq.getRunMode() == MODE_REV ? newSeq.getLength() - 1 : 0);// must always refresh after phraseIndexRun has changed
+				advanceRun(run, masterKernel != nullptr ? &masterKernel->run : nullptr);
+				if (predictCount > 0) {// keep the lookahead if it saw this step coming, otherwise it is recalculated when next asked for
+					PredictedStep ps = predicted[predictHead];
+					if (ps.phrn == run.phraseIndexRun && ps.stepn == run.stepIndexRun) {
+						predictHead = (predictHead + 1) % PREDICT_SIZE;
+						predictCount--;
+					}
+					else
+						invalidatePrediction();
 				}
 
 				// Slide
 				StepAttributes attribRun = getAttributeRun();
 				if (attribRun.getSlide()) {
-					slideStepsRemain = (unsigned long) (((float)clockPeriod * ppsFiltered) * ((float)attribRun.getSlideVal() / 100.0f));
-					if (slideStepsRemain != 0ul) {
-						float slideToCV = getCVRun();
-						slideCVdelta = (slideToCV - slideFromCV)/(float)slideStepsRemain;
-					}
+					float slideSteps = (((float)clockPeriod + clockFraction - edgeFraction) * ppsFiltered) * ((float)attribRun.getSlideVal() / 100.0f);// period between the estimated edges
+					slide.reset();
+					if (slideSteps >= 1.0f)
+						slide.start(slideFromCV, getCVRun(), slideSteps, edgeFraction, *slideShapePtr);
 				}
 				else
-					slideStepsRemain = 0ul;
+					slide.reset();
 			}
-			calcGateCodeEx(phrases[phraseIndexRun].getSeqNum());// uses stepIndexRun as the step		
+			calcGateCodeEx(phrases[run.phraseIndexRun].getSeqNum());// uses run.stepIndexRun as the step		
 		}
 	}
 	clockPeriod = 0ul;
+	clockFraction = edgeFraction;
 }
 
 
-int SequencerKernel::keyIndexToGateTypeEx(int keyIndex) {// return -1 when invalid gate type given current pps setting
+template <int STEPS, int SEQS, int PHRASES>
+int BasicSequencerKernel<STEPS, SEQS, PHRASES>::keyIndexToGateTypeEx(int keyIndex) {// return -1 when invalid gate type given current pps setting
 	int ppsFiltered = getPulsesPerStep();// must use method
 	int ret = keyIndex;
 	
@@ -430,7 +662,8 @@ int SequencerKernel::keyIndexToGateTypeEx(int keyIndex) {// return -1 when inval
 }
 
 
-void SequencerKernel::transposeSeq(int seqn, int delta) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::transposeSeq(int seqn, int delta) {
 	int tVal = sequences[seqn].getTranspose();
 	int oldTransposeOffset = tVal;
 	tVal = clamp(tVal + delta, -99, 99);
@@ -440,12 +673,13 @@ void SequencerKernel::transposeSeq(int seqn, int delta) {
 	if (delta != 0) { 
 		float offsetCV = ((float)(delta))/12.0f;
 		for (int stepn = 0; stepn < MAX_STEPS; stepn++) 
-			cv[seqn][stepn] += offsetCV;
+			steps[seqn][stepn].cv += offsetCV;
 	}
 }
 
 
-void SequencerKernel::rotateSeq(int* rotateOffset, int seqn, int delta) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::rotateSeq(int* rotateOffset, int seqn, int delta) {
 	int oldRotateOffset = *rotateOffset;
 	*rotateOffset = clamp(*rotateOffset + delta, -99, 99);
 	
@@ -463,10 +697,12 @@ void SequencerKernel::rotateSeq(int* rotateOffset, int seqn, int delta) {
 			rotateSeqByOne(seqn, false);
 		}
 	}
+	invalidatePrediction();
 }	
 
 
-void SequencerKernel::rotateSeqByOne(int seqn, bool directionRight) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::rotateSeqByOne(int seqn, bool directionRight) {
 	float rotCV;
 	StepAttributes rotAttributes;
 	int iStart = 0;
@@ -477,199 +713,263 @@ void SequencerKernel::rotateSeqByOne(int seqn, bool directionRight) {
 		iRot = iEnd;
 		iDelta = -1;
 	}
-	rotCV = cv[seqn][iRot];
-	rotAttributes = attributes[seqn][iRot];
+	rotCV = steps[seqn][iRot].cv;
+	rotAttributes = steps[seqn][iRot].attributes;
 	for ( ; ; iRot += iDelta) {
 		if (iDelta == 1 && iRot >= iEnd) break;
 		if (iDelta == -1 && iRot <= iStart) break;
-		cv[seqn][iRot] = cv[seqn][iRot + iDelta];
-		attributes[seqn][iRot] = attributes[seqn][iRot + iDelta];
+		steps[seqn][iRot].cv = steps[seqn][iRot + iDelta].cv;
+		steps[seqn][iRot].attributes = steps[seqn][iRot + iDelta].attributes;
 	}
-	cv[seqn][iRot] = rotCV;
-	attributes[seqn][iRot] = rotAttributes;
+	steps[seqn][iRot].cv = rotCV;
+	steps[seqn][iRot].attributes = rotAttributes;
 }
 
 
-void SequencerKernel::activateTiedStep(int seqn, int stepn) {
-	attributes[seqn][stepn].setTied(true);
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::activateTiedStep(int seqn, int stepn) {
+	steps[seqn][stepn].attributes.setTied(true);
 	if (stepn > 0) 
 		propagateCVtoTied(seqn, stepn - 1);
 	
 	if (*holdTiedNotesPtr) {// new method
-		attributes[seqn][stepn].setGate(true);
-		for (int i = max(stepn, 1); i < MAX_STEPS && attributes[seqn][i].getTied(); i++) {
-			attributes[seqn][i].setGateType(attributes[seqn][i - 1].getGateType());
-			attributes[seqn][i - 1].setGateType(5);
-			attributes[seqn][i - 1].setGate(true);
+		steps[seqn][stepn].attributes.setGate(true);
+		for (int i = max(stepn, 1); i < MAX_STEPS && steps[seqn][i].attributes.getTied(); i++) {
+			steps[seqn][i].attributes.setGateType(steps[seqn][i - 1].attributes.getGateType());
+			steps[seqn][i - 1].attributes.setGateType(5);
+			steps[seqn][i - 1].attributes.setGate(true);
 		}
 	}
 	else {// old method
 		if (stepn > 0) {
-			attributes[seqn][stepn] = attributes[seqn][stepn - 1];
-			attributes[seqn][stepn].setTied(true);
+			steps[seqn][stepn].attributes = steps[seqn][stepn - 1].attributes;
+			steps[seqn][stepn].attributes.setTied(true);
 		}
 	}
 }
 
 
-void SequencerKernel::deactivateTiedStep(int seqn, int stepn) {
-	attributes[seqn][stepn].setTied(false);
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::deactivateTiedStep(int seqn, int stepn) {
+	steps[seqn][stepn].attributes.setTied(false);
 	if (*holdTiedNotesPtr) {// new method
-		int lastGateType = attributes[seqn][stepn].getGateType();
-		for (int i = stepn + 1; i < MAX_STEPS && attributes[seqn][i].getTied(); i++)
-			lastGateType = attributes[seqn][i].getGateType();
+		int lastGateType = steps[seqn][stepn].attributes.getGateType();
+		for (int i = stepn + 1; i < MAX_STEPS && steps[seqn][i].attributes.getTied(); i++)
+			lastGateType = steps[seqn][i].attributes.getGateType();
 		if (stepn > 0)
-			attributes[seqn][stepn - 1].setGateType(lastGateType);
+			steps[seqn][stepn - 1].attributes.setGateType(lastGateType);
 	}
 	//else old method, nothing to do
 }
 
 
-void SequencerKernel::calcGateCodeEx(int seqn) {// uses stepIndexRun as the step
-	StepAttributes attribute = attributes[seqn][stepIndexRun];
-	int ppsFiltered = getPulsesPerStep();// must use method
-	int gateType;
+template <int STEPS, int SEQS, int PHRASES>
+int BasicSequencerKernel<STEPS, SEQS, PHRASES>::predictSteps(int count) {// returns how many of the next count steps are available through getPredictedStep()
+	// Side-effect free on the run: a copy of the run state is advanced exactly as clockStep() would (same rng draws), so the
+	//   predicted steps are the ones that will play as long as nothing is edited. Tracks in TKA follow the prediction of 
+	//   the master kernel step for step, so they are only predicted when they step at the same time as the master (same 
+	//   pulses per step, delay and clock input); otherwise nothing is predicted for them
+	count = min(count, PREDICT_SIZE);
+	bool follows = masterKernel != nullptr && followsMaster();
+	if (follows) {
+		if (getPulsesPerStep() != masterKernel->getPulsesPerStep() || delay != masterKernel->delay || clockSource != masterKernel->clockSource)
+			return 0;
+		count = masterKernel->predictSteps(count);
+		if (predictMasterVersion != masterKernel->predictVersion)
+			predictCount = 0;
+	}
+	if (predictCount == 0) {
+		predictHead = 0;
+		predictState = run;
+		if (follows)
+			predictMasterVersion = masterKernel->predictVersion;
+	}
+	RunState masterState(0);
+	for ( ; predictCount < count; predictCount++) {
+		if (follows) {
+			PredictedStep mps = masterKernel->getPredictedStep(predictCount);
+			masterState.stepIndexRun = mps.stepn;
+			masterState.phraseIndexRun = mps.phrn;
+		}
+		advanceRun(predictState, follows ? &masterState : nullptr);
+		PredictedStep &ps = predicted[(predictHead + predictCount) % PREDICT_SIZE];
+		ps.phrn = predictState.phraseIndexRun;
+		ps.seqn = phrases[ps.phrn].getSeqNum();
+		ps.stepn = predictState.stepIndexRun;
+		if (steps[ps.seqn][ps.stepn].attributes.getGateP())
+			predictState.rng.uniform();// same draw as calcGateCodeEx() on the first ppqn of the step
+	}
+	return count;
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+bool BasicSequencerKernel<STEPS, SEQS, PHRASES>::followsMaster() {// true when a TKA run mode makes this track's path depend on the master's
+	if (runModeSong == MODE_TKA)
+		return true;
+	for (int seqn = 0; seqn < MAX_SEQS; seqn++) {
+		if (sequences[seqn].getRunMode() == MODE_TKA)
+			return true;
+	}
+	return false;
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+int BasicSequencerKernel<STEPS, SEQS, PHRASES>::getSetting(int setn) {// pulses per step is the stored value, not the one given by getPulsesPerStep()
+	switch (setn) {
+		case SET_RUNMODE_SONG : return runModeSong;
+		case SET_BEGIN : return songBeginIndex;
+		case SET_END : return songEndIndex;
+		case SET_PPS : return pulsesPerStep;
+		default : return delay;
+	}
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::setSetting(int setn, int value) {
+	switch (setn) {
+		case SET_RUNMODE_SONG : setRunModeSong(value); break;
+		case SET_BEGIN : setBegin(value); break;// begin and end can be set in any order when restoring both, since the result has begin <= end
+		case SET_END : setEnd(value); break;
+		case SET_PPS : setPulsesPerStep(value); break;
+		default : setDelay(value);
+	}
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::calcGateCodeEx(int seqn) {// uses run.stepIndexRun as the step
+	StepAttributes attribute = steps[seqn][run.stepIndexRun].attributes;
 
 	if (gateCode != -1 || ppqnCount == 0) {// always calc on first ppqnCount, avoid thereafter if gate will be off for whole step
-		gateType = attribute.getGateType();
-		
 		// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
-		if ( ppqnCount == 0 && attribute.getGateP() && !(randomUniform() < ((float)attribute.getGatePVal() / 100.0f)) ) {// randomUniform is [0.0, 1.0), see include/util/common.hpp
+		if ( ppqnCount == 0 && attribute.getGateP() && !(run.rng.uniform() < ((float)attribute.getGatePVal() / 100.0f)) ) {// uniform is [0.0, 1.0), see ImpromptuModular.hpp
 			gateCode = -1;// must do this first in this method since it will kill all remaining pulses of the step if prob turns off the step
 		}
 		else if (!attribute.getGate()) {
 			gateCode = 0;
 		}
-		else if (ppsFiltered == 1 && gateType == 0) {
-			gateCode = 2;// clock high pulse
-		}
 		else {
-			if (gateType == 11) {
-				gateCode = (ppqnCount == 0 ? 3 : 0);// trig on first ppqnCount
-			}
-			else {
-				uint64_t shiftAmt = ppqnCount * (96 / ppsFiltered);
-				if (shiftAmt >= 64)
-					gateCode = (int)((advGateHitMaskHigh[gateType] >> (shiftAmt - (uint64_t)64)) & (uint64_t)0x1);
-				else
-					gateCode = (int)((advGateHitMaskLow[gateType] >> shiftAmt) & (uint64_t)0x1);
-			}
+			gateCode = GateCodes::get(attribute.getGateType(), pulsesPerStep - 1, ppqnCount);// stored pulsesPerStep is the index of getPulsesPerStep()
 		}
 	}
 }
 	
 
-bool SequencerKernel::moveStepIndexRun() {	
-	int reps = phrases[phraseIndexRun].getReps();// 0-rep seqs should be filtered elsewhere and should never happen here. If they do, they will be played (this can be the case when all of the song has 0-rep seqs, or the song is started (reset) into a first phrase that has 0 reps)
-	// assert((reps * MAX_STEPS) <= 0xFFF); // for BRN and RND run modes, history is not a span count but a step count
-	int runMode = sequences[phrases[phraseIndexRun].getSeqNum()].getRunMode();
-	int endStep = sequences[phrases[phraseIndexRun].getSeqNum()].getLength() - 1;
+template <int STEPS, int SEQS, int PHRASES>
+bool BasicSequencerKernel<STEPS, SEQS, PHRASES>::moveStepIndexRun(RunState &rs, const RunState *master) {	
+	int reps = phrases[rs.phraseIndexRun].getReps();// 0-rep seqs should be filtered elsewhere and should never happen here. If they do, they will be played (this can be the case when all of the song has 0-rep seqs, or the song is started (reset) into a first phrase that has 0 reps)
+	// for BRN and RND run modes, history is not a span count but a step count, hence STEP_HISTORY_SPAN (0x1000 with 32 steps)
+	int runMode = sequences[phrases[rs.phraseIndexRun].getSeqNum()].getRunMode();
+	int endStep = sequences[phrases[rs.phraseIndexRun].getSeqNum()].getLength() - 1;
 	
 	bool crossBoundary = false;
 	
 	switch (runMode) {
 	
-		// history 0x0000 is reserved for reset
+		// history 0 is reserved for reset
 		
-		case MODE_REV :// reverse; history base is 0x2000
-			if (stepIndexRunHistory < 0x2001 || stepIndexRunHistory > 0x2FFF)
-				stepIndexRunHistory = 0x2000 + reps;
-			stepIndexRun--;
-			if (stepIndexRun < 0) {
-				stepIndexRun = endStep;
-				stepIndexRunHistory--;
-				if (stepIndexRunHistory <= 0x2000)
+		case MODE_REV :// reverse; history base is 2 * STEP_HISTORY_SPAN
+			if (rs.stepIndexRunHistory < 2 * STEP_HISTORY_SPAN + 1 || rs.stepIndexRunHistory > (3 * STEP_HISTORY_SPAN - 1))
+				rs.stepIndexRunHistory = 2 * STEP_HISTORY_SPAN + reps;
+			rs.stepIndexRun--;
+			if (rs.stepIndexRun < 0) {
+				rs.stepIndexRun = endStep;
+				rs.stepIndexRunHistory--;
+				if (rs.stepIndexRunHistory <= 2 * STEP_HISTORY_SPAN)
 					crossBoundary = true;
 			}
 		break;
 		
-		case MODE_PPG :// forward-reverse; history base is 0x3000
-			if (stepIndexRunHistory < 0x3001 || stepIndexRunHistory > 0x3FFF) // even means going forward, odd means going reverse
-				stepIndexRunHistory = 0x3000 + reps * 2;
-			if ((stepIndexRunHistory & 0x1) == 0) {// even so forward phase
-				stepIndexRun++;
-				if (stepIndexRun > endStep) {
-					stepIndexRun = endStep;
-					stepIndexRunHistory--;
+		case MODE_PPG :// forward-reverse; history base is 3 * STEP_HISTORY_SPAN
+			if (rs.stepIndexRunHistory < 3 * STEP_HISTORY_SPAN + 1 || rs.stepIndexRunHistory > (4 * STEP_HISTORY_SPAN - 1)) // even means going forward, odd means going reverse
+				rs.stepIndexRunHistory = 3 * STEP_HISTORY_SPAN + reps * 2;
+			if ((rs.stepIndexRunHistory & 0x1) == 0) {// even so forward phase
+				rs.stepIndexRun++;
+				if (rs.stepIndexRun > endStep) {
+					rs.stepIndexRun = endStep;
+					rs.stepIndexRunHistory--;
 				}
 			}
 			else {// odd so reverse phase
-				stepIndexRun--;
-				if (stepIndexRun < 0) {
-					stepIndexRun = 0;
-					stepIndexRunHistory--;
-					if (stepIndexRunHistory <= 0x3000)
+				rs.stepIndexRun--;
+				if (rs.stepIndexRun < 0) {
+					rs.stepIndexRun = 0;
+					rs.stepIndexRunHistory--;
+					if (rs.stepIndexRunHistory <= 3 * STEP_HISTORY_SPAN)
 						crossBoundary = true;
 				}
 			}
 		break;
 
-		case MODE_PEN :// forward-reverse; history base is 0x4000
-			if (stepIndexRunHistory < 0x4001 || stepIndexRunHistory > 0x4FFF) // even means going forward, odd means going reverse
-				stepIndexRunHistory = 0x4000 + reps * 2;
-			if ((stepIndexRunHistory & 0x1) == 0) {// even so forward phase
-				stepIndexRun++;
-				if (stepIndexRun > endStep) {
-					stepIndexRun = endStep - 1;
-					stepIndexRunHistory--;
-					if (stepIndexRun <= 0) {// if back at start after turnaround, then no reverse phase needed
-						stepIndexRun = 0;
-						stepIndexRunHistory--;
-						if (stepIndexRunHistory <= 0x4000)
+		case MODE_PEN :// forward-reverse; history base is 4 * STEP_HISTORY_SPAN
+			if (rs.stepIndexRunHistory < 4 * STEP_HISTORY_SPAN + 1 || rs.stepIndexRunHistory > (5 * STEP_HISTORY_SPAN - 1)) // even means going forward, odd means going reverse
+				rs.stepIndexRunHistory = 4 * STEP_HISTORY_SPAN + reps * 2;
+			if ((rs.stepIndexRunHistory & 0x1) == 0) {// even so forward phase
+				rs.stepIndexRun++;
+				if (rs.stepIndexRun > endStep) {
+					rs.stepIndexRun = endStep - 1;
+					rs.stepIndexRunHistory--;
+					if (rs.stepIndexRun <= 0) {// if back at start after turnaround, then no reverse phase needed
+						rs.stepIndexRun = 0;
+						rs.stepIndexRunHistory--;
+						if (rs.stepIndexRunHistory <= 4 * STEP_HISTORY_SPAN)
 							crossBoundary = true;
 					}
 				}
 			}
 			else {// odd so reverse phase
-				stepIndexRun--;
-				if (stepIndexRun > endStep)// handle song jumped
-					stepIndexRun = endStep;
-				if (stepIndexRun <= 0) {
-					stepIndexRun = 0;
-					stepIndexRunHistory--;
-					if (stepIndexRunHistory <= 0x4000)
+				rs.stepIndexRun--;
+				if (rs.stepIndexRun > endStep)// handle song jumped
+					rs.stepIndexRun = endStep;
+				if (rs.stepIndexRun <= 0) {
+					rs.stepIndexRun = 0;
+					rs.stepIndexRunHistory--;
+					if (rs.stepIndexRunHistory <= 4 * STEP_HISTORY_SPAN)
 						crossBoundary = true;
 				}
 			}
 		break;
 		
-		case MODE_BRN :// brownian random; history base is 0x5000
-			if (stepIndexRunHistory < 0x5001 || stepIndexRunHistory > 0x5FFF) 
-				stepIndexRunHistory = 0x5000 + (endStep + 1) * reps;			
-			stepIndexRun += (randomu32() % 3) - 1;
-			if (stepIndexRun > endStep)
-				stepIndexRun = 0;
-			if (stepIndexRun < 0)
-				stepIndexRun = endStep;
-			stepIndexRunHistory--;
-			if (stepIndexRunHistory <= 0x5000)
+		case MODE_BRN :// brownian random; history base is 5 * STEP_HISTORY_SPAN
+			if (rs.stepIndexRunHistory < 5 * STEP_HISTORY_SPAN + 1 || rs.stepIndexRunHistory > (6 * STEP_HISTORY_SPAN - 1)) 
+				rs.stepIndexRunHistory = 5 * STEP_HISTORY_SPAN + (endStep + 1) * reps;			
+			rs.stepIndexRun += (rs.rng.u32() % 3) - 1;
+			if (rs.stepIndexRun > endStep)
+				rs.stepIndexRun = 0;
+			if (rs.stepIndexRun < 0)
+				rs.stepIndexRun = endStep;
+			rs.stepIndexRunHistory--;
+			if (rs.stepIndexRunHistory <= 5 * STEP_HISTORY_SPAN)
 				crossBoundary = true;
 		break;
 		
-		case MODE_RND :// random; history base is 0x6000
-			if (stepIndexRunHistory < 0x6001 || stepIndexRunHistory > 0x6FFF)
-				stepIndexRunHistory = 0x6000 + (endStep + 1) * reps;
-			stepIndexRun = (randomu32() % (endStep + 1));
-			stepIndexRunHistory--;
-			if (stepIndexRunHistory <= 0x6000)
+		case MODE_RND :// random; history base is 6 * STEP_HISTORY_SPAN
+			if (rs.stepIndexRunHistory < 6 * STEP_HISTORY_SPAN + 1 || rs.stepIndexRunHistory > (7 * STEP_HISTORY_SPAN - 1))
+				rs.stepIndexRunHistory = 6 * STEP_HISTORY_SPAN + (endStep + 1) * reps;
+			rs.stepIndexRun = (rs.rng.u32() % (endStep + 1));
+			rs.stepIndexRunHistory--;
+			if (rs.stepIndexRunHistory <= 6 * STEP_HISTORY_SPAN)
 				crossBoundary = true;
 		break;
 		
-		case MODE_TKA :// use track A's stepIndexRun; base is 0x7000
-			if (masterKernel != nullptr) {
-				stepIndexRunHistory = 0x7000;
-				stepIndexRun = masterKernel->getStepIndexRun();
+		case MODE_TKA :// use track A's rs.stepIndexRun; base is 7 * STEP_HISTORY_SPAN
+			if (master != nullptr) {
+				rs.stepIndexRunHistory = 7 * STEP_HISTORY_SPAN;
+				rs.stepIndexRun = master->stepIndexRun;
 				break;
 			}
 			[[fallthrough]];
-		default :// MODE_FWD  forward; history base is 0x1000
-			if (stepIndexRunHistory < 0x1001 || stepIndexRunHistory > 0x1FFF)
-				stepIndexRunHistory = 0x1000 + reps;
-			stepIndexRun++;
-			if (stepIndexRun > endStep) {
-				stepIndexRun = 0;
-				stepIndexRunHistory--;
-				if (stepIndexRunHistory <= 0x1000)
+		default :// MODE_FWD  forward; history base is 1 * STEP_HISTORY_SPAN
+			if (rs.stepIndexRunHistory < 1 * STEP_HISTORY_SPAN + 1 || rs.stepIndexRunHistory > (2 * STEP_HISTORY_SPAN - 1))
+				rs.stepIndexRunHistory = 1 * STEP_HISTORY_SPAN + reps;
+			rs.stepIndexRun++;
+			if (rs.stepIndexRun > endStep) {
+				rs.stepIndexRun = 0;
+				rs.stepIndexRunHistory--;
+				if (rs.stepIndexRunHistory <= 1 * STEP_HISTORY_SPAN)
 					crossBoundary = true;
 			}
 	}
@@ -678,170 +978,323 @@ bool SequencerKernel::moveStepIndexRun() {
 }
 
 
-void SequencerKernel::moveSongIndexBackward(bool init, bool rollover) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::advanceRun(RunState &rs, const RunState *master) {// one step of rs, master is the run state of masterKernel (nullptr for track 0)
+	if (moveStepIndexRun(rs, master)) {
+		movePhraseIndexRun(rs, master, false);// false means normal (not init)
+		SeqAttributes newSeq = sequences[phrases[rs.phraseIndexRun].getSeqNum()];
+		rs.stepIndexRun = (newSeq.getRunMode() == MODE_REV ? newSeq.getLength() - 1 : 0);// must always refresh after phraseIndexRun has changed
+	}
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::updatePlayablePhrases() {// must be called when phrases turn 0-rep or back
+	int numPlayable = 0;
+	prevPlayable[0] = -1;
+	for (int phrn = 0; phrn < MAX_PHRASES; phrn++) {
+		playableRank[phrn] = numPlayable;
+		if (phrases[phrn].getReps() != 0)
+			playablePhrases[numPlayable++] = phrn;
+		prevPlayable[phrn + 1] = (phrases[phrn].getReps() != 0 ? phrn : prevPlayable[phrn]);
+	}
+	playableRank[MAX_PHRASES] = numPlayable;
+	nextPlayable[MAX_PHRASES] = MAX_PHRASES;
+	for (int phrn = MAX_PHRASES - 1; phrn >= 0; phrn--)
+		nextPlayable[phrn] = (phrases[phrn].getReps() != 0 ? phrn : nextPlayable[phrn + 1]);
+}
+
+
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::moveSongIndexBackward(RunState &rs, bool init, bool rollover) {
 	int phrn = 0;
 
 	// search backward for next non 0-rep seq, ends up in same phrase if all reps in the song are 0
 	if (init) {
-		phraseIndexRun = songEndIndex;
-		phrn = phraseIndexRun;
+		rs.phraseIndexRun = songEndIndex;
+		phrn = rs.phraseIndexRun;
 	}
 	else
-		phrn = min(phraseIndexRun - 1, songEndIndex);// handle song jumped
-	for (; phrn >= songBeginIndex && phrases[phrn].getReps() == 0; phrn--);
+		phrn = min(rs.phraseIndexRun - 1, songEndIndex);// handle song jumped
+	phrn = prevPlayable[phrn + 1];
 	if (phrn < songBeginIndex) {
 		if (rollover)
-			for (phrn = songEndIndex; phrn > phraseIndexRun && phrases[phrn].getReps() == 0; phrn--);
+			phrn = max(prevPlayable[songEndIndex + 1], min(rs.phraseIndexRun, songEndIndex));// search back from the end, stop at rs.phraseIndexRun
 		else
-			phrn = phraseIndexRun;
-		phraseIndexRunHistory--;
+			phrn = rs.phraseIndexRun;
+		rs.phraseIndexRunHistory--;
 	}
-	phraseIndexRun = phrn;
+	rs.phraseIndexRun = phrn;
 }
 
 
-void SequencerKernel::moveSongIndexForeward(bool init, bool rollover) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::moveSongIndexForeward(RunState &rs, bool init, bool rollover) {
 	int phrn = 0;
 	
 	// search fowrard for next non 0-rep seq, ends up in same phrase if all reps in the song are 0
 	if (init) {
-		phraseIndexRun = songBeginIndex;
-		phrn = phraseIndexRun;
+		rs.phraseIndexRun = songBeginIndex;
+		phrn = rs.phraseIndexRun;
 	}
 	else
-		phrn = max(phraseIndexRun + 1, songBeginIndex);// handle song jumped
-	for (; phrn <= songEndIndex && phrases[phrn].getReps() == 0; phrn++);
+		phrn = max(rs.phraseIndexRun + 1, songBeginIndex);// handle song jumped
+	phrn = nextPlayable[phrn];
 	if (phrn > songEndIndex) {
 		if (rollover)
-			for (phrn = songBeginIndex; phrn < phraseIndexRun && phrases[phrn].getReps() == 0; phrn++);
+			phrn = min(nextPlayable[songBeginIndex], max(rs.phraseIndexRun, songBeginIndex));// search from the beginning, stop at rs.phraseIndexRun
 		else
-			phrn = phraseIndexRun;
-		phraseIndexRunHistory--;
+			phrn = rs.phraseIndexRun;
+		rs.phraseIndexRunHistory--;
 	}
-	phraseIndexRun = phrn;
+	rs.phraseIndexRun = phrn;
 }
 
 
-void SequencerKernel::moveSongIndexRandom(bool init, uint32_t randomValue) {
-	int phrn = songBeginIndex;
-	int tpi = 0;
-	
-	for (;phrn <= songEndIndex; phrn++) {
-		if (phrases[phrn].getReps() != 0) {
-			tempPhraseIndexes[tpi] = phrn;
-			tpi++;
-			if (init) break;
-		}
-	}
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::moveSongIndexRandom(RunState &rs, bool init, uint32_t randomValue) {
+	int firstRank = playableRank[songBeginIndex];
+	int numPlayable = (songEndIndex >= songBeginIndex ? playableRank[songEndIndex + 1] - firstRank : 0);
 	
-	if (init) {
-		phraseIndexRun = (tpi == 0 ? songBeginIndex : tempPhraseIndexes[0]);
+	if (init || numPlayable == 0) {
+		rs.phraseIndexRun = (numPlayable == 0 ? songBeginIndex : playablePhrases[firstRank]);
 	}
 	else {
-		phraseIndexRun = tempPhraseIndexes[randomValue % tpi];
+		rs.phraseIndexRun = playablePhrases[firstRank + randomValue % numPlayable];
 	}
 }
 
 
-void SequencerKernel::moveSongIndexBrownian(bool init, uint32_t randomValue) {	
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::moveSongIndexBrownian(RunState &rs, bool init, uint32_t randomValue) {	
 	randomValue = randomValue % 3;// 0 = left, 1 = stay, 2 = right
 	
 	if (init) {
-		moveSongIndexForeward(init, true);
+		moveSongIndexForeward(rs, init, true);
 	}
 	else if (randomValue == 1) {// stay
-		if (phraseIndexRun > songEndIndex || phraseIndexRun < songBeginIndex)
-			moveSongIndexForeward(false, true);	
+		if (rs.phraseIndexRun > songEndIndex || rs.phraseIndexRun < songBeginIndex)
+			moveSongIndexForeward(rs, false, true);	
 	}
 	else if (randomValue == 0) {// left
-		moveSongIndexBackward(false, true);
+		moveSongIndexBackward(rs, false, true);
 	}
 	else {// right
-		moveSongIndexForeward(false, true);
+		moveSongIndexForeward(rs, false, true);
 	}
 }
 
 
-void SequencerKernel::movePhraseIndexRun(bool init) {	
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::movePhraseIndexRun(RunState &rs, const RunState *master, bool init) {	
 	if (init)
-		phraseIndexRunHistory = 0;
+		rs.phraseIndexRunHistory = 0;
 	
 	switch (runModeSong) {
 	
 		// history 0x0000 is reserved for reset
 		
 		case MODE_REV :// reverse; history base is 0x2000
-			phraseIndexRunHistory = 0x2000;
-			moveSongIndexBackward(init, true);
+			rs.phraseIndexRunHistory = 0x2000;
+			moveSongIndexBackward(rs, init, true);
 		break;
 		
 		case MODE_PPG :// forward-reverse; history base is 0x3000
-			if (phraseIndexRunHistory < 0x3001 || phraseIndexRunHistory > 0x3002) // even means going forward, odd means going reverse
-				phraseIndexRunHistory = 0x3002;
-			if (phraseIndexRunHistory == 0x3002) {// even so forward phase
-				moveSongIndexForeward(init, false);
+			if (rs.phraseIndexRunHistory < 0x3001 || rs.phraseIndexRunHistory > 0x3002) // even means going forward, odd means going reverse
+				rs.phraseIndexRunHistory = 0x3002;
+			if (rs.phraseIndexRunHistory == 0x3002) {// even so forward phase
+				moveSongIndexForeward(rs, init, false);
 			}
 			else {// odd so reverse phase
-				moveSongIndexBackward(false, false);
+				moveSongIndexBackward(rs, false, false);
 			}
 		break;
 
 		case MODE_PEN :// forward-reverse; history base is 0x4000
-			if (phraseIndexRunHistory < 0x4001 || phraseIndexRunHistory > 0x4002) // even means going forward, odd means going reverse
-				phraseIndexRunHistory = 0x4002;
-			if (phraseIndexRunHistory == 0x4002) {// even so forward phase	
-				moveSongIndexForeward(init, false);
-				if (phraseIndexRunHistory == 0x4001)
-					moveSongIndexBackward(false, false);
+			if (rs.phraseIndexRunHistory < 0x4001 || rs.phraseIndexRunHistory > 0x4002) // even means going forward, odd means going reverse
+				rs.phraseIndexRunHistory = 0x4002;
+			if (rs.phraseIndexRunHistory == 0x4002) {// even so forward phase	
+				moveSongIndexForeward(rs, init, false);
+				if (rs.phraseIndexRunHistory == 0x4001)
+					moveSongIndexBackward(rs, false, false);
 			}
 			else {// odd so reverse phase
-				moveSongIndexBackward(false, false);
-				if (phraseIndexRunHistory == 0x4000)
-					moveSongIndexForeward(false, false);
+				moveSongIndexBackward(rs, false, false);
+				if (rs.phraseIndexRunHistory == 0x4000)
+					moveSongIndexForeward(rs, false, false);
 			}			
 		break;
 		
 		case MODE_BRN :// brownian random; history base is 0x5000
-			phraseIndexRunHistory = 0x5000;
-			moveSongIndexBrownian(init, randomu32());
+			rs.phraseIndexRunHistory = 0x5000;
+			moveSongIndexBrownian(rs, init, rs.rng.u32());
 		break;
 		
 		case MODE_RND :// random; history base is 0x6000
-			phraseIndexRunHistory = 0x6000;
-			moveSongIndexRandom(init, randomu32());
+			rs.phraseIndexRunHistory = 0x6000;
+			moveSongIndexRandom(rs, init, rs.rng.u32());
 		break;
 		
-		case MODE_TKA:// use track A's phraseIndexRun; base is 0x7000
-			if (masterKernel != nullptr) {
-				phraseIndexRunHistory = 0x7000;
-				phraseIndexRun = masterKernel->getPhraseIndexRun();
+		case MODE_TKA:// use track A's rs.phraseIndexRun; base is 0x7000
+			if (master != nullptr) {
+				rs.phraseIndexRunHistory = 0x7000;
+				rs.phraseIndexRun = master->phraseIndexRun;
 				break;
 			}
 			[[fallthrough]];
 		default :// MODE_FWD  forward; history base is 0x1000
-			phraseIndexRunHistory = 0x1000;
-			moveSongIndexForeward(init, true);
+			rs.phraseIndexRunHistory = 0x1000;
+			moveSongIndexForeward(rs, init, true);
 	}
 }
 
 
  
-void SeqCPbuffer::reset() {		
-	for (int stepn = 0; stepn < SequencerKernel::MAX_STEPS; stepn++) {
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::SeqCPbuffer::reset() {		
+	for (int stepn = 0; stepn < MAX_STEPS; stepn++) {
 		cvCPbuffer[stepn] = 0.0f;
 		attribCPbuffer[stepn].init();
 	}
-	seqAttribCPbuffer.init(SequencerKernel::MAX_STEPS, SequencerKernel::MODE_FWD);
-	storedLength = SequencerKernel::MAX_STEPS;// number of steps that contain actual cp data
+	seqAttribCPbuffer.init(MAX_STEPS, MODE_FWD);
+	storedLength = MAX_STEPS;// number of steps that contain actual cp data
 }
 
-void SongCPbuffer::reset() {
-	for (int phrn = 0; phrn < SequencerKernel::MAX_PHRASES; phrn++)
+template <int STEPS, int SEQS, int PHRASES>
+void BasicSequencerKernel<STEPS, SEQS, PHRASES>::SongCPbuffer::reset() {
+	for (int phrn = 0; phrn < MAX_PHRASES; phrn++)
 		phraseCPbuffer[phrn].init();
 	beginIndex = 0;
 	endIndex = 0;
-	runModeSong = SequencerKernel::MODE_FWD;
-	storedLength = SequencerKernel::MAX_PHRASES;
+	runModeSong = MODE_FWD;
+	storedLength = MAX_PHRASES;
+}
+
+
+//*****************************************************************************
+// UndoJournal
+//*****************************************************************************
+
+
+template <class KERNEL, int TRACKS>
+void UndoJournal<KERNEL, TRACKS>::beginEdit(KERNEL *sek, int seqn) {// an edit can only change seqn and the song of each track
+	editSeqn = seqn;
+	for (int trkn = 0; trkn < TRACKS; trkn++) {
+		for (int stepn = 0; stepn < KERNEL::MAX_STEPS; stepn++)
+			seqSteps[trkn][stepn] = sek[trkn].getStepData(seqn, stepn);
+		seqAttribs[trkn] = sek[trkn].getSeqAttrib(seqn);
+		for (int phrn = 0; phrn < KERNEL::MAX_PHRASES; phrn++)
+			phrases[trkn][phrn] = phraseValue(sek[trkn], phrn);
+		for (int setn = 0; setn < KERNEL::NUM_SETTINGS; setn++)
+			settings[trkn][setn] = sek[trkn].getSetting(setn);
+	}
+}
+
+
+template <class KERNEL, int TRACKS>
+void UndoJournal<KERNEL, TRACKS>::endEdit(KERNEL *sek) {// an edit that changed nothing is not recorded
+	bool first = true;
+	editOverflow = false;
+	for (int trkn = 0; trkn < TRACKS; trkn++) {
+		for (int stepn = 0; stepn < KERNEL::MAX_STEPS; stepn++) {
+			StepData stepData = sek[trkn].getStepData(editSeqn, stepn);
+			int index = editSeqn * KERNEL::MAX_STEPS + stepn;
+			record(DELTA_CV, trkn, index, cvBits(seqSteps[trkn][stepn].cv), cvBits(stepData.cv), &first);
+			record(DELTA_ATTRIB, trkn, index, seqSteps[trkn][stepn].attributes.getAttribute(), stepData.attributes.getAttribute(), &first);
+		}
+		record(DELTA_SEQ, trkn, editSeqn, seqAttribs[trkn], sek[trkn].getSeqAttrib(editSeqn), &first);
+		for (int phrn = 0; phrn < KERNEL::MAX_PHRASES; phrn++)
+			record(DELTA_PHRASE, trkn, phrn, phrases[trkn][phrn], phraseValue(sek[trkn], phrn), &first);
+		for (int setn = 0; setn < KERNEL::NUM_SETTINGS; setn++)
+			record(DELTA_SETTING, trkn, setn, (uint32_t)settings[trkn][setn], (uint32_t)sek[trkn].getSetting(setn), &first);
+	}
+	if (editOverflow)// can't be undone, and the edits before it can't be undone either since they are overwritten
+		clear();
+}
+
+
+template <class KERNEL, int TRACKS>
+void UndoJournal<KERNEL, TRACKS>::record(int kind, int trkn, int index, uint32_t oldValue, uint32_t newValue, bool *first) {
+	if (oldValue == newValue || editOverflow)
+		return;
+	if (*first) {// a new edit drops the edits that could be redone
+		head = cursor;
+		editStart = head;
+		kind |= DELTA_FIRST;
+		*first = false;
+	}
+	if (head - editStart == JOURNAL_SIZE) {
+		editOverflow = true;
+		return;
+	}
+	if (head - tail == JOURNAL_SIZE) {// drop the oldest edit
+		do {
+			tail++;
+		} while (tail != head && (deltas[tail % JOURNAL_SIZE].kind & DELTA_FIRST) == 0);
+	}
+	Delta &delta = deltas[head % JOURNAL_SIZE];
+	delta.kind = (uint8_t)kind;
+	delta.trkn = (uint8_t)trkn;
+	delta.index = (uint16_t)index;
+	delta.oldValue = oldValue;
+	delta.newValue = newValue;
+	head++;
+	cursor = head;
+}
+
+
+template <class KERNEL, int TRACKS>
+bool UndoJournal<KERNEL, TRACKS>::undo(KERNEL *sek) {// deltas are undone in reverse order
+	if (cursor == tail)
+		return false;
+	do {
+		cursor--;
+		apply(sek, deltas[cursor % JOURNAL_SIZE], true);
+	} while ((deltas[cursor % JOURNAL_SIZE].kind & DELTA_FIRST) == 0);
+	return true;
+}
+
+
+template <class KERNEL, int TRACKS>
+bool UndoJournal<KERNEL, TRACKS>::redo(KERNEL *sek) {
+	if (cursor == head)
+		return false;
+	do {
+		apply(sek, deltas[cursor % JOURNAL_SIZE], false);
+		cursor++;
+	} while (cursor != head && (deltas[cursor % JOURNAL_SIZE].kind & DELTA_FIRST) == 0);
+	return true;
+}
+
+
+template <class KERNEL, int TRACKS>
+void UndoJournal<KERNEL, TRACKS>::apply(KERNEL *sek, const Delta &delta, bool undo) {
+	KERNEL &k = sek[delta.trkn];
+	uint32_t value = (undo ? delta.oldValue : delta.newValue);
+	int seqn = delta.index / KERNEL::MAX_STEPS;
+	int stepn = delta.index % KERNEL::MAX_STEPS;
+	StepData stepData;
+	switch (delta.kind & ~DELTA_FIRST) {
+		case DELTA_CV :
+			stepData = k.getStepData(seqn, stepn);
+			memcpy(&stepData.cv, &value, sizeof(value));
+			k.setStepData(seqn, stepn, stepData);
+		break;
+		case DELTA_ATTRIB :
+			stepData = k.getStepData(seqn, stepn);
+			stepData.attributes.setAttribute(value);
+			k.setStepData(seqn, stepn, stepData);
+		break;
+		case DELTA_SEQ :
+			k.setSeqAttrib(delta.index, value);
+		break;
+		case DELTA_PHRASE :
+			k.setPhraseSeqNum(delta.index, (int)(value & 0xFF));
+			k.setPhraseReps(delta.index, (int)(value >> 8));
+		break;
+		default :// DELTA_SETTING
+			k.setSetting(delta.index, (int)value);
+	}
 }
 
 
@@ -850,15 +1303,19 @@ void SongCPbuffer::reset() {
 //*****************************************************************************
 
 
-void Sequencer::construct(bool* _holdTiedNotesPtr, int* _velocityModePtr) {// don't want regaular constructor mechanism
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::construct(bool* _holdTiedNotesPtr, int* _velocityModePtr, int* _slideShapePtr) {// don't want regaular constructor mechanism
 	velocityModePtr = _velocityModePtr;
-	sek[0].construct(0, nullptr, _holdTiedNotesPtr);
+	sek[0].construct(0, nullptr, _holdTiedNotesPtr, _slideShapePtr);
 	for (int trkn = 1; trkn < NUM_TRACKS; trkn++)
-		sek[trkn].construct(trkn, &sek[0], _holdTiedNotesPtr);
+		sek[trkn].construct(trkn, &sek[0], _holdTiedNotesPtr, _slideShapePtr);
+	undoJournal.clear();
 }
 
 
-void Sequencer::setVelocityVal(int trkn, int intVel, int multiStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::setVelocityVal(int trkn, int intVel, int multiStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trkn].setVelocityVal(seqIndexEdit, stepIndexEdit, intVel, multiStepsCount);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -866,8 +1323,11 @@ void Sequencer::setVelocityVal(int trkn, int intVel, int multiStepsCount, bool m
 			sek[i].setVelocityVal(seqIndexEdit, stepIndexEdit, intVel, multiStepsCount);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
-void Sequencer::setLength(int length, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::setLength(int length, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setLength(seqIndexEdit, length);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -875,8 +1335,11 @@ void Sequencer::setLength(int length, bool multiTracks) {
 			sek[i].setLength(seqIndexEdit, length);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
-void Sequencer::setBegin(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::setBegin(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setBegin(phraseIndexEdit);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -884,8 +1347,11 @@ void Sequencer::setBegin(bool multiTracks) {
 			sek[i].setBegin(phraseIndexEdit);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
-void Sequencer::setEnd(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::setEnd(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setEnd(phraseIndexEdit);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -893,11 +1359,14 @@ void Sequencer::setEnd(bool multiTracks) {
 			sek[i].setEnd(phraseIndexEdit);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
-bool Sequencer::setGateType(int keyn, int multiSteps, bool autostepClick, bool multiTracks) {// Third param is for right-click autostep. Returns success
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+bool BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::setGateType(int keyn, int multiSteps, bool autostepClick, bool multiTracks) {// Third param is for right-click autostep. Returns success
 	int newMode = keyIndexToGateTypeEx(keyn);
 	if (newMode == -1) 
 		return false;
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setGateType(seqIndexEdit, stepIndexEdit, newMode, multiSteps);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -907,11 +1376,14 @@ bool Sequencer::setGateType(int keyn, int multiSteps, bool autostepClick, bool m
 	}
 	if (autostepClick) // if right-click then move to next step
 		moveStepIndexEdit(1);
+	undoJournal.endEdit(sek);
 	return true;
 }
 
 
-void Sequencer::initSlideVal(int multiStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initSlideVal(int multiStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setSlideVal(seqIndexEdit, stepIndexEdit, StepAttributes::INIT_SLIDE, multiStepsCount);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -919,8 +1391,11 @@ void Sequencer::initSlideVal(int multiStepsCount, bool multiTracks) {
 			sek[i].setSlideVal(seqIndexEdit, stepIndexEdit, StepAttributes::INIT_SLIDE, multiStepsCount);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initGatePVal(int multiStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initGatePVal(int multiStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setGatePVal(seqIndexEdit, stepIndexEdit, StepAttributes::INIT_PROB, multiStepsCount);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -928,8 +1403,11 @@ void Sequencer::initGatePVal(int multiStepsCount, bool multiTracks) {
 			sek[i].setGatePVal(seqIndexEdit, stepIndexEdit, StepAttributes::INIT_PROB, multiStepsCount);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initVelocityVal(int multiStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initVelocityVal(int multiStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setVelocityVal(seqIndexEdit, stepIndexEdit, StepAttributes::INIT_VELOCITY, multiStepsCount);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -937,8 +1415,11 @@ void Sequencer::initVelocityVal(int multiStepsCount, bool multiTracks) {
 			sek[i].setVelocityVal(seqIndexEdit, stepIndexEdit, StepAttributes::INIT_VELOCITY, multiStepsCount);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initPulsesPerStep(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initPulsesPerStep(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].initPulsesPerStep();
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -946,8 +1427,11 @@ void Sequencer::initPulsesPerStep(bool multiTracks) {
 			sek[i].initPulsesPerStep();
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initDelay(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initDelay(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].initDelay();
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -955,35 +1439,47 @@ void Sequencer::initDelay(bool multiTracks) {
 			sek[i].initDelay();
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initRunModeSong(bool multiTracks) {
-	sek[trackIndexEdit].setRunModeSong(SequencerKernel::MODE_FWD);
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initRunModeSong(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
+	sek[trackIndexEdit].setRunModeSong(Kernel::MODE_FWD);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
 			if (i == trackIndexEdit) continue;
-			sek[i].setRunModeSong(SequencerKernel::MODE_FWD);
+			sek[i].setRunModeSong(Kernel::MODE_FWD);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initRunModeSeq(bool multiTracks) {
-	sek[trackIndexEdit].setRunModeSeq(seqIndexEdit, SequencerKernel::MODE_FWD);
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initRunModeSeq(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
+	sek[trackIndexEdit].setRunModeSeq(seqIndexEdit, Kernel::MODE_FWD);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
 			if (i == trackIndexEdit) continue;
-			sek[i].setRunModeSeq(seqIndexEdit, SequencerKernel::MODE_FWD);
+			sek[i].setRunModeSeq(seqIndexEdit, Kernel::MODE_FWD);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initLength(bool multiTracks) {
-	sek[trackIndexEdit].setLength(seqIndexEdit, SequencerKernel::MAX_STEPS);
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initLength(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
+	sek[trackIndexEdit].setLength(seqIndexEdit, Kernel::MAX_STEPS);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
 			if (i == trackIndexEdit) continue;
-			sek[i].setLength(seqIndexEdit, SequencerKernel::MAX_STEPS);
+			sek[i].setLength(seqIndexEdit, Kernel::MAX_STEPS);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initPhraseReps(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initPhraseReps(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setPhraseReps(phraseIndexEdit, 1);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -991,8 +1487,11 @@ void Sequencer::initPhraseReps(bool multiTracks) {
 			sek[i].setPhraseReps(phraseIndexEdit, 1);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::initPhraseSeqNum(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::initPhraseSeqNum(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].setPhraseSeqNum(phraseIndexEdit, 0);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1000,14 +1499,18 @@ void Sequencer::initPhraseSeqNum(bool multiTracks) {
 			sek[i].setPhraseSeqNum(phraseIndexEdit, 0);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
 
-void Sequencer::copySequence(int countCP) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::copySequence(int countCP) {
 	int startCP = stepIndexEdit;
 	sek[trackIndexEdit].copySequence(&seqCPbuf, seqIndexEdit, startCP, countCP);
 }
-void Sequencer::pasteSequence(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::pasteSequence(bool multiTracks) {
 	int startCP = stepIndexEdit;
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].pasteSequence(&seqCPbuf, seqIndexEdit, startCP);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1015,11 +1518,15 @@ void Sequencer::pasteSequence(bool multiTracks) {
 			sek[i].pasteSequence(&seqCPbuf, seqIndexEdit, startCP);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
-void Sequencer::copySong(int countCP) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::copySong(int countCP) {
 	sek[trackIndexEdit].copySong(&songCPbuf, phraseIndexEdit, countCP);
 }
-void Sequencer::pasteSong(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::pasteSong(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].pasteSong(&songCPbuf, phraseIndexEdit);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1027,31 +1534,38 @@ void Sequencer::pasteSong(bool multiTracks) {
 			sek[i].pasteSong(&songCPbuf, phraseIndexEdit);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
 
 
-void Sequencer::writeCV(int trkn, float cvVal, int multiStepsCount, float sampleRate, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::writeCV(int trkn, float cvVal, int multiStepsCount, float sampleRate, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trkn].writeCV(seqIndexEdit, stepIndexEdit, cvVal, multiStepsCount);
 	editingGateCV[trkn] = cvVal;
-	editingGate[trkn] = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+	editingGate[trkn] = (unsigned long) (gateTime * sampleRate / calcDisplayRefreshStepSkips(sampleRate));
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
 			if (i == trkn) continue;
 			sek[i].writeCV(seqIndexEdit, stepIndexEdit, cvVal, multiStepsCount);
 		}
 	}
+	undoJournal.endEdit(sek);
 }
-void Sequencer::autostep(bool autoseq) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::autostep(bool autoseq) {
 	moveStepIndexEdit(1);
 	if (stepIndexEdit == 0 && autoseq)
-		seqIndexEdit = moveIndex(seqIndexEdit, seqIndexEdit + 1, SequencerKernel::MAX_SEQS);	
+		seqIndexEdit = moveIndex(seqIndexEdit, seqIndexEdit + 1, Kernel::MAX_SEQS);	
 }	
 
-bool Sequencer::applyNewOctave(int octn, int multiSteps, float sampleRate, bool multiTracks) { // returns true if tied
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+bool BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::applyNewOctave(int octn, int multiSteps, float sampleRate, bool multiTracks) { // returns true if tied
 	if (sek[trackIndexEdit].getTied(seqIndexEdit, stepIndexEdit))
 		return true;
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	editingGateCV[trackIndexEdit] = sek[trackIndexEdit].applyNewOctave(seqIndexEdit, stepIndexEdit, octn, multiSteps);
-	editingGate[trackIndexEdit] = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+	editingGate[trackIndexEdit] = (unsigned long) (gateTime * sampleRate / calcDisplayRefreshStepSkips(sampleRate));
 	editingGateKeyLight = -1;
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1059,10 +1573,13 @@ bool Sequencer::applyNewOctave(int octn, int multiSteps, float sampleRate, bool
 			sek[i].applyNewOctave(seqIndexEdit, stepIndexEdit, octn, multiSteps);
 		}
 	}
+	undoJournal.endEdit(sek);
 	return false;
 }
-bool Sequencer::applyNewKey(int keyn, int multiSteps, float sampleRate, bool autostepClick, bool multiTracks) { // returns true if tied
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+bool BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::applyNewKey(int keyn, int multiSteps, float sampleRate, bool autostepClick, bool multiTracks) { // returns true if tied
 	bool ret = false;
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	if (sek[trackIndexEdit].getTied(seqIndexEdit, stepIndexEdit)) {
 		if (autostepClick)
 			moveStepIndexEdit(1);
@@ -1071,7 +1588,7 @@ bool Sequencer::applyNewKey(int keyn, int multiSteps, float sampleRate, bool aut
 	}
 	else {
 		editingGateCV[trackIndexEdit] = sek[trackIndexEdit].applyNewKey(seqIndexEdit, stepIndexEdit, keyn, multiSteps);
-		editingGate[trackIndexEdit] = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+		editingGate[trackIndexEdit] = (unsigned long) (gateTime * sampleRate / calcDisplayRefreshStepSkips(sampleRate));
 		editingGateKeyLight = -1;
 		if (multiTracks) {
 			for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1084,15 +1601,17 @@ bool Sequencer::applyNewKey(int keyn, int multiSteps, float sampleRate, bool aut
 			editingGateKeyLight = keyn;
 		}
 	}
+	undoJournal.endEdit(sek);
 	return ret;
 }
 
-void Sequencer::moveStepIndexEditWithEditingGate(int delta, bool writeTrig, float sampleRate) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::moveStepIndexEditWithEditingGate(int delta, bool writeTrig, float sampleRate) {
 	moveStepIndexEdit(delta);
 	for (int trkn = 0; trkn < NUM_TRACKS; trkn++) {
 		if (!sek[trkn].getTied(seqIndexEdit, stepIndexEdit)) {// play if non-tied step
 			if (!writeTrig) {// in case autostep when simultaneous writeCV and stepCV (keep what was done in Write Input block above)
-				editingGate[trkn] = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+				editingGate[trkn] = (unsigned long) (gateTime * sampleRate / calcDisplayRefreshStepSkips(sampleRate));
 				editingGateCV[trkn] = sek[trkn].getCV(seqIndexEdit, stepIndexEdit);
 				editingGateKeyLight = -1;
 			}
@@ -1102,7 +1621,9 @@ void Sequencer::moveStepIndexEditWithEditingGate(int delta, bool writeTrig, floa
 
 
 
-void Sequencer::modSlideVal(int deltaVelKnob, int mutliStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modSlideVal(int deltaVelKnob, int mutliStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int sVal = sek[trackIndexEdit].modSlideVal(seqIndexEdit, stepIndexEdit, deltaVelKnob, mutliStepsCount);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1110,8 +1631,11 @@ void Sequencer::modSlideVal(int deltaVelKnob, int mutliStepsCount, bool multiTra
 			sek[i].setSlideVal(seqIndexEdit, stepIndexEdit, sVal, mutliStepsCount);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modGatePVal(int deltaVelKnob, int mutliStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modGatePVal(int deltaVelKnob, int mutliStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int gpVal = sek[trackIndexEdit].modGatePVal(seqIndexEdit, stepIndexEdit, deltaVelKnob, mutliStepsCount);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1119,8 +1643,11 @@ void Sequencer::modGatePVal(int deltaVelKnob, int mutliStepsCount, bool multiTra
 			sek[i].setGatePVal(seqIndexEdit, stepIndexEdit, gpVal, mutliStepsCount);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modVelocityVal(int deltaVelKnob, int mutliStepsCount, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modVelocityVal(int deltaVelKnob, int mutliStepsCount, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int upperLimit = ((*velocityModePtr) == 0 ? 200 : 127);
 	int vVal = sek[trackIndexEdit].modVelocityVal(seqIndexEdit, stepIndexEdit, deltaVelKnob, upperLimit, mutliStepsCount);
 	if (multiTracks) {
@@ -1129,8 +1656,11 @@ void Sequencer::modVelocityVal(int deltaVelKnob, int mutliStepsCount, bool multi
 			sek[i].setVelocityVal(seqIndexEdit, stepIndexEdit, vVal, mutliStepsCount);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modRunModeSong(int deltaPhrKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modRunModeSong(int deltaPhrKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newRunMode = sek[trackIndexEdit].modRunModeSong(deltaPhrKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1138,8 +1668,11 @@ void Sequencer::modRunModeSong(int deltaPhrKnob, bool multiTracks) {
 			sek[i].setRunModeSong(newRunMode);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modPulsesPerStep(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modPulsesPerStep(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newPPS = sek[trackIndexEdit].modPulsesPerStep(deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1147,8 +1680,11 @@ void Sequencer::modPulsesPerStep(int deltaSeqKnob, bool multiTracks) {
 			sek[i].setPulsesPerStep(newPPS);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modDelay(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modDelay(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newDelay = sek[trackIndexEdit].modDelay(deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1156,8 +1692,11 @@ void Sequencer::modDelay(int deltaSeqKnob, bool multiTracks) {
 			sek[i].setDelay(newDelay);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modRunModeSeq(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modRunModeSeq(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newRunMode = sek[trackIndexEdit].modRunModeSeq(seqIndexEdit, deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1165,8 +1704,11 @@ void Sequencer::modRunModeSeq(int deltaSeqKnob, bool multiTracks) {
 			sek[i].setRunModeSeq(seqIndexEdit, newRunMode);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modLength(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modLength(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newLength = sek[trackIndexEdit].modLength(seqIndexEdit, deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1174,8 +1716,11 @@ void Sequencer::modLength(int deltaSeqKnob, bool multiTracks) {
 			sek[i].setLength(seqIndexEdit, newLength);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modPhraseReps(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modPhraseReps(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newReps = sek[trackIndexEdit].modPhraseReps(phraseIndexEdit, deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1183,8 +1728,11 @@ void Sequencer::modPhraseReps(int deltaSeqKnob, bool multiTracks) {
 			sek[i].setPhraseReps(phraseIndexEdit, newReps);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::modPhraseSeqNum(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::modPhraseSeqNum(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	int newSeqn = sek[trackIndexEdit].modPhraseSeqNum(phraseIndexEdit, deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1192,8 +1740,11 @@ void Sequencer::modPhraseSeqNum(int deltaSeqKnob, bool multiTracks) {
 			sek[i].setPhraseSeqNum(phraseIndexEdit, newSeqn);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::transposeSeq(int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::transposeSeq(int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].transposeSeq(seqIndexEdit, deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1201,8 +1752,11 @@ void Sequencer::transposeSeq(int deltaSeqKnob, bool multiTracks) {
 			sek[i].transposeSeq(seqIndexEdit, deltaSeqKnob);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::unTransposeSeq(bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::unTransposeSeq(bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].unTransposeSeq(seqIndexEdit);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1210,8 +1764,11 @@ void Sequencer::unTransposeSeq(bool multiTracks) {
 			sek[i].unTransposeSeq(seqIndexEdit);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-void Sequencer::rotateSeq(int *rotateOffsetPtr, int deltaSeqKnob, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::rotateSeq(int *rotateOffsetPtr, int deltaSeqKnob, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	sek[trackIndexEdit].rotateSeq(rotateOffsetPtr, seqIndexEdit, deltaSeqKnob);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1220,9 +1777,12 @@ void Sequencer::rotateSeq(int *rotateOffsetPtr, int deltaSeqKnob, bool multiTrac
 			sek[i].rotateSeq(&rotateOffset, seqIndexEdit, deltaSeqKnob);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
 
-void Sequencer::toggleGate(int multiSteps, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::toggleGate(int multiSteps, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	bool newGate = sek[trackIndexEdit].toggleGate(seqIndexEdit, stepIndexEdit, multiSteps);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1230,10 +1790,13 @@ void Sequencer::toggleGate(int multiSteps, bool multiTracks) {
 			sek[i].setGate(seqIndexEdit, stepIndexEdit, newGate, multiSteps);
 		}
 	}		
+	undoJournal.endEdit(sek);
 }
-bool Sequencer::toggleGateP(int multiSteps, bool multiTracks) { // returns true if tied
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+bool BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::toggleGateP(int multiSteps, bool multiTracks) { // returns true if tied
 	if (sek[trackIndexEdit].getTied(seqIndexEdit,stepIndexEdit))
 		return true;
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	bool newGateP = sek[trackIndexEdit].toggleGateP(seqIndexEdit, stepIndexEdit, multiSteps);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1241,11 +1804,14 @@ bool Sequencer::toggleGateP(int multiSteps, bool multiTracks) { // returns true
 			sek[i].setGateP(seqIndexEdit, stepIndexEdit, newGateP, multiSteps);
 		}
 	}				
+	undoJournal.endEdit(sek);
 	return false;
 }
-bool Sequencer::toggleSlide(int multiSteps, bool multiTracks) { // returns true if tied
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+bool BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::toggleSlide(int multiSteps, bool multiTracks) { // returns true if tied
 	if (sek[trackIndexEdit].getTied(seqIndexEdit,stepIndexEdit))
 		return true;
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	bool newSlide = sek[trackIndexEdit].toggleSlide(seqIndexEdit, stepIndexEdit, multiSteps);
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1253,9 +1819,12 @@ bool Sequencer::toggleSlide(int multiSteps, bool multiTracks) { // returns true
 			sek[i].setSlide(seqIndexEdit, stepIndexEdit, newSlide, multiSteps);
 		}
 	}				
+	undoJournal.endEdit(sek);
 	return false;
 }
-void Sequencer::toggleTied(int multiSteps, bool multiTracks) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::toggleTied(int multiSteps, bool multiTracks) {
+	undoJournal.beginEdit(sek, seqIndexEdit);
 	bool newTied = sek[trackIndexEdit].toggleTied(seqIndexEdit, stepIndexEdit, multiSteps);// will clear other attribs if new state is on
 	if (multiTracks) {
 		for (int i = 0; i < NUM_TRACKS; i++) {
@@ -1263,11 +1832,13 @@ void Sequencer::toggleTied(int multiSteps, bool multiTracks) {
 			sek[i].setTied(seqIndexEdit, stepIndexEdit, newTied, multiSteps);
 		}
 	}						
+	undoJournal.endEdit(sek);
 }
 
 
 
-void Sequencer::reset() {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::reset() {
 	stepIndexEdit = 0;
 	phraseIndexEdit = 0;
 	seqIndexEdit = 0;
@@ -1279,9 +1850,11 @@ void Sequencer::reset() {
 		editingGate[trkn] = 0ul;
 		sek[trkn].reset();
 	}
+	undoJournal.clear();
 }
 
-void Sequencer::toJson(json_t *rootJ) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::toJson(json_t *rootJ) {
 	// stepIndexEdit
 	json_object_set_new(rootJ, "stepIndexEdit", json_integer(stepIndexEdit));
 
@@ -1298,7 +1871,8 @@ void Sequencer::toJson(json_t *rootJ) {
 		sek[trkn].toJson(rootJ);
 }
 
-void Sequencer::fromJson(json_t *rootJ) {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+void BasicSequencer<TRACKS, STEPS, SEQS, PHRASES>::fromJson(json_t *rootJ) {
 	// stepIndexEdit
 	json_t *stepIndexEditJ = json_object_get(rootJ, "stepIndexEdit");
 	if (stepIndexEditJ)
@@ -1321,6 +1895,15 @@ void Sequencer::fromJson(json_t *rootJ) {
 	
 	for (int trkn = 0; trkn < NUM_TRACKS; trkn++)
 		sek[trkn].fromJson(rootJ);
+	undoJournal.clear();
 }
 
 
+template class BasicSequencerKernel<32, 64, 99>;
+template class UndoJournal<BasicSequencerKernel<32, 64, 99>, 4>;
+template class BasicSequencer<4, 32, 64, 99>;// Sequencer
+template class BasicSequencerKernel<64, 64, 99>;
+template class UndoJournal<BasicSequencerKernel<64, 64, 99>, 4>;
+template class BasicSequencer<4, 64, 64, 99>;// Sequencer64Steps
+template class UndoJournal<BasicSequencerKernel<32, 64, 99>, 8>;
+template class BasicSequencer<8, 32, 64, 99>;// Sequencer8Tracks
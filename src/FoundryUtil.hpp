@@ -9,29 +9,29 @@ using namespace rack;
 
 
 class StepAttributes {
-	unsigned long attributes;
+	uint32_t attributes;
 	
 	public:
 
-	static const unsigned long ATT_MSK_GATE =      0x01000000, gateShift = 24;
-	static const unsigned long ATT_MSK_GATEP =     0x02000000;
-	static const unsigned long ATT_MSK_SLIDE =     0x04000000;
-	static const unsigned long ATT_MSK_TIED =      0x08000000;
-	static const unsigned long ATT_MSK_GATETYPE =  0xF0000000, gateTypeShift = 28;
-	static const unsigned long ATT_MSK_VELOCITY =  0x000000FF, velocityShift = 0;
-	static const unsigned long ATT_MSK_GATEP_VAL = 0x0000FF00, gatePValShift = 8;
-	static const unsigned long ATT_MSK_SLIDE_VAL = 0x00FF0000, slideValShift = 16;
+	static const uint32_t ATT_MSK_GATE =      0x01000000, gateShift = 24;
+	static const uint32_t ATT_MSK_GATEP =     0x02000000;
+	static const uint32_t ATT_MSK_SLIDE =     0x04000000;
+	static const uint32_t ATT_MSK_TIED =      0x08000000;
+	static const uint32_t ATT_MSK_GATETYPE =  0xF0000000, gateTypeShift = 28;
+	static const uint32_t ATT_MSK_VELOCITY =  0x000000FF, velocityShift = 0;
+	static const uint32_t ATT_MSK_GATEP_VAL = 0x0000FF00, gatePValShift = 8;
+	static const uint32_t ATT_MSK_SLIDE_VAL = 0x00FF0000, slideValShift = 16;
 
 	static const int INIT_VELOCITY = 100;
 	static const int MAX_VELOCITY = 200;
 	static const int INIT_PROB = 50;// range is 0 to 100
 	static const int INIT_SLIDE = 10;// range is 0 to 100
 	
-	static const unsigned long ATT_MSK_INITSTATE = ((ATT_MSK_GATE) | (INIT_VELOCITY << velocityShift) | (INIT_PROB << gatePValShift) | (INIT_SLIDE << slideValShift));
+	static const uint32_t ATT_MSK_INITSTATE = ((ATT_MSK_GATE) | (INIT_VELOCITY << velocityShift) | (INIT_PROB << gatePValShift) | (INIT_SLIDE << slideValShift));
 
-	inline void clear() {attributes = 0ul;}
+	inline void clear() {attributes = 0u;}
 	inline void init() {attributes = ATT_MSK_INITSTATE;}
-	inline void randomize() {attributes = ( (randomu32() & (ATT_MSK_GATE | ATT_MSK_GATEP | ATT_MSK_SLIDE | ATT_MSK_TIED)) | ((randomu32() % 101) << gatePValShift) | ((randomu32() % 101) << slideValShift) | (randomu32() % (MAX_VELOCITY + 1)) ) ;}
+	inline void randomize(RandomGenerator* rng) {attributes = ( (rng->u32() & (ATT_MSK_GATE | ATT_MSK_GATEP | ATT_MSK_SLIDE | ATT_MSK_TIED)) | ((rng->u32() % 101) << gatePValShift) | ((rng->u32() % 101) << slideValShift) | (rng->u32() % (MAX_VELOCITY + 1)) ) ;}
 	
 	inline bool getGate() {return (attributes & ATT_MSK_GATE) != 0;}
 	inline int getGateType() {return (int)((attributes & ATT_MSK_GATETYPE) >> gateTypeShift);}
@@ -41,10 +41,10 @@ class StepAttributes {
 	inline bool getSlide() {return (attributes & ATT_MSK_SLIDE) != 0;}
 	inline int getSlideVal() {return (int)((attributes & ATT_MSK_SLIDE_VAL) >> slideValShift);}
 	inline int getVelocityVal() {return (int)((attributes & ATT_MSK_VELOCITY) >> velocityShift);}
-	inline unsigned long getAttribute() {return attributes;}
+	inline uint32_t getAttribute() {return attributes;}
 
 	inline void setGate(bool gate1State) {attributes &= ~ATT_MSK_GATE; if (gate1State) attributes |= ATT_MSK_GATE;}
-	inline void setGateType(int gateType) {attributes &= ~ATT_MSK_GATETYPE; attributes |= (((unsigned long)gateType) << gateTypeShift);}
+	inline void setGateType(int gateType) {attributes &= ~ATT_MSK_GATETYPE; attributes |= (((uint32_t)gateType) << gateTypeShift);}
 	inline void setTied(bool tiedState) {
 		attributes &= ~ATT_MSK_TIED; 
 		if (tiedState) {
@@ -53,12 +53,20 @@ class StepAttributes {
 		}
 	}
 	inline void setGateP(bool GatePState) {attributes &= ~ATT_MSK_GATEP; if (GatePState) attributes |= ATT_MSK_GATEP;}
-	inline void setGatePVal(int gatePval) {attributes &= ~ATT_MSK_GATEP_VAL; attributes |= (((unsigned long)gatePval) << gatePValShift);}
+	inline void setGatePVal(int gatePval) {attributes &= ~ATT_MSK_GATEP_VAL; attributes |= (((uint32_t)gatePval) << gatePValShift);}
 	inline void setSlide(bool slideState) {attributes &= ~ATT_MSK_SLIDE; if (slideState) attributes |= ATT_MSK_SLIDE;}
-	inline void setSlideVal(int slideVal) {attributes &= ~ATT_MSK_SLIDE_VAL; attributes |= (((unsigned long)slideVal) << slideValShift);}
-	inline void setVelocityVal(int _velocity) {attributes &= ~ATT_MSK_VELOCITY; attributes |= (((unsigned long)_velocity) << velocityShift);}
-	inline void setAttribute(unsigned long _attributes) {attributes = _attributes;}
+	inline void setSlideVal(int slideVal) {attributes &= ~ATT_MSK_SLIDE_VAL; attributes |= (((uint32_t)slideVal) << slideValShift);}
+	inline void setVelocityVal(int _velocity) {attributes &= ~ATT_MSK_VELOCITY; attributes |= (((uint32_t)_velocity) << velocityShift);}
+	inline void setAttribute(uint32_t _attributes) {attributes = _attributes;}
 };// class StepAttributes
+static_assert(sizeof(StepAttributes) == 4, "StepAttributes must stay packed in 32 bits");
+
+
+struct StepData {
+	float cv;// [-3.0 : 3.917].
+	StepAttributes attributes;
+};// struct StepData
+static_assert(sizeof(StepData) == 8, "StepData must interleave cv and attributes without padding");
 
 
 //*****************************************************************************
@@ -66,41 +74,42 @@ class StepAttributes {
 
 class Phrase {
 	// a phrase is a sequence number and a number of repetitions; it is used to make a song
-	unsigned long phrase;
+	uint16_t phrase;
 	
 	public:
 
-	static const unsigned long PHR_MSK_SEQNUM = 0x00FF;
-	static const unsigned long PHR_MSK_REPS =   0xFF00, repShift = 8;// a rep is 0 to 99
+	static const uint16_t PHR_MSK_SEQNUM = 0x00FF;
+	static const uint16_t PHR_MSK_REPS =   0xFF00, repShift = 8;// a rep is 0 to 99
 	
 	inline void init() {phrase = (1 << repShift);}
-	inline void randomize(int maxSeqs) {phrase = ((randomu32() % maxSeqs) | ((randomu32() % 4 + 1) << repShift));}
+	inline void randomize(int maxSeqs, RandomGenerator* rng) {phrase = ((rng->u32() % maxSeqs) | ((rng->u32() % 4 + 1) << repShift));}
 	
 	inline int getSeqNum() {return (int)(phrase & PHR_MSK_SEQNUM);}
 	inline int getReps() {return (int)((phrase & PHR_MSK_REPS) >> repShift);}
-	inline unsigned long getPhraseJson() {return phrase - (1 << repShift);}// compression trick (store 0 instead of 1)
+	inline int32_t getPhraseJson() {return (int32_t)phrase - (1 << repShift);}// compression trick (store 0 instead of 1)
 	
-	inline void setSeqNum(int seqn) {phrase &= ~PHR_MSK_SEQNUM; phrase |= ((unsigned long)seqn);}
-	inline void setReps(int _reps) {phrase &= ~PHR_MSK_REPS; phrase |= (((unsigned long)_reps) << repShift);}
-	inline void setPhraseJson(unsigned long _phrase) {phrase = (_phrase + (1 << repShift));}// compression trick (store 0 instead of 1)
+	inline void setSeqNum(int seqn) {phrase &= ~PHR_MSK_SEQNUM; phrase |= ((uint16_t)seqn);}
+	inline void setReps(int _reps) {phrase &= ~PHR_MSK_REPS; phrase |= (((uint16_t)_reps) << repShift);}
+	inline void setPhraseJson(int32_t _phrase) {phrase = (uint16_t)(_phrase + (1 << repShift));}// compression trick (store 0 instead of 1)
 };// class Phrase
+static_assert(sizeof(Phrase) == 2, "Phrase must stay packed in 16 bits");
 
 
 //*****************************************************************************
 
 
 class SeqAttributes {
-	unsigned long attributes;
+	uint32_t attributes;
 	
 	public:
 
-	static const unsigned long SEQ_MSK_LENGTH  =   0x0000FF;// number of steps in each sequence, min value is 1
-	static const unsigned long SEQ_MSK_RUNMODE =   0x00FF00, runModeShift = 8;
-	static const unsigned long SEQ_MSK_TRANSPOSE = 0x7F0000, transposeShift = 16;
-	static const unsigned long SEQ_MSK_TRANSIGN  = 0x800000;// manually implement sign bit
+	static const uint32_t SEQ_MSK_LENGTH  =   0x0000FF;// number of steps in each sequence, min value is 1
+	static const uint32_t SEQ_MSK_RUNMODE =   0x00FF00, runModeShift = 8;
+	static const uint32_t SEQ_MSK_TRANSPOSE = 0x7F0000, transposeShift = 16;
+	static const uint32_t SEQ_MSK_TRANSIGN  = 0x800000;// manually implement sign bit
 	
-	inline void init(int length, int runMode) {attributes = ((length) | (((unsigned long)runMode) << runModeShift));}
-	inline void randomize(int maxSteps, int numModes) {attributes = ( (1 + (randomu32() % maxSteps)) | (((unsigned long)(randomu32() % numModes) << runModeShift)) );}
+	inline void init(int length, int runMode) {attributes = ((length) | (((uint32_t)runMode) << runModeShift));}
+	inline void randomize(int maxSteps, int numModes, RandomGenerator* rng) {attributes = ( (1 + (rng->u32() % maxSteps)) | (((uint32_t)(rng->u32() % numModes) << runModeShift)) );}
 	
 	inline int getLength() {return (int)(attributes & SEQ_MSK_LENGTH);}
 	inline int getRunMode() {return (int)((attributes & SEQ_MSK_RUNMODE) >> runModeShift);}
@@ -110,18 +119,19 @@ class SeqAttributes {
 			ret *= -1;
 		return ret;
 	}
-	inline unsigned long getSeqAttrib() {return attributes;}
+	inline uint32_t getSeqAttrib() {return attributes;}
 	
-	inline void setLength(int length) {attributes &= ~SEQ_MSK_LENGTH; attributes |= ((unsigned long)length);}
-	inline void setRunMode(int runMode) {attributes &= ~SEQ_MSK_RUNMODE; attributes |= (((unsigned long)runMode) << runModeShift);}
+	inline void setLength(int length) {attributes &= ~SEQ_MSK_LENGTH; attributes |= ((uint32_t)length);}
+	inline void setRunMode(int runMode) {attributes &= ~SEQ_MSK_RUNMODE; attributes |= (((uint32_t)runMode) << runModeShift);}
 	inline void setTranspose(int transp) {
 		attributes &= ~ (SEQ_MSK_TRANSPOSE | SEQ_MSK_TRANSIGN); 
-		attributes |= (((unsigned long)abs(transp)) << transposeShift);
+		attributes |= (((uint32_t)abs(transp)) << transposeShift);
 		if (transp < 0) 
 			attributes |= SEQ_MSK_TRANSIGN;
 	}
-	inline void setSeqAttrib(unsigned long _attributes) {attributes = _attributes;}
+	inline void setSeqAttrib(uint32_t _attributes) {attributes = _attributes;}
 };// class SeqAttributes
+static_assert(sizeof(SeqAttributes) == 4, "SeqAttributes must stay packed in 32 bits");
 
 
 //*****************************************************************************
@@ -129,31 +139,88 @@ class SeqAttributes {
 //*****************************************************************************
 
 
-struct SeqCPbuffer;
-struct SongCPbuffer;
+// Everything that moving the run indexes reads and writes, so that the predictor can advance a copy of it without touching the real one
+struct RunState {
+	int stepIndexRun;
+	unsigned long stepIndexRunHistory;
+	int phraseIndexRun;
+	unsigned long phraseIndexRunHistory;
+	RandomGenerator rng;// per track, saved with the track so that random run modes and gate probabilities can be reproduced
+	
+	RunState() {}
+	RunState(uint64_t seedValue) : rng(seedValue) {}// for scratch copies, so that they don't use up seeds of the global generator
+};// struct RunState
+
+struct PredictedStep {
+	int phrn;
+	int seqn;
+	int stepn;
+};// struct PredictedStep
+
+
+constexpr unsigned long calcStepHistorySpan(unsigned long span, unsigned long maxCount) {// smallest power of two span above maxCount
+	return (span > maxCount ? span : calcStepHistorySpan(span << 1, maxCount));
+}
 
-class SequencerKernel {
+
+template <int STEPS, int SEQS, int PHRASES>
+class BasicSequencerKernel {
 	public: 
 	
 	
 	// General constants
 	// ----------------
 
-	// Sequencer kernel dimensions
-	static const int MAX_STEPS = 32;// must be a power of two (some multi select loops have bitwise "& (MAX_STEPS - 1)")
-	static const int MAX_SEQS = 64;
-	static const int MAX_PHRASES = 99;// maximum value is 99 (index value is 0 to 98; disp will be 1 to 99)
+	// Sequencer kernel dimensions (see SequencerKernel typedef below for the one used in Foundry)
+	static const int MAX_STEPS = STEPS;// must be a power of two (some multi select loops have bitwise "& (MAX_STEPS - 1)")
+	static const int MAX_SEQS = SEQS;
+	static const int MAX_PHRASES = PHRASES;// maximum value is 99 (index value is 0 to 98; disp will be 1 to 99)
+	static_assert(MAX_STEPS >= 2 && (MAX_STEPS & (MAX_STEPS - 1)) == 0 && MAX_STEPS <= 128, "MAX_STEPS must be a power of two that fits SEQ_MSK_LENGTH");
+	static_assert(MAX_SEQS >= 1 && MAX_SEQS <= 256, "MAX_SEQS must fit PHR_MSK_SEQNUM");
+	static_assert(MAX_PHRASES >= 1 && MAX_PHRASES <= 99, "MAX_PHRASES must fit the two digit phrase display");
+	static const unsigned long STEP_HISTORY_SPAN = calcStepHistorySpan(0x1000, MAX_STEPS * 99);// range of stepIndexRunHistory for each run mode
 
 	// Run modes
 	enum RunModeIds {MODE_FWD, MODE_REV, MODE_PPG, MODE_PEN, MODE_BRN, MODE_RND, MODE_TKA, NUM_MODES};
 	static const std::string modeLabels[NUM_MODES];
 	
 	// Gate types
-	static const int NUM_GATES = 12;	
-	static const uint64_t advGateHitMaskLow[NUM_GATES];		
-	static const uint64_t advGateHitMaskHigh[NUM_GATES];
+	static const int NUM_GATES = NUM_ADV_GATES;
+	typedef AdvGateCodes<96, 49> GateCodes;// pulses per step 1, 2, 4, 6 ... 96, indexed with pulsesPerStep - 1
 
 	static constexpr float INIT_CV = 0.0f;
+	
+	
+	// Predictor
+	static const int PREDICT_SIZE = 32;// ring buffer size, max number of steps that can be looked ahead
+	
+	// Track settings that are not in the steps, sequences or phrases (see getSetting())
+	enum SettingIds {SET_RUNMODE_SONG, SET_BEGIN, SET_END, SET_PPS, SET_DELAY, NUM_SETTINGS};
+	
+	
+	// Copy-paste buffers
+	// ----------------
+
+	struct SeqCPbuffer {
+		float cvCPbuffer[MAX_STEPS];// copy paste buffer for CVs
+		StepAttributes attribCPbuffer[MAX_STEPS];
+		SeqAttributes seqAttribCPbuffer;
+		int storedLength;// number of steps that contain actual cp data
+		
+		SeqCPbuffer() {reset();}
+		void reset();
+	};// struct SeqCPbuffer
+
+	struct SongCPbuffer {
+		Phrase phraseCPbuffer[MAX_PHRASES];
+		int beginIndex;
+		int endIndex;
+		int runModeSong;
+		int storedLength;// number of steps that contain actual cp data
+		
+		SongCPbuffer() {reset();}
+		void reset();
+	};// song SeqCPbuffer
 
 
 	private:
@@ -172,28 +239,38 @@ class SequencerKernel {
 	int songEndIndex;
 	Phrase phrases[MAX_PHRASES];// This is the song (series of phases; a phrase is a sequence number and a repetition value)	
 	SeqAttributes sequences[MAX_SEQS];
-	float cv[MAX_SEQS][MAX_STEPS];// [-3.0 : 3.917].
-	StepAttributes attributes[MAX_SEQS][MAX_STEPS];
+	StepData steps[MAX_SEQS][MAX_STEPS];// cv and attributes of a step share a cache line when clocked
 	
 	// No need to save
-	int stepIndexRun;
-	unsigned long stepIndexRunHistory;
-	int phraseIndexRun;
-	unsigned long phraseIndexRunHistory;
+	RunState run;
 	int ppqnCount;
 	int ppqnLeftToSkip;// used in clock delay
 	int gateCode;// -1 = Killed for all pulses of step, 0 = Low for current pulse of step, 1 = High for current pulse of step, 2 = Clk high pulse, 3 = 1ms trig
-	unsigned long slideStepsRemain;// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta;// no need to initialize, this is only used when slideStepsRemain is not 0
-	SequencerKernel *masterKernel;// nullprt for track 0, used for grouped run modes (tracks B,C,D follow A when random, for example)
+	SlideGenerator slide;
+	BasicSequencerKernel *masterKernel;// nullprt for track 0, used for grouped run modes (tracks B,C,D follow A when random, for example)
 	bool* holdTiedNotesPtr;
+	int* slideShapePtr;
 	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
+	float clockFraction;// edge fraction of the last clock (see ClockTrigger), companion to clockPeriod
+	int clockSource;// track whose clock input clocks this track (see Foundry::calcClkInSources())
+	// Non 0-rep phrases, so that song run modes don't have to scan the phrases (see updatePlayablePhrases())
+	int nextPlayable[MAX_PHRASES + 1];// first non 0-rep phrase at or after index (MAX_PHRASES if none)
+	int prevPlayable[MAX_PHRASES + 1];// last non 0-rep phrase at or before index - 1 (-1 if none)
+	int playableRank[MAX_PHRASES + 1];// number of non 0-rep phrases before index
+	int playablePhrases[MAX_PHRASES];// the non 0-rep phrases in order
+	// Lookahead (see predictSteps()), filled lazily from a copy of run and emptied by invalidatePrediction() on any edit that can change the path
+	PredictedStep predicted[PREDICT_SIZE];// ring buffer, predicted[predictHead] is the step that the next clocked step should land on
+	int predictHead;
+	int predictCount;// 0 when invalidated
+	RunState predictState = RunState(0);// run state after the last predicted step
+	unsigned long predictVersion;// incremented on each invalidation, so that tracks following this one (TKA) know their own prediction is stale
+	unsigned long predictMasterVersion;// masterKernel's predictVersion when the prediction was started
 	
 	
 	public: 
 	
 	
-	void construct(int _id, SequencerKernel *_masterKernel, bool* _holdTiedNotesPtr); // don't want regaular constructor mechanism
+	void construct(int _id, BasicSequencerKernel *_masterKernel, bool* _holdTiedNotesPtr, int* _slideShapePtr); // don't want regaular constructor mechanism
 	
 	
 	inline int getRunModeSong() {return runModeSong;}
@@ -206,31 +283,43 @@ class SequencerKernel {
 	inline int getPulsesPerStep() {return (pulsesPerStep > 2 ? ((pulsesPerStep - 1) << 1) : pulsesPerStep);}
 	inline int getDelay() {return delay;}
 	inline int getTransposeOffset(int seqn) {return sequences[seqn].getTranspose();}
-	inline int getStepIndexRun() {return stepIndexRun;}
-	inline int getPhraseIndexRun() {return phraseIndexRun;}
-	inline float getCV(int seqn, int stepn) {return cv[seqn][stepn];}
-	inline float getCVRun() {return cv[phrases[phraseIndexRun].getSeqNum()][stepIndexRun];}
-	inline StepAttributes getAttribute(int seqn, int stepn) {return attributes[seqn][stepn];}
-	inline StepAttributes getAttributeRun() {return attributes[phrases[phraseIndexRun].getSeqNum()][stepIndexRun];}
-	inline bool getGate(int seqn, int stepn) {return attributes[seqn][stepn].getGate();}
-	inline bool getGateP(int seqn, int stepn) {return attributes[seqn][stepn].getGateP();}
-	inline bool getSlide(int seqn, int stepn) {return attributes[seqn][stepn].getSlide();}
-	inline bool getTied(int seqn, int stepn) {return attributes[seqn][stepn].getTied();}
-	inline int getGatePVal(int seqn, int stepn) {return attributes[seqn][stepn].getGatePVal();}
-	inline int getSlideVal(int seqn, int stepn) {return attributes[seqn][stepn].getSlideVal();}
-	inline int getVelocityVal(int seqn, int stepn) {return attributes[seqn][stepn].getVelocityVal();}
+	inline int getStepIndexRun() {return run.stepIndexRun;}
+	inline int getPhraseIndexRun() {return run.phraseIndexRun;}
+	inline float getCV(int seqn, int stepn) {return steps[seqn][stepn].cv;}
+	inline float getCVRun() {return steps[phrases[run.phraseIndexRun].getSeqNum()][run.stepIndexRun].cv;}
+	inline StepAttributes getAttribute(int seqn, int stepn) {return steps[seqn][stepn].attributes;}
+	inline StepAttributes getAttributeRun() {return steps[phrases[run.phraseIndexRun].getSeqNum()][run.stepIndexRun].attributes;}
+	inline bool getGate(int seqn, int stepn) {return steps[seqn][stepn].attributes.getGate();}
+	inline bool getGateP(int seqn, int stepn) {return steps[seqn][stepn].attributes.getGateP();}
+	inline bool getSlide(int seqn, int stepn) {return steps[seqn][stepn].attributes.getSlide();}
+	inline bool getTied(int seqn, int stepn) {return steps[seqn][stepn].attributes.getTied();}
+	inline int getGatePVal(int seqn, int stepn) {return steps[seqn][stepn].attributes.getGatePVal();}
+	inline int getSlideVal(int seqn, int stepn) {return steps[seqn][stepn].attributes.getSlideVal();}
+	inline int getVelocityVal(int seqn, int stepn) {return steps[seqn][stepn].attributes.getVelocityVal();}
 	inline int getVelocityValRun() {return getAttributeRun().getVelocityVal();}
-	inline int getGateType(int seqn, int stepn) {return attributes[seqn][stepn].getGateType();}	
-	
-	inline void setPulsesPerStep(int _pps) {pulsesPerStep = _pps;}
-	inline void setDelay(int _delay) {delay = _delay;}
-	inline void setLength(int seqn, int _length) {sequences[seqn].setLength(_length);}
-	inline void setPhraseReps(int phrn, int _reps) {phrases[phrn].setReps(_reps);}
-	inline void setPhraseSeqNum(int phrn, int _seqn) {phrases[phrn].setSeqNum(_seqn);}
-	inline void setBegin(int phrn) {songBeginIndex = phrn; songEndIndex = max(phrn, songEndIndex);}
-	inline void setEnd(int phrn) {songEndIndex = phrn; songBeginIndex = min(phrn, songBeginIndex);}
-	inline void setRunModeSong(int _runMode) {runModeSong = _runMode;}
-	inline void setRunModeSeq(int seqn, int _runMode) {sequences[seqn].setRunMode(_runMode);}
+	inline int getGateType(int seqn, int stepn) {return steps[seqn][stepn].attributes.getGateType();}	
+	
+	inline void setPulsesPerStep(int _pps) {pulsesPerStep = _pps; invalidatePrediction();}
+	inline void setDelay(int _delay) {delay = _delay; invalidatePrediction();}
+	inline void setClockSource(int _clockSource) {
+		if (clockSource != _clockSource) {
+			clockSource = _clockSource;
+			invalidatePrediction();
+		}
+	}
+	inline void setLength(int seqn, int _length) {sequences[seqn].setLength(_length); invalidatePrediction();}
+	inline void setPhraseReps(int phrn, int _reps) {
+		bool wasPlayable = (phrases[phrn].getReps() != 0);
+		phrases[phrn].setReps(_reps);
+		if (wasPlayable != (_reps != 0))
+			updatePlayablePhrases();
+		invalidatePrediction();
+	}
+	inline void setPhraseSeqNum(int phrn, int _seqn) {phrases[phrn].setSeqNum(_seqn); invalidatePrediction();}
+	inline void setBegin(int phrn) {songBeginIndex = phrn; songEndIndex = max(phrn, songEndIndex); invalidatePrediction();}
+	inline void setEnd(int phrn) {songEndIndex = phrn; songBeginIndex = min(phrn, songBeginIndex); invalidatePrediction();}
+	inline void setRunModeSong(int _runMode) {runModeSong = _runMode; invalidatePrediction();}
+	inline void setRunModeSeq(int seqn, int _runMode) {sequences[seqn].setRunMode(_runMode); invalidatePrediction();}
 	void setGate(int seqn, int stepn, bool newGate, int count);
 	void setGateP(int seqn, int stepn, bool newGateP, int count);
 	void setSlide(int seqn, int stepn, bool newSlide, int count);
@@ -243,40 +332,46 @@ class SequencerKernel {
 	
 	inline int modRunModeSong(int delta) {
 		runModeSong = clamp(runModeSong += delta, 0, NUM_MODES - 1);
+		invalidatePrediction();
 		return runModeSong;
 	}
 	inline int modRunModeSeq(int seqn, int delta) {
 		int rVal = sequences[seqn].getRunMode();
 		rVal = clamp(rVal + delta, 0, NUM_MODES - 1);
 		sequences[seqn].setRunMode(rVal);
+		invalidatePrediction();
 		return rVal;
 	}
 	inline int modLength(int seqn, int delta) {
 		int lVal = sequences[seqn].getLength();
 		lVal = clamp(lVal + delta, 1, MAX_STEPS);
 		sequences[seqn].setLength(lVal);
+		invalidatePrediction();
 		return lVal;
 	}
 	inline int modPhraseSeqNum(int phrn, int delta) {
 		int seqn = phrases[phrn].getSeqNum();
 		seqn = moveIndex(seqn, seqn + delta, MAX_SEQS);
 		phrases[phrn].setSeqNum(seqn);
+		invalidatePrediction();
 		return seqn;
 	}
 	inline int modPhraseReps(int phrn, int delta) {
 		int rVal = phrases[phrn].getReps();
 		rVal = clamp(rVal + delta, 0, 99);
-		phrases[phrn].setReps(rVal);
+		setPhraseReps(phrn, rVal);
 		return rVal;
 	}		
 	inline int modPulsesPerStep(int delta) {
 		pulsesPerStep += delta;
 		if (pulsesPerStep < 1) pulsesPerStep = 1;
 		if (pulsesPerStep > 49) pulsesPerStep = 49;
+		invalidatePrediction();
 		return pulsesPerStep;
 	}
 	inline int modDelay(int delta) {
 		delay = clamp(delay + delta, 0, 99);
+		invalidatePrediction();
 		return delay;
 	}
 	inline int modGatePVal(int seqn, int stepn, int delta, int count) {
@@ -297,24 +392,24 @@ class SequencerKernel {
 		setVelocityVal(seqn, stepn, vVal, count);
 		return vVal;
 	}		
-	inline void decSlideStepsRemain() {if (slideStepsRemain > 0ul) slideStepsRemain--;}	
+	inline void decSlideStepsRemain() {slide.advance();}	
 	inline bool toggleGate(int seqn, int stepn, int count) {
-		bool newGate = !attributes[seqn][stepn].getGate();
+		bool newGate = !steps[seqn][stepn].attributes.getGate();
 		setGate(seqn, stepn, newGate, count);
 		return newGate;
 	}
 	inline bool toggleGateP(int seqn, int stepn, int count) {
-		bool newGateP = !attributes[seqn][stepn].getGateP();
+		bool newGateP = !steps[seqn][stepn].attributes.getGateP();
 		setGateP(seqn, stepn, newGateP, count);
 		return newGateP;
 	}
 	inline bool toggleSlide(int seqn, int stepn, int count) {
-		bool newSlide = !attributes[seqn][stepn].getSlide();
+		bool newSlide = !steps[seqn][stepn].attributes.getSlide();
 		setSlide(seqn, stepn, newSlide, count);
 		return newSlide;
 	}	
 	inline bool toggleTied(int seqn, int stepn, int count) {
-		bool newTied = !attributes[seqn][stepn].getTied();
+		bool newTied = !steps[seqn][stepn].attributes.getTied();
 		setTied(seqn, stepn, newTied, count);
 		return newTied;
 	}	
@@ -323,7 +418,7 @@ class SequencerKernel {
 	void writeCV(int seqn, int stepn, float newCV, int count);
 	
 	
-	inline float calcSlideOffset() {return (slideStepsRemain > 0ul ? (slideCVdelta * (float)slideStepsRemain) : 0.0f);}
+	inline float calcSlideOffset() {return slide.getOffset();}
 	inline bool calcGate(SchmittTrigger clockTrigger, float sampleRate) {
 		if (ppqnLeftToSkip != 0)
 			return false;
@@ -331,11 +426,20 @@ class SequencerKernel {
 			return gateCode == 1;
 		if (gateCode == 2)
 			return clockTrigger.isHigh();
-		return clockPeriod < (unsigned long) (sampleRate * 0.01f);
+		return clockPeriod < calcTrigSteps(sampleRate, clockFraction);
+	}
+	inline int getGateCode() {return (ppqnLeftToSkip != 0 ? 0 : gateCode);}// gate code as seen by calcGate(), for clock-rate simulation (no sample rate)
+	inline long calcIdleSteps(float sampleRate) {// number of upcoming step() calls during which, without a clock edge, the outputs can't change
+		if (slide.isSliding())
+			return 0l;
+		unsigned long trigSteps = calcTrigSteps(sampleRate, clockFraction);
+		if (ppqnLeftToSkip != 0 || gateCode < 3 || clockPeriod >= trigSteps)
+			return LONG_MAX;
+		return (long) (trigSteps - 1ul - clockPeriod);
 	}
 	
-	inline void initPulsesPerStep() {pulsesPerStep = 1;}
-	inline void initDelay() {delay = 0;}
+	inline void initPulsesPerStep() {pulsesPerStep = 1; invalidatePrediction();}
+	inline void initDelay() {delay = 0; invalidatePrediction();}
 	
 	void initSequence(int seqn);
 	void initSong();
@@ -357,16 +461,37 @@ class SequencerKernel {
 	void initRun();
 	void toJson(json_t *rootJ);
 	void fromJson(json_t *rootJ);
-	void clockStep(bool realClockEdgeToHandle);
+	std::string stepDataToString();// cv and attributes of all sequences, see FoundryUtil.cpp for the format
+	bool stepDataFromString(const char *stepDataStr);// returns false (and changes nothing) if not a valid step data string
+	static bool writeLegacyJson;// when true, toJson() writes the cv and attributes as json arrays like earlier versions (used by the bench)
+	void clockStep(bool realClockEdgeToHandle, float edgeFraction);
 	inline void step() {
 		clockPeriod++;
 	}
+	inline void skipIdleSteps(long n) {
+		clockPeriod += (unsigned long)n;
+	}
 	int keyIndexToGateTypeEx(int keyIndex);
 	void transposeSeq(int seqn, int delta);
 	void unTransposeSeq(int seqn) {
 		transposeSeq(seqn, getTransposeOffset(seqn) * -1);
 	}
 	void rotateSeq(int* rotateOffset, int seqn, int delta);	
+	int predictSteps(int count);
+	bool followsMaster();
+	inline PredictedStep getPredictedStep(int i) {return predicted[(predictHead + i) % PREDICT_SIZE];}// i must be less than predictSteps()
+	inline void invalidatePrediction() {
+		predictCount = 0;
+		predictVersion++;
+	}
+	
+	// Raw access for the undo journal, which only restores states that were reached through the editing methods above (tied steps etc)
+	inline StepData getStepData(int seqn, int stepn) {return steps[seqn][stepn];}
+	inline void setStepData(int seqn, int stepn, StepData stepData) {steps[seqn][stepn] = stepData; invalidatePrediction();}
+	inline uint32_t getSeqAttrib(int seqn) {return sequences[seqn].getSeqAttrib();}
+	inline void setSeqAttrib(int seqn, uint32_t seqAttrib) {sequences[seqn].setSeqAttrib(seqAttrib); invalidatePrediction();}
+	int getSetting(int setn);
+	void setSetting(int setn, int value);
 
 	
 	private:
@@ -374,43 +499,97 @@ class SequencerKernel {
 	
 	void rotateSeqByOne(int seqn, bool directionRight);
 	inline void propagateCVtoTied(int seqn, int stepn) {
-		for (int i = stepn + 1; i < MAX_STEPS && attributes[seqn][i].getTied(); i++)
-			cv[seqn][i] = cv[seqn][i - 1];	
+		for (int i = stepn + 1; i < MAX_STEPS && steps[seqn][i].attributes.getTied(); i++)
+			steps[seqn][i].cv = steps[seqn][i - 1].cv;	
 	}
 	void activateTiedStep(int seqn, int stepn);
 	void deactivateTiedStep(int seqn, int stepn);
+	void updatePlayablePhrases();
 	void calcGateCodeEx(int seqn);
-	bool moveStepIndexRun();
-	void moveSongIndexBackward(bool init, bool rollover);
-	void moveSongIndexForeward(bool init, bool rollover);
-	int tempPhraseIndexes[MAX_PHRASES];// used only in next method	
-	void moveSongIndexRandom(bool init, uint32_t randomValue);	
-	void moveSongIndexBrownian(bool init, uint32_t randomValue);	
-	void movePhraseIndexRun(bool init);
-};// class SequencerKernel 
-
-
-struct SeqCPbuffer {
-	float cvCPbuffer[SequencerKernel::MAX_STEPS];// copy paste buffer for CVs
-	StepAttributes attribCPbuffer[SequencerKernel::MAX_STEPS];
-	SeqAttributes seqAttribCPbuffer;
-	int storedLength;// number of steps that contain actual cp data
-	
-	SeqCPbuffer() {reset();}
-	void reset();
-};// struct SeqCPbuffer
+	bool moveStepIndexRun(RunState &rs, const RunState *master);
+	void moveSongIndexBackward(RunState &rs, bool init, bool rollover);
+	void moveSongIndexForeward(RunState &rs, bool init, bool rollover);
+	void moveSongIndexRandom(RunState &rs, bool init, uint32_t randomValue);	
+	void moveSongIndexBrownian(RunState &rs, bool init, uint32_t randomValue);	
+	void movePhraseIndexRun(RunState &rs, const RunState *master, bool init);
+	void advanceRun(RunState &rs, const RunState *master);
+};// class BasicSequencerKernel 
 
 
-struct SongCPbuffer {
-	Phrase phraseCPbuffer[SequencerKernel::MAX_PHRASES];
-	int beginIndex;
-	int endIndex;
-	int runModeSong;
-	int storedLength;// number of steps that contain actual cp data
+typedef BasicSequencerKernel<32, 64, 99> SequencerKernel;
+
+
+//*****************************************************************************
+// UndoJournal
+//*****************************************************************************
+
+
+// Undo and redo of the Sequencer's edits. An edit is kept as the deltas (old and new values) of the step cvs and attributes,
+// sequence attributes, phrases and track settings that it changed, in a ring of deltas shared by all undo levels; when the ring
+// is full, the oldest edits are dropped. The Sequencer brackets each editing method with beginEdit() and endEdit(), which
+// snapshot the edited sequence and the song of all tracks and then diff them, so the kernel's editing methods are unchanged.
+template <class KERNEL, int TRACKS>
+class UndoJournal {
+	public:
 	
-	SongCPbuffer() {reset();}
-	void reset();
-};// song SeqCPbuffer
+	static const int JOURNAL_SIZE = 512;// number of deltas (12 bytes each)
+	
+	
+	private:
+	
+	enum DeltaKinds {DELTA_CV, DELTA_ATTRIB, DELTA_SEQ, DELTA_PHRASE, DELTA_SETTING};
+	static const uint8_t DELTA_FIRST = 0x80;// or'ed into the kind of the first delta of each edit
+	
+	struct Delta {
+		uint8_t kind;
+		uint8_t trkn;
+		uint16_t index;// seqn * MAX_STEPS + stepn for cvs and attributes, seqn, phrn or setn otherwise
+		uint32_t oldValue;// cvs are kept as their bits
+		uint32_t newValue;
+	};
+	static_assert(sizeof(Delta) == 12, "Delta must stay compact");
+	
+	Delta deltas[JOURNAL_SIZE];// ring buffer, indexed with the counters below modulo JOURNAL_SIZE
+	unsigned long tail;// first delta of the oldest edit
+	unsigned long cursor;// edits before cursor can be undone, edits from cursor to head can be redone
+	unsigned long head;
+	unsigned long editStart;// first delta of the edit being recorded
+	bool editOverflow;// when the edit being recorded does not fit in the journal, the journal is cleared
+	
+	// Snapshot taken by beginEdit()
+	int editSeqn;
+	StepData seqSteps[TRACKS][KERNEL::MAX_STEPS];
+	uint32_t seqAttribs[TRACKS];
+	uint32_t phrases[TRACKS][KERNEL::MAX_PHRASES];
+	int settings[TRACKS][KERNEL::NUM_SETTINGS];
+	
+	
+	public:
+	
+	inline void clear() {
+		tail = 0;
+		cursor = 0;
+		head = 0;
+	}
+	void beginEdit(KERNEL *sek, int seqn);
+	void endEdit(KERNEL *sek);
+	bool undo(KERNEL *sek);// returns false when there is nothing to undo
+	bool redo(KERNEL *sek);// returns false when there is nothing to redo
+	
+	
+	private:
+	
+	static inline uint32_t cvBits(float cv) {
+		uint32_t bits;
+		memcpy(&bits, &cv, sizeof(bits));
+		return bits;
+	}
+	static inline uint32_t phraseValue(KERNEL &k, int phrn) {
+		return (uint32_t)k.getPhraseSeq(phrn) | ((uint32_t)k.getPhraseReps(phrn) << 8);
+	}
+	void record(int kind, int trkn, int index, uint32_t oldValue, uint32_t newValue, bool *first);
+	void apply(KERNEL *sek, const Delta &delta, bool undo);
+};// class UndoJournal
 
 
 //*****************************************************************************
@@ -418,7 +597,8 @@ struct SongCPbuffer {
 //*****************************************************************************
 
 
-class Sequencer {
+template <int TRACKS, int STEPS, int SEQS, int PHRASES>
+class BasicSequencer {
 	public: 
 	
 	
@@ -426,7 +606,8 @@ class Sequencer {
 	// ----------------
 
 	// Sequencer dimensions
-	static const int NUM_TRACKS = 4;
+	static const int NUM_TRACKS = TRACKS;
+	typedef BasicSequencerKernel<STEPS, SEQS, PHRASES> Kernel;
 	static constexpr float gateTime = 0.4f;// seconds
 
 
@@ -441,21 +622,22 @@ class Sequencer {
 	int seqIndexEdit;// used in edit Seq mode only
 	int phraseIndexEdit;// used in edit Song mode only
 	int trackIndexEdit;
-	SequencerKernel sek[NUM_TRACKS];
+	Kernel sek[NUM_TRACKS];
 	
 	// No need to save	
 	unsigned long editingGate[NUM_TRACKS];// 0 when no edit gate, downward step counter timer when edit gate
 	float editingGateCV[NUM_TRACKS];// no need to initialize, this goes with editingGate (output this only when editingGate > 0)
 	int editingGateKeyLight;// no need to initialize, this goes with editingGate (use this only when editingGate > 0)
-	SeqCPbuffer seqCPbuf;
-	SongCPbuffer songCPbuf;
+	typename Kernel::SeqCPbuffer seqCPbuf;
+	typename Kernel::SongCPbuffer songCPbuf;
+	UndoJournal<Kernel, NUM_TRACKS> undoJournal;
 	int* velocityModePtr;
 	
 	
 	public: 
 	
 	
-	void construct(bool* _holdTiedNotesPtr, int* _velocityModePtr);
+	void construct(bool* _holdTiedNotesPtr, int* _velocityModePtr, int* _slideShapePtr);
 	
 
 	inline int getStepIndexEdit() {return stepIndexEdit;}
@@ -463,6 +645,11 @@ class Sequencer {
 	inline int getPhraseIndexEdit() {return phraseIndexEdit;}
 	inline int getTrackIndexEdit() {return trackIndexEdit;}
 	inline int getStepIndexRun(int trkn) {return sek[trkn].getStepIndexRun();}
+	inline int getPhraseIndexRun(int trkn) {return sek[trkn].getPhraseIndexRun();}
+	inline const Kernel &getKernel(int trkn) {return sek[trkn];}// for the bench's checks
+	inline int predictSteps(int trkn, int count) {return sek[trkn].predictSteps(count);}// engine thread only, see SequencerKernel::predictSteps()
+	inline void setClockSource(int trkn, int clockSource) {sek[trkn].setClockSource(clockSource);}
+	inline PredictedStep getPredictedStep(int trkn, int i) {return sek[trkn].getPredictedStep(i);}
 	inline int getLength() {return sek[trackIndexEdit].getLength(seqIndexEdit);}
 	inline StepAttributes getAttribute() {return sek[trackIndexEdit].getAttribute(seqIndexEdit, stepIndexEdit);}
 	inline float getCV() {return sek[trackIndexEdit].getCV(seqIndexEdit, stepIndexEdit);}
@@ -483,7 +670,7 @@ class Sequencer {
 	inline void setStepIndexEdit(int _stepIndexEdit, int sampleRate) {
 		stepIndexEdit = _stepIndexEdit;
 		if (!sek[trackIndexEdit].getTied(seqIndexEdit,stepIndexEdit)) {// play if non-tied step
-			editingGate[trackIndexEdit] = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+			editingGate[trackIndexEdit] = (unsigned long) (gateTime * sampleRate / calcDisplayRefreshStepSkips(sampleRate));
 			editingGateCV[trackIndexEdit] = sek[trackIndexEdit].getCV(seqIndexEdit, stepIndexEdit);
 			editingGateKeyLight = -1;
 		}
@@ -533,14 +720,14 @@ class Sequencer {
 	bool applyNewKey(int keyn, int multiSteps, float sampleRate, bool autostepClick, bool multiTracks); // returns true if tied
 
 	inline void moveStepIndexEdit(int delta) {
-		stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, SequencerKernel::MAX_STEPS);
+		stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, Kernel::MAX_STEPS);
 	}
 	void moveStepIndexEditWithEditingGate(int delta, bool writeTrig, float sampleRate);
 	inline void moveSeqIndexEdit(int deltaSeqKnob) {
-		seqIndexEdit = moveIndex(seqIndexEdit, seqIndexEdit + deltaSeqKnob, SequencerKernel::MAX_SEQS);
+		seqIndexEdit = moveIndex(seqIndexEdit, seqIndexEdit + deltaSeqKnob, Kernel::MAX_SEQS);
 	}
 	inline void movePhraseIndexEdit(int deltaPhrKnob) {
-		phraseIndexEdit = moveIndex(phraseIndexEdit, phraseIndexEdit + deltaPhrKnob, SequencerKernel::MAX_PHRASES);
+		phraseIndexEdit = moveIndex(phraseIndexEdit, phraseIndexEdit + deltaPhrKnob, Kernel::MAX_PHRASES);
 	}
 
 	
@@ -562,6 +749,9 @@ class Sequencer {
 	bool toggleGateP(int multiSteps, bool multiTracks); // returns true if tied
 	bool toggleSlide(int multiSteps, bool multiTracks); // returns true if tied
 	void toggleTied(int multiSteps, bool multiTracks);
+	
+	inline bool undo() {return undoJournal.undo(sek);}// undoes the last edit made with the methods above, returns false when none
+	inline bool redo() {return undoJournal.redo(sek);}
 
 
 	inline float calcCvOutputAndDecSlideStepsRemain(int trkn, bool running) {
@@ -595,7 +785,7 @@ class Sequencer {
 	}
 	inline float calcKeyLightWithEditing(int keyScanIndex, int keyLightIndex, float sampleRate) {
 		if (editingGate[trackIndexEdit] > 0ul && editingGateKeyLight != -1)
-			return (keyScanIndex == editingGateKeyLight ? ((float) editingGate[trackIndexEdit] / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+			return (keyScanIndex == editingGateKeyLight ? ((float) editingGate[trackIndexEdit] / (float)(gateTime * sampleRate / calcDisplayRefreshStepSkips(sampleRate))) : 0.0f);
 		return (keyScanIndex == keyLightIndex ? 1.0f : 0.0f);
 	}
 	
@@ -623,6 +813,7 @@ class Sequencer {
 	inline void randomize() {
 		for (int trkn = 0; trkn < NUM_TRACKS; trkn++)
 			sek[trkn].randomize();	
+		undoJournal.clear();
 	}
 	
 	inline void initRun() {
@@ -633,13 +824,28 @@ class Sequencer {
 	void toJson(json_t *rootJ);
 	void fromJson(json_t *rootJ);
 
-	inline void clockStep(int trkn, bool realClockEdgeToHandle) {
-		sek[trkn].clockStep(realClockEdgeToHandle);
+	inline void clockStep(int trkn, bool realClockEdgeToHandle, float edgeFraction) {
+		sek[trkn].clockStep(realClockEdgeToHandle, edgeFraction);
 	}
 	inline void step() {
 		for (int trkn = 0; trkn < NUM_TRACKS; trkn++) 
 			sek[trkn].step();
 	}
+	inline long calcIdleSteps(float sampleRate) {
+		long idleSteps = LONG_MAX;
+		for (int trkn = 0; trkn < NUM_TRACKS; trkn++) 
+			idleSteps = std::min(idleSteps, sek[trkn].calcIdleSteps(sampleRate));
+		return idleSteps;
+	}
+	inline void skipIdleSteps(long n) {
+		for (int trkn = 0; trkn < NUM_TRACKS; trkn++) 
+			sek[trkn].skipIdleSteps(n);
+	}
 	
-};// class Sequencer 
+};// class BasicSequencer 
+
+
+typedef BasicSequencer<4, 32, 64, 99> Sequencer;// Foundry
+typedef BasicSequencer<4, 64, 64, 99> Sequencer64Steps;// larger variants, instantiated in FoundryUtil.cpp
+typedef BasicSequencer<8, 32, 64, 99> Sequencer8Tracks;
 
@@ -188,8 +188,8 @@ struct FourViewWidget : ModuleWidget {
 		
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/FourView.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/FourView_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/FourView.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/FourView_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
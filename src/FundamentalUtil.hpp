@@ -6,6 +6,7 @@
 //***********************************************************************************************
 
 #include "rack.hpp"
+#include "ImpromptuModular.hpp"
 #include "dsp/functions.hpp"
 #include "dsp/resampler.hpp"
 #include "dsp/ode.hpp"
@@ -68,6 +69,7 @@ struct VoltageControlledOscillator {
 	// For analog detuning effect
 	float pitchSlew = 0.0f;
 	int pitchSlewIndex = 0;
+	RandomGenerator* rng;// must be set by the owner module, see ImpromptuModular.hpp
 
 	float sinBuffer[OVERSAMPLE] = {};
 	float triBuffer[OVERSAMPLE] = {};
@@ -16,7 +16,7 @@
 #include "PhraseSeqUtil.hpp"
 
 
-struct GateSeq64 : Module {
+struct GateSeq64 : Module, BlockProcessor {
 	enum ParamIds {
 		ENUMS(STEP_PARAMS, 64),
 		MODES_PARAM,
@@ -63,14 +63,15 @@ struct GateSeq64 : Module {
 		ENUMS(GMODE_LIGHTS, 8 * 2),// room for GreenRed
 		NUM_LIGHTS
 	};
+	enum EditIds {EDIT_PANEL_THEME, EDIT_EXPANSION, EDIT_RESET_ON_RUN, EDIT_AUTOSEQ, EDIT_SEQCV_METHOD};// see applyEdit()
 	
 	// Constants
 	enum DisplayStateIds {DISP_GATE, DISP_LENGTH, DISP_MODES};
 	enum AttributeBitMasksGS {ATT_MSK_PROB = 0xFF, ATT_MSK_GATEP = 0x100, ATT_MSK_GATE = 0x200};
 	static const int ATT_MSK_GATEMODE = 0x1C00;// 3 bits
 	static const int gateModeShift = 10;
-	//										1/4		DUO			D2			TR1		TR2		TR3 		TR23	   TRI
-	const uint32_t advGateHitMaskGS[8] = {0x00003F, 0x03F03F, 0x03F000, 0x00000F, 0x000F00, 0x0F0000, 0x0F0F00, 0x0F0F0F};
+	//										1/4	DUO	D2	TR1	TR2	TR3	TR23	TRI
+	const int gateModeToAdvGate[8] = {0, 7, 9, 6, 8, 10, 3, 1};// see advGateHitMask
 	static const int blinkNumInit = 15;
 	static constexpr float CONFIG_PARAM_INIT_VALUE = 0.0f;// so that module constructor is coherent with widget initialization, since module created before widget
 
@@ -89,6 +90,7 @@ struct GateSeq64 : Module {
 	int phrases;//1 to 64
 	int attributes[16][64];
 	bool resetOnRun;
+	RandomGenerator rng;// see ImpromptuModular.hpp
 
 	// No need to save
 	int displayState;
@@ -117,7 +119,11 @@ struct GateSeq64 : Module {
 
 
 	int stepConfigSync = 0;// 0 means no sync requested, 1 means soft sync (no reset lengths), 2 means hard (reset lengths)
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
+	EditQueue editQueue;// edits from the widgets, see ImpromptuModular.hpp
+#ifdef IM_CPU_METER
+	CpuMeter cpuMeter;
+#endif
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	SchmittTrigger modesTrigger;
@@ -162,19 +168,15 @@ struct GateSeq64 : Module {
 	inline void setGateMode(int seq, int step, int gateMode) {attributes[seq][step] &= ~ATT_MSK_GATEMODE; attributes[seq][step] |= (gateMode << gateModeShift);}
 	inline void toggleGate(int seq, int step) {attributes[seq][step] ^= ATT_MSK_GATE;}
 
-	inline int getAdvGateGS(int ppqnCount, int pulsesPerStep, int gateMode) { 
-		uint32_t shiftAmt = ppqnCount * (24 / pulsesPerStep);
-		return (int)((advGateHitMaskGS[gateMode] >> shiftAmt) & (uint32_t)0x1);
-	}	
 	inline int calcGateCode(int attribute, int ppqnCount, int pulsesPerStep) {
 		// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high
-		if (ppqnCount == 0 && getGatePa(attribute) && !(randomUniform() < ((float)(getGatePValA(attribute))/100.0f)))// randomUniform is [0.0, 1.0), see include/util/common.hpp
+		if (ppqnCount == 0 && getGatePa(attribute) && !(rng.uniform() < ((float)(getGatePValA(attribute))/100.0f)))// uniform is [0.0, 1.0), see ImpromptuModular.hpp
 			return -1;
 		if (!getGateA(attribute))
 			return 0;
 		if (pulsesPerStep == 1)
 			return 2;// clock high
-		return getAdvGateGS(ppqnCount, pulsesPerStep, getGateAMode(attribute));
+		return PhraseSeqGateCodes::get(gateModeToAdvGate[getGateAMode(attribute)], ppsToIndex(pulsesPerStep), ppqnCount);
 	}		
 	inline bool calcGate(int gateCode, SchmittTrigger clockTrigger) {
 		if (gateCode < 2) 
@@ -188,9 +190,9 @@ struct GateSeq64 : Module {
 			stepIndexRun[3] = stepIndexRun[0];
 		}
 		else {
-			stepIndexRun[1] = randomu32() % len;
-			stepIndexRun[2] = randomu32() % len;
-			stepIndexRun[3] = randomu32() % len;
+			stepIndexRun[1] = rng.u32() % len;
+			stepIndexRun[2] = rng.u32() % len;
+			stepIndexRun[3] = rng.u32() % len;
 		}
 	}
 	inline int ppsToIndexGS(int pulsesPerStep) {// map 1,4,6,12,24, to 0,1,2,3,4
@@ -260,20 +262,20 @@ struct GateSeq64 : Module {
 	
 	void onRandomize() override {
 		stepConfig = getStepConfig(params[CONFIG_PARAM].value);
-		runModeSong = randomu32() % 5;
+		runModeSong = rng.u32() % 5;
 		stepIndexEdit = 0;
 		phraseIndexEdit = 0;
-		sequence = randomu32() % 16;
-		phrases = 1 + (randomu32() % 64);
+		sequence = rng.u32() % 16;
+		phrases = 1 + (rng.u32() % 64);
 		for (int i = 0; i < 16; i++) {
 			for (int s = 0; s < 64; s++) {
-				attributes[i][s] = (randomu32() % 101) | (randomu32() & (ATT_MSK_GATEP | ATT_MSK_GATE | ATT_MSK_GATEMODE));
+				attributes[i][s] = (rng.u32() % 101) | (rng.u32() & (ATT_MSK_GATEP | ATT_MSK_GATE | ATT_MSK_GATEMODE));
 			}
-			runModeSeq[i] = randomu32() % NUM_MODES;
-			lengths[i] = 1 + (randomu32() % (16 * stepConfig));
+			runModeSeq[i] = rng.u32() % NUM_MODES;
+			lengths[i] = 1 + (rng.u32() % (16 * stepConfig));
 		}
 		for (int i = 0; i < 64; i++)
-			phrase[i] = randomu32() % 16;
+			phrase[i] = rng.u32() % 16;
 		initRun();
 	}
 
@@ -331,7 +333,7 @@ struct GateSeq64 : Module {
 		for (int i = 0; i < 16; i++)
 			json_array_insert_new(lengthsJ, i, json_integer(lengths[i]));
 		json_object_set_new(rootJ, "lengths", lengthsJ);
-	
+
 		// phrase 
 		json_t *phraseJ = json_array();
 		for (int i = 0; i < 64; i++)
@@ -354,10 +356,13 @@ struct GateSeq64 : Module {
 		
 		// stepIndexEdit
 		json_object_set_new(rootJ, "stepIndexEdit", json_integer(stepIndexEdit));
-	
+
 		// phraseIndexEdit
 		json_object_set_new(rootJ, "phraseIndexEdit", json_integer(phraseIndexEdit));
 
+		// rng
+		json_object_set_new(rootJ, "rng", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -502,11 +507,38 @@ struct GateSeq64 : Module {
 		if (phraseIndexEditJ)
 			phraseIndexEdit = json_integer_value(phraseIndexEditJ);
 		
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
+
 		stepConfigSync = 1;// signal a sync from fromJson so that step will get lengths from lengthsBuffer
 	}
 
 	
+	void applyEdit(EditCommand command) {
+		switch (command.id) {
+			case EDIT_PANEL_THEME :
+				panelTheme = command.value;
+			break;
+			case EDIT_EXPANSION :
+				expansion = expansion == 1 ? 0 : 1;
+			break;
+			case EDIT_RESET_ON_RUN :
+				resetOnRun = !resetOnRun;
+			break;
+			case EDIT_AUTOSEQ :
+				autoseq = !autoseq;
+			break;
+			case EDIT_SEQCV_METHOD :
+				seqCVmethod++;
+				if (seqCVmethod > 2)
+					seqCVmethod = 0;
+			break;
+		}
+	}
+	
+	
 	void step() override {
+		IM_CPU_METER_BEGIN(cpuMeter);
 		static const float copyPasteInfoTime = 0.5f;// seconds
 		static const float displayProbInfoTime = 3.0f;// seconds
 		static const float revertDisplayTime = 0.5f;// seconds
@@ -536,7 +568,11 @@ struct GateSeq64 : Module {
 			displayState = DISP_GATE;
 		}
 		
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
+			// Edits from the widgets
+			EditCommand editCommand;
+			while (editQueue.pop(&editCommand))
+				applyEdit(editCommand);
 			
 			// Edit mode blink when change
 			if (editingSequenceTrigger.process(editingSequence))
@@ -594,13 +630,13 @@ struct GateSeq64 : Module {
 						attribOrPhraseCPbuffer[i] = phrase[p];
 					lengthCPbuffer = -1;// so that a cross paste can be detected
 				}
-				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_GATE;
 				blinkNum = blinkNumInit;
 			}
 			// Paste button
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
-				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				startCP = 0;
 				if (countCP <= 8) {
 					startCP = editingSequence ? stepIndexEdit : phraseIndexEdit;
@@ -626,13 +662,13 @@ struct GateSeq64 : Module {
 						}
 						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (randomize gates)
 							for (int s = 0; s < 64; s++)
-								if ( (randomu32() & 0x1) != 0)
+								if ( (rng.u32() & 0x1) != 0)
 									toggleGate(sequence, s);
 						}
 						else {// 8 (randomize probs)
 							for (int s = 0; s < 64; s++) {
-								setGateP(sequence, s, (randomu32() & 0x1) != 0);
-								setGatePVal(sequence, s, randomu32() % 101);
+								setGateP(sequence, s, (rng.u32() & 0x1) != 0);
+								setGatePVal(sequence, s, rng.u32() % 101);
 							}
 						}
 						startCP = 0;
@@ -656,7 +692,7 @@ struct GateSeq64 : Module {
 						}
 						else {// 8 (randomize phrases)
 							for (int p = 0; p < 64; p++)
-								phrase[p] = randomu32() % 64;
+								phrase[p] = rng.u32() % 64;
 						}
 						startCP = 0;
 						countCP = 64;
@@ -714,7 +750,7 @@ struct GateSeq64 : Module {
 				if (editingSequence) {
 					if (displayState == DISP_LENGTH) {
 						lengths[sequence] = stepPressed % (16 * stepConfig) + 1;
-						revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+						revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 					}
 					else if (displayState == DISP_MODES) {
 					}
@@ -722,7 +758,7 @@ struct GateSeq64 : Module {
 						if (!getGate(sequence, stepPressed)) {// clicked inactive, so turn gate on
 							setGate(sequence, stepPressed, true);
 							if (getGateP(sequence, stepPressed))
-								displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
+								displayProbInfo = (long) (displayProbInfoTime * sampleRate / refresh.lightSkips);
 							else
 								displayProbInfo = 0l;
 						}
@@ -733,7 +769,7 @@ struct GateSeq64 : Module {
 							}
 							else {
 								if (getGateP(sequence, stepPressed))
-									displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
+									displayProbInfo = (long) (displayProbInfoTime * sampleRate / refresh.lightSkips);
 								else
 									displayProbInfo = 0l;
 							}
@@ -747,14 +783,14 @@ struct GateSeq64 : Module {
 						phrases = stepPressed + 1;
 						if (phrases > 64) phrases = 64;
 						if (phrases < 1 ) phrases = 1;
-						revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+						revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 					}
 					else if (displayState == DISP_MODES) {
 					}
 					else {
 						phraseIndexEdit = stepPressed;
 						if (running)
-							editingPhraseSongRunning = (long) (editingPhraseSongRunningTime * sampleRate / displayRefreshStepSkips);
+							editingPhraseSongRunning = (long) (editingPhraseSongRunningTime * sampleRate / refresh.lightSkips);
 						else
 							phraseIndexRun = stepPressed;
 					}
@@ -772,7 +808,7 @@ struct GateSeq64 : Module {
 					displayState = DISP_MODES;
 				else
 					displayState = DISP_GATE;
-				modeHoldDetect.start((long) (holdDetectTime * sampleRate / displayRefreshStepSkips));
+				modeHoldDetect.start((long) (holdDetectTime * sampleRate / refresh.lightSkips));
 			}
 
 			// Prob button
@@ -784,7 +820,7 @@ struct GateSeq64 : Module {
 						setGateP(sequence, stepIndexEdit, false);
 					}
 					else {
-						displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
+						displayProbInfo = (long) (displayProbInfoTime * sampleRate / refresh.lightSkips);
 						setGateP(sequence, stepIndexEdit, true);
 					}
 				}
@@ -800,7 +836,7 @@ struct GateSeq64 : Module {
 							setGateMode(sequence, stepIndexEdit, i);
 						}
 						else {
-							editingPpqn = (long) (editingPpqnTime * sampleRate / displayRefreshStepSkips);
+							editingPpqn = (long) (editingPpqnTime * sampleRate / refresh.lightSkips);
 						}
 					}
 				}
@@ -824,11 +860,11 @@ struct GateSeq64 : Module {
 						if (pval < 0)
 							pval = 0;
 						setGatePVal(sequence, stepIndexEdit, pval);
-						displayProbInfo = (long) (displayProbInfoTime * sampleRate / displayRefreshStepSkips);
+						displayProbInfo = (long) (displayProbInfoTime * sampleRate / refresh.lightSkips);
 					}
 					else if (editingPpqn != 0) {
 						pulsesPerStep = indexToPpsGS(ppsToIndexGS(pulsesPerStep) + deltaKnob);// indexToPps() does clamping
-						editingPpqn = (long) (editingPpqnTime * sampleRate / displayRefreshStepSkips);
+						editingPpqn = (long) (editingPpqnTime * sampleRate / refresh.lightSkips);
 					}
 					else if (displayState == DISP_MODES) {
 						if (editingSequence) {
@@ -870,7 +906,7 @@ struct GateSeq64 : Module {
 								if (phrase[phraseIndexEdit] < 0) phrase[phraseIndexEdit] = 0;
 								if (phrase[phraseIndexEdit] >= 16) phrase[phraseIndexEdit] = (16 - 1);
 								if (running)
-									editingPhraseSongRunning = (long) (editingPhraseSongRunningTime * sampleRate / displayRefreshStepSkips);
+									editingPhraseSongRunning = (long) (editingPhraseSongRunningTime * sampleRate / refresh.lightSkips);
 							}
 						}	
 					}					
@@ -878,6 +914,7 @@ struct GateSeq64 : Module {
 				sequenceKnob = newSequenceKnob;
 			}		
 		
+			IM_CPU_METER_MARK(cpuMeter, SECT_INPUTS);
 		}// userInputs refresh
 		
 		
@@ -894,11 +931,11 @@ struct GateSeq64 : Module {
 				int newSeq = sequence;// good value when editingSequence, overwrite if not editingSequence
 				if (ppqnCount == 0) {
 					if (editingSequence) {
-						moveIndexRunMode(&stepIndexRun[0], lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory);
+						moveIndexRunMode(&stepIndexRun[0], lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory, &rng);
 					}
 					else {
-						if (moveIndexRunMode(&stepIndexRun[0], lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
+						if (moveIndexRunMode(&stepIndexRun[0], lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory, &rng)) {
+							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory, &rng);
 							stepIndexRun[0] = (runModeSeq[phrase[phraseIndexRun]] == MODE_REV ? lengths[phrase[phraseIndexRun]] - 1 : 0);// must always refresh after phraseIndexRun has changed
 						}
 						newSeq = phrase[phraseIndexRun];
@@ -927,6 +964,8 @@ struct GateSeq64 : Module {
 		}
 	
 		
+		IM_CPU_METER_MARK(cpuMeter, SECT_CLOCK);
+		
 		//********** Outputs and lights **********
 				
 		// Gate outputs
@@ -939,9 +978,9 @@ struct GateSeq64 : Module {
 				outputs[GATE_OUTPUTS + i].value = 0.0f;	
 		}
 
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		IM_CPU_METER_MARK(cpuMeter, SECT_OUTPUTS);
+
+		if (refresh.processLights()) {
 
 			// Step LED button lights
 			if (infoCopyPaste != 0l) {
@@ -971,7 +1010,7 @@ struct GateSeq64 : Module {
 						}
 						else {
 							float stepHereOffset = ((stepIndexRun[row] == col) && running) ? 0.5f : 1.0f;
-							long blinkCountMarker = (long) (0.67f * sampleRate / displayRefreshStepSkips);							
+							long blinkCountMarker = (long) (0.67f * sampleRate / refresh.lightSkips);							
 							if (getGate(sequence, i)) {
 								bool blinkEnableOn = (displayState != DISP_MODES) && (blinkCount < blinkCountMarker);
 								if (getGateP(sequence, i)) {
@@ -1046,7 +1085,7 @@ struct GateSeq64 : Module {
 		
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;	
-			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * refresh.lightSkips;
 
 			// Run lights
 			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
@@ -1061,7 +1100,7 @@ struct GateSeq64 : Module {
 				displayProbInfo--;
 			if (modeHoldDetect.process(params[MODES_PARAM].value)) {
 				displayState = DISP_GATE;
-				editingPpqn = (long) (editingPpqnTime * sampleRate / displayRefreshStepSkips);
+				editingPpqn = (long) (editingPpqnTime * sampleRate / refresh.lightSkips);
 			}
 			if (editingPpqn > 0l)
 				editingPpqn--;
@@ -1074,18 +1113,31 @@ struct GateSeq64 : Module {
 			}
 			if (blinkNum > 0) {
 				blinkCount++;
-				if (blinkCount >= (long) (1.0f * sampleRate / displayRefreshStepSkips)) {
+				if (blinkCount >= (long) (1.0f * sampleRate / refresh.lightSkips)) {
 					blinkCount = 0l;
 					blinkNum--;
 				}
 			}
-		}// lightRefreshCounter
+			IM_CPU_METER_MARK(cpuMeter, SECT_LIGHTS);
+		}// processLights()
 
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 
+		IM_CPU_METER_END(cpuMeter);
 	}// step()
 	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {// outputs only change on clock edges and user inputs
+		return LONG_MAX;
+	}
+	inline void skipIdleSteps(long n) {
+		clockIgnoreOnReset = std::max(clockIgnoreOnReset - n, 0l);
+	}
+	
 	inline void setGreenRed(int id, float green, float red) {
 		lights[id + 0].value = green;
 		lights[id + 1].value = red;
@@ -1093,6 +1145,7 @@ struct GateSeq64 : Module {
 
 };// GateSeq64 : module
 
+
 struct GateSeq64Widget : ModuleWidget {
 	GateSeq64 *module;
 	DynamicSVGPanel *panel;
@@ -1197,7 +1250,7 @@ struct GateSeq64Widget : ModuleWidget {
 		GateSeq64 *module;
 		int theme;
 		void onAction(EventAction &e) override {
-			module->panelTheme = theme;
+			module->editQueue.push(GateSeq64::EDIT_PANEL_THEME, theme);
 		}
 		void step() override {
 			rightText = (module->panelTheme == theme) ? "✔" : "";
@@ -1206,27 +1259,25 @@ struct GateSeq64Widget : ModuleWidget {
 	struct ExpansionItem : MenuItem {
 		GateSeq64 *module;
 		void onAction(EventAction &e) override {
-			module->expansion = module->expansion == 1 ? 0 : 1;
+			module->editQueue.push(GateSeq64::EDIT_EXPANSION);
 		}
 	};
 	struct ResetOnRunItem : MenuItem {
 		GateSeq64 *module;
 		void onAction(EventAction &e) override {
-			module->resetOnRun = !module->resetOnRun;
+			module->editQueue.push(GateSeq64::EDIT_RESET_ON_RUN);
 		}
 	};
 	struct AutoseqItem : MenuItem {
 		GateSeq64 *module;
 		void onAction(EventAction &e) override {
-			module->autoseq = !module->autoseq;
+			module->editQueue.push(GateSeq64::EDIT_AUTOSEQ);
 		}
 	};
 	struct SeqCVmethodItem : MenuItem {
 		GateSeq64 *module;
 		void onAction(EventAction &e) override {
-			module->seqCVmethod++;
-			if (module->seqCVmethod > 2)
-				module->seqCVmethod = 0;
+			module->editQueue.push(GateSeq64::EDIT_SEQCV_METHOD);
 		}
 		void step() override {
 			if (module->seqCVmethod == 0)
@@ -1290,6 +1341,10 @@ struct GateSeq64Widget : ModuleWidget {
 		expItem->module = module;
 		menu->addChild(expItem);
 
+#ifdef IM_CPU_METER
+		addCpuMeterMenu(menu, &module->cpuMeter);// ImpromptuModular.hpp
+#endif
+
 		return menu;
 	}	
 	
@@ -1321,8 +1376,8 @@ struct GateSeq64Widget : ModuleWidget {
         panel = new DynamicSVGPanel();
         panel->mode = &module->panelTheme;
 		panel->expWidth = &expWidth;
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/GateSeq64.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/GateSeq64_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/GateSeq64.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/GateSeq64_dark.svg"));
         box.size = panel->box.size;
 		box.size.x = box.size.x - (1 - module->expansion) * expWidth;
         addChild(panel);		
@@ -1460,6 +1515,7 @@ Model *modelGateSeq64 = Model::create<GateSeq64, GateSeq64Widget>("Impromptu Mod
 fix run mode bug (history not reset when hard reset)
 fix initRun() timing bug when turn off-and-then-on running button (it was resetting ppqnCount)
 add two extra modes for Seq CV input (right-click menu): note-voltage-levels and trigger-increment
+use a per-module random number generator (saved in the patch) instead of Rack's global one
 
 0.6.12:
 input refresh optimization
@@ -71,9 +71,9 @@ DynamicSVGScrew::DynamicSVGScrew() {
     addChild(swAlt);
 }
 
-void DynamicSVGScrew::addSVGalt(std::shared_ptr<SVG> svg) {
-    if(!swAlt->svg) {
-        swAlt->setSVG(svg);
+void DynamicSVGScrew::addSVGalt(const std::string &filename) {
+    if(altFilename.empty()) {
+        altFilename = filename;
     }
 }
 
@@ -88,6 +88,8 @@ void DynamicSVGScrew::step() { // all code except middle if() from SVGPanel::ste
 			swAlt->visible = false;
 		}
 		else {
+			if (!swAlt->svg && !altFilename.empty())
+				swAlt->setSVG(SVG::load(altFilename));
 			sw->visible = false;
 			swAlt->visible = true;
 		}
@@ -129,10 +131,10 @@ DynamicSVGPanel::DynamicSVGPanel() {
     addChild(border);
 }
 
-void DynamicSVGPanel::addPanel(std::shared_ptr<SVG> svg) {
-    panels.push_back(svg);
+void DynamicSVGPanel::addPanel(const std::string &filename) {
+    panels.push_back(LazySVG(filename));
     if(!visiblePanel->svg) {
-        visiblePanel->setSVG(svg);
+        visiblePanel->setSVG(panels.back().get());
         box.size = visiblePanel->box.size.div(RACK_GRID_SIZE).round().mult(RACK_GRID_SIZE);
         border->box.size = box.size;
     }
@@ -147,7 +149,7 @@ void DynamicSVGPanel::step() { // all code except middle if() from SVGPanel::ste
         oversample = 2.f;
     }
     if(mode != nullptr && *mode != oldMode) {
-        visiblePanel->setSVG(panels[*mode]);
+        visiblePanel->setSVG(panels[*mode].get());
         oldMode = *mode;
         dirty = true;
     }
@@ -164,10 +166,10 @@ DynamicSVGPort::DynamicSVGPort() {
 	//SVGPort constructor automatically called
 }
 
-void DynamicSVGPort::addFrame(std::shared_ptr<SVG> svg) {
-    frames.push_back(svg);
+void DynamicSVGPort::addFrame(const std::string &filename) {
+    frames.push_back(LazySVG(filename));
     if(!background->svg)
-        SVGPort::setSVG(svg);
+        SVGPort::setSVG(frames.back().get());
 }
 
 void DynamicSVGPort::step() {
@@ -176,7 +178,7 @@ void DynamicSVGPort::step() {
         oversample = 2.f;
     }
     if(mode != nullptr && *mode != oldMode) {
-        background->setSVG(frames[min(*mode, frames.size() - 1)]);
+        background->setSVG(frames[min(*mode, frames.size() - 1)].get());
         oldMode = *mode;
         dirty = true;
     }
@@ -193,11 +195,11 @@ DynamicSVGSwitch::DynamicSVGSwitch() {
 	//SVGSwitch constructor automatically called
 }
 
-void DynamicSVGSwitch::addFrameAll(std::shared_ptr<SVG> svg) {
-    framesAll.push_back(svg);
+void DynamicSVGSwitch::addFrameAll(const std::string &filename) {
+    framesAll.push_back(LazySVG(filename));
 	if (framesAll.size() == 2) {
-		addFrame(framesAll[0]);
-		addFrame(framesAll[1]);
+		addFrame(framesAll[0].get());
+		addFrame(framesAll[1].get());
 	}
 }
 
@@ -208,12 +210,12 @@ void DynamicSVGSwitch::step() {
     }
     if(mode != nullptr && *mode != oldMode) {
         if ((*mode) == 0) {
-			frames[0]=framesAll[0];
-			frames[1]=framesAll[1];
+			frames[0]=framesAll[0].get();
+			frames[1]=framesAll[1].get();
 		}
 		else {
-			frames[0]=framesAll[2];
-			frames[1]=framesAll[3];
+			frames[0]=framesAll[2].get();
+			frames[1]=framesAll[3].get();
 		}
         oldMode = *mode;
 		onChange(*(new EventChange()));// required because of the way SVGSwitch changes images, we only change the frames above.
@@ -232,15 +234,15 @@ DynamicSVGKnob::DynamicSVGKnob() {
 	//SVGKnob constructor automatically called
 }
 
-void DynamicSVGKnob::addFrameAll(std::shared_ptr<SVG> svg) {
-    framesAll.push_back(svg);
+void DynamicSVGKnob::addFrameAll(const std::string &filename) {
+    framesAll.push_back(LazySVG(filename));
 	if (framesAll.size() == 1) {
-		setSVG(svg);
+		setSVG(framesAll[0].get());
 	}
 }
 
-void DynamicSVGKnob::addEffect(std::shared_ptr<SVG> svg) {
-    effect->setSVG(svg);
+void DynamicSVGKnob::addEffect(const std::string &filename) {// effect is only shown in the alternate theme, so it's loaded then
+    effectFilename = filename;
 	addChild(effect);
 }
 
@@ -251,11 +253,13 @@ void DynamicSVGKnob::step() {
     }
     if(mode != nullptr && *mode != oldMode) {
         if ((*mode) == 0) {
-			setSVG(framesAll[0]);
+			setSVG(framesAll[0].get());
 			effect->visible = false;
 		}
 		else {
-			setSVG(framesAll[1]);
+			setSVG(framesAll[1].get());
+			if (!effect->svg && !effectFilename.empty())
+				effect->setSVG(SVG::load(effectFilename));
 			effect->visible = true;
 		}
         oldMode = *mode;
@@ -15,6 +15,24 @@ using namespace rack;
 
 
 
+// Lazy SVG
+
+// SVG that is only loaded the first time it is needed, used for the frames of the alternate panel themes so that these are only
+//   parsed when a module actually switches its panelTheme
+struct LazySVG {
+	std::string filename;
+	std::shared_ptr<SVG> svg;
+	
+	LazySVG(const std::string &_filename) : filename(_filename) {}
+	std::shared_ptr<SVG> get() {
+		if (!svg)
+			svg = SVG::load(filename);
+		return svg;
+	}
+};
+
+
+
 // Dynamic SVGScrew
 
 // General Dynamic Screw creation
@@ -38,11 +56,12 @@ struct DynamicSVGScrew : FramebufferWidget {
 	SVGWidget *sw;
 	TransformWidget *tw;
 	ScrewCircle *sc;
-	// for fixed svg screw used in alternate mode
+	// for fixed svg screw used in alternate mode (loaded when first shown)
     SVGWidget* swAlt;
+	std::string altFilename;
 	
     DynamicSVGScrew();
-    void addSVGalt(std::shared_ptr<SVG> svg);
+    void addSVGalt(const std::string &filename);
     void step() override;
 };
 
@@ -59,11 +78,11 @@ struct DynamicSVGPanel : FramebufferWidget { // like SVGPanel (in app.hpp and SV
     int* mode;
     int oldMode;
 	int* expWidth;
-    std::vector<std::shared_ptr<SVG>> panels;
+    std::vector<LazySVG> panels;
     SVGWidget* visiblePanel;
     PanelBorderWidget* border;
     DynamicSVGPanel();
-    void addPanel(std::shared_ptr<SVG> svg);
+    void addPanel(const std::string &filename);
     void dupPanel();
     void step() override;
 };
@@ -97,10 +116,10 @@ TDynamicPort* createDynamicPortCentered(Vec pos, Port::PortType type, Module *mo
 struct DynamicSVGPort : SVGPort {
     int* mode;
     int oldMode;
-    std::vector<std::shared_ptr<SVG>> frames;
+    std::vector<LazySVG> frames;
 
     DynamicSVGPort();
-    void addFrame(std::shared_ptr<SVG> svg);
+    void addFrame(const std::string &filename);
     void step() override;
 };
 
@@ -129,10 +148,10 @@ TDynamicParam* createDynamicParamCentered(Vec pos, Module *module, int paramId,
 struct DynamicSVGSwitch : SVGSwitch {
     int* mode;
     int oldMode;
-	std::vector<std::shared_ptr<SVG>> framesAll;
+	std::vector<LazySVG> framesAll;
 	
     DynamicSVGSwitch();
-	void addFrameAll(std::shared_ptr<SVG> svg);
+	void addFrameAll(const std::string &filename);
     void step() override;
 };
 
@@ -140,12 +159,13 @@ struct DynamicSVGSwitch : SVGSwitch {
 struct DynamicSVGKnob : SVGKnob {
     int* mode;
     int oldMode;
-	std::vector<std::shared_ptr<SVG>> framesAll;
+	std::vector<LazySVG> framesAll;
 	SVGWidget* effect;
+	std::string effectFilename;
 	
     DynamicSVGKnob();
-	void addFrameAll(std::shared_ptr<SVG> svg);
-	void addEffect(std::shared_ptr<SVG> svg);// do this last
+	void addFrameAll(const std::string &filename);
+	void addEffect(const std::string &filename);// do this last
     void step() override;
 };
 
@@ -181,3 +181,166 @@ int moveIndex(int index, int indexNext, int numSteps) {
 	return index;
 }
 
+
+
+void SlideGenerator::start(float fromCV, float toCV, float slideSteps, float edgeFraction, int shape) {
+	// the slide started at the clock edge, before this sample
+	double delta = (double)(toCV - fromCV);
+	double x0 = (double)edgeFraction / (double)slideSteps;// slide position of this sample, in [0.0 : 1.0)
+	stepsRemain = slideSteps - edgeFraction;
+	curved = (shape == SLIDE_EXP || shape == SLIDE_LOG);
+	if (curved) {
+		// offset(x) = delta * (e^(ax) - e^a) / (1 - e^a), so each increment is the previous one times e^(a/slideSteps)
+		double a = (shape == SLIDE_EXP ? -CURVE : CURVE);
+		double norm = delta / (1.0 - exp(a));
+		ratio = exp(a / (double)slideSteps);
+		offset = norm * (exp(a * x0) - exp(a));
+		increment = norm * exp(a * x0) * (1.0 - ratio);
+	}
+	else {// SLIDE_LINEAR
+		offset = delta * (1.0 - x0);
+		increment = delta / (double)slideSteps;
+	}
+}
+
+
+void RandomGenerator::seed(uint64_t seedValue) {
+	// splitmix64 expansion of the seed, so that state is never all zeros
+	for (int i = 0; i < 2; i++) {
+		seedValue += 0x9E3779B97F4A7C15ULL;
+		uint64_t z = seedValue;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		state[i] = z ^ (z >> 31);
+	}
+}
+
+float RandomGenerator::normal() {
+	// Box-Muller transform, as in Rack's randomNormal()
+	float radius = sqrtf(-2.0f * logf(1.0f - uniform()));
+	float theta = 2.0f * M_PI * uniform();
+	return radius * sinf(theta);
+}
+
+json_t *RandomGenerator::toJson() {
+	json_t *rngJ = json_array();
+	for (int i = 0; i < 2; i++) {
+		json_array_insert_new(rngJ, i * 2 + 0, json_integer((json_int_t)(state[i] & 0xFFFFFFFF)));
+		json_array_insert_new(rngJ, i * 2 + 1, json_integer((json_int_t)(state[i] >> 32)));
+	}
+	return rngJ;
+}
+
+void RandomGenerator::fromJson(json_t *rngJ) {
+	// when absent (patches from before this was saved), the generator keeps the seed it was given at construction
+	if (!rngJ || json_array_size(rngJ) != 4)
+		return;
+	uint64_t newState[2];
+	for (int i = 0; i < 2; i++)
+		newState[i] = ((uint64_t)json_integer_value(json_array_get(rngJ, i * 2 + 0)) & 0xFFFFFFFF) | ((uint64_t)json_integer_value(json_array_get(rngJ, i * 2 + 1)) << 32);
+	if (newState[0] == 0 && newState[1] == 0)
+		return;
+	state[0] = newState[0];
+	state[1] = newState[1];
+}
+
+
+#ifdef IM_CPU_METER
+void CpuMeter::reset() {
+	stepStart = 0;
+	sectStart = 0;
+	samples = 0;
+	for (int sect = 0; sect < NUM_SECTS; sect++) {
+		counts[sect] = 0;
+		sums[sect] = 0;
+		for (int bin = 0; bin < NUM_BINS; bin++)
+			bins[sect][bin] = 0;
+	}
+}
+
+void CpuMeter::decay() {
+	samples >>= 1;
+	for (int sect = 0; sect < NUM_SECTS; sect++) {
+		counts[sect] = 0;
+		sums[sect] >>= 1;
+		for (int bin = 0; bin < NUM_BINS; bin++) {
+			bins[sect][bin] >>= 1;
+			counts[sect] += bins[sect][bin];
+		}
+	}
+}
+
+float CpuMeter::mean(int sect) {
+	return counts[sect] == 0 ? 0.0f : (float)sums[sect] / (float)counts[sect];
+}
+
+float CpuMeter::percentile(int sect, float fraction) {
+	uint32_t target = (uint32_t)(fraction * (float)counts[sect]);
+	uint32_t cumul = 0;
+	int bin = 0;
+	for (; bin < NUM_BINS - 1; bin++) {
+		cumul += bins[sect][bin];
+		if (cumul > target)
+			break;
+	}
+	if (bin < 4)
+		return (float)(bin + 1);
+	return (float)((uint64_t)(5 + (bin & 0x3)) << (bin / 4 - 1));
+}
+
+float CpuMeter::perSample(int sect) {
+	return samples == 0 ? 0.0f : (float)sums[sect] / (float)samples;
+}
+
+
+struct CpuMeterLabel : MenuLabel {
+	CpuMeter *cpuMeter;
+	int sect;
+	void step() override {
+		static const char *sectNames[CpuMeter::NUM_SECTS] = {"Inputs", "Clock", "Outputs", "Lights", "Synth", "Total"};
+		char buf[96];
+		snprintf(buf, 96, "%s: mean %.0f, p99 %.0f, %.1f per sample", sectNames[sect], cpuMeter->mean(sect), cpuMeter->percentile(sect, 0.99f), cpuMeter->perSample(sect));
+		text = buf;
+		MenuLabel::step();
+	}
+};
+struct CpuMeterResetItem : MenuItem {
+	CpuMeter *cpuMeter;
+	void onAction(EventAction &e) override {
+		cpuMeter->reset();
+	}
+};
+struct CpuMeterItem : MenuItem {
+	CpuMeter *cpuMeter;
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu();
+		
+		MenuLabel *unitLabel = new MenuLabel();
+		unitLabel->text = std::string("Step sections, in ") + CpuMeter::unitName();
+		menu->addChild(unitLabel);
+		
+		for (int sect = 0; sect < CpuMeter::NUM_SECTS; sect++) {
+			if (cpuMeter->counts[sect] == 0)// section not used by this module
+				continue;
+			CpuMeterLabel *sectLabel = new CpuMeterLabel();
+			sectLabel->cpuMeter = cpuMeter;
+			sectLabel->sect = sect;
+			menu->addChild(sectLabel);
+		}
+		
+		CpuMeterResetItem *resetItem = MenuItem::create<CpuMeterResetItem>("Reset");
+		resetItem->cpuMeter = cpuMeter;
+		menu->addChild(resetItem);
+		
+		return menu;
+	}
+};
+
+void addCpuMeterMenu(Menu *menu, CpuMeter *cpuMeter) {
+	menu->addChild(new MenuLabel());// empty line
+	
+	CpuMeterItem *meterItem = MenuItem::create<CpuMeterItem>("CPU meter", RIGHT_ARROW);
+	meterItem->cpuMeter = cpuMeter;
+	menu->addChild(meterItem);
+}
+#endif
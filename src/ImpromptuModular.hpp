@@ -14,6 +14,14 @@
 #include "rack.hpp"
 #include "IMWidgets.hpp"
 #include "dsp/digital.hpp"
+#include <climits>
+#include <atomic>
+#ifdef IM_CPU_METER
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
 
 using namespace rack;
 
@@ -45,8 +53,8 @@ static const int displayAlpha = 23;
 static const std::string lightPanelID = "Classic";
 static const std::string darkPanelID = "Dark-valor";
 static const std::string expansionMenuLabel = "Extra CVs (requires +4HP to the right!)";// note: PS32EX detects '4' and replaces it with '7'
-static const unsigned int displayRefreshStepSkips = 256;
-static const unsigned int userInputsStepSkipMask = 0xF;// sub interval of displayRefreshStepSkips, since inputs should be more responsive than lights
+static const unsigned int displayRefreshStepSkips = 256;// at 44.1kHz, see RefreshCounter
+static const unsigned int userInputsStepSkipMask = 0xF;// at 44.1kHz; sub interval of displayRefreshStepSkips, since inputs should be more responsive than lights
 // above value should make it such that inputs are sampled > 1kHz so as to not miss 1ms triggers
 
 
@@ -80,7 +88,7 @@ static const int offsetTrimpot = 3;//does both h and v
 
 struct IMScrew : DynamicSVGScrew {
 	IMScrew() {
-		addSVGalt(SVG::load(assetPlugin(plugin, "res/dark/comp/ScrewSilver.svg")));
+		addSVGalt(assetPlugin(plugin, "res/dark/comp/ScrewSilver.svg"));
 	}
 };
 
@@ -90,8 +98,8 @@ struct IMScrew : DynamicSVGScrew {
 struct IMPort : DynamicSVGPort {
 	IMPort() {
 		//addFrame(SVG::load(assetGlobal("res/ComponentLibrary/PJ301M.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/light/comp/PJ301M.svg")));
-		addFrame(SVG::load(assetPlugin(plugin, "res/dark/comp/PJ301M.svg")));
+		addFrame(assetPlugin(plugin, "res/light/comp/PJ301M.svg"));
+		addFrame(assetPlugin(plugin, "res/dark/comp/PJ301M.svg"));
 		shadow->blurRadius = 10.0;
 		shadow->opacity = 0.8;
 	}
@@ -129,19 +137,19 @@ struct CKSSThreeInv : SVGSwitch, ToggleSwitch {
 
 struct IMBigPushButton : DynamicSVGSwitch, MomentarySwitch {
 	IMBigPushButton() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/CKD6b_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/CKD6b_1.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/CKD6b_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/CKD6b_1.svg")));	
+		addFrameAll(assetPlugin(plugin, "res/light/comp/CKD6b_0.svg"));
+		addFrameAll(assetPlugin(plugin, "res/light/comp/CKD6b_1.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/CKD6b_0.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/CKD6b_1.svg"));	
 	}
 };
 
 struct IMPushButton : DynamicSVGSwitch, MomentarySwitch {
 	IMPushButton() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/TL1105_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/TL1105_1.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/TL1105_0.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/TL1105_1.svg")));	
+		addFrameAll(assetPlugin(plugin, "res/light/comp/TL1105_0.svg"));
+		addFrameAll(assetPlugin(plugin, "res/light/comp/TL1105_1.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/TL1105_0.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/TL1105_1.svg"));	
 	}
 };
 
@@ -164,9 +172,9 @@ struct IMKnob : DynamicSVGKnob {
 
 struct IMBigKnob : IMKnob {
 	IMBigKnob() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/BlackKnobLargeWithMark.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMark.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMarkEffects.svg")));
+		addFrameAll(assetPlugin(plugin, "res/light/comp/BlackKnobLargeWithMark.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMark.svg"));
+		addEffect(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeWithMarkEffects.svg"));
 	}
 };
 struct IMBigSnapKnob : IMBigKnob {
@@ -178,9 +186,9 @@ struct IMBigSnapKnob : IMBigKnob {
 
 struct IMBigKnobInf : IMKnob {
 	IMBigKnobInf() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/BlackKnobLarge.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLarge.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeEffects.svg")));
+		addFrameAll(assetPlugin(plugin, "res/light/comp/BlackKnobLarge.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/BlackKnobLarge.svg"));
+		addEffect(assetPlugin(plugin, "res/dark/comp/BlackKnobLargeEffects.svg"));
 		speed = 0.9f;				
 		//smooth = false;
 	}
@@ -188,9 +196,9 @@ struct IMBigKnobInf : IMKnob {
 
 struct IMSmallKnob : IMKnob {
 	IMSmallKnob() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/RoundSmallBlackKnob.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnob.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnobEffects.svg")));		
+		addFrameAll(assetPlugin(plugin, "res/light/comp/RoundSmallBlackKnob.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnob.svg"));
+		addEffect(assetPlugin(plugin, "res/dark/comp/RoundSmallBlackKnobEffects.svg"));		
 		shadow->box.pos = Vec(0.0, box.size.y * 0.15);
 	}
 };
@@ -204,9 +212,9 @@ struct IMSmallSnapKnob : IMSmallKnob {
 
 struct IMMediumKnobInf : IMKnob {
 	IMMediumKnobInf() {
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/light/comp/RoundMediumBlackKnobNoMark.svg")));
-		addFrameAll(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMark.svg")));
-		addEffect(SVG::load(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMarkEffects.svg")));
+		addFrameAll(assetPlugin(plugin, "res/light/comp/RoundMediumBlackKnobNoMark.svg"));
+		addFrameAll(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMark.svg"));
+		addEffect(assetPlugin(plugin, "res/dark/comp/RoundMediumBlackKnobNoMarkEffects.svg"));
 		shadow->box.pos = Vec(0.0, box.size.y * 0.15);
 		speed = 0.9f;				
 		//smooth = false;
@@ -292,6 +300,42 @@ struct ScrewHole : TransparentWidget {
 	void draw(NVGcontext *vg) override;
 };	
 
+// Segment displays are drawn into a framebuffer that is only redrawn when what they show changes. TDisplay provides
+//   calcStateHash(), called once per UI frame, which must be cheap: print the display text and hash it with hashDisplayText(),
+//   or return the displayed value directly. The nanovg drawing of the display is only redone when the hash changes.
+inline uint64_t hashDisplayText(const char *text) {// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (; *text != 0; text++)
+		hash = (hash ^ (unsigned char)*text) * 1099511628211ULL;
+	return hash;
+}
+
+template <class TDisplay>
+struct CachedDisplay : FramebufferWidget {
+	TDisplay *display;
+	uint64_t oldStateHash = 0;// first draw is done anyways since dirty starts true
+	
+	CachedDisplay(TDisplay *_display) {
+		display = _display;
+		box = display->box;
+		display->box.pos = Vec(0.0f, 0.0f);
+		addChild(display);
+	}
+	void step() override {
+		uint64_t stateHash = display->calcStateHash();
+		if (stateHash != oldStateHash) {
+			oldStateHash = stateHash;
+			dirty = true;
+		}
+		FramebufferWidget::step();
+	}
+};
+
+template <class TDisplay>
+CachedDisplay<TDisplay> *createCachedDisplay(TDisplay *display) {
+	return new CachedDisplay<TDisplay>(display);
+}
+
 
 
 // Other
@@ -323,6 +367,390 @@ struct HoldDetect {
 	}
 };
 
+// SchmittTrigger for clock inputs that also estimates when the rising edge happened, by linear interpolation of the input's
+//   crossing of the trigger threshold between the previous sample and the one that detected the edge. Sequencers add
+//   edgeFraction to their sample counts, so that measured clock periods (and the slides and triggers timed from them) don't
+//   jitter by a sample, whatever the sample rate
+struct ClockTrigger : SchmittTrigger {
+	float lastIn = 0.0f;
+	float edgeFraction = 0.0f;// time from the estimated edge to the sample that detected it, in samples [0.0f : 1.0f)
+
+	bool process(float in) {
+		bool triggered = SchmittTrigger::process(in);
+		if (triggered)
+			edgeFraction = (in - 1.0f) / (in - lastIn);// lastIn < 1.0f <= in, since the trigger was low on the previous sample
+		lastIn = in;
+		return triggered;
+	}
+};
+
+inline unsigned long calcTrigSteps(float sampleRate, float edgeFraction) {// number of clock period counts that trigger gates (10 ms) last, see ClockTrigger
+	return (unsigned long) ceilf(sampleRate * 0.01f - edgeFraction);
+}
+
+// Glide of a sequencer's CV output from the previous step's CV to the new one. The offset to subtract from the new CV
+//   starts at the whole CV difference and goes to 0 along the chosen curve; the linear curve is advanced with one add per
+//   sample, the exponential and logarithmic curves also scale the increment by a constant ratio
+// The offset is accumulated in double, a float one drifts by more than 10 mV over a 2 second slide at 96 kHz
+enum SlideShapeIds {SLIDE_LINEAR, SLIDE_EXP, SLIDE_LOG, NUM_SLIDE_SHAPES};// exponential: fast start (portamento), logarithmic: slow start
+
+struct SlideGenerator {
+	static constexpr double CURVE = 4.0;// time constants in a slide for the exponential and logarithmic curves
+	float stepsRemain;// 0 when no slide under way, downward sample counter when sliding (fractional, see ClockTrigger)
+	double offset;// no need to initialize, this and the next three are companions to stepsRemain
+	double increment;
+	double ratio;
+	bool curved;// false for the linear curve, whose increment is constant
+
+	SlideGenerator() {
+		reset();
+	}
+
+	inline void reset() {stepsRemain = 0.0f;}
+	inline bool isSliding() {return stepsRemain > 0.0f;}
+	inline float getOffset() {return stepsRemain > 0.0f ? (float)offset : 0.0f;}
+	inline void advance() {
+		if (stepsRemain > 0.0f) {
+			stepsRemain = stepsRemain - 1.0f;
+			offset -= increment;
+			if (curved)
+				increment *= ratio;
+		}
+	}
+	void start(float fromCV, float toCV, float slideSteps, float edgeFraction, int shape);// slideSteps >= 1.0f, edgeFraction: see ClockTrigger
+};
+
+// Per-instance random number generator (xoroshiro128+, like Rack's global one), so that modules don't share Rack's global
+//   generator on the audio thread and so that random run modes and gate probabilities can be reproduced (state is saved in the patch)
+struct RandomGenerator {
+	uint64_t state[2];
+	
+	RandomGenerator() {
+		seed(randomu64());
+	}
+	RandomGenerator(uint64_t seedValue) {// does not draw from the global generator
+		seed(seedValue);
+	}
+	void seed(uint64_t seedValue);
+	
+	inline uint64_t u64() {
+		uint64_t s0 = state[0];
+		uint64_t s1 = state[1];
+		uint64_t result = s0 + s1;
+		s1 ^= s0;
+		state[0] = ((s0 << 55) | (s0 >> 9)) ^ s1 ^ (s1 << 14);
+		state[1] = (s1 << 36) | (s1 >> 28);
+		return result;
+	}
+	inline uint32_t u32() {
+		return (uint32_t)(u64() >> 32);
+	}
+	inline float uniform() {// [0.0, 1.0)
+		return (float)(u64() >> 40) / 16777216.0f;
+	}
+	float normal();
+	
+	json_t *toJson();
+	void fromJson(json_t *rngJ);
+};
+
+
+// Advanced gate types (gate modes of PhraseSeq16/32, SemiModularSynth and GateSeq64, gate types of Foundry)
+// The hit masks have one bit per 1/24 of a step. The gate code of every gate type, pulses per step and ppqn count is
+//   looked up in a table built at compile time, so that no division or branch is needed on a clock edge:
+//   0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
+// RES is the number of ppqn per step of the finest setting (24 in the PhraseSeqs, 96 in Foundry), and NUM_PPS the number of
+//   pulses per step settings, index 0 being 1 pps and index n being 2*n pps (see ppsToIndex())
+// Gate types are stored in 4 bits, so the table also covers the unused types 12 to 15 (a gate that stays off), which
+//   randomized PhraseSeq attributes can contain
+static const int NUM_ADV_GATES = 12;
+static const int NUM_ADV_GATE_CODES = 16;
+static constexpr uint32_t advGateHitMask[NUM_ADV_GATE_CODES] =
+{0x00003F, 0x0F0F0F, 0x000FFF, 0x0F0F00, 0x03FFFF, 0xFFFFFF, 0x00000F, 0x03F03F, 0x000F00, 0x03F000, 0x0F0000, 0, 0, 0, 0, 0};
+//	  25%		TRI		  50%		T23		  75%		FUL		  TR1 		DUO		  TR2 	     D2		  TR3  TRIG	unused
+
+constexpr int calcAdvGateCodePps(int gateType, int pps, int ppqnCount, int res) {
+	return ppqnCount >= pps ? 0 :
+		(pps == 1 && gateType == 0) ? 2 :// clock high
+		gateType == 11 ? (ppqnCount == 0 ? 3 : 0) :// trig on first ppqnCount
+		(int)((advGateHitMask[gateType] >> (ppqnCount * (res / pps) * 24 / res)) & 0x1);
+}
+constexpr int calcAdvGateCode(int gateType, int ppsIndex, int ppqnCount, int res) {
+	return calcAdvGateCodePps(gateType, ppsIndex == 0 ? 1 : ppsIndex * 2, ppqnCount, res);
+}
+
+template <int... Is> struct IntSeq {};
+template <int N, int... Is> struct MakeIntSeq : MakeIntSeq<N - 1, N - 1, Is...> {};
+template <int... Is> struct MakeIntSeq<0, Is...> : IntSeq<Is...> {};
+
+template <int RES>
+struct AdvGateRow {int8_t codes[RES];};
+template <int RES, int NUM_PPS>
+struct AdvGatePlane {AdvGateRow<RES> rows[NUM_PPS];};
+template <int RES, int NUM_PPS>
+struct AdvGateTable {AdvGatePlane<RES, NUM_PPS> planes[NUM_ADV_GATE_CODES];};
+
+template <int RES, int... Q>
+constexpr AdvGateRow<RES> makeAdvGateRow(int gateType, int ppsIndex, IntSeq<Q...>) {
+	return AdvGateRow<RES>{{(int8_t)calcAdvGateCode(gateType, ppsIndex, Q, RES)...}};
+}
+template <int RES, int NUM_PPS, int... P>
+constexpr AdvGatePlane<RES, NUM_PPS> makeAdvGatePlane(int gateType, IntSeq<P...>) {
+	return AdvGatePlane<RES, NUM_PPS>{{makeAdvGateRow<RES>(gateType, P, MakeIntSeq<RES>())...}};
+}
+template <int RES, int NUM_PPS, int... G>
+constexpr AdvGateTable<RES, NUM_PPS> makeAdvGateTable(IntSeq<G...>) {
+	return AdvGateTable<RES, NUM_PPS>{{makeAdvGatePlane<RES, NUM_PPS>(G, MakeIntSeq<NUM_PPS>())...}};
+}
+
+template <int RES, int NUM_PPS>
+struct AdvGateCodes {
+	static constexpr AdvGateTable<RES, NUM_PPS> table = makeAdvGateTable<RES, NUM_PPS>(MakeIntSeq<NUM_ADV_GATE_CODES>());
+
+	static inline int get(int gateType, int ppsIndex, int ppqnCount) {
+		return table.planes[gateType].rows[ppsIndex].codes[ppqnCount];
+	}
+};
+template <int RES, int NUM_PPS>
+constexpr AdvGateTable<RES, NUM_PPS> AdvGateCodes<RES, NUM_PPS>::table;
+
+
+// Number of samples between two light/display refreshes at the given sample rate: displayRefreshStepSkips is scaled by a
+//   power of two so that the refresh rates stay about the same as at 44.1kHz (inputs ~2.8kHz, lights ~170Hz) up to 192kHz and above
+inline unsigned int calcDisplayRefreshStepSkips(float sampleRate) {
+	unsigned int skips = displayRefreshStepSkips;
+	while (sampleRate * (float)displayRefreshStepSkips > 66150.0f * (float)skips)// 1.5 * 44100
+		skips <<= 1;
+	return skips;
+}
+
+
+// Control-rate scheduler used by all modules' step(): user inputs are processed when processInputs() is true,
+//   lights and displays when processLights() is true (call both once per sample, in that order).
+// Each instance starts at a random phase so that the light refreshes of all the modules in a patch don't land on the same sample.
+// lightSkips is the number of samples between two light refreshes, use it to convert seconds to light refreshes (and for smoothing)
+struct RefreshCounter {
+	unsigned int counter;
+	unsigned int inputsMask;
+	unsigned int lightSkips;
+	
+	RefreshCounter() {
+		setSampleRate(engineGetSampleRate());
+		counter = randomu32() % lightSkips;
+	}
+	void setSampleRate(float sampleRate) {
+		lightSkips = calcDisplayRefreshStepSkips(sampleRate);
+		inputsMask = ((userInputsStepSkipMask + 1) * (lightSkips / displayRefreshStepSkips)) - 1;
+	}
+	
+	inline bool processInputs() {
+		return (counter & inputsMask) == 0;
+	}
+	inline bool processLights() {// sample rate changes are picked up here, at the end of a light interval
+		counter++;
+		if (counter >= lightSkips) {
+			counter = 0;
+			setSampleRate(engineGetSampleRate());
+			return true;
+		}
+		return false;
+	}
+	
+	inline long calcIdleSteps() {// number of upcoming samples that will process neither inputs nor lights, see processBlockIdleRuns()
+		unsigned int toInputs = (inputsMask + 1 - (counter & inputsMask)) & inputsMask;
+		unsigned int toLights = lightSkips - 1 - counter;
+		return (long)std::min(toInputs, toLights);
+	}
+	inline void skipIdleSteps(long n) {
+		counter += (unsigned int)n;
+	}
+};
+
+
+// Edits made by the widgets (context menus, right-click on knobs) are not written into the module directly, since step() may be
+//   running at the same time on the engine thread: the UI thread pushes them here and step() applies them when it processes
+//   its user inputs. Single producer (UI thread), single consumer (engine thread), lock-free.
+struct EditCommand {
+	int id;// see the module's EditIds
+	int value;
+};
+
+struct EditQueue {
+	static const unsigned int SIZE = 32;// must be a power of 2
+	EditCommand commands[SIZE];
+	std::atomic<unsigned int> head;// next write, only written by the producer
+	std::atomic<unsigned int> tail;// next read, only written by the consumer
+	
+	EditQueue() {
+		head.store(0);
+		tail.store(0);
+	}
+	
+	bool push(int id, int value = 0) {// returns false when full, in which case the edit is dropped
+		unsigned int h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) >= SIZE)
+			return false;
+		commands[h & (SIZE - 1)].id = id;
+		commands[h & (SIZE - 1)].value = value;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+	inline bool pop(EditCommand *command) {
+		unsigned int t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire))
+			return false;
+		*command = commands[t & (SIZE - 1)];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+
+// Block processing for the sequencers, for hosts (and the bench) that work on buffers rather than one sample at a time
+// inBufs and outBufs are indexed by input and output id; an input with a NULL buffer keeps its current value for the whole
+//   block, an output with a NULL buffer is not written.
+struct BlockProcessor {
+	virtual ~BlockProcessor() {}
+	virtual void processBlock(int frames, const float* const* inBufs, float* const* outBufs) = 0;
+};
+
+// Between clock edges a sequencer's step() mostly recomputes the same outputs, so processBlock() only calls step() where
+//   something can happen: an input changes, an input or light refresh is due, or the module itself is not idle (slides,
+//   trigger gates). The outputs of the frames in between are filled in runs with the values of the last step(), and the
+//   per-sample counters are advanced in one go. TModule provides calcIdleSteps() (how many samples it can skip when its
+//   inputs don't change) and skipIdleSteps(n), as well as a RefreshCounter named refresh.
+// The module must also have been idle before the last step(), since a step() that ends a slide still outputs its last value.
+template <class TModule>
+void processBlockIdleRuns(TModule *module, int frames, const float* const* inBufs, float* const* outBufs) {
+	int numInputs = (int)module->inputs.size();
+	int numOutputs = (int)module->outputs.size();
+	long idleSteps = module->calcIdleSteps();
+	int i = 0;
+	while (i < frames) {
+		for (int in = 0; in < numInputs; in++) {
+			if (inBufs[in])
+				module->inputs[in].value = inBufs[in][i];
+		}
+		bool wasIdle = idleSteps > 0;
+		module->step();
+		idleSteps = module->calcIdleSteps();
+		for (int out = 0; out < numOutputs; out++) {
+			if (outBufs[out])
+				outBufs[out][i] = module->outputs[out].value;
+		}
+		i++;
+		
+		long run = wasIdle ? std::min((long)(frames - i), std::min(module->refresh.calcIdleSteps(), idleSteps)) : 0l;
+		for (int in = 0; in < numInputs && run > 0; in++) {// inputs must be bit-identical to the ones step() just saw
+			if (!inBufs[in])
+				continue;
+			uint32_t lastBits;
+			memcpy(&lastBits, &module->inputs[in].value, sizeof(lastBits));
+			long j = 0;
+			for (; j < run; j++) {
+				uint32_t bits;
+				memcpy(&bits, &inBufs[in][i + j], sizeof(bits));
+				if (bits != lastBits)
+					break;
+			}
+			run = j;
+		}
+		if (run > 0) {
+			for (int out = 0; out < numOutputs; out++) {
+				if (outBufs[out])
+					std::fill(outBufs[out] + i, outBufs[out] + i + run, module->outputs[out].value);
+			}
+			module->refresh.skipIdleSteps(run);
+			module->skipIdleSteps(run);
+			i += (int)run;
+		}
+	}
+}
+
+
+#ifdef IM_CPU_METER
+// Per-section CPU accounting of a module's step(), only compiled in when IM_CPU_METER is defined (see Makefile)
+// Sections are timed back to back: begin() at the top of step(), mark(sect) at the end of each section, end() at the bottom.
+// Sections that are skipped on a given sample (inputs and lights) are simply not marked, so their histograms hold one entry per execution.
+struct CpuMeter {
+	enum SectionIds {SECT_INPUTS, SECT_CLOCK, SECT_OUTPUTS, SECT_LIGHTS, SECT_SYNTH, SECT_STEP, NUM_SECTS};// SECT_SYNTH only used by SMS16
+	static const int NUM_BINS = 96;// 4 bins per octave, so up to 2^24 ticks
+	static const uint32_t decayInterval = 0x10000;// in samples; all counts are halved at this interval, which makes the histograms rolling
+	
+	uint64_t stepStart;
+	uint64_t sectStart;
+	uint32_t samples;
+	uint32_t counts[NUM_SECTS];
+	uint64_t sums[NUM_SECTS];
+	uint32_t bins[NUM_SECTS][NUM_BINS];
+	
+	
+	CpuMeter() {
+		reset();
+	}
+	void reset();
+	
+	static inline uint64_t now() {// CPU cycles when available, else nanoseconds
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+	static inline const char* unitName() {
+#if defined(__x86_64__) || defined(__i386__)
+		return "cycles";
+#else
+		return "ns";
+#endif
+	}
+	
+	inline void begin() {
+		stepStart = now();
+		sectStart = stepStart;
+	}
+	inline void mark(int sect) {
+		uint64_t t = now();
+		add(sect, t - sectStart);
+		sectStart = t;
+	}
+	inline void end() {
+		add(SECT_STEP, now() - stepStart);
+		samples++;
+		if (samples >= decayInterval)
+			decay();
+	}
+	inline void add(int sect, uint64_t elapsed) {
+		int bin = (int)elapsed;
+		if (elapsed >= 4) {
+			int log2e = 63 - __builtin_clzll(elapsed);
+			bin = 4 * (log2e - 1) + (int)((elapsed >> (log2e - 2)) & 0x3);
+			if (bin >= NUM_BINS)
+				bin = NUM_BINS - 1;
+		}
+		bins[sect][bin]++;
+		counts[sect]++;
+		sums[sect] += elapsed;
+	}
+	void decay();
+	
+	float mean(int sect);// per execution of the section
+	float percentile(int sect, float fraction);// upper edge of the bin, per execution of the section
+	float perSample(int sect);// amortized over all samples, what the section really costs the engine
+};
+
+#define IM_CPU_METER_BEGIN(meter) (meter).begin()
+#define IM_CPU_METER_MARK(meter, sect) (meter).mark(CpuMeter::sect)
+#define IM_CPU_METER_END(meter) (meter).end()
+
+void addCpuMeterMenu(Menu *menu, CpuMeter *cpuMeter);
+#else
+#define IM_CPU_METER_BEGIN(meter)
+#define IM_CPU_METER_MARK(meter, sect)
+#define IM_CPU_METER_END(meter)
+#endif
+
+
 inline bool calcWarningFlash(long count, long countInit) {
 	if ( (count > (countInit * 2l / 4l) && count < (countInit * 3l / 4l)) || (count < (countInit * 1l / 4l)) )
 		return false;
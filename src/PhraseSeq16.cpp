@@ -16,7 +16,7 @@
 #include "PhraseSeqUtil.hpp"
 
 
-struct PhraseSeq16 : Module {
+struct PhraseSeq16 : Module, BlockProcessor {
 	enum ParamIds {
 		KEYNOTE_PARAM,// 0.6.12 replaces unused
 		KEYGATE_PARAM,// 0.6.12 replaces unused
@@ -99,6 +99,7 @@ struct PhraseSeq16 : Module {
 		ENUMS(KEYGATE_LIGHT, 2),// room for GreenRed
 		NUM_LIGHTS
 	};
+	enum EditIds {EDIT_PANEL_THEME, EDIT_EXPANSION, EDIT_RESET_ON_RUN, EDIT_AUTOSEQ, EDIT_HOLD_TIED, EDIT_SLIDE_SHAPE, EDIT_SEQCV_METHOD, EDIT_SEQUENCE_KNOB_DEFAULT};// see applyEdit()
 	
 	// Constants
 	enum DisplayStateIds {DISP_NORMAL, DISP_MODE, DISP_LENGTH, DISP_TRANSPOSE, DISP_ROTATE};
@@ -108,6 +109,7 @@ struct PhraseSeq16 : Module {
 	int expansion = 0;
 	bool autoseq;
 	bool holdTiedNotes = true;
+	int slideShape = SLIDE_LINEAR;// see SlideGenerator
 	int seqCVmethod = 0;// 0 is 0-10V, 1 is C4-D5#, 2 is TrigIncr
 	int pulsesPerStep;// 1 means normal gate mode, alt choices are 4, 6, 12, 24 PPS (Pulses per step)
 	bool running;
@@ -122,6 +124,7 @@ struct PhraseSeq16 : Module {
 	bool resetOnRun;
 	bool attached;
 	int transposeOffsets[16];
+	RandomGenerator rng;// see ImpromptuModular.hpp
 
 	// No need to save
 	int stepIndexEdit;
@@ -135,8 +138,7 @@ struct PhraseSeq16 : Module {
 	unsigned long stepIndexRunHistory;
 	unsigned long phraseIndexRunHistory;
 	int displayState;
-	unsigned long slideStepsRemain;// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta;// no need to initialize, this is a companion to slideStepsRemain
+	SlideGenerator slide;
 	float cvCPbuffer[16];// copy paste buffer for CVs
 	StepAttributes attribCPbuffer[16];
 	int phraseCPbuffer[16];
@@ -147,6 +149,7 @@ struct PhraseSeq16 : Module {
 	int rotateOffset;// no need to initialize, this is companion to displayMode = DISP_ROTATE
 	long clockIgnoreOnReset;
 	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
+	float clockFraction;// edge fraction of the last clock (see ClockTrigger), companion to clockPeriod
 	long tiedWarning;// 0 when no warning, positive downward step counter timer when warning
 	long attachedWarning;// 0 when no warning, positive downward step counter timer when warning
 	int gate1Code;
@@ -158,14 +161,18 @@ struct PhraseSeq16 : Module {
 	int ppqnCount;
 
 	
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
+	EditQueue editQueue;// edits from the widgets, see ImpromptuModular.hpp
+#ifdef IM_CPU_METER
+	CpuMeter cpuMeter;
+#endif
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	SchmittTrigger resetTrigger;
 	SchmittTrigger leftTrigger;
 	SchmittTrigger rightTrigger;
 	SchmittTrigger runningTrigger;
-	SchmittTrigger clockTrigger;
+	ClockTrigger clockTrigger;
 	SchmittTrigger octTriggers[7];
 	SchmittTrigger octmTrigger;
 	SchmittTrigger gate1Trigger;
@@ -226,9 +233,10 @@ struct PhraseSeq16 : Module {
 		editingGate = 0ul;
 		infoCopyPaste = 0l;
 		displayState = DISP_NORMAL;
-		slideStepsRemain = 0ul;
+		slide.reset();
 		attached = false;
 		clockPeriod = 0ul;
+		clockFraction = 0.0f;
 		tiedWarning = 0ul;
 		attachedWarning = 0l;
 		revertDisplay = 0l;
@@ -241,18 +249,18 @@ struct PhraseSeq16 : Module {
 
 	
 	void onRandomize() override {
-		runModeSong = randomu32() % 5;
+		runModeSong = rng.u32() % 5;
 		stepIndexEdit = 0;
 		phraseIndexEdit = 0;
-		sequence = randomu32() % 16;
-		phrases = 1 + (randomu32() % 16);
+		sequence = rng.u32() % 16;
+		phrases = 1 + (rng.u32() % 16);
 		for (int i = 0; i < 16; i++) {
-			runModeSeq[i] = randomu32() % (NUM_MODES - 1);
-			phrase[i] = randomu32() % 16;
-			lengths[i] = 1 + (randomu32() % 16);
+			runModeSeq[i] = rng.u32() % (NUM_MODES - 1);
+			phrase[i] = rng.u32() % 16;
+			lengths[i] = 1 + (rng.u32() % 16);
 			for (int s = 0; s < 16; s++) {
-				cv[i][s] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
-				attributes[i][s].randomize();
+				cv[i][s] = ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f;
+				attributes[i][s].randomize(&rng);
 				if (attributes[i][s].getTied()) {
 					activateTiedStep(i, s);
 				}
@@ -271,9 +279,9 @@ struct PhraseSeq16 : Module {
 		stepIndexRunHistory = 0;
 
 		ppqnCount = 0;
-		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
+		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value, &rng);
 		gate2Code = calcGate2Code(attributes[seq][stepIndexRun], 0, pulsesPerStep);
-		slideStepsRemain = 0ul;
+		slide.reset();
 	}
 	
 	
@@ -292,6 +300,9 @@ struct PhraseSeq16 : Module {
 		// holdTiedNotes
 		json_object_set_new(rootJ, "holdTiedNotes", json_boolean(holdTiedNotes));
 		
+		// slideShape
+		json_object_set_new(rootJ, "slideShape", json_integer(slideShape));
+		
 		// seqCVmethod
 		json_object_set_new(rootJ, "seqCVmethod", json_integer(seqCVmethod));
 
@@ -362,6 +373,9 @@ struct PhraseSeq16 : Module {
 			json_array_insert_new(transposeOffsetsJ, i, json_integer(transposeOffsets[i]));
 		json_object_set_new(rootJ, "transposeOffsets", transposeOffsetsJ);
 
+		// rng
+		json_object_set_new(rootJ, "rng", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -388,6 +402,11 @@ struct PhraseSeq16 : Module {
 		else
 			holdTiedNotes = false;// legacy
 		
+		// slideShape
+		json_t *slideShapeJ = json_object_get(rootJ, "slideShape");
+		if (slideShapeJ)
+			slideShape = clamp((int)json_integer_value(slideShapeJ), 0, NUM_SLIDE_SHAPES - 1);
+		
 		// seqCVmethod
 		json_t *seqCVmethodJ = json_object_get(rootJ, "seqCVmethod");
 		if (seqCVmethodJ)
@@ -598,6 +617,9 @@ struct PhraseSeq16 : Module {
 			}			
 		}
 		
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
+
 		// Initialize dependants after everything loaded
 		initRun();
 	}
@@ -627,7 +649,84 @@ struct PhraseSeq16 : Module {
 	}
 	
 
+	void applyEdit(EditCommand command) {
+		switch (command.id) {
+			case EDIT_PANEL_THEME :
+				panelTheme = command.value;
+			break;
+			case EDIT_EXPANSION :
+				expansion = expansion == 1 ? 0 : 1;
+			break;
+			case EDIT_RESET_ON_RUN :
+				resetOnRun = !resetOnRun;
+			break;
+			case EDIT_AUTOSEQ :
+				autoseq = !autoseq;
+			break;
+			case EDIT_HOLD_TIED :
+				holdTiedNotes = !holdTiedNotes;
+			break;
+			case EDIT_SLIDE_SHAPE :
+				slideShape++;
+				if (slideShape >= NUM_SLIDE_SHAPES)
+					slideShape = SLIDE_LINEAR;
+			break;
+			case EDIT_SEQCV_METHOD :
+				seqCVmethod++;
+				if (seqCVmethod > 2)
+					seqCVmethod = 0;
+			break;
+			case EDIT_SEQUENCE_KNOB_DEFAULT :
+				sequenceKnobDefault();
+			break;
+		}
+	}
+	
+	void sequenceKnobDefault() {// right-click on the sequence knob
+		// same code structure below as in sequence knob in main step()
+		if (editingPpqn != 0) {
+			pulsesPerStep = 1;
+			//editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
+		}
+		else if (displayState == DISP_MODE) {
+			if (isEditingSequence()) {
+				if (!inputs[MODECV_INPUT].active) {
+					runModeSeq[sequence] = MODE_FWD;
+				}
+			}
+			else {
+				runModeSong = MODE_FWD;
+			}
+		}
+		else if (displayState == DISP_LENGTH) {
+			if (isEditingSequence()) {
+				lengths[sequence] = 16;
+			}
+			else {
+				phrases = 4;
+			}
+		}
+		else if (displayState == DISP_TRANSPOSE) {
+			// nothing
+		}
+		else if (displayState == DISP_ROTATE) {
+			// nothing			
+		}
+		else {// DISP_NORMAL
+			if (isEditingSequence()) {
+				if (!inputs[SEQCV_INPUT].active) {
+					sequence = 0;;
+				}
+			}
+			else {
+				phrase[phraseIndexEdit] = 0;
+			}
+		}
+	}
+	
+	
 	void step() override {
+		IM_CPU_METER_BEGIN(cpuMeter);
 		float sampleRate = engineGetSampleRate();
 		static const float gateTime = 0.4f;// seconds
 		static const float copyPasteInfoTime = 0.5f;// seconds
@@ -652,8 +751,12 @@ struct PhraseSeq16 : Module {
 			displayState = DISP_NORMAL;
 		}
 
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
-
+		if (refresh.processInputs()) {
+			// Edits from the widgets
+			EditCommand editCommand;
+			while (editQueue.pop(&editCommand))
+				applyEdit(editCommand);
+			
 			// Seq CV input
 			if (inputs[SEQCV_INPUT].active) {
 				if (seqCVmethod == 0) {// 0-10 V
@@ -711,12 +814,12 @@ struct PhraseSeq16 : Module {
 						phraseCPbuffer[i] = phrase[p];
 					lengthCPbuffer = -1;// so that a cross paste can be detected
 				}
-				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}
 			// Paste button
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
-				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				startCP = 0;
 				if (countCP <= 8) {
 					startCP = editingSequence ? stepIndexEdit : phraseIndexEdit;
@@ -747,12 +850,12 @@ struct PhraseSeq16 : Module {
 						}
 						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (randomize CVs)
 							for (int s = 0; s < 16; s++)
-								cv[sequence][s] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
+								cv[sequence][s] = ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f;
 							transposeOffsets[sequence] = 0;
 						}
 						else {// 8 (randomize gate 1)
 							for (int s = 0; s < 16; s++)
-								if ( (randomu32() & 0x1) != 0)
+								if ( (rng.u32() & 0x1) != 0)
 									attributes[sequence][s].toggleGate1();
 						}
 						startCP = 0;
@@ -776,7 +879,7 @@ struct PhraseSeq16 : Module {
 						}
 						else {// 8 (randomize phrases)
 							for (int p = 0; p < 16; p++)
-								phrase[p] = randomu32() % 16;
+								phrase[p] = rng.u32() % 16;
 						}
 						startCP = 0;
 						countCP = 16;
@@ -795,7 +898,7 @@ struct PhraseSeq16 : Module {
 						cv[sequence][stepIndexEdit] = inputs[CV_INPUT].value;
 						propagateCVtoTied(sequence, stepIndexEdit);
 					}
-					editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+					editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 					editingGateCV = inputs[CV_INPUT].value;// cv[sequence][stepIndexEdit];
 					editingGateKeyLight = -1;
 					// Autostep (after grab all active inputs)
@@ -834,7 +937,7 @@ struct PhraseSeq16 : Module {
 							stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, 16);
 							if (!attributes[sequence][stepIndexEdit].getTied()) {// play if non-tied step
 								if (!writeTrig) {// in case autostep when simultaneous writeCV and stepCV (keep what was done in Write Input block above)
-									editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+									editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 									editingGateCV = cv[sequence][stepIndexEdit];
 									editingGateKeyLight = -1;
 								}
@@ -861,14 +964,14 @@ struct PhraseSeq16 : Module {
 						lengths[sequence] = stepPressed + 1;
 					else
 						phrases = stepPressed + 1;
-					revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+					revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 				}
 				else {
 					if (!running || !attached) {// not running or detached
 						if (editingSequence) {
 							stepIndexEdit = stepPressed;
 							if (!attributes[sequence][stepIndexEdit].getTied()) {// play if non-tied step
-								editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+								editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 								editingGateCV = cv[sequence][stepIndexEdit];
 								editingGateKeyLight = -1;
 							}
@@ -880,7 +983,7 @@ struct PhraseSeq16 : Module {
 						}
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					displayState = DISP_NORMAL;
 				}
 			} 
@@ -895,7 +998,7 @@ struct PhraseSeq16 : Module {
 					displayState = DISP_MODE;
 				else
 					displayState = DISP_NORMAL;
-				modeHoldDetect.start((long) (holdDetectTime * sampleRate / displayRefreshStepSkips));
+				modeHoldDetect.start((long) (holdDetectTime * sampleRate / refresh.lightSkips));
 			}
 			
 			// Transpose/Rotate button
@@ -924,7 +1027,7 @@ struct PhraseSeq16 : Module {
 					// any changes in here should may also require right click behavior to be updated in the knob's onMouseDown()
 					if (editingPpqn != 0) {
 						pulsesPerStep = indexToPps(ppsToIndex(pulsesPerStep) + deltaKnob);// indexToPps() does clamping
-						editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+						editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 					}
 					else if (displayState == DISP_MODE) {
 						if (editingSequence) {
@@ -991,11 +1094,11 @@ struct PhraseSeq16 : Module {
 			if (newOct >= 0 && newOct <= 6) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else {			
 						cv[sequence][stepIndexEdit] = applyNewOct(cv[sequence][stepIndexEdit], newOct);
 						propagateCVtoTied(sequence, stepIndexEdit);
-						editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+						editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 						editingGateCV = cv[sequence][stepIndexEdit];
 						editingGateKeyLight = -1;
 					}
@@ -1018,18 +1121,18 @@ struct PhraseSeq16 : Module {
 									stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 16);
 							}
 							else
-								editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+								editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 						}
 						else if (attributes[sequence][stepIndexEdit].getTied()) {
 							if (params[KEY_PARAMS + i].value > 1.5f)
 								stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 16);
 							else
-								tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+								tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 						}
 						else {			
 							cv[sequence][stepIndexEdit] = floor(cv[sequence][stepIndexEdit]) + ((float) i) / 12.0f;
 							propagateCVtoTied(sequence, stepIndexEdit);
-							editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+							editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 							editingGateCV = cv[sequence][stepIndexEdit];
 							editingGateKeyLight = -1;
 							if (params[KEY_PARAMS + i].value > 1.5f) {
@@ -1066,7 +1169,7 @@ struct PhraseSeq16 : Module {
 			if (gate1ProbTrigger.process(params[GATE1_PROB_PARAM].value)) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else
 						attributes[sequence][stepIndexEdit].toggleGate1P();
 				}
@@ -1081,7 +1184,7 @@ struct PhraseSeq16 : Module {
 			if (slideTrigger.process(params[SLIDE_BTN_PARAM].value + inputs[SLIDECV_INPUT].value)) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else
 						attributes[sequence][stepIndexEdit].toggleSlide();
 				}
@@ -1099,6 +1202,7 @@ struct PhraseSeq16 : Module {
 				displayState = DISP_NORMAL;
 			}
 		
+			IM_CPU_METER_MARK(cpuMeter, SECT_INPUTS);
 		}// userInputs refresh
 		
 		
@@ -1117,12 +1221,12 @@ struct PhraseSeq16 : Module {
 					float slideFromCV = 0.0f;
 					if (editingSequence) {
 						slideFromCV = cv[sequence][stepIndexRun];
-						moveIndexRunMode(&stepIndexRun, lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory);
+						moveIndexRunMode(&stepIndexRun, lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory, &rng);
 					}
 					else {
 						slideFromCV = cv[phrase[phraseIndexRun]][stepIndexRun];
-						if (moveIndexRunMode(&stepIndexRun, lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
+						if (moveIndexRunMode(&stepIndexRun, lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory, &rng)) {
+							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory, &rng);
 							stepIndexRun = (runModeSeq[phrase[phraseIndexRun]] == MODE_REV ? lengths[phrase[phraseIndexRun]] - 1 : 0);// must always refresh after phraseIndexRun has changed
 						}
 						newSeq = phrase[phraseIndexRun];
@@ -1130,24 +1234,24 @@ struct PhraseSeq16 : Module {
 					
 					// Slide
 					if (attributes[newSeq][stepIndexRun].getSlide()) {
-						slideStepsRemain =   (unsigned long) (((float)clockPeriod * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f);
-						if (slideStepsRemain != 0ul) {
-							float slideToCV = cv[newSeq][stepIndexRun];
-							slideCVdelta = (slideToCV - slideFromCV)/(float)slideStepsRemain;
-						}
+						float slideSteps = (((float)clockPeriod + clockFraction - clockTrigger.edgeFraction) * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f;// period between the estimated edges
+						slide.reset();
+						if (slideSteps >= 1.0f)
+							slide.start(slideFromCV, cv[newSeq][stepIndexRun], slideSteps, clockTrigger.edgeFraction, slideShape);
 					}
-					else
-						slideStepsRemain = 0ul;
+					else 
+						slide.reset();
 				}
 				else {
 					if (!editingSequence)
 						newSeq = phrase[phraseIndexRun];
 				}
 				if (gate1Code != -1 || ppqnCount == 0)
-					gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
+					gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value, &rng);
 				gate2Code = calcGate2Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep);						 
 			}
 			clockPeriod = 0ul;
+			clockFraction = clockTrigger.edgeFraction;
 		}	
 		clockPeriod++;
 		
@@ -1162,6 +1266,8 @@ struct PhraseSeq16 : Module {
 		}
 		
 		
+		IM_CPU_METER_MARK(cpuMeter, SECT_CLOCK);
+		
 		//********** Outputs and lights **********
 				
 		// CV and gates outputs
@@ -1170,8 +1276,7 @@ struct PhraseSeq16 : Module {
 		if (running) {
 			bool muteGate1 = !editingSequence && ((params[GATE1_PARAM].value + inputs[GATE1CV_INPUT].value) > 0.5f);// live mute
 			bool muteGate2 = !editingSequence && ((params[GATE2_PARAM].value + inputs[GATE2CV_INPUT].value) > 0.5f);// live mute
-			float slideOffset = (slideStepsRemain > 0ul ? (slideCVdelta * (float)slideStepsRemain) : 0.0f);
-			outputs[CV_OUTPUT].value = cv[seq][step] - slideOffset;
+			outputs[CV_OUTPUT].value = cv[seq][step] - slide.getOffset();
 			outputs[GATE1_OUTPUT].value = (calcGate(gate1Code, clockTrigger, clockPeriod, sampleRate) && !muteGate1) ? 10.0f : 0.0f;
 			outputs[GATE2_OUTPUT].value = (calcGate(gate2Code, clockTrigger, clockPeriod, sampleRate) && !muteGate2) ? 10.0f : 0.0f;
 		}
@@ -1180,12 +1285,11 @@ struct PhraseSeq16 : Module {
 			outputs[GATE1_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 			outputs[GATE2_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 		}
-		if (slideStepsRemain > 0ul)
-			slideStepsRemain--;
+		slide.advance();
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		IM_CPU_METER_MARK(cpuMeter, SECT_OUTPUTS);
+
+		if (refresh.processLights()) {
 
 			// Step/phrase lights
 			if (infoCopyPaste != 0l) {
@@ -1251,7 +1355,7 @@ struct PhraseSeq16 : Module {
 					lights[OCTAVE_LIGHTS + i].value = 0.0f;
 				else {
 					if (tiedWarning > 0l) {
-						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 						lights[OCTAVE_LIGHTS + i].value = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
 					}
 					else				
@@ -1303,12 +1407,12 @@ struct PhraseSeq16 : Module {
 						lights[KEY_LIGHTS + i * 2 + 1].value = 0.0f;
 					else {
 						if (tiedWarning > 0l) {
-							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 							lights[KEY_LIGHTS + i * 2 + 1].value = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
 						}
 						else {
 							if (editingGate > 0ul && editingGateKeyLight != -1)
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / refresh.lightSkips)) : 0.0f);
 							else
 								lights[KEY_LIGHTS + i * 2 + 1].value = (i == keyLightIndex ? 1.0f : 0.0f);
 						}
@@ -1345,7 +1449,7 @@ struct PhraseSeq16 : Module {
 				lights[GATE1_PROB_LIGHT].value = attributesVal.getGate1P() ? 1.0f : 0.0f;
 				lights[SLIDE_LIGHT].value = attributesVal.getSlide() ? 1.0f : 0.0f;
 				if (tiedWarning > 0l) {
-					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 					lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 				}
 				else
@@ -1354,7 +1458,7 @@ struct PhraseSeq16 : Module {
 			
 			// Attach light
 			if (attachedWarning > 0l) {
-				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 			}
 			else
@@ -1362,7 +1466,7 @@ struct PhraseSeq16 : Module {
 			
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;	
-			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * refresh.lightSkips;
 			
 			// Run light
 			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
@@ -1383,20 +1487,37 @@ struct PhraseSeq16 : Module {
 				attachedWarning--;
 			if (modeHoldDetect.process(params[RUNMODE_PARAM].value)) {
 				displayState = DISP_NORMAL;
-				editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+				editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 			}
 			if (revertDisplay > 0l) {
 				if (revertDisplay == 1)
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
-		}// lightRefreshCounter
+			IM_CPU_METER_MARK(cpuMeter, SECT_LIGHTS);
+		}// processLights()
 		
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 
+		IM_CPU_METER_END(cpuMeter);
 	}// step()
 	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {
+		if (slide.isSliding())
+			return 0l;
+		float sampleRate = engineGetSampleRate();
+		return std::min(calcGateIdleSteps(gate1Code, clockPeriod, clockFraction, sampleRate), calcGateIdleSteps(gate2Code, clockPeriod, clockFraction, sampleRate));
+	}
+	inline void skipIdleSteps(long n) {
+		clockPeriod += (unsigned long)n;
+		clockIgnoreOnReset = std::max(clockIgnoreOnReset - n, 0l);
+	}
+	
 
 	inline void setGreenRed(int id, float green, float red) {
 		lights[id + 0].value = green;
@@ -1556,7 +1677,7 @@ struct PhraseSeq16Widget : ModuleWidget {
 		PhraseSeq16 *module;
 		int theme;
 		void onAction(EventAction &e) override {
-			module->panelTheme = theme;
+			module->editQueue.push(PhraseSeq16::EDIT_PANEL_THEME, theme);
 		}
 		void step() override {
 			rightText = (module->panelTheme == theme) ? "✔" : "";
@@ -1565,33 +1686,45 @@ struct PhraseSeq16Widget : ModuleWidget {
 	struct ExpansionItem : MenuItem {
 		PhraseSeq16 *module;
 		void onAction(EventAction &e) override {
-			module->expansion = module->expansion == 1 ? 0 : 1;
+			module->editQueue.push(PhraseSeq16::EDIT_EXPANSION);
 		}
 	};
 	struct ResetOnRunItem : MenuItem {
 		PhraseSeq16 *module;
 		void onAction(EventAction &e) override {
-			module->resetOnRun = !module->resetOnRun;
+			module->editQueue.push(PhraseSeq16::EDIT_RESET_ON_RUN);
 		}
 	};
 	struct AutoseqItem : MenuItem {
 		PhraseSeq16 *module;
 		void onAction(EventAction &e) override {
-			module->autoseq = !module->autoseq;
+			module->editQueue.push(PhraseSeq16::EDIT_AUTOSEQ);
 		}
 	};
+	struct SlideShapeItem : MenuItem {
+		PhraseSeq16 *module;
+		void onAction(EventAction &e) override {
+			module->editQueue.push(PhraseSeq16::EDIT_SLIDE_SHAPE);
+		}
+		void step() override {
+			if (module->slideShape == SLIDE_LINEAR)
+				text = "Slide: <Linear>,  Exponential,  Logarithmic";
+			else if (module->slideShape == SLIDE_EXP)
+				text = "Slide: Linear,  <Exponential>,  Logarithmic";
+			else
+				text = "Slide: Linear,  Exponential,  <Logarithmic>";
+		}	
+	};
 	struct HoldTiedItem : MenuItem {
 		PhraseSeq16 *module;
 		void onAction(EventAction &e) override {
-			module->holdTiedNotes = !module->holdTiedNotes;
+			module->editQueue.push(PhraseSeq16::EDIT_HOLD_TIED);
 		}
 	};
 	struct SeqCVmethodItem : MenuItem {
 		PhraseSeq16 *module;
 		void onAction(EventAction &e) override {
-			module->seqCVmethod++;
-			if (module->seqCVmethod > 2)
-				module->seqCVmethod = 0;
+			module->editQueue.push(PhraseSeq16::EDIT_SEQCV_METHOD);
 		}
 		void step() override {
 			if (module->seqCVmethod == 0)
@@ -1645,6 +1778,10 @@ struct PhraseSeq16Widget : ModuleWidget {
 		holdItem->module = module;
 		menu->addChild(holdItem);
 
+		SlideShapeItem *slideItem = MenuItem::create<SlideShapeItem>("Slide: ", "");
+		slideItem->module = module;
+		menu->addChild(slideItem);
+
 		SeqCVmethodItem *seqcvItem = MenuItem::create<SeqCVmethodItem>("Seq CV in: ", "");
 		seqcvItem->module = module;
 		menu->addChild(seqcvItem);
@@ -1659,6 +1796,10 @@ struct PhraseSeq16Widget : ModuleWidget {
 		expItem->module = module;
 		menu->addChild(expItem);
 		
+#ifdef IM_CPU_METER
+		addCpuMeterMenu(menu, &module->cpuMeter);// ImpromptuModular.hpp
+#endif
+
 		return menu;
 	}	
 	
@@ -1678,47 +1819,8 @@ struct PhraseSeq16Widget : ModuleWidget {
 		SequenceKnob() {};		
 		void onMouseDown(EventMouseDown &e) override {// from ParamWidget.cpp
 			PhraseSeq16* module = dynamic_cast<PhraseSeq16*>(this->module);
-			if (e.button == 1) {
-				// same code structure below as in sequence knob in main step()
-				if (module->editingPpqn != 0) {
-					module->pulsesPerStep = 1;
-					//editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
-				}
-				else if (module->displayState == PhraseSeq16::DISP_MODE) {
-					if (module->isEditingSequence()) {
-						if (!module->inputs[PhraseSeq16::MODECV_INPUT].active) {
-							module->runModeSeq[module->sequence] = MODE_FWD;
-						}
-					}
-					else {
-						module->runModeSong = MODE_FWD;
-					}
-				}
-				else if (module->displayState == PhraseSeq16::DISP_LENGTH) {
-					if (module->isEditingSequence()) {
-						module->lengths[module->sequence] = 16;
-					}
-					else {
-						module->phrases = 4;
-					}
-				}
-				else if (module->displayState == PhraseSeq16::DISP_TRANSPOSE) {
-					// nothing
-				}
-				else if (module->displayState == PhraseSeq16::DISP_ROTATE) {
-					// nothing			
-				}
-				else {// DISP_NORMAL
-					if (module->isEditingSequence()) {
-						if (!module->inputs[PhraseSeq16::SEQCV_INPUT].active) {
-							module->sequence = 0;;
-						}
-					}
-					else {
-						module->phrase[module->phraseIndexEdit] = 0;
-					}
-				}
-			}
+			if (e.button == 1)
+				module->editQueue.push(PhraseSeq16::EDIT_SEQUENCE_KNOB_DEFAULT);// see sequenceKnobDefault()
 			ParamWidget::onMouseDown(e);
 		}
 	};	
@@ -1731,8 +1833,8 @@ struct PhraseSeq16Widget : ModuleWidget {
         panel = new DynamicSVGPanel();
         panel->mode = &module->panelTheme;
 		panel->expWidth = &expWidth;
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/PhraseSeq16.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/PhraseSeq16_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/PhraseSeq16.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/PhraseSeq16_dark.svg"));
         box.size = panel->box.size;
 		box.size.x = box.size.x - (1 - module->expansion) * expWidth;
         addChild(panel);		
@@ -1962,6 +2064,7 @@ fix tied bug that prevented correct tied propagation when editing beyond sequenc
 implement held tied notes option
 clear all attributes (gates, gatep, tied, slide) when cross-paste to seq ALL (CVs not affected)
 implement right-click initialization on main knob
+use a per-module random number generator (saved in the patch) instead of Rack's global one
 
 0.6.12:
 input refresh optimization
@@ -16,7 +16,7 @@
 #include "PhraseSeqUtil.hpp"
 
 
-struct PhraseSeq32 : Module {
+struct PhraseSeq32 : Module, BlockProcessor {
 	enum ParamIds {
 		LEFT_PARAM,
 		RIGHT_PARAM,
@@ -90,6 +90,7 @@ struct PhraseSeq32 : Module {
 		ENUMS(KEYGATE_LIGHT, 2),// room for GreenRed
 		NUM_LIGHTS
 	};
+	enum EditIds {EDIT_PANEL_THEME, EDIT_EXPANSION, EDIT_RESET_ON_RUN, EDIT_AUTOSEQ, EDIT_HOLD_TIED, EDIT_SLIDE_SHAPE, EDIT_SEQCV_METHOD, EDIT_SEQUENCE_KNOB_DEFAULT};// see applyEdit()
 	
 	// Constants
 	enum DisplayStateIds {DISP_NORMAL, DISP_MODE, DISP_LENGTH, DISP_TRANSPOSE, DISP_ROTATE};
@@ -100,6 +101,7 @@ struct PhraseSeq32 : Module {
 	int expansion = 0;
 	bool autoseq;
 	bool holdTiedNotes = true;
+	int slideShape = SLIDE_LINEAR;// see SlideGenerator
 	int seqCVmethod = 0;// 0 is 0-10V, 1 is C4-G6, 2 is TrigIncr
 	int pulsesPerStep;// 1 means normal gate mode, alt choices are 4, 6, 12, 24 PPS (Pulses per step)
 	bool running;
@@ -114,6 +116,7 @@ struct PhraseSeq32 : Module {
 	bool resetOnRun;
 	bool attached;
 	int transposeOffsets[32];
+	RandomGenerator rng;// see ImpromptuModular.hpp
 
 	// No need to save
 	int stepIndexEdit;
@@ -128,8 +131,7 @@ struct PhraseSeq32 : Module {
 	unsigned long stepIndexRunHistory;
 	unsigned long phraseIndexRunHistory;
 	int displayState;
-	unsigned long slideStepsRemain[2];// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta[2];// no need to initialize, this is a companion to slideStepsRemain
+	SlideGenerator slides[2];
 	float cvCPbuffer[32];// copy paste buffer for CVs
 	StepAttributes attribCPbuffer[32];
 	int phraseCPbuffer[32];
@@ -140,6 +142,7 @@ struct PhraseSeq32 : Module {
 	int rotateOffset;// no need to initialize, this is companion to displayMode = DISP_ROTATE
 	long clockIgnoreOnReset;
 	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
+	float clockFraction;// edge fraction of the last clock (see ClockTrigger), companion to clockPeriod
 	long tiedWarning;// 0 when no warning, positive downward step counter timer when warning
 	long attachedWarning;// 0 when no warning, positive downward step counter timer when warning
 	int gate1Code[2];
@@ -154,14 +157,18 @@ struct PhraseSeq32 : Module {
 	
 
 	int stepConfigSync = 0;// 0 means no sync requested, 1 means soft sync (no reset lengths), 2 means hard (reset lengths)
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
+	EditQueue editQueue;// edits from the widgets, see ImpromptuModular.hpp
+#ifdef IM_CPU_METER
+	CpuMeter cpuMeter;
+#endif
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	SchmittTrigger resetTrigger;
 	SchmittTrigger leftTrigger;
 	SchmittTrigger rightTrigger;
 	SchmittTrigger runningTrigger;
-	SchmittTrigger clockTrigger;
+	ClockTrigger clockTrigger;
 	SchmittTrigger octTriggers[7];
 	SchmittTrigger octmTrigger;
 	SchmittTrigger gate1Trigger;
@@ -195,7 +202,7 @@ struct PhraseSeq32 : Module {
 		if (runMode != MODE_RN2) 
 			stepIndexRun[1] = stepIndexRun[0];
 		else
-			stepIndexRun[1] = randomu32() % len;
+			stepIndexRun[1] = rng.u32() % len;
 	}
 	
 		
@@ -239,10 +246,11 @@ struct PhraseSeq32 : Module {
 		editingGate = 0ul;
 		infoCopyPaste = 0l;
 		displayState = DISP_NORMAL;
-		slideStepsRemain[0] = 0ul;
-		slideStepsRemain[1] = 0ul;
+		slides[0].reset();
+		slides[1].reset();
 		attached = false;
 		clockPeriod = 0ul;
+		clockFraction = 0.0f;
 		tiedWarning = 0ul;
 		attachedWarning = 0l;
 		attachedChanB = false;
@@ -257,19 +265,19 @@ struct PhraseSeq32 : Module {
 	
 	void onRandomize() override {
 		stepConfig = getStepConfig(params[CONFIG_PARAM].value);
-		runModeSong = randomu32() % 5;
+		runModeSong = rng.u32() % 5;
 		stepIndexEdit = 0;
 		phraseIndexEdit = 0;
-		sequence = randomu32() % 32;
-		phrases = 1 + (randomu32() % 32);
+		sequence = rng.u32() % 32;
+		phrases = 1 + (rng.u32() % 32);
 		for (int i = 0; i < 32; i++) {
-			runModeSeq[i] = randomu32() % NUM_MODES;
-			phrase[i] = randomu32() % 32;
-			lengths[i] = 1 + (randomu32() % (16 * stepConfig));
+			runModeSeq[i] = rng.u32() % NUM_MODES;
+			phrase[i] = rng.u32() % 32;
+			lengths[i] = 1 + (rng.u32() % (16 * stepConfig));
 			transposeOffsets[i] = 0;
 			for (int s = 0; s < 32; s++) {
-				cv[i][s] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
-				attributes[i][s].randomize();
+				cv[i][s] = ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f;
+				attributes[i][s].randomize(&rng);
 				if (attributes[i][s].getTied()) {
 					activateTiedStep(i, s);
 				}
@@ -290,11 +298,11 @@ struct PhraseSeq32 : Module {
 
 		ppqnCount = 0;
 		for (int i = 0; i < 2; i += stepConfig) {
-			gate1Code[i] = calcGate1Code(attributes[seq][(i * 16) + stepIndexRun[i]], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
+			gate1Code[i] = calcGate1Code(attributes[seq][(i * 16) + stepIndexRun[i]], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value, &rng);
 			gate2Code[i] = calcGate2Code(attributes[seq][(i * 16) + stepIndexRun[i]], 0, pulsesPerStep);
 		}
-		slideStepsRemain[0] = 0ul;
-		slideStepsRemain[1] = 0ul;
+		slides[0].reset();
+		slides[1].reset();
 	}	
 
 	
@@ -313,6 +321,9 @@ struct PhraseSeq32 : Module {
 		// holdTiedNotes
 		json_object_set_new(rootJ, "holdTiedNotes", json_boolean(holdTiedNotes));
 		
+		// slideShape
+		json_object_set_new(rootJ, "slideShape", json_integer(slideShape));
+		
 		// seqCVmethod
 		json_object_set_new(rootJ, "seqCVmethod", json_integer(seqCVmethod));
 
@@ -373,7 +384,7 @@ struct PhraseSeq32 : Module {
 		
 		// stepIndexEdit
 		json_object_set_new(rootJ, "stepIndexEdit", json_integer(stepIndexEdit));
-	
+
 		// phraseIndexEdit
 		json_object_set_new(rootJ, "phraseIndexEdit", json_integer(phraseIndexEdit));
 
@@ -383,6 +394,9 @@ struct PhraseSeq32 : Module {
 			json_array_insert_new(transposeOffsetsJ, i, json_integer(transposeOffsets[i]));
 		json_object_set_new(rootJ, "transposeOffsets", transposeOffsetsJ);
 
+		// rng
+		json_object_set_new(rootJ, "rng", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -410,6 +424,11 @@ struct PhraseSeq32 : Module {
 		else
 			holdTiedNotes = false;// legacy
 		
+		// slideShape
+		json_t *slideShapeJ = json_object_get(rootJ, "slideShape");
+		if (slideShapeJ)
+			slideShape = clamp((int)json_integer_value(slideShapeJ), 0, NUM_SLIDE_SHAPES - 1);
+		
 		// seqCVmethod
 		json_t *seqCVmethodJ = json_object_get(rootJ, "seqCVmethod");
 		if (seqCVmethodJ)
@@ -546,6 +565,9 @@ struct PhraseSeq32 : Module {
 			}			
 		}
 
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
+
 		stepConfigSync = 1;// signal a sync from fromJson so that step will get lengths from lengthsBuffer
 	}
 
@@ -575,7 +597,84 @@ struct PhraseSeq32 : Module {
 	}
 	
 
+	void applyEdit(EditCommand command) {
+		switch (command.id) {
+			case EDIT_PANEL_THEME :
+				panelTheme = command.value;
+			break;
+			case EDIT_EXPANSION :
+				expansion = expansion == 1 ? 0 : 1;
+			break;
+			case EDIT_RESET_ON_RUN :
+				resetOnRun = !resetOnRun;
+			break;
+			case EDIT_AUTOSEQ :
+				autoseq = !autoseq;
+			break;
+			case EDIT_HOLD_TIED :
+				holdTiedNotes = !holdTiedNotes;
+			break;
+			case EDIT_SLIDE_SHAPE :
+				slideShape++;
+				if (slideShape >= NUM_SLIDE_SHAPES)
+					slideShape = SLIDE_LINEAR;
+			break;
+			case EDIT_SEQCV_METHOD :
+				seqCVmethod++;
+				if (seqCVmethod > 2)
+					seqCVmethod = 0;
+			break;
+			case EDIT_SEQUENCE_KNOB_DEFAULT :
+				sequenceKnobDefault();
+			break;
+		}
+	}
+	
+	void sequenceKnobDefault() {// right-click on the sequence knob
+		// same code structure below as in sequence knob in main step()
+		if (editingPpqn != 0) {
+			pulsesPerStep = 1;
+			//editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
+		}
+		else if (displayState == DISP_MODE) {
+			if (isEditingSequence()) {
+				if (!inputs[MODECV_INPUT].active) {
+					runModeSeq[sequence] = MODE_FWD;
+				}
+			}
+			else {
+				runModeSong = MODE_FWD;
+			}
+		}
+		else if (displayState == DISP_LENGTH) {
+			if (isEditingSequence()) {
+				lengths[sequence] = 16;
+			}
+			else {
+				phrases = 4;
+			}
+		}
+		else if (displayState == DISP_TRANSPOSE) {
+			// nothing
+		}
+		else if (displayState == DISP_ROTATE) {
+			// nothing			
+		}
+		else {// DISP_NORMAL
+			if (isEditingSequence()) {
+				if (!inputs[SEQCV_INPUT].active) {
+					sequence = 0;;
+				}
+			}
+			else {
+				phrase[phraseIndexEdit] = 0;
+			}
+		}
+	}
+	
+	
 	void step() override {
+		IM_CPU_METER_BEGIN(cpuMeter);
 		float sampleRate = engineGetSampleRate();
 		static const float gateTime = 0.4f;// seconds
 		static const float copyPasteInfoTime = 0.5f;// seconds
@@ -603,8 +702,12 @@ struct PhraseSeq32 : Module {
 			displayState = DISP_NORMAL;
 		}
 
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
-
+		if (refresh.processInputs()) {
+			// Edits from the widgets
+			EditCommand editCommand;
+			while (editQueue.pop(&editCommand))
+				applyEdit(editCommand);
+			
 			// Config switch
 			if (stepConfigSync != 0) {
 				stepConfig = getStepConfig(params[CONFIG_PARAM].value);
@@ -684,12 +787,12 @@ struct PhraseSeq32 : Module {
 						phraseCPbuffer[i] = phrase[p];
 					lengthCPbuffer = -1;// so that a cross paste can be detected
 				}
-				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}
 			// Paste button
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
-				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				startCP = 0;
 				if (countCP <= 8) {
 					startCP = editingSequence ? stepIndexEdit : phraseIndexEdit;
@@ -720,12 +823,12 @@ struct PhraseSeq32 : Module {
 						}
 						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (randomize CVs)
 							for (int s = 0; s < 32; s++)
-								cv[sequence][s] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
+								cv[sequence][s] = ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f;
 							transposeOffsets[sequence] = 0;
 						}
 						else {// 8 (randomize gate 1)
 							for (int s = 0; s < 32; s++)
-								if ( (randomu32() & 0x1) != 0)
+								if ( (rng.u32() & 0x1) != 0)
 									attributes[sequence][s].toggleGate1();
 						}
 						startCP = 0;
@@ -749,7 +852,7 @@ struct PhraseSeq32 : Module {
 						}
 						else {// 8 (randomize phrases)
 							for (int p = 0; p < 32; p++)
-								phrase[p] = randomu32() % 32;
+								phrase[p] = rng.u32() % 32;
 						}
 						startCP = 0;
 						countCP = 32;
@@ -768,7 +871,7 @@ struct PhraseSeq32 : Module {
 						cv[sequence][stepIndexEdit] = inputs[CV_INPUT].value;
 						propagateCVtoTied(sequence, stepIndexEdit);
 					}
-					editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+					editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 					editingGateCV = inputs[CV_INPUT].value;// cv[sequence][stepIndexEdit];
 					editingGateKeyLight = -1;
 					editingChannel = (stepIndexEdit >= 16 * stepConfig) ? 1 : 0;
@@ -809,7 +912,7 @@ struct PhraseSeq32 : Module {
 							stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, 32);
 							if (!attributes[sequence][stepIndexEdit].getTied()) {// play if non-tied step
 								if (!writeTrig) {// in case autostep when simultaneous writeCV and stepCV (keep what was done in Write Input block above)
-									editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+									editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 									editingGateCV = cv[sequence][stepIndexEdit];
 									editingGateKeyLight = -1;
 									editingChannel = (stepIndexEdit >= 16 * stepConfig) ? 1 : 0;
@@ -837,14 +940,14 @@ struct PhraseSeq32 : Module {
 						lengths[sequence] = (stepPressed % (16 * stepConfig)) + 1;
 					else
 						phrases = stepPressed + 1;
-					revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+					revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 				}
 				else {
 					if (!running || !attached) {// not running or detached
 						if (editingSequence) {
 							stepIndexEdit = stepPressed;
 							if (!attributes[sequence][stepIndexEdit].getTied()) {// play if non-tied step
-								editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+								editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 								editingGateCV = cv[sequence][stepIndexEdit];
 								editingGateKeyLight = -1;
 								editingChannel = (stepIndexEdit >= 16 * stepConfig) ? 1 : 0;
@@ -858,7 +961,7 @@ struct PhraseSeq32 : Module {
 					}
 					else {// attached and running
 						if (attached)
-							attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+							attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 						if (editingSequence) {
 							if ((stepPressed < 16) && attachedChanB)
 								attachedChanB = false;
@@ -880,7 +983,7 @@ struct PhraseSeq32 : Module {
 					displayState = DISP_MODE;
 				else
 					displayState = DISP_NORMAL;
-				modeHoldDetect.start((long) (holdDetectTime * sampleRate / displayRefreshStepSkips));
+				modeHoldDetect.start((long) (holdDetectTime * sampleRate / refresh.lightSkips));
 			}
 			
 			// Transpose/Rotate button
@@ -909,7 +1012,7 @@ struct PhraseSeq32 : Module {
 					// any changes in here should may also require right click behavior to be updated in the knob's onMouseDown()
 					if (editingPpqn != 0) {
 						pulsesPerStep = indexToPps(ppsToIndex(pulsesPerStep) + deltaKnob);// indexToPps() does clamping
-						editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+						editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 					}
 					else if (displayState == DISP_MODE) {
 						if (editingSequence) {
@@ -986,11 +1089,11 @@ struct PhraseSeq32 : Module {
 			if (newOct >= 0 && newOct <= 6) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else {			
 						cv[sequence][stepIndexEdit] = applyNewOct(cv[sequence][stepIndexEdit], newOct);
 						propagateCVtoTied(sequence, stepIndexEdit);
-						editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+						editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 						editingGateCV = cv[sequence][stepIndexEdit];
 						editingGateKeyLight = -1;
 						editingChannel = (stepIndexEdit >= 16 * stepConfig) ? 1 : 0;
@@ -1014,18 +1117,18 @@ struct PhraseSeq32 : Module {
 									stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 32);
 							}
 							else
-								editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+								editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 						}
 						else if (attributes[sequence][stepIndexEdit].getTied()) {
 							if (params[KEY_PARAMS + i].value > 1.5f)
 								stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 32);
 							else
-								tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+								tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 						}
 						else {			
 							cv[sequence][stepIndexEdit] = floor(cv[sequence][stepIndexEdit]) + ((float) i) / 12.0f;
 							propagateCVtoTied(sequence, stepIndexEdit);
-							editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+							editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 							editingGateCV = cv[sequence][stepIndexEdit];
 							editingGateKeyLight = -1;
 							editingChannel = (stepIndexEdit >= 16 * stepConfig) ? 1 : 0;
@@ -1063,7 +1166,7 @@ struct PhraseSeq32 : Module {
 			if (gate1ProbTrigger.process(params[GATE1_PROB_PARAM].value)) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else
 						attributes[sequence][stepIndexEdit].toggleGate1P();
 				}
@@ -1078,7 +1181,7 @@ struct PhraseSeq32 : Module {
 			if (slideTrigger.process(params[SLIDE_BTN_PARAM].value + inputs[SLIDECV_INPUT].value)) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else
 						attributes[sequence][stepIndexEdit].toggleSlide();
 				}
@@ -1096,6 +1199,7 @@ struct PhraseSeq32 : Module {
 				displayState = DISP_NORMAL;
 			}		
 			
+			IM_CPU_METER_MARK(cpuMeter, SECT_INPUTS);
 		}// userInputs refresh
 		
 		
@@ -1115,13 +1219,13 @@ struct PhraseSeq32 : Module {
 					if (editingSequence) {
 						for (int i = 0; i < 2; i += stepConfig)
 							slideFromCV[i] = cv[sequence][(i * 16) + stepIndexRun[i]];
-						moveIndexRunMode(&stepIndexRun[0], lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory);
+						moveIndexRunMode(&stepIndexRun[0], lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory, &rng);
 					}
 					else {
 						for (int i = 0; i < 2; i += stepConfig)
 							slideFromCV[i] = cv[phrase[phraseIndexRun]][(i * 16) + stepIndexRun[i]];
-						if (moveIndexRunMode(&stepIndexRun[0], lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
+						if (moveIndexRunMode(&stepIndexRun[0], lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory, &rng)) {
+							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory, &rng);
 							stepIndexRun[0] = (runModeSeq[phrase[phraseIndexRun]] == MODE_REV ? lengths[phrase[phraseIndexRun]] - 1 : 0);// must always refresh after phraseIndexRun has changed
 						}
 						newSeq = phrase[phraseIndexRun];
@@ -1131,14 +1235,13 @@ struct PhraseSeq32 : Module {
 					// Slide
 					for (int i = 0; i < 2; i += stepConfig) {
 						if (attributes[newSeq][(i * 16) + stepIndexRun[i]].getSlide()) {
-							slideStepsRemain[i] = (unsigned long) (((float)clockPeriod  * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f);
-							if (slideStepsRemain[i] != 0ul) {
-								float slideToCV = cv[newSeq][(i * 16) + stepIndexRun[i]];
-								slideCVdelta[i] = (slideToCV - slideFromCV[i])/(float)slideStepsRemain[i];
-							}
+							float slideSteps = (((float)clockPeriod + clockFraction - clockTrigger.edgeFraction) * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f;// period between the estimated edges
+							slides[i].reset();
+							if (slideSteps >= 1.0f)
+								slides[i].start(slideFromCV[i], cv[newSeq][(i * 16) + stepIndexRun[i]], slideSteps, clockTrigger.edgeFraction, slideShape);
 						}
 						else
-							slideStepsRemain[i] = 0ul;
+							slides[i].reset();
 					}
 				}
 				else {
@@ -1147,11 +1250,12 @@ struct PhraseSeq32 : Module {
 				}
 				for (int i = 0; i < 2; i += stepConfig) {
 					if (gate1Code[i] != -1 || ppqnCount == 0)
-						gate1Code[i] = calcGate1Code(attributes[newSeq][(i * 16) + stepIndexRun[i]], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
+						gate1Code[i] = calcGate1Code(attributes[newSeq][(i * 16) + stepIndexRun[i]], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value, &rng);
 					gate2Code[i] = calcGate2Code(attributes[newSeq][(i * 16) + stepIndexRun[i]], ppqnCount, pulsesPerStep);	
 				}
 			}
 			clockPeriod = 0ul;
+			clockFraction = clockTrigger.edgeFraction;
 		}
 		clockPeriod++;
 		
@@ -1166,6 +1270,8 @@ struct PhraseSeq32 : Module {
 		}
 		
 		
+		IM_CPU_METER_MARK(cpuMeter, SECT_CLOCK);
+		
 		//********** Outputs and lights **********
 				
 		// CV and gates outputs
@@ -1189,7 +1295,7 @@ struct PhraseSeq32 : Module {
 			}
 			float slideOffset[2];
 			for (int i = 0; i < 2; i += stepConfig)
-				slideOffset[i] = (slideStepsRemain[i] > 0ul ? (slideCVdelta[i] * (float)slideStepsRemain[i]) : 0.0f);
+				slideOffset[i] = slides[i].getOffset();
 			outputs[CVA_OUTPUT].value = cv[seq][step0] - slideOffset[0];
 			outputs[GATE1A_OUTPUT].value = (calcGate(gate1Code[0], clockTrigger, clockPeriod, sampleRate) && !muteGate1A) ? 10.0f : 0.0f;
 			outputs[GATE2A_OUTPUT].value = (calcGate(gate2Code[0], clockTrigger, clockPeriod, sampleRate) && !muteGate2A) ? 10.0f : 0.0f;
@@ -1236,13 +1342,12 @@ struct PhraseSeq32 : Module {
 			}	
 		}
 		for (int i = 0; i < 2; i++)
-			if (slideStepsRemain[i] > 0ul)
-				slideStepsRemain[i]--;
+			slides[i].advance();
 
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		IM_CPU_METER_MARK(cpuMeter, SECT_OUTPUTS);
+
+		if (refresh.processLights()) {
 		
 			// Step/phrase lights
 			if (infoCopyPaste != 0l) {
@@ -1311,7 +1416,7 @@ struct PhraseSeq32 : Module {
 					lights[OCTAVE_LIGHTS + i].value = 0.0f;
 				else {
 					if (tiedWarning > 0l) {
-						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 						lights[OCTAVE_LIGHTS + i].value = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
 					}
 					else				
@@ -1364,12 +1469,12 @@ struct PhraseSeq32 : Module {
 						lights[KEY_LIGHTS + i * 2 + 1].value = 0.0f;
 					else {
 						if (tiedWarning > 0l) {
-							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 							lights[KEY_LIGHTS + i * 2 + 1].value = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
 						}
 						else {
 							if (editingGate > 0ul && editingGateKeyLight != -1)
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / refresh.lightSkips)) : 0.0f);
 							else
 								lights[KEY_LIGHTS + i * 2 + 1].value = (i == keyLightIndex ? 1.0f : 0.0f);
 						}
@@ -1407,7 +1512,7 @@ struct PhraseSeq32 : Module {
 				lights[GATE1_PROB_LIGHT].value = attributesVal.getGate1P() ? 1.0f : 0.0f;
 				lights[SLIDE_LIGHT].value = attributesVal.getSlide() ? 1.0f : 0.0f;
 				if (tiedWarning > 0l) {
-					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 					lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 				}
 				else
@@ -1416,7 +1521,7 @@ struct PhraseSeq32 : Module {
 			
 			// Attach light
 			if (attachedWarning > 0l) {
-				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 			}
 			else
@@ -1424,7 +1529,7 @@ struct PhraseSeq32 : Module {
 			
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;
-			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * refresh.lightSkips;
 			
 			// Run light
 			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
@@ -1445,19 +1550,41 @@ struct PhraseSeq32 : Module {
 				attachedWarning--;
 			if (modeHoldDetect.process(params[RUNMODE_PARAM].value)) {
 				displayState = DISP_NORMAL;
-				editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+				editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 			}
 			if (revertDisplay > 0l) {
 				if (revertDisplay == 1)
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
-		}// lightRefreshCounter
+			IM_CPU_METER_MARK(cpuMeter, SECT_LIGHTS);
+		}// processLights()
 				
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
+		IM_CPU_METER_END(cpuMeter);
 	}// step()
 	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {
+		if (slides[0].isSliding() || slides[1].isSliding())
+			return 0l;
+		float sampleRate = engineGetSampleRate();
+		long idleSteps = LONG_MAX;
+		for (int i = 0; i < 2; i++) {
+			idleSteps = std::min(idleSteps, calcGateIdleSteps(gate1Code[i], clockPeriod, clockFraction, sampleRate));
+			idleSteps = std::min(idleSteps, calcGateIdleSteps(gate2Code[i], clockPeriod, clockFraction, sampleRate));
+		}
+		return idleSteps;
+	}
+	inline void skipIdleSteps(long n) {
+		clockPeriod += (unsigned long)n;
+		clockIgnoreOnReset = std::max(clockIgnoreOnReset - n, 0l);
+	}
+	
 
 	inline void setGreenRed(int id, float green, float red) {
 		lights[id + 0].value = green;
@@ -1545,15 +1672,8 @@ struct PhraseSeq32Widget : ModuleWidget {
 				snprintf(displayStr, 4, "%s", modeLabels[num].c_str());
 		}
 
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
+		void printText() {
 			bool editingSequence = module->isEditingSequence();
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
 			if (module->infoCopyPaste != 0l) {
 				if (module->infoCopyPaste > 0l)
 					snprintf(displayStr, 4, "CPY");
@@ -1609,6 +1729,22 @@ struct PhraseSeq32Widget : ModuleWidget {
 				snprintf(displayStr, 4, " %2u", (unsigned) (editingSequence ? 
 					module->sequence : module->phrase[module->phraseIndexEdit]) + 1 );
 			}
+		}
+		
+		uint64_t calcStateHash() {// see CachedDisplay
+			printText();
+			return hashDisplayText(displayStr);
+		}
+
+		void draw(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, font->handle);
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
+			printText();
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -1617,7 +1753,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 		PhraseSeq32 *module;
 		int theme;
 		void onAction(EventAction &e) override {
-			module->panelTheme = theme;
+			module->editQueue.push(PhraseSeq32::EDIT_PANEL_THEME, theme);
 		}
 		void step() override {
 			rightText = (module->panelTheme == theme) ? "✔" : "";
@@ -1626,33 +1762,45 @@ struct PhraseSeq32Widget : ModuleWidget {
 	struct ExpansionItem : MenuItem {
 		PhraseSeq32 *module;
 		void onAction(EventAction &e) override {
-			module->expansion = module->expansion == 1 ? 0 : 1;
+			module->editQueue.push(PhraseSeq32::EDIT_EXPANSION);
 		}
 	};
 	struct ResetOnRunItem : MenuItem {
 		PhraseSeq32 *module;
 		void onAction(EventAction &e) override {
-			module->resetOnRun = !module->resetOnRun;
+			module->editQueue.push(PhraseSeq32::EDIT_RESET_ON_RUN);
 		}
 	};
 	struct AutoseqItem : MenuItem {
 		PhraseSeq32 *module;
 		void onAction(EventAction &e) override {
-			module->autoseq = !module->autoseq;
+			module->editQueue.push(PhraseSeq32::EDIT_AUTOSEQ);
 		}
 	};
+	struct SlideShapeItem : MenuItem {
+		PhraseSeq32 *module;
+		void onAction(EventAction &e) override {
+			module->editQueue.push(PhraseSeq32::EDIT_SLIDE_SHAPE);
+		}
+		void step() override {
+			if (module->slideShape == SLIDE_LINEAR)
+				text = "Slide: <Linear>,  Exponential,  Logarithmic";
+			else if (module->slideShape == SLIDE_EXP)
+				text = "Slide: Linear,  <Exponential>,  Logarithmic";
+			else
+				text = "Slide: Linear,  Exponential,  <Logarithmic>";
+		}	
+	};
 	struct HoldTiedItem : MenuItem {
 		PhraseSeq32 *module;
 		void onAction(EventAction &e) override {
-			module->holdTiedNotes = !module->holdTiedNotes;
+			module->editQueue.push(PhraseSeq32::EDIT_HOLD_TIED);
 		}
 	};
 	struct SeqCVmethodItem : MenuItem {
 		PhraseSeq32 *module;
 		void onAction(EventAction &e) override {
-			module->seqCVmethod++;
-			if (module->seqCVmethod > 2)
-				module->seqCVmethod = 0;
+			module->editQueue.push(PhraseSeq32::EDIT_SEQCV_METHOD);
 		}
 		void step() override {
 			if (module->seqCVmethod == 0)
@@ -1706,6 +1854,10 @@ struct PhraseSeq32Widget : ModuleWidget {
 		holdItem->module = module;
 		menu->addChild(holdItem);
 
+		SlideShapeItem *slideItem = MenuItem::create<SlideShapeItem>("Slide: ", "");
+		slideItem->module = module;
+		menu->addChild(slideItem);
+
 		SeqCVmethodItem *seqcvItem = MenuItem::create<SeqCVmethodItem>("Seq CV in: ", "");
 		seqcvItem->module = module;
 		menu->addChild(seqcvItem);
@@ -1720,6 +1872,10 @@ struct PhraseSeq32Widget : ModuleWidget {
 		expItem->module = module;
 		menu->addChild(expItem);
 		
+#ifdef IM_CPU_METER
+		addCpuMeterMenu(menu, &module->cpuMeter);// ImpromptuModular.hpp
+#endif
+
 		return menu;
 	}	
 	
@@ -1747,47 +1903,8 @@ struct PhraseSeq32Widget : ModuleWidget {
 		SequenceKnob() {};		
 		void onMouseDown(EventMouseDown &e) override {// from ParamWidget.cpp
 			PhraseSeq32* module = dynamic_cast<PhraseSeq32*>(this->module);
-			if (e.button == 1) {
-				// same code structure below as in sequence knob in main step()
-				if (module->editingPpqn != 0) {
-					module->pulsesPerStep = 1;
-					//editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
-				}
-				else if (module->displayState == PhraseSeq32::DISP_MODE) {
-					if (module->isEditingSequence()) {
-						if (!module->inputs[PhraseSeq32::MODECV_INPUT].active) {
-							module->runModeSeq[module->sequence] = MODE_FWD;
-						}
-					}
-					else {
-						module->runModeSong = MODE_FWD;
-					}
-				}
-				else if (module->displayState == PhraseSeq32::DISP_LENGTH) {
-					if (module->isEditingSequence()) {
-						module->lengths[module->sequence] = 16;
-					}
-					else {
-						module->phrases = 4;
-					}
-				}
-				else if (module->displayState == PhraseSeq32::DISP_TRANSPOSE) {
-					// nothing
-				}
-				else if (module->displayState == PhraseSeq32::DISP_ROTATE) {
-					// nothing			
-				}
-				else {// DISP_NORMAL
-					if (module->isEditingSequence()) {
-						if (!module->inputs[PhraseSeq32::SEQCV_INPUT].active) {
-							module->sequence = 0;;
-						}
-					}
-					else {
-						module->phrase[module->phraseIndexEdit] = 0;
-					}
-				}
-			}
+			if (e.button == 1)
+				module->editQueue.push(PhraseSeq32::EDIT_SEQUENCE_KNOB_DEFAULT);// see sequenceKnobDefault()
 			ParamWidget::onMouseDown(e);
 		}
 	};		
@@ -1800,8 +1917,8 @@ struct PhraseSeq32Widget : ModuleWidget {
         panel = new DynamicSVGPanel();
         panel->mode = &module->panelTheme;
 		panel->expWidth = &expWidth;
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/PhraseSeq32.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/PhraseSeq32_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/PhraseSeq32.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/PhraseSeq32_dark.svg"));
         box.size = panel->box.size;
 		box.size.x = box.size.x - (1 - module->expansion) * expWidth;
         addChild(panel);
@@ -1913,7 +2030,7 @@ struct PhraseSeq32Widget : ModuleWidget {
 		displaySequence->box.pos = Vec(columnRulerMK1-15, rowRulerMK0 + 3 + vOffsetDisplay);
 		displaySequence->box.size = Vec(55, 30);// 3 characters
 		displaySequence->module = module;
-		addChild(displaySequence);
+		addChild(createCachedDisplay(displaySequence));
 		// Len/mode button
 		addParam(createDynamicParam<IMBigPushButton>(Vec(columnRulerMK2 + offsetCKD6b, rowRulerMK0 + 0 + offsetCKD6b), module, PhraseSeq32::RUNMODE_PARAM, 0.0f, 1.0f, 0.0f, &module->panelTheme));
 
@@ -2038,6 +2155,7 @@ fix tied bug that prevented correct tied propagation when editing beyond sequenc
 implement held tied notes option
 clear all attributes (gates, gatep, tied, slide) when cross-paste to seq ALL (CVs not affected)
 implement right-click initialization on main knob
+use a per-module random number generator (saved in the patch) instead of Rack's global one
 
 0.6.12:
 input refresh optimization
@@ -6,7 +6,7 @@
 #include "PhraseSeqUtil.hpp"
 
 
-bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history) {// some of this code if from PS32EX)
+bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history, RandomGenerator* rng) {// some of this code if from PS32EX)
 	int reps = 1;
 	// assert((reps * numSteps) <= 0xFFF); // for BRN and RND run modes, history is not a span count but a step count
 	
@@ -79,7 +79,7 @@ bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* hist
 		case MODE_BRN :// brownian random; history base is 0x5000
 			if ((*history) < 0x5001 || (*history) > 0x5FFF) 
 				(*history) = 0x5000 + numSteps * reps;
-			(*index) += (randomu32() % 3) - 1;
+			(*index) += (rng->u32() % 3) - 1;
 			if ((*index) >= numSteps) {
 				(*index) = 0;
 			}
@@ -96,7 +96,7 @@ bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* hist
 		case MODE_RN2 :
 			if ((*history) < 0x6001 || (*history) > 0x6FFF) 
 				(*history) = 0x6000 + numSteps * reps;
-			(*index) = (randomu32() % numSteps) ;
+			(*index) = (rng->u32() % numSteps) ;
 			(*history)--;
 			if ((*history) <= 0x6000) {
 				crossBoundary = true;
@@ -2,6 +2,7 @@
 //Impromptu Modular: Modules for VCV Rack by Marc Boulé
 //***********************************************************************************************
 
+#include "ImpromptuModular.hpp"
 #include "dsp/digital.hpp"
 
 using namespace rack;
@@ -12,10 +13,7 @@ using namespace rack;
 enum RunModeIds {MODE_FWD, MODE_REV, MODE_PPG, MODE_PEN, MODE_BRN, MODE_RND, MODE_FW2, MODE_FW3, MODE_FW4, MODE_RN2, NUM_MODES};
 static const std::string modeLabels[NUM_MODES] = {"FWD","REV","PPG","PEN","BRN","RND","FW2","FW3","FW4","RN2"};// PS16 and SMS16 use NUM_MODES - 1 since no RN2!!!
 
-static const int NUM_GATES = 12;												
-static const uint32_t advGateHitMask[NUM_GATES] = 
-{0x00003F, 0x0F0F0F, 0x000FFF, 0x0F0F00, 0x03FFFF, 0xFFFFFF, 0x00000F, 0x03F03F, 0x000F00, 0x03F000, 0x0F0000, 0};
-//	  25%		TRI		  50%		T23		  75%		FUL		  TR1 		DUO		  TR2 	     D2		  TR3  TRIG		
+typedef AdvGateCodes<24, 13> PhraseSeqGateCodes;// pulses per step 1, 2, 4, 6 ... 24, indexed with ppsToIndex()
 
 
 class StepAttributes {
@@ -35,7 +33,7 @@ class StepAttributes {
 	
 	inline void clear() {attributes = 0u;}
 	inline void init() {attributes = ATT_MSK_INITSTATE;}
-	inline void randomize() {attributes = (randomu32() & (ATT_MSK_GATE1 | ATT_MSK_GATE1P | ATT_MSK_GATE2 | ATT_MSK_SLIDE | ATT_MSK_TIED | ATT_MSK_GATE1MODE | ATT_MSK_GATE2MODE));}
+	inline void randomize(RandomGenerator* rng) {attributes = (rng->u32() & (ATT_MSK_GATE1 | ATT_MSK_GATE1P | ATT_MSK_GATE2 | ATT_MSK_SLIDE | ATT_MSK_TIED | ATT_MSK_GATE1MODE | ATT_MSK_GATE2MODE));}
 	
 	inline bool getGate1() {return (attributes & ATT_MSK_GATE1) != 0;}
 	inline bool getGate1P() {return (attributes & ATT_MSK_GATE1P) != 0;}
@@ -83,44 +81,33 @@ inline float applyNewOct(float cvVal, int newOct) {
 	return newCV - floor(newCV) + (float) (newOct - 3);
 }
 
-inline bool calcGate(int gateCode, SchmittTrigger clockTrigger, unsigned long clockStep, float sampleRate) {
+inline bool calcGate(int gateCode, ClockTrigger clockTrigger, unsigned long clockStep, float sampleRate) {
 	if (gateCode < 2) 
 		return gateCode == 1;
 	if (gateCode == 2)
 		return clockTrigger.isHigh();
-	return clockStep < (unsigned long) (sampleRate * 0.01f);
+	return clockStep < calcTrigSteps(sampleRate, clockTrigger.edgeFraction);
 }
-
-inline int getAdvGate(int ppqnCount, int pulsesPerStep, int gateMode) { 
-	if (gateMode == 11)
-		return ppqnCount == 0 ? 3 : 0;
-	uint32_t shiftAmt = ppqnCount * (24 / pulsesPerStep);
-	return (int)((advGateHitMask[gateMode] >> shiftAmt) & (uint32_t)0x1);
+inline long calcGateIdleSteps(int gateCode, unsigned long clockStep, float edgeFraction, float sampleRate) {// number of upcoming steps during which calcGate() can't change without a clock edge
+	unsigned long trigSteps = calcTrigSteps(sampleRate, edgeFraction);
+	if (gateCode < 3 || clockStep >= trigSteps)
+		return LONG_MAX;
+	return (long) (trigSteps - 1ul - clockStep);
 }
 
-inline int calcGate1Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep, float randKnob) {
+inline int calcGate1Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep, float randKnob, RandomGenerator* rng) {
 	// -1 = gate off for whole step, 0 = gate off for current ppqn, 1 = gate on, 2 = clock high, 3 = trigger
-	if (ppqnCount == 0 && attribute.getGate1P() && !(randomUniform() < randKnob))// randomUniform is [0.0, 1.0), see include/util/common.hpp
+	if (ppqnCount == 0 && attribute.getGate1P() && !(rng->uniform() < randKnob))// uniform is [0.0, 1.0), see ImpromptuModular.hpp
 		return -1;// must do this first in this method since it will kill rest of step if prob turns off the step
 	if (!attribute.getGate1())
 		return 0;
-	int gateType = attribute.getGate1Mode();
-	if (pulsesPerStep == 1 && gateType == 0)
-		return 2;// clock high
-	if (gateType == 11)
-		return (ppqnCount == 0 ? 3 : 0);
-	return getAdvGate(ppqnCount, pulsesPerStep, gateType);
+	return PhraseSeqGateCodes::get(attribute.getGate1Mode(), ppsToIndex(pulsesPerStep), ppqnCount);
 }
 inline int calcGate2Code(StepAttributes attribute, int ppqnCount, int pulsesPerStep) {
 	// 0 = gate off, 1 = clock high, 2 = trigger, 3 = gate on
 	if (!attribute.getGate2())
 		return 0;
-	int gateType = attribute.getGate2Mode();
-	if (pulsesPerStep == 1 && gateType == 0)
-		return 2;// clock high
-	if (gateType == 11)
-		return (ppqnCount == 0 ? 3 : 0);
-	return getAdvGate(ppqnCount, pulsesPerStep, gateType);
+	return PhraseSeqGateCodes::get(attribute.getGate2Mode(), ppsToIndex(pulsesPerStep), ppqnCount);
 }
 
 inline int gateModeToKeyLightIndex(StepAttributes attribute, bool isGate1) {// keyLight index now matches gate modes, so no mapping table needed anymore
@@ -131,7 +118,7 @@ inline int gateModeToKeyLightIndex(StepAttributes attribute, bool isGate1) {// k
 
 // Other methods (code in PhraseSeqUtil.cpp)	
 												
-bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history);
+bool moveIndexRunMode(int* index, int numSteps, int runMode, unsigned long* history, RandomGenerator* rng);
 int keyIndexToGateMode(int keyIndex, int pulsesPerStep);
 
 
@@ -174,6 +174,7 @@ struct SemiModularSynth : Module {
 		
 		NUM_LIGHTS
 	};
+	enum EditIds {EDIT_PANEL_THEME, EDIT_RESET_ON_RUN, EDIT_AUTOSEQ, EDIT_HOLD_TIED, EDIT_SLIDE_SHAPE, EDIT_SEQUENCE_KNOB_DEFAULT};// see applyEdit()
 
 	
 	// SEQUENCER
@@ -185,6 +186,7 @@ struct SemiModularSynth : Module {
 	int panelTheme = 2;
 	bool autoseq;
 	bool holdTiedNotes = true;
+	int slideShape = SLIDE_LINEAR;// see SlideGenerator
 	int pulsesPerStep;// 1 means normal gate mode, alt choices are 4, 6, 12, 24 PPS (Pulses per step)
 	bool running;
 	int runModeSeq[16]; 
@@ -198,6 +200,7 @@ struct SemiModularSynth : Module {
 	bool resetOnRun;
 	bool attached;
 	int transposeOffsets[16];
+	RandomGenerator rng;// see ImpromptuModular.hpp
 
 	// No need to save
 	int stepIndexEdit;
@@ -211,8 +214,7 @@ struct SemiModularSynth : Module {
 	unsigned long stepIndexRunHistory;
 	unsigned long phraseIndexRunHistory;
 	int displayState;
-	unsigned long slideStepsRemain;// 0 when no slide under way, downward step counter when sliding
-	float slideCVdelta;// no need to initialize, this is a companion to slideStepsRemain
+	SlideGenerator slide;
 	float cvCPbuffer[16];// copy paste buffer for CVs
 	StepAttributes attribCPbuffer[16];
 	int phraseCPbuffer[16];
@@ -223,6 +225,7 @@ struct SemiModularSynth : Module {
 	int rotateOffset;// no need to initialize, this is companion to displayMode = DISP_ROTATE
 	long clockIgnoreOnReset;
 	unsigned long clockPeriod;// counts number of step() calls upward from last clock (reset after clock processed)
+	float clockFraction;// edge fraction of the last clock (see ClockTrigger), companion to clockPeriod
 	long tiedWarning;// 0 when no warning, positive downward step counter timer when warning
 	long attachedWarning;// 0 when no warning, positive downward step counter timer when warning
 	int gate1Code;
@@ -250,14 +253,18 @@ struct SemiModularSynth : Module {
 	LadderFilter filter;
 	
 
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
+	EditQueue editQueue;// edits from the widgets, see ImpromptuModular.hpp
+#ifdef IM_CPU_METER
+	CpuMeter cpuMeter;
+#endif
 	float resetLight = 0.0f;
 	int sequenceKnob = 0;
 	SchmittTrigger resetTrigger;
 	SchmittTrigger leftTrigger;
 	SchmittTrigger rightTrigger;
 	SchmittTrigger runningTrigger;
-	SchmittTrigger clockTrigger;
+	ClockTrigger clockTrigger;
 	SchmittTrigger octTriggers[7];
 	SchmittTrigger octmTrigger;
 	SchmittTrigger gate1Trigger;
@@ -292,6 +299,7 @@ struct SemiModularSynth : Module {
 		
 		// VCO
 		oscillatorVco.soft = false;//params[VCO_SYNC_PARAM].value <= 0.0f;
+		oscillatorVco.rng = &rng;
 		
 		// CLK 
 		oscillatorClk.offset = true;//(params[OFFSET_PARAM].value > 0.0f);
@@ -335,9 +343,10 @@ struct SemiModularSynth : Module {
 		editingGate = 0ul;
 		infoCopyPaste = 0l;
 		displayState = DISP_NORMAL;
-		slideStepsRemain = 0ul;
+		slide.reset();
 		attached = false;
 		clockPeriod = 0ul;
+		clockFraction = 0.0f;
 		tiedWarning = 0ul;
 		attachedWarning = 0l;
 		revertDisplay = 0l;
@@ -358,18 +367,18 @@ struct SemiModularSynth : Module {
 
 	
 	void onRandomize() override {
-		runModeSong = randomu32() % 5;
+		runModeSong = rng.u32() % 5;
 		stepIndexEdit = 0;
 		phraseIndexEdit = 0;
-		sequence = randomu32() % 16;
-		phrases = 1 + (randomu32() % 16);
+		sequence = rng.u32() % 16;
+		phrases = 1 + (rng.u32() % 16);
 		for (int i = 0; i < 16; i++) {
-			runModeSeq[i] = randomu32() % (NUM_MODES - 1);
-			phrase[i] = randomu32() % 16;
-			lengths[i] = 1 + (randomu32() % 16);
+			runModeSeq[i] = rng.u32() % (NUM_MODES - 1);
+			phrase[i] = rng.u32() % 16;
+			lengths[i] = 1 + (rng.u32() % 16);
 			for (int s = 0; s < 16; s++) {
-				cv[i][s] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
-				attributes[i][s].randomize();
+				cv[i][s] = ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f;
+				attributes[i][s].randomize(&rng);
 				if (attributes[i][s].getTied()) {
 					activateTiedStep(i, s);
 				}
@@ -388,9 +397,9 @@ struct SemiModularSynth : Module {
 		stepIndexRunHistory = 0;
 
 		ppqnCount = 0;
-		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
+		gate1Code = calcGate1Code(attributes[seq][stepIndexRun], 0, pulsesPerStep, params[GATE1_KNOB_PARAM].value, &rng);
 		gate2Code = calcGate2Code(attributes[seq][stepIndexRun], 0, pulsesPerStep);
-		slideStepsRemain = 0ul;
+		slide.reset();
 		clockIgnoreOnReset = (long) (clockIgnoreOnResetDuration * engineGetSampleRate());
 	}
 	
@@ -407,6 +416,9 @@ struct SemiModularSynth : Module {
 		// holdTiedNotes
 		json_object_set_new(rootJ, "holdTiedNotes", json_boolean(holdTiedNotes));
 		
+		// slideShape
+		json_object_set_new(rootJ, "slideShape", json_integer(slideShape));
+		
 		// pulsesPerStep
 		json_object_set_new(rootJ, "pulsesPerStep", json_integer(pulsesPerStep));
 
@@ -474,6 +486,9 @@ struct SemiModularSynth : Module {
 			json_array_insert_new(transposeOffsetsJ, i, json_integer(transposeOffsets[i]));
 		json_object_set_new(rootJ, "transposeOffsets", transposeOffsetsJ);
 
+		// rng
+		json_object_set_new(rootJ, "rng", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -495,6 +510,11 @@ struct SemiModularSynth : Module {
 		else
 			holdTiedNotes = false;// legacy
 		
+		// slideShape
+		json_t *slideShapeJ = json_object_get(rootJ, "slideShape");
+		if (slideShapeJ)
+			slideShape = clamp((int)json_integer_value(slideShapeJ), 0, NUM_SLIDE_SHAPES - 1);
+		
 		// pulsesPerStep
 		json_t *pulsesPerStepJ = json_object_get(rootJ, "pulsesPerStep");
 		if (pulsesPerStepJ)
@@ -627,6 +647,9 @@ struct SemiModularSynth : Module {
 			}			
 		}
 
+		// rng
+		rng.fromJson(json_object_get(rootJ, "rng"));
+
 		// Initialize dependants after everything loaded
 		initRun();
 	}
@@ -656,7 +679,74 @@ struct SemiModularSynth : Module {
 	}
 	
 
+	void applyEdit(EditCommand command) {
+		switch (command.id) {
+			case EDIT_PANEL_THEME :
+				panelTheme = command.value;
+			break;
+			case EDIT_RESET_ON_RUN :
+				resetOnRun = !resetOnRun;
+			break;
+			case EDIT_AUTOSEQ :
+				autoseq = !autoseq;
+			break;
+			case EDIT_HOLD_TIED :
+				holdTiedNotes = !holdTiedNotes;
+			break;
+			case EDIT_SLIDE_SHAPE :
+				slideShape++;
+				if (slideShape >= NUM_SLIDE_SHAPES)
+					slideShape = SLIDE_LINEAR;
+			break;
+			case EDIT_SEQUENCE_KNOB_DEFAULT :
+				sequenceKnobDefault();
+			break;
+		}
+	}
+	
+	void sequenceKnobDefault() {// right-click on the sequence knob
+		// same code structure below as in sequence knob in main step()
+		if (editingPpqn != 0) {
+			pulsesPerStep = 1;
+			//editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
+		}
+		else if (displayState == DISP_MODE) {
+			if (isEditingSequence()) {
+				runModeSeq[sequence] = MODE_FWD;
+			}
+			else {
+				runModeSong = MODE_FWD;
+			}
+		}
+		else if (displayState == DISP_LENGTH) {
+			if (isEditingSequence()) {
+				lengths[sequence] = 16;
+			}
+			else {
+				phrases = 4;
+			}
+		}
+		else if (displayState == DISP_TRANSPOSE) {
+			// nothing
+		}
+		else if (displayState == DISP_ROTATE) {
+			// nothing			
+		}
+		else {// DISP_NORMAL
+			if (isEditingSequence()) {
+				if (!inputs[SEQCV_INPUT].active) {
+					sequence = 0;;
+				}
+			}
+			else {
+				phrase[phraseIndexEdit] = 0;
+			}
+		}
+	}
+	
+	
 	void step() override {
+		IM_CPU_METER_BEGIN(cpuMeter);
 		float sampleRate = engineGetSampleRate();
 	
 		// SEQUENCER
@@ -685,8 +775,12 @@ struct SemiModularSynth : Module {
 			displayState = DISP_NORMAL;
 		}
 
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
-
+		if (refresh.processInputs()) {
+			// Edits from the widgets
+			EditCommand editCommand;
+			while (editQueue.pop(&editCommand))
+				applyEdit(editCommand);
+			
 			// Seq CV input
 			if (inputs[SEQCV_INPUT].active) {
 				sequence = (int) clamp( round(inputs[SEQCV_INPUT].value * (16.0f - 1.0f) / 10.0f), 0.0f, (16.0f - 1.0f) );
@@ -727,12 +821,12 @@ struct SemiModularSynth : Module {
 						phraseCPbuffer[i] = phrase[p];
 					lengthCPbuffer = -1;// so that a cross paste can be detected
 				}
-				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				displayState = DISP_NORMAL;
 			}
 			// Paste button
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
-				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / displayRefreshStepSkips);
+				infoCopyPaste = (long) (-1 * copyPasteInfoTime * sampleRate / refresh.lightSkips);
 				startCP = 0;
 				if (countCP <= 8) {
 					startCP = editingSequence ? stepIndexEdit : phraseIndexEdit;
@@ -763,12 +857,12 @@ struct SemiModularSynth : Module {
 						}
 						else if (params[CPMODE_PARAM].value < 0.5f) {// 4 (randomize CVs)
 							for (int s = 0; s < 16; s++)
-								cv[sequence][s] = ((float)(randomu32() % 7)) + ((float)(randomu32() % 12)) / 12.0f - 3.0f;
+								cv[sequence][s] = ((float)(rng.u32() % 7)) + ((float)(rng.u32() % 12)) / 12.0f - 3.0f;
 							transposeOffsets[sequence] = 0;
 						}
 						else {// 8 (randomize gate 1)
 							for (int s = 0; s < 16; s++)
-								if ( (randomu32() & 0x1) != 0)
+								if ( (rng.u32() & 0x1) != 0)
 									attributes[sequence][s].toggleGate1();
 						}
 						startCP = 0;
@@ -792,7 +886,7 @@ struct SemiModularSynth : Module {
 						}
 						else {// 8 (randomize phrases)
 							for (int p = 0; p < 16; p++)
-								phrase[p] = randomu32() % 16;
+								phrase[p] = rng.u32() % 16;
 						}
 						startCP = 0;
 						countCP = 16;
@@ -811,7 +905,7 @@ struct SemiModularSynth : Module {
 						cv[sequence][stepIndexEdit] = inputs[CV_INPUT].value;
 						propagateCVtoTied(sequence, stepIndexEdit);
 					}
-					editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+					editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 					editingGateCV = inputs[CV_INPUT].value;// cv[sequence][stepIndexEdit];
 					editingGateKeyLight = -1;
 					// Autostep (after grab all active inputs)
@@ -850,7 +944,7 @@ struct SemiModularSynth : Module {
 							stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + delta, 16);
 							if (!attributes[sequence][stepIndexEdit].getTied()) {// play if non-tied step
 								if (!writeTrig) {// in case autostep when simultaneous writeCV and stepCV (keep what was done in Write Input block above)
-									editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+									editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 									editingGateCV = cv[sequence][stepIndexEdit];
 									editingGateKeyLight = -1;
 								}
@@ -877,14 +971,14 @@ struct SemiModularSynth : Module {
 						lengths[sequence] = stepPressed + 1;
 					else
 						phrases = stepPressed + 1;
-					revertDisplay = (long) (revertDisplayTime * sampleRate / displayRefreshStepSkips);
+					revertDisplay = (long) (revertDisplayTime * sampleRate / refresh.lightSkips);
 				}
 				else {
 					if (!running || !attached) {// not running or detached
 						if (editingSequence) {
 							stepIndexEdit = stepPressed;
 							if (!attributes[sequence][stepIndexEdit].getTied()) {// play if non-tied step
-								editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+								editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 								editingGateCV = cv[sequence][stepIndexEdit];
 								editingGateKeyLight = -1;
 							}
@@ -896,7 +990,7 @@ struct SemiModularSynth : Module {
 						}
 					}
 					else if (attached)
-						attachedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						attachedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					displayState = DISP_NORMAL;
 				}
 			} 
@@ -911,7 +1005,7 @@ struct SemiModularSynth : Module {
 					displayState = DISP_MODE;
 				else
 					displayState = DISP_NORMAL;
-				modeHoldDetect.start((long) (holdDetectTime * sampleRate / displayRefreshStepSkips));
+				modeHoldDetect.start((long) (holdDetectTime * sampleRate / refresh.lightSkips));
 			}
 			
 			// Transpose/Rotate button
@@ -940,7 +1034,7 @@ struct SemiModularSynth : Module {
 					// any changes in here should may also require right click behavior to be updated in the knob's onMouseDown()
 					if (editingPpqn != 0) {
 						pulsesPerStep = indexToPps(ppsToIndex(pulsesPerStep) + deltaKnob);// indexToPps() does clamping
-						editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+						editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 					}
 					else if (displayState == DISP_MODE) {
 						if (editingSequence) {
@@ -1005,11 +1099,11 @@ struct SemiModularSynth : Module {
 			if (newOct >= 0 && newOct <= 6) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else {			
 						cv[sequence][stepIndexEdit] = applyNewOct(cv[sequence][stepIndexEdit], newOct);
 						propagateCVtoTied(sequence, stepIndexEdit);
-						editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+						editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 						editingGateCV = cv[sequence][stepIndexEdit];
 						editingGateKeyLight = -1;
 					}
@@ -1032,18 +1126,18 @@ struct SemiModularSynth : Module {
 									stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 16);
 							}
 							else
-								editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+								editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 						}
 						else if (attributes[sequence][stepIndexEdit].getTied()) {
 							if (params[KEY_PARAMS + i].value > 1.5f)
 								stepIndexEdit = moveIndex(stepIndexEdit, stepIndexEdit + 1, 16);
 							else
-								tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+								tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 						}
 						else {			
 							cv[sequence][stepIndexEdit] = floor(cv[sequence][stepIndexEdit]) + ((float) i) / 12.0f;
 							propagateCVtoTied(sequence, stepIndexEdit);
-							editingGate = (unsigned long) (gateTime * sampleRate / displayRefreshStepSkips);
+							editingGate = (unsigned long) (gateTime * sampleRate / refresh.lightSkips);
 							editingGateCV = cv[sequence][stepIndexEdit];
 							editingGateKeyLight = -1;
 							if (params[KEY_PARAMS + i].value > 1.5f) {
@@ -1080,7 +1174,7 @@ struct SemiModularSynth : Module {
 			if (gate1ProbTrigger.process(params[GATE1_PROB_PARAM].value)) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else
 						attributes[sequence][stepIndexEdit].toggleGate1P();
 				}
@@ -1095,7 +1189,7 @@ struct SemiModularSynth : Module {
 			if (slideTrigger.process(params[SLIDE_BTN_PARAM].value)) {
 				if (editingSequence) {
 					if (attributes[sequence][stepIndexEdit].getTied())
-						tiedWarning = (long) (warningTime * sampleRate / displayRefreshStepSkips);
+						tiedWarning = (long) (warningTime * sampleRate / refresh.lightSkips);
 					else
 						attributes[sequence][stepIndexEdit].toggleSlide();
 				}
@@ -1113,6 +1207,7 @@ struct SemiModularSynth : Module {
 				displayState = DISP_NORMAL;
 			}		
 		
+			IM_CPU_METER_MARK(cpuMeter, SECT_INPUTS);
 		}// userInputs refresh
 
 
@@ -1132,12 +1227,12 @@ struct SemiModularSynth : Module {
 					float slideFromCV = 0.0f;
 					if (editingSequence) {
 						slideFromCV = cv[sequence][stepIndexRun];
-						moveIndexRunMode(&stepIndexRun, lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory);
+						moveIndexRunMode(&stepIndexRun, lengths[sequence], runModeSeq[sequence], &stepIndexRunHistory, &rng);
 					}
 					else {
 						slideFromCV = cv[phrase[phraseIndexRun]][stepIndexRun];
-						if (moveIndexRunMode(&stepIndexRun, lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory)) {
-							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory);
+						if (moveIndexRunMode(&stepIndexRun, lengths[phrase[phraseIndexRun]], runModeSeq[phrase[phraseIndexRun]], &stepIndexRunHistory, &rng)) {
+							moveIndexRunMode(&phraseIndexRun, phrases, runModeSong, &phraseIndexRunHistory, &rng);
 							stepIndexRun = (runModeSeq[phrase[phraseIndexRun]] == MODE_REV ? lengths[phrase[phraseIndexRun]] - 1 : 0);// must always refresh after phraseIndexRun has changed
 						}
 						newSeq = phrase[phraseIndexRun];
@@ -1145,24 +1240,24 @@ struct SemiModularSynth : Module {
 					
 					// Slide
 					if (attributes[newSeq][stepIndexRun].getSlide()) {
-						slideStepsRemain =   (unsigned long) (((float)clockPeriod * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f);
-						if (slideStepsRemain != 0ul) {
-							float slideToCV = cv[newSeq][stepIndexRun];
-							slideCVdelta = (slideToCV - slideFromCV)/(float)slideStepsRemain;
-						}
+						float slideSteps = (((float)clockPeriod + clockFraction - clockTrigger.edgeFraction) * pulsesPerStep) * params[SLIDE_KNOB_PARAM].value / 2.0f;// period between the estimated edges
+						slide.reset();
+						if (slideSteps >= 1.0f)
+							slide.start(slideFromCV, cv[newSeq][stepIndexRun], slideSteps, clockTrigger.edgeFraction, slideShape);
 					}
 					else 
-						slideStepsRemain = 0ul;
+						slide.reset();
 				}
 				else {
 					if (!editingSequence)
 						newSeq = phrase[phraseIndexRun];
 				}
 				if (gate1Code != -1 || ppqnCount == 0)
-					gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value);
+					gate1Code = calcGate1Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep, params[GATE1_KNOB_PARAM].value, &rng);
 				gate2Code = calcGate2Code(attributes[newSeq][stepIndexRun], ppqnCount, pulsesPerStep);						 
 			}
 			clockPeriod = 0ul;
+			clockFraction = clockTrigger.edgeFraction;
 		}	
 		clockPeriod++;
 		
@@ -1174,6 +1269,8 @@ struct SemiModularSynth : Module {
 		}
 		
 		
+		IM_CPU_METER_MARK(cpuMeter, SECT_CLOCK);
+		
 		//********** Outputs and lights **********
 				
 		// CV and gates outputs
@@ -1182,8 +1279,7 @@ struct SemiModularSynth : Module {
 		if (running) {
 			bool muteGate1 = !editingSequence && (params[GATE1_PARAM].value > 0.5f);// live mute
 			bool muteGate2 = !editingSequence && (params[GATE2_PARAM].value > 0.5f);// live mute
-			float slideOffset = (slideStepsRemain > 0ul ? (slideCVdelta * (float)slideStepsRemain) : 0.0f);
-			outputs[CV_OUTPUT].value = cv[seq][step] - slideOffset;
+			outputs[CV_OUTPUT].value = cv[seq][step] - slide.getOffset();
 			outputs[GATE1_OUTPUT].value = (calcGate(gate1Code, clockTrigger, clockPeriod, sampleRate) && !muteGate1) ? 10.0f : 0.0f;
 			outputs[GATE2_OUTPUT].value = (calcGate(gate2Code, clockTrigger, clockPeriod, sampleRate) && !muteGate2) ? 10.0f : 0.0f;
 		}
@@ -1192,12 +1288,11 @@ struct SemiModularSynth : Module {
 			outputs[GATE1_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 			outputs[GATE2_OUTPUT].value = (editingGate > 0ul) ? 10.0f : 0.0f;
 		}
-		if (slideStepsRemain > 0ul)
-			slideStepsRemain--;
+		slide.advance();
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		IM_CPU_METER_MARK(cpuMeter, SECT_OUTPUTS);
+
+		if (refresh.processLights()) {
 
 			// Step/phrase lights
 			if (infoCopyPaste != 0l) {
@@ -1263,7 +1358,7 @@ struct SemiModularSynth : Module {
 					lights[OCTAVE_LIGHTS + i].value = 0.0f;
 				else {
 					if (tiedWarning > 0l) {
-						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+						bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 						lights[OCTAVE_LIGHTS + i].value = (warningFlashState && (i == (6 - octLightIndex))) ? 1.0f : 0.0f;
 					}
 					else				
@@ -1315,12 +1410,12 @@ struct SemiModularSynth : Module {
 						lights[KEY_LIGHTS + i * 2 + 1].value = 0.0f;
 					else {
 						if (tiedWarning > 0l) {
-							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+							bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 							lights[KEY_LIGHTS + i * 2 + 1].value = (warningFlashState && i == keyLightIndex) ? 1.0f : 0.0f;
 						}
 						else {
 							if (editingGate > 0ul && editingGateKeyLight != -1)
-								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / displayRefreshStepSkips)) : 0.0f);
+								lights[KEY_LIGHTS + i * 2 + 1].value = (i == editingGateKeyLight ? ((float) editingGate / (float)(gateTime * sampleRate / refresh.lightSkips)) : 0.0f);
 							else
 								lights[KEY_LIGHTS + i * 2 + 1].value = (i == keyLightIndex ? 1.0f : 0.0f);
 						}
@@ -1357,7 +1452,7 @@ struct SemiModularSynth : Module {
 				lights[GATE1_PROB_LIGHT].value = attributesVal.getGate1P() ? 1.0f : 0.0f;
 				lights[SLIDE_LIGHT].value = attributesVal.getSlide() ? 1.0f : 0.0f;
 				if (tiedWarning > 0l) {
-					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+					bool warningFlashState = calcWarningFlash(tiedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 					lights[TIE_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 				}
 				else
@@ -1366,7 +1461,7 @@ struct SemiModularSynth : Module {
 
 			// Attach light
 			if (attachedWarning > 0l) {
-				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / displayRefreshStepSkips));
+				bool warningFlashState = calcWarningFlash(attachedWarning, (long) (warningTime * sampleRate / refresh.lightSkips));
 				lights[ATTACH_LIGHT].value = (warningFlashState) ? 1.0f : 0.0f;
 			}
 			else
@@ -1374,7 +1469,7 @@ struct SemiModularSynth : Module {
 			
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;	
-			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * refresh.lightSkips;
 			
 			// Run light
 			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
@@ -1395,14 +1490,15 @@ struct SemiModularSynth : Module {
 				attachedWarning--;
 			if (modeHoldDetect.process(params[RUNMODE_PARAM].value)) {
 				displayState = DISP_NORMAL;
-				editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
+				editingPpqn = (long) (editGateLengthTime * sampleRate / refresh.lightSkips);
 			}
 			if (revertDisplay > 0l) {
 				if (revertDisplay == 1)
 					displayState = DISP_NORMAL;
 				revertDisplay--;
 			}
-		}// lightRefreshCounter
+			IM_CPU_METER_MARK(cpuMeter, SECT_LIGHTS);
+		}// processLights()
 		
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
@@ -1431,7 +1527,7 @@ struct SemiModularSynth : Module {
 			
 			
 		// CLK
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 			oscillatorClk.setPitch(params[CLK_FREQ_PARAM].value + log2f(pulsesPerStep));
 			oscillatorClk.setPulseWidth(params[CLK_PW_PARAM].value);
 		}	
@@ -1505,7 +1601,7 @@ struct SemiModularSynth : Module {
 			float gain = powf(1.f + drive, 5);
 			input *= gain;
 			// Add -60dB noise to bootstrap self-oscillation
-			input += 1e-6f * (2.f * randomUniform() - 1.f);
+			input += 1e-6f * (2.f * rng.uniform() - 1.f);
 			// Set resonance
 			float res = clamp(params[VCF_RES_PARAM].value + inputs[VCF_RES_INPUT].value / 10.f, 0.f, 1.f);
 			filter.resonance = powf(res, 2) * 10.f;
@@ -1529,7 +1625,7 @@ struct SemiModularSynth : Module {
 		
 		// LFO
 		if (outputs[LFO_SIN_OUTPUT].active || outputs[LFO_TRI_OUTPUT].active) {
-			if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+			if (refresh.processInputs()) {
 				oscillatorLfo.setPitch(params[LFO_FREQ_PARAM].value);
 			}
 			oscillatorLfo.step(engineGetSampleTime());
@@ -1544,6 +1640,8 @@ struct SemiModularSynth : Module {
 			outputs[LFO_TRI_OUTPUT].value = 0.0f;
 		}			
 		
+		IM_CPU_METER_MARK(cpuMeter, SECT_SYNTH);
+		IM_CPU_METER_END(cpuMeter);
 	}// step()
 	
 
@@ -1630,15 +1728,8 @@ struct SemiModularSynthWidget : ModuleWidget {
 				snprintf(displayStr, 4, "%s", modeLabels[num].c_str());
 		}
 
-		void draw(NVGcontext *vg) override {
-			NVGcolor textColor = prepareDisplay(vg, &box, 18);
-			nvgFontFaceId(vg, font->handle);
+		void printText() {
 			bool editingSequence = module->isEditingSequence();
-
-			Vec textPos = Vec(6, 24);
-			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
-			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
-			nvgFillColor(vg, textColor);
 			if (module->infoCopyPaste != 0l) {
 				if (module->infoCopyPaste > 0l)
 					snprintf(displayStr, 4, "CPY");
@@ -1694,6 +1785,22 @@ struct SemiModularSynthWidget : ModuleWidget {
 				snprintf(displayStr, 4, " %2u", (unsigned) (editingSequence ? 
 					module->sequence : module->phrase[module->phraseIndexEdit]) + 1 );
 			}
+		}
+		
+		uint64_t calcStateHash() {// see CachedDisplay
+			printText();
+			return hashDisplayText(displayStr);
+		}
+
+		void draw(NVGcontext *vg) override {
+			NVGcolor textColor = prepareDisplay(vg, &box, 18);
+			nvgFontFaceId(vg, font->handle);
+
+			Vec textPos = Vec(6, 24);
+			nvgFillColor(vg, nvgTransRGBA(textColor, displayAlpha));
+			nvgText(vg, textPos.x, textPos.y, "~~~", NULL);
+			nvgFillColor(vg, textColor);
+			printText();
 			nvgText(vg, textPos.x, textPos.y, displayStr, NULL);
 		}
 	};		
@@ -1702,7 +1809,7 @@ struct SemiModularSynthWidget : ModuleWidget {
 		SemiModularSynth *module;
 		int panelTheme;
 		void onAction(EventAction &e) override {
-			module->panelTheme = panelTheme;
+			module->editQueue.push(SemiModularSynth::EDIT_PANEL_THEME, panelTheme);
 		}
 		void step() override {
 			rightText = (module->panelTheme == panelTheme) ? "✔" : "";
@@ -1711,19 +1818,33 @@ struct SemiModularSynthWidget : ModuleWidget {
 	struct ResetOnRunItem : MenuItem {
 		SemiModularSynth *module;
 		void onAction(EventAction &e) override {
-			module->resetOnRun = !module->resetOnRun;
+			module->editQueue.push(SemiModularSynth::EDIT_RESET_ON_RUN);
 		}
 	};
 	struct AutoseqItem : MenuItem {
 		SemiModularSynth *module;
 		void onAction(EventAction &e) override {
-			module->autoseq = !module->autoseq;
+			module->editQueue.push(SemiModularSynth::EDIT_AUTOSEQ);
 		}
 	};
+	struct SlideShapeItem : MenuItem {
+		SemiModularSynth *module;
+		void onAction(EventAction &e) override {
+			module->editQueue.push(SemiModularSynth::EDIT_SLIDE_SHAPE);
+		}
+		void step() override {
+			if (module->slideShape == SLIDE_LINEAR)
+				text = "Slide: <Linear>,  Exponential,  Logarithmic";
+			else if (module->slideShape == SLIDE_EXP)
+				text = "Slide: Linear,  <Exponential>,  Logarithmic";
+			else
+				text = "Slide: Linear,  Exponential,  <Logarithmic>";
+		}	
+	};
 	struct HoldTiedItem : MenuItem {
 		SemiModularSynth *module;
 		void onAction(EventAction &e) override {
-			module->holdTiedNotes = !module->holdTiedNotes;
+			module->editQueue.push(SemiModularSynth::EDIT_HOLD_TIED);
 		}
 	};
 	Menu *createContextMenu() override {
@@ -1775,6 +1896,14 @@ struct SemiModularSynthWidget : ModuleWidget {
 		holdItem->module = module;
 		menu->addChild(holdItem);
 
+		SlideShapeItem *slideItem = MenuItem::create<SlideShapeItem>("Slide: ", "");
+		slideItem->module = module;
+		menu->addChild(slideItem);
+
+#ifdef IM_CPU_METER
+		addCpuMeterMenu(menu, &module->cpuMeter);// ImpromptuModular.hpp
+#endif
+
 		return menu;
 	}	
 	
@@ -1782,45 +1911,8 @@ struct SemiModularSynthWidget : ModuleWidget {
 		SequenceKnob() {};		
 		void onMouseDown(EventMouseDown &e) override {// from ParamWidget.cpp
 			SemiModularSynth* module = dynamic_cast<SemiModularSynth*>(this->module);
-			if (e.button == 1) {
-				// same code structure below as in sequence knob in main step()
-				if (module->editingPpqn != 0) {
-					module->pulsesPerStep = 1;
-					//editingPpqn = (long) (editGateLengthTime * sampleRate / displayRefreshStepSkips);
-				}
-				else if (module->displayState == SemiModularSynth::DISP_MODE) {
-					if (module->isEditingSequence()) {
-						module->runModeSeq[module->sequence] = MODE_FWD;
-					}
-					else {
-						module->runModeSong = MODE_FWD;
-					}
-				}
-				else if (module->displayState == SemiModularSynth::DISP_LENGTH) {
-					if (module->isEditingSequence()) {
-						module->lengths[module->sequence] = 16;
-					}
-					else {
-						module->phrases = 4;
-					}
-				}
-				else if (module->displayState == SemiModularSynth::DISP_TRANSPOSE) {
-					// nothing
-				}
-				else if (module->displayState == SemiModularSynth::DISP_ROTATE) {
-					// nothing			
-				}
-				else {// DISP_NORMAL
-					if (module->isEditingSequence()) {
-						if (!module->inputs[SemiModularSynth::SEQCV_INPUT].active) {
-							module->sequence = 0;;
-						}
-					}
-					else {
-						module->phrase[module->phraseIndexEdit] = 0;
-					}
-				}
-			}
+			if (e.button == 1)
+				module->editQueue.push(SemiModularSynth::EDIT_SEQUENCE_KNOB_DEFAULT);// see sequenceKnobDefault()
 			ParamWidget::onMouseDown(e);
 		}
 	};		
@@ -1833,9 +1925,9 @@ struct SemiModularSynthWidget : ModuleWidget {
 		// Main panel from Inkscape
         panel = new DynamicSVGPanel();
         panel->mode = &module->panelTheme;
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/SemiModular.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/SemiModular.svg"));
 		panel->dupPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/SemiModular_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/dark/SemiModular_dark.svg"));
         box.size = panel->box.size;
         addChild(panel);		
 		
@@ -1944,7 +2036,7 @@ struct SemiModularSynthWidget : ModuleWidget {
 		displaySequence->box.pos = Vec(columnRulerMK1-15, rowRulerMK0 + 3 + vOffsetDisplay);
 		displaySequence->box.size = Vec(55, 30);// 3 characters
 		displaySequence->module = module;
-		addChild(displaySequence);
+		addChild(createCachedDisplay(displaySequence));
 		// Len/mode button
 		addParam(createDynamicParam<IMBigPushButton>(Vec(columnRulerMK2 + offsetCKD6b, rowRulerMK0 + 0 + offsetCKD6b), module, SemiModularSynth::RUNMODE_PARAM, 0.0f, 1.0f, 0.0f, &module->panelTheme));
 
@@ -2147,6 +2239,7 @@ fix tied bug that prevented correct tied propagation when editing beyond sequenc
 implement held tied notes option
 clear all attributes (gates, gatep, tied, slide) when cross-paste to seq ALL (CVs not affected)
 implement right-click initialization on main knob
+use a per-module random number generator (saved in the patch) instead of Rack's global one
 
 0.6.12:
 input refresh optimization
@@ -57,7 +57,7 @@ struct Tact : Module {
 	
 	float infoCVinLight[2] = {0.0f, 0.0f};
 	float paramReadRequest[2] = {-10.0f, -10.0f}; 
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
 	SchmittTrigger topTriggers[2];
 	SchmittTrigger botTriggers[2];
 	SchmittTrigger topInvTriggers[2];
@@ -157,14 +157,14 @@ struct Tact : Module {
 		float sampleTime = engineGetSampleTime();
 		static const float storeInfoTime = 0.5f;// seconds	
 	
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 		
 			// store buttons
 			for (int i = 0; i < 2; i++) {
 				if (storeTriggers[i].process(params[STORE_PARAMS + i].value)) {
 					if ( !(i == 1 && isLinked()) ) {// ignore right channel store-button press when linked
 						storeCV[i] = cv[i];
-						infoStore = (long) (storeInfoTime * sampleRate / displayRefreshStepSkips) * (i == 0 ? 1l : -1l);
+						infoStore = (long) (storeInfoTime * sampleRate / refresh.lightSkips) * (i == 0 ? 1l : -1l);
 					}
 				}
 			}
@@ -257,17 +257,15 @@ struct Tact : Module {
 		}
 		
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			// Tactile lights
 			if (infoStore > 0l)
-				setTLightsStore(0, infoStore, (long) (storeInfoTime * sampleRate / displayRefreshStepSkips) );
+				setTLightsStore(0, infoStore, (long) (storeInfoTime * sampleRate / refresh.lightSkips) );
 			else
 				setTLights(0);
 			if (infoStore < 0l)
-				setTLightsStore(1, infoStore * -1l, (long) (storeInfoTime * sampleRate / displayRefreshStepSkips) );
+				setTLightsStore(1, infoStore * -1l, (long) (storeInfoTime * sampleRate / refresh.lightSkips) );
 			else
 				setTLights(1);
 			if (infoStore != 0l) {
@@ -281,7 +279,7 @@ struct Tact : Module {
 				lights[CVIN_LIGHTS + i * 2].value = infoCVinLight[i];
 			
 			for (int i = 0; i < 2; i++) {
-				infoCVinLight[i] -= (infoCVinLight[i] / lightLambda) * sampleTime * displayRefreshStepSkips;
+				infoCVinLight[i] -= (infoCVinLight[i] / lightLambda) * sampleTime * refresh.lightSkips;
 			}
 		}
 		
@@ -386,8 +384,8 @@ struct TactWidget : ModuleWidget {
 	TactWidget(Tact *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Tact.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/Tact_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/Tact.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/Tact_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
@@ -528,7 +526,7 @@ struct Tact1 : Module {
 	float rateMultiplier;
 
 	// No need to save
-	unsigned int lightRefreshCounter = 0;	
+	RefreshCounter refresh;
 	
 	inline bool isExpSliding(void) {return params[EXP_PARAM].value > 0.5f;}
 
@@ -620,9 +618,7 @@ struct Tact1 : Module {
 		outputs[CV_OUTPUT].value = (float)cv * params[ATTV_PARAM].value;
 		
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			setTLights();
 		}
@@ -702,8 +698,8 @@ struct Tact1Widget : ModuleWidget {
 	Tact1Widget(Tact1 *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/Tact1.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/Tact1_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/Tact1.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/Tact1_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
@@ -53,7 +53,7 @@ struct TwelveKey : Module {
 	int lastKeyPressed;// 0 to 11
 
 	
-	unsigned int lightRefreshCounter = 0;
+	RefreshCounter refresh;
 	//float gateLight = 0.0f;
 	SchmittTrigger keyTriggers[12];
 	SchmittTrigger gateInputTrigger;
@@ -130,7 +130,7 @@ struct TwelveKey : Module {
 		bool upOctTrig = false;
 		bool downOctTrig = false;
 		
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 		
 			// Octave buttons and input
 			upOctTrig = octIncTrigger.process(params[OCTINC_PARAM].value);
@@ -141,7 +141,7 @@ struct TwelveKey : Module {
 				if (keyTriggers[i].process(params[KEY_PARAMS + i].value)) {
 					cv = ((float)(octaveNum - 4)) + ((float) i) / 12.0f;
 					stateInternal = true;
-					noteLightCounter = (unsigned long) (noteLightTime * engineGetSampleRate() / displayRefreshStepSkips);
+					noteLightCounter = (unsigned long) (noteLightTime * engineGetSampleRate() / refresh.lightSkips);
 					lastKeyPressed = i;
 				}
 			}
@@ -180,9 +180,7 @@ struct TwelveKey : Module {
 		// Octave output
 		outputs[OCT_OUTPUT].value = round( (float)(octaveNum + 1) );
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			// Key lights
 			for (int i = 0; i < 12; i++)
@@ -264,8 +262,8 @@ struct TwelveKeyWidget : ModuleWidget {
 	TwelveKeyWidget(TwelveKey *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/TwelveKey.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/TwelveKey_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/TwelveKey.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/TwelveKey_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
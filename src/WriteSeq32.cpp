@@ -11,7 +11,7 @@
 #include "ImpromptuModular.hpp"
 
 
-struct WriteSeq32 : Module {
+struct WriteSeq32 : Module, BlockProcessor {
 	enum ParamIds {
 		SHARP_PARAM,
 		ENUMS(WINDOW_PARAM, 4),
@@ -78,7 +78,7 @@ struct WriteSeq32 : Module {
 	long clockIgnoreOnReset;
 
 
-	unsigned int lightRefreshCounter = 0;	
+	RefreshCounter refresh;
 	SchmittTrigger clockTrigger;
 	SchmittTrigger resetTrigger;
 	SchmittTrigger runningTrigger;
@@ -255,11 +255,11 @@ struct WriteSeq32 : Module {
 			}
 		}
 		
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 		
 			// Copy button
 			if (copyTrigger.process(params[COPY_PARAM].value)) {
-				infoCopyPaste = (long) (copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
+				infoCopyPaste = (long) (copyPasteInfoTime * engineGetSampleRate() / refresh.lightSkips);
 				for (int s = 0; s < 32; s++) {
 					cvCPbuffer[s] = cv[indexChannel][s];
 					gateCPbuffer[s] = gates[indexChannel][s];
@@ -270,7 +270,7 @@ struct WriteSeq32 : Module {
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
 				if (params[PASTESYNC_PARAM].value < 0.5f || indexChannel == 3) {
 					// Paste realtime, no pending to schedule
-					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
+					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / refresh.lightSkips);
 					for (int s = 0; s < 32; s++) {
 						cv[indexChannel][s] = cvCPbuffer[s];
 						gates[indexChannel][s] = gateCPbuffer[s];
@@ -369,7 +369,7 @@ struct WriteSeq32 : Module {
 				// Pending paste on clock or end of seq
 				if ( ((pendingPaste&0x3) == 1) || ((pendingPaste&0x3) == 2 && indexStep == 0) ) {
 					int pasteChannel = pendingPaste>>2;
-					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
+					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / refresh.lightSkips);
 					for (int s = 0; s < 32; s++) {
 						cv[pasteChannel][s] = cvCPbuffer[s];
 						gates[pasteChannel][s] = gateCPbuffer[s];
@@ -411,9 +411,7 @@ struct WriteSeq32 : Module {
 			}
 		}
 
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			int index = (indexChannel == 3 ? indexStepStage : indexStep);
 			// Window lights
@@ -449,11 +447,22 @@ struct WriteSeq32 : Module {
 				if (infoCopyPaste < 0l)
 					infoCopyPaste ++;
 			}
-		}// lightRefreshCounter
+		}// processLights()
 		
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 	}
+	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {// outputs only change on clock edges and user inputs
+		return LONG_MAX;
+	}
+	inline void skipIdleSteps(long n) {
+		clockIgnoreOnReset = std::max(clockIgnoreOnReset - n, 0l);
+	}
 };
 
 
@@ -597,8 +606,8 @@ struct WriteSeq32Widget : ModuleWidget {
 	WriteSeq32Widget(WriteSeq32 *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/WriteSeq32.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/WriteSeq32_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/WriteSeq32.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/WriteSeq32_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);
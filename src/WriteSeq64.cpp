@@ -11,7 +11,7 @@
 #include "ImpromptuModular.hpp"
 
 
-struct WriteSeq64 : Module {
+struct WriteSeq64 : Module, BlockProcessor {
 	enum ParamIds {
 		SHARP_PARAM,
 		QUANTIZE_PARAM,
@@ -78,7 +78,7 @@ struct WriteSeq64 : Module {
 	long clockIgnoreOnReset;
 
 
-	unsigned int lightRefreshCounter = 0;	
+	RefreshCounter refresh;
 	int stepKnob = 0;
 	int stepsKnob = 0;
 	float resetLight = 0.0f;
@@ -281,11 +281,11 @@ struct WriteSeq64 : Module {
 			}
 		}
 	
-		if ((lightRefreshCounter & userInputsStepSkipMask) == 0) {
+		if (refresh.processInputs()) {
 		
 			// Copy button
 			if (copyTrigger.process(params[COPY_PARAM].value)) {
-				infoCopyPaste = (long) (copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
+				infoCopyPaste = (long) (copyPasteInfoTime * engineGetSampleRate() / refresh.lightSkips);
 				for (int s = 0; s < 64; s++) {
 					cvCPbuffer[s] = cv[indexChannel][s];
 					gateCPbuffer[s] = gates[indexChannel][s];
@@ -297,7 +297,7 @@ struct WriteSeq64 : Module {
 			if (pasteTrigger.process(params[PASTE_PARAM].value)) {
 				if (params[PASTESYNC_PARAM].value < 0.5f || indexChannel == 4) {
 					// Paste realtime, no pending to schedule
-					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
+					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / refresh.lightSkips);
 					for (int s = 0; s < 64; s++) {
 						cv[indexChannel][s] = cvCPbuffer[s];
 						gates[indexChannel][s] = gateCPbuffer[s];
@@ -401,7 +401,7 @@ struct WriteSeq64 : Module {
 			if ( ((pendingPaste&0x3) == 1) || ((pendingPaste&0x3) == 2 && indexStep[indexChannel] == 0) ) {
 				if ( (clk12step && (indexChannel == 0 || indexChannel == 1)) ||
 					 (clk34step && (indexChannel == 2 || indexChannel == 3)) ) {
-					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / displayRefreshStepSkips);
+					infoCopyPaste = (long) (-1 * copyPasteInfoTime * engineGetSampleRate() / refresh.lightSkips);
 					int pasteChannel = pendingPaste>>2;
 					for (int s = 0; s < 64; s++) {
 						cv[pasteChannel][s] = cvCPbuffer[s];
@@ -453,16 +453,14 @@ struct WriteSeq64 : Module {
 			}
 		}
 		
-		lightRefreshCounter++;
-		if (lightRefreshCounter >= displayRefreshStepSkips) {
-			lightRefreshCounter = 0;
+		if (refresh.processLights()) {
 
 			// Gate light
 			lights[GATE_LIGHT].value = gates[indexChannel][indexStep[indexChannel]] ? 1.0f : 0.0f;			
 			
 			// Reset light
 			lights[RESET_LIGHT].value =	resetLight;	
-			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * displayRefreshStepSkips;
+			resetLight -= (resetLight / lightLambda) * engineGetSampleTime() * refresh.lightSkips;
 
 			// Run light
 			lights[RUN_LIGHT].value = running ? 1.0f : 0.0f;
@@ -480,11 +478,22 @@ struct WriteSeq64 : Module {
 				if (infoCopyPaste < 0l)
 					infoCopyPaste ++;
 			}
-		}// lightRefreshCounter
+		}// processLights()
 		
 		if (clockIgnoreOnReset > 0l)
 			clockIgnoreOnReset--;
 	}
+	
+	// Block processing, see processBlockIdleRuns() in ImpromptuModular.hpp
+	void processBlock(int frames, const float* const* inBufs, float* const* outBufs) override {
+		processBlockIdleRuns(this, frames, inBufs, outBufs);
+	}
+	inline long calcIdleSteps() {// outputs only change on clock edges and user inputs
+		return LONG_MAX;
+	}
+	inline void skipIdleSteps(long n) {
+		clockIgnoreOnReset = std::max(clockIgnoreOnReset - n, 0l);
+	}
 };
 
 
@@ -670,8 +679,8 @@ struct WriteSeq64Widget : ModuleWidget {
 	WriteSeq64Widget(WriteSeq64 *module) : ModuleWidget(module) {
 		// Main panel from Inkscape
         DynamicSVGPanel *panel = new DynamicSVGPanel();
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/light/WriteSeq64.svg")));
-        panel->addPanel(SVG::load(assetPlugin(plugin, "res/dark/WriteSeq64_dark.svg")));
+        panel->addPanel(assetPlugin(plugin, "res/light/WriteSeq64.svg"));
+        panel->addPanel(assetPlugin(plugin, "res/dark/WriteSeq64_dark.svg"));
         box.size = panel->box.size;
         panel->mode = &module->panelTheme;
         addChild(panel);